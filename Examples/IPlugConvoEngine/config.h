@@ -15,7 +15,7 @@
 
 #define SHARED_RESOURCES_SUBPATH "IPlugConvoEngine"
 
-#define PLUG_CHANNEL_IO "1-1"
+#define PLUG_CHANNEL_IO "1-1 2-2"
 
 #define PLUG_LATENCY 0
 #define PLUG_TYPE 0
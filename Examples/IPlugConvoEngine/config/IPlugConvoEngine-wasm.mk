@@ -6,16 +6,10 @@ include ../../../common-wasm.mk
 
 SRC += $(PROJECT_ROOT)/IPlugConvoEngine.cpp
 
-# r8brain resampler
-SRC += $(PROJECT_ROOT)/r8brain/r8bbase.cpp
-SRC += $(PROJECT_ROOT)/r8brain/pffft.cpp
-
-# WDL FFT and Convolution Engine
+# WDL FFT, Convolution Engine and Resampler
 WASM_DSP_SRC += $(WDL_PATH)/fft.c
 WASM_DSP_SRC += $(WDL_PATH)/convoengine.cpp
-
-# DSP module flags
-WASM_DSP_CFLAGS += -I$(PROJECT_ROOT)/r8brain -DUSE_R8BRAIN
+WASM_DSP_SRC += $(WDL_PATH)/resample.cpp
 
 # Use DEBUG=1 for DWARF debugging: emmake make -f IPlugConvoEngine-hybrid-dsp.mk DEBUG=1
 # Note: DSP module runs in AudioWorklet with synchronous WASM loading constraints
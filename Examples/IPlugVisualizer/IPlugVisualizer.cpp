@@ -9,6 +9,10 @@ IPlugVisualizer::IPlugVisualizer(const InstanceInfo& info)
 : iplug::Plugin(info, MakeConfig(kNumParams, kNumPresets))
 {
   GetParam(kOctaveGain)->InitDouble("OctaveGain", 0.0, 0., 12.0, 0.1, "dB");
+
+#if IPLUG_DSP
+//  mSender.SetAnalysisThread(true); // compute the STFT on a worker thread, rather than in OnIdle()
+#endif
   
 #if IPLUG_EDITOR // http://bit.ly/2S64BDd
   mMakeGraphicsFunc = [&]() {
@@ -36,7 +40,9 @@ IPlugVisualizer::IPlugVisualizer(const InstanceInfo& info)
       .WithColor(kFG, {255, 128, 128, 128})
       .WithLabelText(DEFAULT_LABEL_TEXT.WithFGColor(COLOR_WHITE))
       .WithValueText(DEFAULT_VALUE_TEXT.WithFGColor(COLOR_WHITE));
-    pGraphics->AttachControl(new IVSpectrumAnalyzerControl<2>(b, "Spectrum", style), kCtrlTagSpectrumAnalyzer);
+    auto* pSpectrumControl = new IVSpectrumAnalyzerControl<2>(b, "Spectrum", style);
+    pGraphics->AttachControl(pSpectrumControl, kCtrlTagSpectrumAnalyzer);
+    pSpectrumControl->SetReduceToWidth(true);
     
 //    auto* pControl = new IVBarGraphSpectrumAnalyzerControl<2>(
 //       b, "Spectrum", DEFAULT_STYLE, 32, 16,
@@ -98,6 +104,12 @@ bool IPlugVisualizer::OnMessage(int msgTag, int ctrlTag, int dataSize, const voi
     mSender.SetWindowType(static_cast<ISpectrumSender<2>::EWindowType>(idx));
     return true;
   }
+  else if (msgTag == IVSpectrumAnalyzerControl<>::kMsgTagNumPoints)
+  {
+    int nPoints = *reinterpret_cast<const int*>(pData);
+    mSender.SetNumOutputPoints(nPoints);
+    return true;
+  }
 
   return false;
 }
@@ -155,10 +167,12 @@ void IPlugVisualizer::SyncUIControl()
   auto fftSize = mSender.GetFFTSize();
   auto overlap = mSender.GetOverlap();
   auto windowType = static_cast<int>(mSender.GetWindowType());
+  auto nPoints = mSender.GetNumOutputPoints();
   SendControlMsgFromDelegate(kCtrlTagSpectrumAnalyzer, IVSpectrumAnalyzerControl<>::kMsgTagSampleRate, sizeof(double), &sr);
   SendControlMsgFromDelegate(kCtrlTagSpectrumAnalyzer, IVSpectrumAnalyzerControl<>::kMsgTagFFTSize, sizeof(int), &fftSize);
   SendControlMsgFromDelegate(kCtrlTagSpectrumAnalyzer, IVSpectrumAnalyzerControl<>::kMsgTagOverlap, sizeof(int), &overlap);
   SendControlMsgFromDelegate(kCtrlTagSpectrumAnalyzer, IVSpectrumAnalyzerControl<>::kMsgTagWindowType, sizeof(int), &windowType);
+  SendControlMsgFromDelegate(kCtrlTagSpectrumAnalyzer, IVSpectrumAnalyzerControl<>::kMsgTagNumPoints, sizeof(int), &nPoints);
 }
 
 #endif
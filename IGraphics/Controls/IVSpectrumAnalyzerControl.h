@@ -38,7 +38,8 @@ public:
     kMsgTagFFTSize,
     kMsgTagOverlap,
     kMsgTagWindowType,
-    kMsgTagOctaveGain
+    kMsgTagOctaveGain,
+    kMsgTagNumPoints
   };
   
   static constexpr auto numExtraPoints = 2;
@@ -177,8 +178,25 @@ public:
   void OnResize() override
   {
     SetTargetRECT(MakeRects(mRECT));
+
+    if (mReduceToWidth && GetDelegate())
+    {
+      // ask the ISpectrumSender for one band per pixel column, see ISpectrumSender::SetNumOutputPoints()
+      int nPoints = static_cast<int>(std::ceil(mWidgetBounds.W()));
+      GetDelegate()->SendArbitraryMsgFromUI(kMsgTagNumPoints, kNoTag, sizeof(int), &nPoints);
+      SetNumOutputPoints(nPoints);
+    }
+
     SetDirty(false);
   }
+
+  /** If enabled, the control sends kMsgTagNumPoints to the delegate whenever it is resized, requesting log-spaced bands with one point per pixel.
+   * Your plug-in should forward the message to ISpectrumSender::SetNumOutputPoints() */
+  void SetReduceToWidth(bool reduce)
+  {
+    mReduceToWidth = reduce;
+    OnResize();
+  }
   
   void OnMsgFromDelegate(int msgTag, int dataSize, const void* pData) override
   {
@@ -186,12 +204,25 @@ public:
 
     if (!IsDisabled() && msgTag == ISender<>::kUpdateMessage)
     {
-      ISenderData<MAXNC, TDataPacket> d;
-      stream.Get(&d, 0);
-      
-      for (auto c = d.chanOffset; c < (d.chanOffset + d.nChans); c++)
+      using TSenderData = ISenderData<MAXNC, TDataPacket>;
+      assert(dataSize == sizeof(TSenderData));
+
+      // the packet is only read during this call, so use it in place when it is aligned, which it is unless it was
+      // serialized into a byte stream, e.g. by a distributed editor. Otherwise copy it rather than read it misaligned
+      const TSenderData* pPacket = static_cast<const TSenderData*>(pData);
+
+      if (reinterpret_cast<uintptr_t>(pData) % alignof(TSenderData))
       {
-        CalculateYPoints(c, d.vals[c]);
+        if (!mUnalignedPacket)
+          mUnalignedPacket = std::make_unique<TSenderData>();
+
+        memcpy(static_cast<void*>(mUnalignedPacket.get()), pData, sizeof(TSenderData));
+        pPacket = mUnalignedPacket.get();
+      }
+
+      for (auto c = pPacket->chanOffset; c < (pPacket->chanOffset + pPacket->nChans); c++)
+      {
+        CalculateYPoints(c, pPacket->vals[c]);
       }
     }
     else if (msgTag == kMsgTagSampleRate)
@@ -224,6 +255,12 @@ public:
       stream.Get(&octaveGain, 0);
       SetOctaveGain(octaveGain);
     }
+    else if (msgTag == kMsgTagNumPoints)
+    {
+      int nPoints;
+      stream.Get(&nPoints, 0);
+      SetNumOutputPoints(nPoints);
+    }
   }
   
   void Draw(IGraphics& g) override
@@ -338,12 +375,7 @@ private:
       }
       else
       {
-        for (int i = 1; i < nBins; ++i)
-        {
-          float xi = mWidgetBounds.L + mXPoints[i] * mWidgetBounds.W();
-          float yi = mWidgetBounds.B - mYPoints[c][i] * mWidgetBounds.H();
-          g.PathLineTo(xi, yi);
-        }
+        PathLinesTo(g, c, nBins);
       }
 
       // Fill under the curve with a vertical gradient to transparent
@@ -393,12 +425,7 @@ private:
         }
         else
         {
-          for (int i = 1; i < nBins; ++i)
-          {
-            float xi = mWidgetBounds.L + mXPoints[i] * mWidgetBounds.W();
-            float yi = mWidgetBounds.B - mYPoints[c][i] * mWidgetBounds.H();
-            g.PathLineTo(xi, yi);
-          }
+          PathLinesTo(g, c, nBins);
         }
       }
 
@@ -407,6 +434,36 @@ private:
     }
   }
 
+  /** Adds straight segments from the first bin to the others. With more than four bins per pixel column only the first, lowest, highest
+   * and last bins of each column are added, which draws the same line */
+  void PathLinesTo(IGraphics& g, int c, int nBins)
+  {
+    const float* pX = mXPoints.data();
+    const float* pY = mYPoints[c].data();
+    const int nColumns = static_cast<int>(std::ceil(mWidgetBounds.W() * g.GetTotalScale()));
+    int nPoints = nBins;
+
+    if (g.DataDecimationEnabled() && IDataDecimator::IsWorthwhile(nBins, nColumns))
+    {
+      IDataDecimator& decimator = g.GetDataDecimator();
+      const int nDecimated = decimator.Process(pY, pX, nBins, nColumns);
+
+      if (nDecimated > 0)
+      {
+        pX = decimator.GetX();
+        pY = decimator.GetY();
+        nPoints = nDecimated;
+      }
+    }
+
+    for (int i = 1; i < nPoints; ++i)
+    {
+      float xi = mWidgetBounds.L + pX[i] * mWidgetBounds.W();
+      float yi = mWidgetBounds.B - pY[i] * mWidgetBounds.H();
+      g.PathLineTo(xi, yi);
+    }
+  }
+
   void DrawCursorValues(IGraphics& g)
   {
     WDL_String label;
@@ -440,6 +497,17 @@ private:
     SetDirty(false);
   }
 
+  /** @param nPoints The number of log-spaced bands in incoming packets, or 0 if they contain all FFT bins */
+  void SetNumOutputPoints(int nPoints)
+  {
+    assert(nPoints <= MAX_FFT_SIZE);
+    mNumOutputPoints = nPoints;
+
+    ResizePoints();
+    CalculateXPoints();
+    SetDirty(false);
+  }
+
   void SetSampleRate(double sampleRate)
   {
     mSampleRate = sampleRate;
@@ -519,11 +587,12 @@ protected:
   void CalculateXPoints()
   {
     const auto numBins = NumBins();
-    const auto xIncr = (1.0f / static_cast<float>(numBins-1)) * NyquistFreq();
+    const auto xIncr = (1.0f / static_cast<float>(mFFTSize / 2 - 1)) * NyquistFreq();
     mXPoints[0] = 0.0f;
     for (auto i = 1; i < numBins; i++)
     {
-      auto xVal = CalcXNorm(float(i) * xIncr, mFreqScale);
+      const float bin = mNumOutputPoints > 0 ? ISpectrumSender<MAXNC>::GetBandCenterBin(mFFTSize, mNumOutputPoints, i) : float(i);
+      auto xVal = CalcXNorm(bin * xIncr, mFreqScale);
       mXPoints[i] = xVal;
     }
     mXPoints[numBins] = mXPoints[numBins-1];
@@ -617,7 +686,7 @@ protected:
   }
 
   int NumPoints() const { return FillCurves() ? NumBins() + numExtraPoints : NumBins(); }
-  int NumBins() const { return mFFTSize / 2; }
+  int NumBins() const { return mNumOutputPoints > 0 ? mNumOutputPoints : mFFTSize / 2; }
   double FirstBinFreq() const { return NyquistFreq()/mFFTSize; }
   double NyquistFreq() const { return mSampleRate * 0.5; }
   bool FillCurves() const { return mFillOpacity > 0.0f; }
@@ -652,7 +721,10 @@ private:
   float mReleaseCoeff = 0.99f;
   int mOverlap = 1;
   int mWindowType = 0; // matches ISpectrumSender<>::EWindowType::Hann
+  int mNumOutputPoints = 0; // matches ISpectrumSender<>::GetNumOutputPoints()
+  bool mReduceToWidth = false;
   float mCurveSmoothing = 0.6f; // 0 = straight lines, 1 = full Catmull-Rom
+  std::unique_ptr<ISenderData<MAXNC, TDataPacket>> mUnalignedPacket;
 };
 
 END_IGRAPHICS_NAMESPACE
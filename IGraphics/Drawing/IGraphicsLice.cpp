@@ -0,0 +1,1553 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "IGraphicsLice.h"
+#include "wdlutf8.h"
+
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+// WDL's libpng is configured without write support
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+#pragma mark - Private Classes and Structs
+
+class IGraphicsLice::Bitmap : public APIBitmap
+{
+public:
+  Bitmap(int width, int height, float scale, float drawScale);
+  Bitmap(LICE_IBitmap* pBitmap, int scale);
+  ~Bitmap() { delete GetBitmap(); }
+};
+
+IGraphicsLice::Bitmap::Bitmap(int width, int height, float scale, float drawScale)
+{
+  LICE_MemBitmap* pBitmap = new LICE_MemBitmap(width, height);
+  memset(pBitmap->getBits(), 0, pBitmap->getRowSpan() * height * sizeof(LICE_pixel));
+  SetBitmap(pBitmap, width, height, scale, drawScale);
+}
+
+IGraphicsLice::Bitmap::Bitmap(LICE_IBitmap* pBitmap, int scale)
+{
+  SetBitmap(pBitmap, pBitmap->getWidth(), pBitmap->getHeight(), scale, 1.f);
+}
+
+struct IGraphicsLice::Font
+{
+  Font(IFontDataPtr&& data)
+  : mData(std::move(data))
+  {
+    const unsigned char* pData = mData->Get();
+    mValid = stbtt_InitFont(&mInfo, pData, stbtt_GetFontOffsetForIndex(pData, mData->GetFaceIdx())) != 0;
+  }
+
+  IFontDataPtr mData;
+  stbtt_fontinfo mInfo;
+  bool mValid;
+};
+
+// Fonts
+StaticStorage<IGraphicsLice::Font> IGraphicsLice::sFontCache;
+
+#pragma mark - Pixel utilities
+
+static inline uint32_t Div255(uint32_t x)
+{
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+/** Scales all four channels of a pixel by k / 256 */
+static inline LICE_pixel ScalePixel(LICE_pixel p, uint32_t k)
+{
+  const uint32_t rb = (((p & 0x00ff00ff) * k) >> 8) & 0x00ff00ff;
+  const uint32_t ag = (((p >> 8) & 0x00ff00ff) * k) & 0xff00ff00;
+  return rb | ag;
+}
+
+static inline LICE_pixel PremultipliedPixel(const IColor& color, float weight)
+{
+  const uint32_t a = static_cast<uint32_t>(Clip(std::lround(color.A * weight), 0L, 255L));
+  return LICE_RGBA(Div255(color.R * a), Div255(color.G * a), Div255(color.B * a), a);
+}
+
+static void PremultiplyBitmap(LICE_IBitmap* pBitmap)
+{
+  for (int y = 0; y < pBitmap->getHeight(); y++)
+  {
+    LICE_pixel* pRow = pBitmap->getBits() + y * pBitmap->getRowSpan();
+
+    for (int x = 0; x < pBitmap->getWidth(); x++)
+    {
+      const uint32_t a = LICE_GETA(pRow[x]);
+
+      if (a != 255)
+        pRow[x] = LICE_RGBA(Div255(LICE_GETR(pRow[x]) * a), Div255(LICE_GETG(pRow[x]) * a), Div255(LICE_GETB(pRow[x]) * a), a);
+    }
+  }
+}
+
+static inline IColor UnpremultipliedColor(LICE_pixel p)
+{
+  const int a = LICE_GETA(p);
+
+  if (!a)
+    return IColor(0, 0, 0, 0);
+
+  auto unpremultiply = [a](int c) { return std::min(255, (c * 255 + a / 2) / a); };
+  return IColor(a, unpremultiply(LICE_GETR(p)), unpremultiply(LICE_GETG(p)), unpremultiply(LICE_GETB(p)));
+}
+
+/** Composites a span of premultiplied source pixels onto the destination, with a coverage value per pixel */
+static void BlendSpan(LICE_pixel* pDst, const LICE_pixel* pSrc, const float* pCoverage, int n, EBlend method)
+{
+  if (method == EBlend::SrcOver)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      const float coverage = pCoverage[i];
+
+      if (coverage <= 0.f)
+        continue;
+
+      LICE_pixel src = pSrc[i];
+
+      if (coverage < 1.f)
+        src = ScalePixel(src, static_cast<uint32_t>(coverage * 256.f + 0.5f));
+
+      const uint32_t a = LICE_GETA(src);
+
+      if (a == 255)
+        pDst[i] = src;
+      else if (a || src)
+        pDst[i] = src + ScalePixel(pDst[i], 256 - a);
+    }
+
+    return;
+  }
+
+  // The Porter-Duff operators: result = src * Fa + dst * Fb, then lerped with the destination by coverage
+  for (int i = 0; i < n; i++)
+  {
+    const float coverage = pCoverage[i];
+
+    if (coverage <= 0.f)
+      continue;
+
+    const LICE_pixel s = pSrc[i];
+    const LICE_pixel d = pDst[i];
+    const float sa = LICE_GETA(s) / 255.f;
+    const float da = LICE_GETA(d) / 255.f;
+    float fa = 1.f, fb = 1.f;
+
+    switch (method)
+    {
+      case EBlend::SrcOver:   fa = 1.f;         fb = 1.f - sa;    break;
+      case EBlend::SrcIn:     fa = da;          fb = 0.f;         break;
+      case EBlend::SrcOut:    fa = 1.f - da;    fb = 0.f;         break;
+      case EBlend::SrcAtop:   fa = da;          fb = 1.f - sa;    break;
+      case EBlend::DstOver:   fa = 1.f - da;    fb = 1.f;         break;
+      case EBlend::DstIn:     fa = 0.f;         fb = sa;          break;
+      case EBlend::DstOut:    fa = 0.f;         fb = 1.f - sa;    break;
+      case EBlend::DstAtop:   fa = 1.f - da;    fb = sa;          break;
+      case EBlend::Add:       fa = 1.f;         fb = 1.f;         break;
+      case EBlend::XOR:       fa = 1.f - da;    fb = 1.f - sa;    break;
+    }
+
+    auto channel = [&](int sc, int dc) {
+      const float result = std::min(255.f, sc * fa + dc * fb);
+      return static_cast<int>(dc + coverage * (result - dc) + 0.5f);
+    };
+
+    pDst[i] = LICE_RGBA(channel(LICE_GETR(s), LICE_GETR(d)), channel(LICE_GETG(s), LICE_GETG(d)),
+                        channel(LICE_GETB(s), LICE_GETB(d)), channel(LICE_GETA(s), LICE_GETA(d)));
+  }
+}
+
+/** @return The matrix that applies first and then second */
+static IMatrix Concat(const IMatrix& first, const IMatrix& second)
+{
+  return IMatrix(second).Transform(first);
+}
+
+#pragma mark - Shaders
+
+/** Produces the premultiplied source pixels of a solid color or a gradient, for device pixel centers */
+class PatternShader
+{
+public:
+  /** @param deviceToUser Maps device pixels to the user space in which the pattern is defined */
+  PatternShader(const IPattern& pattern, const IMatrix& deviceToUser, float weight)
+  : mType(pattern.NStops() < 2 ? EPatternType::Solid : pattern.mType)
+  , mExtend(pattern.mExtend)
+  , mMatrix(Concat(deviceToUser, pattern.mTransform))
+  {
+    if (mType == EPatternType::Solid)
+    {
+      mSolid = PremultipliedPixel(pattern.GetStop(0).mColor, weight);
+      return;
+    }
+
+    // Colors are interpolated unpremultiplied between the stops, as Skia does
+    const int nStops = pattern.NStops();
+
+    for (int i = 0; i < kLUTSize; i++)
+    {
+      const float t = static_cast<float>(i) / (kLUTSize - 1);
+      int stop = 0;
+
+      while (stop < nStops - 1 && pattern.GetStop(stop + 1).mOffset < t)
+        stop++;
+
+      const IColorStop& s0 = pattern.GetStop(stop);
+      const IColorStop& s1 = pattern.GetStop(std::min(stop + 1, nStops - 1));
+      const float range = s1.mOffset - s0.mOffset;
+      const float f = range > 0.f ? Clip((t - s0.mOffset) / range, 0.f, 1.f) : (t < s0.mOffset ? 0.f : 1.f);
+
+      auto lerp = [f](int a, int b) { return static_cast<int>(std::lround(a + f * (b - a))); };
+      const IColor color(lerp(s0.mColor.A, s1.mColor.A), lerp(s0.mColor.R, s1.mColor.R),
+                         lerp(s0.mColor.G, s1.mColor.G), lerp(s0.mColor.B, s1.mColor.B));
+
+      mLUT[i] = PremultipliedPixel(color, weight);
+    }
+  }
+
+  void Shade(int x, int y, int n, LICE_pixel* pOut) const
+  {
+    if (mType == EPatternType::Solid)
+    {
+      std::fill_n(pOut, n, mSolid);
+      return;
+    }
+
+    double px, py;
+    mMatrix.TransformPoint(px, py, x + 0.5, y + 0.5);
+
+    for (int i = 0; i < n; i++, px += mMatrix.mXX, py += mMatrix.mYX)
+    {
+      double t = 0.0;
+
+      switch (mType)
+      {
+        case EPatternType::Linear:  t = py;                                                    break;
+        case EPatternType::Radial:  t = std::sqrt(px * px + py * py);                          break;
+        case EPatternType::Sweep:   t = std::atan2(px, -py) / (2.0 * PI); t -= std::floor(t);  break; // 0 is up, clockwise
+        default:                                                                               break;
+      }
+
+      pOut[i] = Lookup(t);
+    }
+  }
+
+private:
+  static constexpr int kLUTSize = 256;
+
+  LICE_pixel Lookup(double t) const
+  {
+    switch (mExtend)
+    {
+      case EPatternExtend::None:     if (t < 0.0 || t > 1.0) return 0;     break;
+      case EPatternExtend::Pad:                                            break;
+      case EPatternExtend::Repeat:   t -= std::floor(t);                   break;
+      case EPatternExtend::Reflect:  t = std::fabs(t - 2.0 * std::floor(t * 0.5 + 0.5));  break;
+    }
+
+    return mLUT[Clip(static_cast<int>(t * (kLUTSize - 1) + 0.5), 0, kLUTSize - 1)];
+  }
+
+  EPatternType mType;
+  EPatternExtend mExtend;
+  IMatrix mMatrix; // device to pattern space
+  LICE_pixel mSolid = 0;
+  LICE_pixel mLUT[kLUTSize];
+};
+
+/** Produces bilinearly filtered premultiplied pixels from a bitmap, clamped at its edges */
+class BitmapShader
+{
+public:
+  /** @param deviceToBitmap Maps device pixels to bitmap pixels */
+  BitmapShader(LICE_IBitmap* pBitmap, const IMatrix& deviceToBitmap, float weight)
+  : mBits(pBitmap->getBits())
+  , mWidth(pBitmap->getWidth())
+  , mHeight(pBitmap->getHeight())
+  , mRowSpan(pBitmap->getRowSpan())
+  , mMatrix(deviceToBitmap)
+  , mWeight(static_cast<uint32_t>(Clip(weight, 0.f, 1.f) * 256.f + 0.5f))
+  {
+    // An unscaled copy at integer offsets, which is the common case, needs no filtering
+    mCopy = mMatrix.mXX == 1.0 && mMatrix.mYY == 1.0 && mMatrix.mXY == 0.0 && mMatrix.mYX == 0.0
+         && mMatrix.mTX == std::floor(mMatrix.mTX) && mMatrix.mTY == std::floor(mMatrix.mTY);
+  }
+
+  void Shade(int x, int y, int n, LICE_pixel* pOut) const
+  {
+    if (mCopy)
+    {
+      const int by = Clip(y + static_cast<int>(mMatrix.mTY), 0, mHeight - 1);
+      const LICE_pixel* pRow = mBits + by * mRowSpan;
+
+      for (int i = 0; i < n; i++)
+        pOut[i] = Weighted(pRow[Clip(x + i + static_cast<int>(mMatrix.mTX), 0, mWidth - 1)]);
+
+      return;
+    }
+
+    double u, v;
+    mMatrix.TransformPoint(u, v, x + 0.5, y + 0.5);
+    u -= 0.5;
+    v -= 0.5;
+
+    for (int i = 0; i < n; i++, u += mMatrix.mXX, v += mMatrix.mYX)
+    {
+      const double fu = std::floor(u);
+      const double fv = std::floor(v);
+      const int x0 = static_cast<int>(fu);
+      const int y0 = static_cast<int>(fv);
+      const uint32_t wx = static_cast<uint32_t>((u - fu) * 256.0);
+      const uint32_t wy = static_cast<uint32_t>((v - fv) * 256.0);
+      const int xa = Clip(x0, 0, mWidth - 1), xb = Clip(x0 + 1, 0, mWidth - 1);
+      const LICE_pixel* pRowA = mBits + Clip(y0, 0, mHeight - 1) * mRowSpan;
+      const LICE_pixel* pRowB = mBits + Clip(y0 + 1, 0, mHeight - 1) * mRowSpan;
+
+      const LICE_pixel top = ScalePixel(pRowA[xa], 256 - wx) + ScalePixel(pRowA[xb], wx);
+      const LICE_pixel bottom = ScalePixel(pRowB[xa], 256 - wx) + ScalePixel(pRowB[xb], wx);
+      pOut[i] = Weighted(ScalePixel(top, 256 - wy) + ScalePixel(bottom, wy));
+    }
+  }
+
+private:
+  LICE_pixel Weighted(LICE_pixel p) const { return mWeight >= 256 ? p : ScalePixel(p, mWeight); }
+
+  const LICE_pixel* mBits;
+  int mWidth;
+  int mHeight;
+  int mRowSpan;
+  IMatrix mMatrix;
+  uint32_t mWeight;
+  bool mCopy;
+};
+
+#pragma mark - Rasterizer
+
+/** Accumulates the signed area that polygon edges cover in each pixel, then fills with a prefix sum along each row.
+ * The coverage of a pixel is exact for any number of overlapping edges, which gives anti-aliasing without supersampling */
+class IGraphicsLice::Rasterizer
+{
+public:
+  void Reset(int clipL, int clipT, int clipR, int clipB)
+  {
+    mClipL = clipL;
+    mClipT = clipT;
+    mClipR = clipR;
+    mClipB = clipB;
+    mEdges.clear();
+    mMinX = mMinY = std::numeric_limits<float>::max();
+    mMaxX = mMaxY = std::numeric_limits<float>::lowest();
+  }
+
+  bool Empty() const { return mEdges.empty(); }
+
+  void AddEdge(float x0, float y0, float x1, float y1)
+  {
+    if (y0 == y1 || !std::isfinite(x0 + y0 + x1 + y1))
+      return;
+
+    mEdges.push_back({x0, y0, x1, y1});
+    mMinX = std::min(mMinX, std::min(x0, x1));
+    mMaxX = std::max(mMaxX, std::max(x0, x1));
+    mMinY = std::min(mMinY, std::min(y0, y1));
+    mMaxY = std::max(mMaxY, std::max(y0, y1));
+  }
+
+  /** Adds a closed polygon */
+  void AddPolygon(const PathPoint* pPoints, int n)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      const PathPoint& a = pPoints[i];
+      const PathPoint& b = pPoints[i + 1 < n ? i + 1 : 0];
+      AddEdge(a.x, a.y, b.x, b.y);
+    }
+  }
+
+  /** Fills the polygons that have been added since Reset() */
+  template <class Shader>
+  void Render(LICE_IBitmap* pDst, const Shader& shader, EBlend method, bool evenOdd)
+  {
+    if (mEdges.empty())
+      return;
+
+    const int areaL = std::max(mClipL, static_cast<int>(std::floor(mMinX)));
+    const int areaT = std::max(mClipT, static_cast<int>(std::floor(mMinY)));
+    const int areaR = std::min(mClipR, static_cast<int>(std::ceil(mMaxX)));
+    const int areaB = std::min(mClipB, static_cast<int>(std::ceil(mMaxY)));
+
+    if (areaL >= areaR || areaT >= areaB)
+      return;
+
+    mWidth = areaR - areaL;
+    mHeight = areaB - areaT;
+    mStride = mWidth + 2;
+
+    // The accumulation buffer is cleared as it is read, so it only grows here
+    if (mAccumulation.size() < static_cast<size_t>(mStride) * mHeight)
+      mAccumulation.resize(static_cast<size_t>(mStride) * mHeight, 0.f);
+
+    mRowMin.assign(mHeight, std::numeric_limits<int>::max());
+    mRowMax.assign(mHeight, -1);
+    mCoverage.resize(mWidth);
+    mSource.resize(mWidth);
+
+    for (const Edge& e : mEdges)
+      ClipAndAccumulate(e.x0 - areaL, e.y0 - areaT, e.x1 - areaL, e.y1 - areaT);
+
+    for (int y = 0; y < mHeight; y++)
+    {
+      if (mRowMin[y] > mRowMax[y])
+        continue;
+
+      float* pAcc = mAccumulation.data() + static_cast<size_t>(y) * mStride;
+      const int start = mRowMin[y];
+      const int last = mRowMax[y];
+      float acc = 0.f;
+      int end = mWidth;
+
+      for (int x = start; x < mWidth; x++)
+      {
+        acc += pAcc[x];
+        pAcc[x] = 0.f;
+
+        float coverage = std::fabs(acc);
+
+        if (evenOdd)
+        {
+          coverage = std::fmod(coverage, 2.f);
+          coverage = coverage > 1.f ? 2.f - coverage : coverage;
+        }
+        else
+          coverage = std::min(coverage, 1.f);
+
+        // Past the last edge the coverage is constant, so an empty run ends the span
+        if (x > last && coverage < 1e-4f)
+        {
+          end = x;
+          break;
+        }
+
+        mCoverage[x - start] = coverage;
+      }
+
+      for (int x = end; x <= last; x++)
+        pAcc[x] = 0.f;
+
+      if (end <= start)
+        continue;
+
+      const int n = end - start;
+      LICE_pixel* pRow = pDst->getBits() + (areaT + y) * pDst->getRowSpan() + areaL + start;
+      shader.Shade(areaL + start, areaT + y, n, mSource.data());
+      BlendSpan(pRow, mSource.data(), mCoverage.data(), n, method);
+    }
+  }
+
+private:
+  struct Edge
+  {
+    float x0, y0, x1, y1;
+  };
+
+  /** Splits an edge at the left and right of the area, keeping its direction. Parts on the left are moved onto x = 0, where they cover
+   * whole pixels, and parts on the right are dropped, as they do not affect any pixel in the area */
+  void ClipAndAccumulate(float x0, float y0, float x1, float y1)
+  {
+    const float w = static_cast<float>(mWidth);
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    float splits[4] = {0.f, 1.f, 1.f, 1.f};
+    int nSplits = 1;
+
+    for (float xSplit : {0.f, w})
+    {
+      if ((x0 < xSplit) != (x1 < xSplit))
+        splits[nSplits++] = (xSplit - x0) / dx;
+    }
+
+    std::sort(splits + 1, splits + nSplits);
+    splits[nSplits] = 1.f;
+
+    for (int i = 0; i < nSplits; i++)
+    {
+      const float xMid = x0 + dx * 0.5f * (splits[i] + splits[i + 1]);
+      const float ya = y0 + dy * splits[i];
+      const float yb = y0 + dy * splits[i + 1];
+
+      if (xMid >= w)
+        continue;
+      else if (xMid <= 0.f)
+        Accumulate(0.f, ya, 0.f, yb);
+      else
+        Accumulate(Clip(x0 + dx * splits[i], 0.f, w), ya, Clip(x0 + dx * splits[i + 1], 0.f, w), yb);
+    }
+  }
+
+  /** Adds the signed area of an edge to the cells of the rows it spans, with x in [0, width] */
+  void Accumulate(float x0, float y0, float x1, float y1)
+  {
+    if (y0 == y1)
+      return;
+
+    float dir = 1.f;
+
+    if (y0 > y1)
+    {
+      std::swap(x0, x1);
+      std::swap(y0, y1);
+      dir = -1.f;
+    }
+
+    const float dxdy = (x1 - x0) / (y1 - y0);
+    const int yStart = std::max(0, static_cast<int>(std::floor(y0)));
+    const int yEnd = std::min(mHeight, static_cast<int>(std::ceil(y1)));
+    float x = x0 + (std::max(y0, static_cast<float>(yStart)) - y0) * dxdy;
+
+    for (int y = yStart; y < yEnd; y++)
+    {
+      float* pAcc = mAccumulation.data() + static_cast<size_t>(y) * mStride;
+      const float dy = std::min(static_cast<float>(y + 1), y1) - std::max(static_cast<float>(y), y0);
+      const float xNext = x + dxdy * dy;
+      const float d = dy * dir;
+      const float xa = Clip(std::min(x, xNext), 0.f, static_cast<float>(mWidth));
+      const float xb = Clip(std::max(x, xNext), 0.f, static_cast<float>(mWidth));
+      const float xaFloor = std::floor(xa);
+      const int xai = static_cast<int>(xaFloor);
+      const float xbCeil = std::ceil(xb);
+      const int xbi = static_cast<int>(xbCeil);
+
+      if (xbi <= xai + 1)
+      {
+        // Within one pixel, the area right of the edge is split by its mid point
+        const float xmf = 0.5f * (xa + xb) - xaFloor;
+        pAcc[xai] += d - d * xmf;
+        pAcc[xai + 1] += d * xmf;
+        MarkRow(y, xai, xai + 1);
+      }
+      else
+      {
+        const float s = 1.f / (xb - xa);
+        const float xaf = xa - xaFloor;
+        const float a0 = 0.5f * s * (1.f - xaf) * (1.f - xaf);
+        const float xbf = xb - xbCeil + 1.f;
+        const float am = 0.5f * s * xbf * xbf;
+
+        pAcc[xai] += d * a0;
+
+        if (xbi == xai + 2)
+          pAcc[xai + 1] += d * (1.f - a0 - am);
+        else
+        {
+          const float a1 = s * (1.5f - xaf);
+          pAcc[xai + 1] += d * (a1 - a0);
+
+          for (int xi = xai + 2; xi < xbi - 1; xi++)
+            pAcc[xi] += d * s;
+
+          const float a2 = a1 + (xbi - xai - 3) * s;
+          pAcc[xbi - 1] += d * (1.f - a2 - am);
+        }
+
+        pAcc[xbi] += d * am;
+        MarkRow(y, xai, xbi);
+      }
+
+      x = xNext;
+    }
+  }
+
+  void MarkRow(int y, int x0, int x1)
+  {
+    mRowMin[y] = std::min(mRowMin[y], x0);
+    mRowMax[y] = std::max(mRowMax[y], x1);
+  }
+
+  std::vector<Edge> mEdges;
+  std::vector<float> mAccumulation;
+  std::vector<float> mCoverage;
+  std::vector<LICE_pixel> mSource;
+  std::vector<int> mRowMin;
+  std::vector<int> mRowMax;
+  float mMinX = 0.f, mMinY = 0.f, mMaxX = 0.f, mMaxY = 0.f;
+  int mClipL = 0, mClipT = 0, mClipR = 0, mClipB = 0;
+  int mWidth = 0, mHeight = 0, mStride = 0;
+};
+
+#pragma mark -
+
+IGraphicsLice::IGraphicsLice(IGEditorDelegate& dlg, int w, int h, int fps, float scale)
+: IGraphics(dlg, w, h, fps, scale)
+, mRasterizer(std::make_unique<Rasterizer>())
+{
+  DBGMSG("IGraphics LICE @ %i FPS\n", fps);
+  StaticStorage<Font>::Accessor storage(sFontCache);
+  storage.Retain();
+}
+
+IGraphicsLice::~IGraphicsLice()
+{
+  StaticStorage<Font>::Accessor storage(sFontCache);
+  storage.Release();
+}
+
+bool IGraphicsLice::BitmapExtSupported(const char* ext)
+{
+  char extLower[32];
+  ToLower(extLower, ext);
+  return (strstr(extLower, "png") != nullptr) || (strstr(extLower, "jpg") != nullptr) || (strstr(extLower, "jpeg") != nullptr);
+}
+
+APIBitmap* IGraphicsLice::LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext)
+{
+#ifdef OS_WIN
+  if (location == EResourceLocation::kWinBinary)
+  {
+    int size = 0;
+    const void* pData = LoadWinResource(fileNameOrResID, ext, size, GetWinModuleHandle());
+    return LoadAPIBitmap(fileNameOrResID, pData, size, scale);
+  }
+#endif
+
+  char extLower[32];
+  ToLower(extLower, ext);
+  const bool isJPG = (strstr(extLower, "jpg") != nullptr) || (strstr(extLower, "jpeg") != nullptr);
+  LICE_IBitmap* pBitmap = isJPG ? LICE_LoadJPG(fileNameOrResID, new LICE_MemBitmap) : LICE_LoadPNG(fileNameOrResID, new LICE_MemBitmap);
+
+  assert(pBitmap && "Unable to load file at path");
+
+  if (!pBitmap)
+    return nullptr;
+
+  PremultiplyBitmap(pBitmap);
+  return new Bitmap(pBitmap, scale);
+}
+
+APIBitmap* IGraphicsLice::LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale)
+{
+  // JPEG data starts with an SOI marker
+  const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+  const bool isJPG = dataSize > 2 && pBytes[0] == 0xFF && pBytes[1] == 0xD8;
+  LICE_IBitmap* pBitmap = isJPG ? LICE_LoadJPGFromMemory(pData, dataSize, new LICE_MemBitmap)
+                                : LICE_LoadPNGFromMemory(pData, dataSize, new LICE_MemBitmap);
+
+  if (!pBitmap)
+    return nullptr;
+
+  PremultiplyBitmap(pBitmap);
+  return new Bitmap(pBitmap, scale);
+}
+
+APIBitmap* IGraphicsLice::CreateAPIBitmap(int width, int height, float scale, double drawScale, bool cacheable)
+{
+  return new Bitmap(width, height, scale, static_cast<float>(drawScale));
+}
+
+void IGraphicsLice::DrawResize()
+{
+  const int w = static_cast<int>(std::ceil(static_cast<float>(WindowWidth()) * GetScreenScale()));
+  const int h = static_cast<int>(std::ceil(static_cast<float>(WindowHeight()) * GetScreenScale()));
+
+  if (!mDrawBitmap)
+    mDrawBitmap = std::make_unique<LICE_MemBitmap>(w, h);
+  else
+    mDrawBitmap->resize(w, h);
+
+  memset(mDrawBitmap->getBits(), 0, mDrawBitmap->getRowSpan() * h * sizeof(LICE_pixel));
+  UpdateLayer();
+}
+
+bool IGraphicsLice::WriteDrawBitmapPNG(const char* path) const
+{
+  if (!mDrawBitmap)
+    return false;
+
+  const int w = mDrawBitmap->getWidth();
+  const int h = mDrawBitmap->getHeight();
+  std::vector<uint8_t> pixels(static_cast<size_t>(w) * h * 4);
+
+  for (int y = 0; y < h; y++)
+  {
+    const LICE_pixel* pSrc = mDrawBitmap->getBits() + y * mDrawBitmap->getRowSpan();
+    uint8_t* pDst = pixels.data() + static_cast<size_t>(y) * w * 4;
+
+    for (int x = 0; x < w; x++, pDst += 4)
+    {
+      const IColor c = UnpremultipliedColor(pSrc[x]);
+      pDst[0] = static_cast<uint8_t>(c.R);
+      pDst[1] = static_cast<uint8_t>(c.G);
+      pDst[2] = static_cast<uint8_t>(c.B);
+      pDst[3] = static_cast<uint8_t>(c.A);
+    }
+  }
+
+  return stbi_write_png(path, w, h, 4, pixels.data(), w * 4) != 0;
+}
+
+void IGraphicsLice::UpdateLayer()
+{
+  mRenderBitmap = mLayers.empty() ? mDrawBitmap.get() : mLayers.top()->GetAPIBitmap()->GetBitmap();
+}
+
+void IGraphicsLice::PathTransformSetMatrix(const IMatrix& m)
+{
+  double xTranslate = 0.0;
+  double yTranslate = 0.0;
+
+  if (!mLayers.empty())
+  {
+    IRECT bounds = mLayers.top()->Bounds();
+
+    xTranslate = -bounds.L;
+    yTranslate = -bounds.T;
+  }
+
+  const double scale = GetTotalScale();
+  mClipMatrix = IMatrix(scale, 0.0, 0.0, scale, xTranslate * scale, yTranslate * scale);
+  mFinalMatrix = IMatrix(mClipMatrix).Transform(m);
+}
+
+void IGraphicsLice::SetClipRegion(const IRECT& r)
+{
+  if (!mRenderBitmap)
+    return;
+
+  double l = r.L, t = r.T, rr = r.R, b = r.B;
+  mClipMatrix.TransformPoint(l, t);
+  mClipMatrix.TransformPoint(rr, b);
+
+  mClipL = Clip(static_cast<int>(std::lround(l)), 0, mRenderBitmap->getWidth());
+  mClipT = Clip(static_cast<int>(std::lround(t)), 0, mRenderBitmap->getHeight());
+  mClipR = Clip(static_cast<int>(std::lround(rr)), mClipL, mRenderBitmap->getWidth());
+  mClipB = Clip(static_cast<int>(std::lround(b)), mClipT, mRenderBitmap->getHeight());
+}
+
+float IGraphicsLice::GetDeviceScale() const
+{
+  return static_cast<float>(std::sqrt(std::fabs(mFinalMatrix.mXX * mFinalMatrix.mYY - mFinalMatrix.mXY * mFinalMatrix.mYX)));
+}
+
+#pragma mark - Paths
+
+void IGraphicsLice::PathClear()
+{
+  mPath.Clear();
+  mPathHasCurrentPoint = false;
+}
+
+void IGraphicsLice::PathClose()
+{
+  if (!mPath.mContours.empty())
+    mPath.mContours.back().mClosed = true;
+}
+
+void IGraphicsLice::AddDevicePoint(float x, float y, bool newContour)
+{
+  std::vector<PathContour>& contours = mPath.mContours;
+
+  if (!newContour && !contours.empty() && contours.back().mClosed)
+  {
+    // Drawing continues from the start of a closed contour
+    const PathPoint start = mPath.mPoints[contours.back().mStart];
+    contours.push_back({static_cast<int>(mPath.mPoints.size()), 1, false});
+    mPath.mPoints.push_back(start);
+  }
+  else if (newContour || contours.empty())
+  {
+    contours.push_back({static_cast<int>(mPath.mPoints.size()), 0, false});
+  }
+
+  mPath.mPoints.push_back({x, y});
+  contours.back().mCount++;
+}
+
+void IGraphicsLice::PathMoveTo(float x, float y)
+{
+  double dx, dy;
+  mFinalMatrix.TransformPoint(dx, dy, x, y);
+  AddDevicePoint(static_cast<float>(dx), static_cast<float>(dy), true);
+  mPathHasCurrentPoint = true;
+}
+
+void IGraphicsLice::PathLineTo(float x, float y)
+{
+  double dx, dy;
+  mFinalMatrix.TransformPoint(dx, dy, x, y);
+  AddDevicePoint(static_cast<float>(dx), static_cast<float>(dy), !mPathHasCurrentPoint);
+  mPathHasCurrentPoint = true;
+}
+
+IGraphicsLice::PathPoint IGraphicsLice::GetCurrentDevicePoint() const
+{
+  const PathContour& contour = mPath.mContours.back();
+  return contour.mClosed ? mPath.mPoints[contour.mStart] : mPath.mPoints.back();
+}
+
+void IGraphicsLice::AddDeviceCubic(PathPoint p0, PathPoint p1, PathPoint p2, PathPoint p3)
+{
+  // The flattening error of n uniform steps is at most 3/4 of the largest second difference over n squared
+  constexpr float kTolerance = 0.2f;
+  const float ddx = std::max(std::fabs(p0.x - 2.f * p1.x + p2.x), std::fabs(p1.x - 2.f * p2.x + p3.x));
+  const float ddy = std::max(std::fabs(p0.y - 2.f * p1.y + p2.y), std::fabs(p1.y - 2.f * p2.y + p3.y));
+  const float dd = std::sqrt(ddx * ddx + ddy * ddy);
+  const int n = Clip(static_cast<int>(std::ceil(std::sqrt(0.75f * dd / kTolerance))), 1, 256);
+
+  for (int i = 1; i <= n; i++)
+  {
+    const float t = static_cast<float>(i) / n;
+    const float u = 1.f - t;
+    const float b0 = u * u * u, b1 = 3.f * u * u * t, b2 = 3.f * u * t * t, b3 = t * t * t;
+    AddDevicePoint(b0 * p0.x + b1 * p1.x + b2 * p2.x + b3 * p3.x, b0 * p0.y + b1 * p1.y + b2 * p2.y + b3 * p3.y, false);
+  }
+}
+
+void IGraphicsLice::PathCubicBezierTo(float c1x, float c1y, float c2x, float c2y, float x2, float y2)
+{
+  if (!mPathHasCurrentPoint)
+    PathMoveTo(c1x, c1y);
+
+  auto transform = [this](float x, float y) {
+    double dx, dy;
+    mFinalMatrix.TransformPoint(dx, dy, x, y);
+    return PathPoint{static_cast<float>(dx), static_cast<float>(dy)};
+  };
+
+  AddDeviceCubic(GetCurrentDevicePoint(), transform(c1x, c1y), transform(c2x, c2y), transform(x2, y2));
+}
+
+void IGraphicsLice::PathQuadraticBezierTo(float cx, float cy, float x2, float y2)
+{
+  if (!mPathHasCurrentPoint)
+    PathMoveTo(cx, cy);
+
+  auto transform = [this](float x, float y) {
+    double dx, dy;
+    mFinalMatrix.TransformPoint(dx, dy, x, y);
+    return PathPoint{static_cast<float>(dx), static_cast<float>(dy)};
+  };
+
+  // Elevated to a cubic, which is exact
+  const PathPoint p0 = GetCurrentDevicePoint();
+  const PathPoint c = transform(cx, cy);
+  const PathPoint p3 = transform(x2, y2);
+  const PathPoint p1 = {p0.x + 2.f / 3.f * (c.x - p0.x), p0.y + 2.f / 3.f * (c.y - p0.y)};
+  const PathPoint p2 = {p3.x + 2.f / 3.f * (c.x - p3.x), p3.y + 2.f / 3.f * (c.y - p3.y)};
+  AddDeviceCubic(p0, p1, p2, p3);
+}
+
+void IGraphicsLice::PathArc(float cx, float cy, float r, float a1, float a2, EWinding winding)
+{
+  float sweep = (a2 - a1);
+  const bool fullCircle = sweep >= 360.f || sweep <= -360.f;
+
+  if (fullCircle)
+    sweep = 360.f;
+  else if (winding == EWinding::CW)
+  {
+    while (sweep < 0)
+      sweep += 360.f;
+  }
+  else
+  {
+    while (sweep > 0)
+      sweep -= 360.f;
+  }
+
+  // Enough steps that the chords stay within a fraction of a pixel of the arc
+  const float deviceRadius = std::max(r * GetDeviceScale(), 0.5f);
+  const float maxStep = 2.f * std::acos(std::max(0.f, 1.f - 0.2f / deviceRadius));
+  const int n = Clip(static_cast<int>(std::ceil(DegToRad(std::fabs(sweep)) / std::max(maxStep, 0.01f))), 1, 1024);
+
+  for (int i = 0; i <= n; i++)
+  {
+    if (fullCircle && i == n)
+      break;
+
+    const float angle = DegToRad(a1 + sweep * i / n);
+    double x, y;
+    mFinalMatrix.TransformPoint(x, y, cx + r * std::sin(angle), cy - r * std::cos(angle));
+    AddDevicePoint(static_cast<float>(x), static_cast<float>(y), i == 0 && (fullCircle || !mPathHasCurrentPoint));
+  }
+
+  if (fullCircle)
+    PathClose();
+
+  mPathHasCurrentPoint = true;
+}
+
+#pragma mark - Stroking
+
+namespace
+{
+  struct Vec2
+  {
+    float x, y;
+  };
+
+  inline float Cross(Vec2 a, Vec2 b) { return a.x * b.y - a.y * b.x; }
+
+  /** Adds a polygon with positive orientation, so that overlapping parts of a stroke never cancel with the nonzero rule */
+  template <class Rasterizer, class Point>
+  void AddOriented(Rasterizer& rasterizer, Point* pPoints, int n)
+  {
+    float area = 0.f;
+
+    for (int i = 0; i < n; i++)
+    {
+      const Point& a = pPoints[i];
+      const Point& b = pPoints[(i + 1) % n];
+      area += a.x * b.y - b.x * a.y;
+    }
+
+    if (area < 0.f)
+      std::reverse(pPoints, pPoints + n);
+
+    rasterizer.AddPolygon(pPoints, n);
+  }
+}
+
+void IGraphicsLice::StrokeToRasterizer(float width, const IStrokeOptions& options)
+{
+  const float scale = GetDeviceScale();
+  const float hw = 0.5f * width * scale;
+
+  if (hw <= 0.f)
+    return;
+
+  const Path* pPath = &mPath;
+
+  // Dashes are cut from the flattened path in device space
+  if (options.mDash.GetCount())
+  {
+    const int dashCount = options.mDash.GetCount();
+    const int dashMax = dashCount & 1 ? dashCount * 2 : dashCount;
+    std::vector<float> dashes(dashMax);
+    float dashTotal = 0.f;
+
+    for (int i = 0; i < dashMax; i++)
+    {
+      dashes[i] = std::max(0.f, options.mDash.GetArray()[i % dashCount] * scale);
+      dashTotal += dashes[i];
+    }
+
+    if (dashTotal > 0.f)
+    {
+      mDashPath.Clear();
+
+      for (const PathContour& contour : mPath.mContours)
+      {
+        const int nSegments = contour.mClosed ? contour.mCount : contour.mCount - 1;
+        int dashIdx = 0;
+        float dashRemaining = dashes[0];
+        float offset = std::fmod(options.mDash.GetOffset() * scale, dashTotal);
+
+        if (offset < 0.f)
+          offset += dashTotal;
+
+        while (offset > 0.f)
+        {
+          if (offset >= dashRemaining)
+          {
+            offset -= dashRemaining;
+            dashIdx = (dashIdx + 1) % dashMax;
+            dashRemaining = dashes[dashIdx];
+          }
+          else
+          {
+            dashRemaining -= offset;
+            offset = 0.f;
+          }
+        }
+
+        bool inDash = false;
+
+        for (int s = 0; s < nSegments; s++)
+        {
+          PathPoint a = mPath.mPoints[contour.mStart + s];
+          const PathPoint b = mPath.mPoints[contour.mStart + (s + 1) % contour.mCount];
+          float length = std::hypot(b.x - a.x, b.y - a.y);
+
+          while (length > 0.f)
+          {
+            const bool on = !(dashIdx & 1);
+
+            if (on && !inDash)
+            {
+              mDashPath.mContours.push_back({static_cast<int>(mDashPath.mPoints.size()), 1, false});
+              mDashPath.mPoints.push_back(a);
+              inDash = true;
+            }
+
+            const float step = std::min(dashRemaining, length);
+            const float f = step / length;
+            a = {a.x + f * (b.x - a.x), a.y + f * (b.y - a.y)};
+            length -= step;
+            dashRemaining -= step;
+
+            if (on)
+            {
+              mDashPath.mPoints.push_back(a);
+              mDashPath.mContours.back().mCount++;
+            }
+
+            if (dashRemaining <= 0.f)
+            {
+              inDash = false;
+              dashIdx = (dashIdx + 1) % dashMax;
+              dashRemaining = dashes[dashIdx];
+            }
+          }
+        }
+      }
+
+      pPath = &mDashPath;
+    }
+  }
+
+  const int circleSteps = Clip(static_cast<int>(std::ceil(PI / std::acos(std::max(0.f, 1.f - 0.2f / std::max(hw, 0.5f))))), 8, 256);
+  std::vector<PathPoint> poly;
+
+  auto addCircle = [&](PathPoint c) {
+    poly.resize(circleSteps);
+
+    for (int i = 0; i < circleSteps; i++)
+    {
+      const float angle = 2.f * PI * i / circleSteps;
+      poly[i] = {c.x + hw * std::cos(angle), c.y + hw * std::sin(angle)};
+    }
+
+    AddOriented(*mRasterizer, poly.data(), circleSteps);
+  };
+
+  std::vector<PathPoint> points;
+
+  for (const PathContour& contour : pPath->mContours)
+  {
+    // Coincident points have no direction, so they are removed first
+    points.clear();
+
+    for (int i = 0; i < contour.mCount; i++)
+    {
+      const PathPoint& p = pPath->mPoints[contour.mStart + i];
+
+      if (points.empty() || p.x != points.back().x || p.y != points.back().y)
+        points.push_back(p);
+    }
+
+    bool closed = contour.mClosed;
+
+    if (closed && points.size() > 1 && points.front().x == points.back().x && points.front().y == points.back().y)
+      points.pop_back();
+
+    const int n = static_cast<int>(points.size());
+
+    if (n == 1)
+    {
+      if (!closed && options.mCapOption == ELineCap::Round)
+        addCircle(points[0]);
+      else if (!closed && options.mCapOption == ELineCap::Square)
+      {
+        const PathPoint& p = points[0];
+        PathPoint square[4] = {{p.x - hw, p.y - hw}, {p.x + hw, p.y - hw}, {p.x + hw, p.y + hw}, {p.x - hw, p.y + hw}};
+        AddOriented(*mRasterizer, square, 4);
+      }
+
+      continue;
+    }
+
+    if (n < 2)
+      continue;
+
+    closed = closed && n > 2;
+    const int nSegments = closed ? n : n - 1;
+
+    auto direction = [&](int s) {
+      const PathPoint& a = points[s];
+      const PathPoint& b = points[(s + 1) % n];
+      const float length = std::hypot(b.x - a.x, b.y - a.y);
+      return Vec2{(b.x - a.x) / length, (b.y - a.y) / length};
+    };
+
+    for (int s = 0; s < nSegments; s++)
+    {
+      const Vec2 d = direction(s);
+      const Vec2 normal = {-d.y * hw, d.x * hw};
+      PathPoint a = points[s];
+      PathPoint b = points[(s + 1) % n];
+
+      if (!closed && options.mCapOption == ELineCap::Square)
+      {
+        if (s == 0)
+          a = {a.x - d.x * hw, a.y - d.y * hw};
+
+        if (s == nSegments - 1)
+          b = {b.x + d.x * hw, b.y + d.y * hw};
+      }
+
+      PathPoint quad[4] = {{a.x + normal.x, a.y + normal.y}, {b.x + normal.x, b.y + normal.y},
+                           {b.x - normal.x, b.y - normal.y}, {a.x - normal.x, a.y - normal.y}};
+      AddOriented(*mRasterizer, quad, 4);
+    }
+
+    // Joins, at every vertex of a closed contour and the inner vertices of an open one
+    const int firstJoin = closed ? 0 : 1;
+    const int lastJoin = closed ? n : n - 1;
+
+    for (int v = firstJoin; v < lastJoin; v++)
+    {
+      const Vec2 d0 = direction((v + n - 1) % n);
+      const Vec2 d1 = direction(v);
+      const float cross = Cross(d0, d1);
+      const float dot = d0.x * d1.x + d0.y * d1.y;
+
+      if (std::fabs(cross) < 1e-6f && dot > 0.f)
+        continue;
+
+      const PathPoint& p = points[v];
+
+      if (options.mJoinOption == ELineJoin::Round)
+      {
+        addCircle(p);
+        continue;
+      }
+
+      // The outer side of the turn
+      const float side = cross > 0.f ? -1.f : 1.f;
+      const Vec2 n0 = {-d0.y * side, d0.x * side};
+      const Vec2 n1 = {-d1.y * side, d1.x * side};
+      const PathPoint e0 = {p.x + n0.x * hw, p.y + n0.y * hw};
+      const PathPoint e1 = {p.x + n1.x * hw, p.y + n1.y * hw};
+      const float miterDenominator = 1.f + n0.x * n1.x + n0.y * n1.y;
+
+      if (options.mJoinOption == ELineJoin::Miter && miterDenominator > 1e-6f)
+      {
+        const Vec2 miter = {(n0.x + n1.x) / miterDenominator, (n0.y + n1.y) / miterDenominator};
+
+        if (std::hypot(miter.x, miter.y) <= options.mMiterLimit)
+        {
+          PathPoint quad[4] = {p, e0, {p.x + miter.x * hw, p.y + miter.y * hw}, e1};
+          AddOriented(*mRasterizer, quad, 4);
+          continue;
+        }
+      }
+
+      PathPoint triangle[3] = {p, e0, e1};
+      AddOriented(*mRasterizer, triangle, 3);
+    }
+
+    if (!closed && options.mCapOption == ELineCap::Round)
+    {
+      addCircle(points.front());
+      addCircle(points.back());
+    }
+  }
+}
+
+void IGraphicsLice::FillRasterizer(const IPattern& pattern, const IBlend* pBlend, EFillRule rule)
+{
+  IMatrix deviceToUser = mFinalMatrix;
+  deviceToUser.Invert();
+
+  const PatternShader shader(pattern, deviceToUser, BlendWeight(pBlend));
+  mRasterizer->Render(mRenderBitmap, shader, pBlend ? pBlend->mMethod : EBlend::SrcOver, rule == EFillRule::EvenOdd);
+}
+
+void IGraphicsLice::PathStroke(const IPattern& pattern, float thickness, const IStrokeOptions& options, const IBlend* pBlend)
+{
+  if (mRenderBitmap)
+  {
+    mRasterizer->Reset(mClipL, mClipT, mClipR, mClipB);
+    StrokeToRasterizer(thickness, options);
+    FillRasterizer(pattern, pBlend, EFillRule::Winding);
+  }
+
+  if (!options.mPreserve)
+    PathClear();
+}
+
+void IGraphicsLice::PathFill(const IPattern& pattern, const IFillOptions& options, const IBlend* pBlend)
+{
+  if (mRenderBitmap)
+  {
+    mRasterizer->Reset(mClipL, mClipT, mClipR, mClipB);
+
+    for (const PathContour& contour : mPath.mContours)
+      mRasterizer->AddPolygon(mPath.mPoints.data() + contour.mStart, contour.mCount);
+
+    FillRasterizer(pattern, pBlend, options.mFillRule);
+  }
+
+  if (!options.mPreserve)
+    PathClear();
+}
+
+#pragma mark - Bitmaps and shadows
+
+void IGraphicsLice::DrawBitmap(const IBitmap& bitmap, const IRECT& dest, int srcX, int srcY, const IBlend* pBlend)
+{
+  if (!mRenderBitmap)
+    return;
+
+  LICE_IBitmap* pSource = bitmap.GetAPIBitmap()->GetBitmap();
+  const double scale = bitmap.GetScale() * bitmap.GetDrawScale();
+
+  // The part of dest that the bitmap covers, in user space
+  const IRECT extent(dest.L - srcX, dest.T - srcY, static_cast<float>(dest.L - srcX + pSource->getWidth() / scale),
+                     static_cast<float>(dest.T - srcY + pSource->getHeight() / scale));
+  const IRECT area = dest.Intersect(extent);
+
+  if (area.Empty())
+    return;
+
+  // Device pixels to user space, then to bitmap pixels
+  IMatrix deviceToUser = mFinalMatrix;
+  deviceToUser.Invert();
+  const IMatrix userToBitmap(scale, 0.0, 0.0, scale, (srcX - dest.L) * scale, (srcY - dest.T) * scale);
+  IMatrix deviceToBitmap = Concat(deviceToUser, userToBitmap);
+
+  // Rounding errors from inverting an exact translation would defeat the unfiltered copy
+  auto snap = [](double& v) { if (std::fabs(v - std::round(v)) < 1e-6) v = std::round(v); };
+  snap(deviceToBitmap.mXX);
+  snap(deviceToBitmap.mYY);
+  snap(deviceToBitmap.mXY);
+  snap(deviceToBitmap.mYX);
+  snap(deviceToBitmap.mTX);
+  snap(deviceToBitmap.mTY);
+
+  mRasterizer->Reset(mClipL, mClipT, mClipR, mClipB);
+  PathPoint corners[4];
+  const float xs[4] = {area.L, area.R, area.R, area.L};
+  const float ys[4] = {area.T, area.T, area.B, area.B};
+
+  for (int i = 0; i < 4; i++)
+  {
+    double x, y;
+    mFinalMatrix.TransformPoint(x, y, xs[i], ys[i]);
+    corners[i] = {static_cast<float>(x), static_cast<float>(y)};
+  }
+
+  mRasterizer->AddPolygon(corners, 4);
+
+  const BitmapShader shader(pSource, deviceToBitmap, BlendWeight(pBlend));
+  mRasterizer->Render(mRenderBitmap, shader, pBlend ? pBlend->mMethod : EBlend::SrcOver, false);
+}
+
+void IGraphicsLice::DrawFastDropShadow(const IRECT& innerBounds, const IRECT& outerBounds, float xyDrop, float roundness, float blur, IBlend* pBlend)
+{
+  if (!mRenderBitmap)
+    return;
+
+  // A solid rounded rectangle with a Gaussian falloff outside it, as a distance field in device space
+  const float scale = GetDeviceScale();
+  const IRECT r = innerBounds.GetTranslated(xyDrop, xyDrop);
+  double l = r.L, t = r.T, rr = r.R, b = r.B;
+  mFinalMatrix.TransformPoint(l, t);
+  mFinalMatrix.TransformPoint(rr, b);
+
+  const float sigma = std::max(0.5f * blur * scale, 1e-3f); // 0.5 matches the other backends
+  const float radius = std::min(roundness * scale, 0.5f * static_cast<float>(std::min(std::fabs(rr - l), std::fabs(b - t))));
+  const float cx = static_cast<float>(0.5 * (l + rr)), cy = static_cast<float>(0.5 * (t + b));
+  const float hx = static_cast<float>(0.5 * std::fabs(rr - l)) - radius, hy = static_cast<float>(0.5 * std::fabs(b - t)) - radius;
+  const float extent = 3.f * sigma;
+
+  const int x0 = std::max(mClipL, static_cast<int>(std::floor(cx - hx - radius - extent)));
+  const int x1 = std::min(mClipR, static_cast<int>(std::ceil(cx + hx + radius + extent)));
+  const int y0 = std::max(mClipT, static_cast<int>(std::floor(cy - hy - radius - extent)));
+  const int y1 = std::min(mClipB, static_cast<int>(std::ceil(cy + hy + radius + extent)));
+
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  const int n = x1 - x0;
+  std::vector<float> coverage(n);
+  std::vector<LICE_pixel> source(n, PremultipliedPixel(COLOR_BLACK_DROP_SHADOW, BlendWeight(pBlend)));
+
+  for (int y = y0; y < y1; y++)
+  {
+    for (int x = x0; x < x1; x++)
+    {
+      const float qx = std::max(std::fabs(x + 0.5f - cx) - hx, 0.f);
+      const float qy = std::max(std::fabs(y + 0.5f - cy) - hy, 0.f);
+      const float distance = std::sqrt(qx * qx + qy * qy) - radius;
+      const float edge = Clip(0.5f - distance, 0.f, 1.f);
+      const float falloff = 0.5f * std::erfc(std::max(distance, 0.f) / (sigma * std::sqrt(2.f)));
+      coverage[x - x0] = std::max(edge, falloff);
+    }
+
+    BlendSpan(mRenderBitmap->getBits() + y * mRenderBitmap->getRowSpan() + x0, source.data(), coverage.data(), n,
+              pBlend ? pBlend->mMethod : EBlend::SrcOver);
+  }
+}
+
+static size_t CalcRowBytes(int width)
+{
+  width = ((width + 7) & (-8));
+  return width * sizeof(uint32_t);
+}
+
+void IGraphicsLice::GetLayerBitmapData(const ILayerPtr& layer, RawBitmapData& data)
+{
+  LICE_IBitmap* pBitmap = layer->GetAPIBitmap()->GetBitmap();
+  const size_t rowBytes = CalcRowBytes(pBitmap->getWidth());
+  const int size = pBitmap->getHeight() * static_cast<int>(rowBytes);
+
+  data.Resize(size);
+
+  if (data.GetSize() >= size)
+  {
+    for (int y = 0; y < pBitmap->getHeight(); y++)
+      memcpy(data.Get() + y * rowBytes, pBitmap->getBits() + y * pBitmap->getRowSpan(), pBitmap->getWidth() * sizeof(LICE_pixel));
+  }
+}
+
+void IGraphicsLice::ApplyShadowMask(ILayerPtr& layer, RawBitmapData& mask, const IShadow& shadow)
+{
+  LICE_IBitmap* pBitmap = layer->GetAPIBitmap()->GetBitmap();
+  const int width = pBitmap->getWidth();
+  const int height = pBitmap->getHeight();
+  const size_t rowBytes = CalcRowBytes(width);
+  const double scale = layer->GetAPIBitmap()->GetDrawScale() * layer->GetAPIBitmap()->GetScale();
+  const int xOffset = static_cast<int>(std::lround(shadow.mXOffset * scale));
+  const int yOffset = static_cast<int>(std::lround(shadow.mYOffset * scale));
+
+  // The pattern is in the user space of the layer
+  const IMatrix deviceToUser(1.0 / scale, 0.0, 0.0, 1.0 / scale, layer->Bounds().L, layer->Bounds().T);
+  const PatternShader shader(shadow.mPattern, deviceToUser, shadow.mOpacity);
+  std::vector<LICE_pixel> row(width);
+
+  for (int y = 0; y < height; y++)
+  {
+    LICE_pixel* pRow = pBitmap->getBits() + y * pBitmap->getRowSpan();
+    const int maskY = y - yOffset;
+    shader.Shade(0, y, width, row.data());
+
+    for (int x = 0; x < width; x++)
+    {
+      const int maskX = x - xOffset;
+      uint32_t maskAlpha = 0;
+
+      if (maskX >= 0 && maskX < width && maskY >= 0 && maskY < height)
+        maskAlpha = mask.Get()[maskY * rowBytes + maskX * sizeof(LICE_pixel) + AlphaChannel()];
+
+      const LICE_pixel shadowPixel = ScalePixel(row[x], maskAlpha + (maskAlpha >> 7));
+
+      if (shadow.mDrawForeground)
+        pRow[x] = pRow[x] + ScalePixel(shadowPixel, 256 - LICE_GETA(pRow[x]));
+      else
+        pRow[x] = shadowPixel;
+    }
+  }
+}
+
+IColor IGraphicsLice::GetPoint(int x, int y)
+{
+  if (!mRenderBitmap || x < 0 || y < 0 || x >= mRenderBitmap->getWidth() || y >= mRenderBitmap->getHeight())
+    return COLOR_TRANSPARENT;
+
+  return UnpremultipliedColor(mRenderBitmap->getBits()[y * mRenderBitmap->getRowSpan() + x]);
+}
+
+#pragma mark - Text
+
+bool IGraphicsLice::LoadAPIFont(const char* fontID, const PlatformFontPtr& font)
+{
+  StaticStorage<Font>::Accessor storage(sFontCache);
+  Font* cached = storage.Find(fontID);
+
+  if (cached)
+    return true;
+
+  IFontDataPtr data = font->GetFontData();
+
+  if (data->IsValid())
+  {
+    std::unique_ptr<Font> pFont = std::make_unique<Font>(std::move(data));
+
+    if (pFont->mValid)
+    {
+      storage.Add(pFont.release(), fontID);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const IGraphicsLice::Font* IGraphicsLice::FindFont(const char* fontID) const
+{
+  // Fonts are never removed from sFontCache while this instance retains it, so the pointers can be kept without locking
+  auto it = mFontLookup.find(fontID);
+
+  if (it != mFontLookup.end())
+    return it->second;
+
+  const Font* pFont = sFontCache.FindShared(fontID);
+
+  if (pFont)
+    mFontLookup.emplace(fontID, pFont);
+
+  return pFont;
+}
+
+const IGraphicsLice::TextLayout& IGraphicsLice::PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double& y) const
+{
+  const TextLayout* pLayout = mTextLayoutCache.Find(text.mFont, text.mSize, static_cast<int>(text.mAlign), static_cast<int>(text.mVAlign), str);
+
+  if (!pLayout)
+  {
+    const Font* pFont = FindFont(text.mFont);
+
+    assert(pFont && "No font found - did you forget to load it?");
+
+    TextLayout layout;
+
+    if (pFont)
+    {
+      const stbtt_fontinfo* pInfo = &pFont->mInfo;
+      int ascent, descent, lineGap;
+      stbtt_GetFontVMetrics(pInfo, &ascent, &descent, &lineGap);
+
+      layout.mFont = pFont;
+      layout.mScale = stbtt_ScaleForMappingEmToPixels(pInfo, static_cast<float>(text.mSize * pFont->mData->GetHeightEMRatio()));
+      layout.mAscender = -ascent * layout.mScale;
+      layout.mDescender = -descent * layout.mScale;
+
+      double penX = 0.0;
+      int prevGlyph = 0;
+
+      for (const char* pChar = str; *pChar;)
+      {
+        int codepoint;
+        pChar += std::max(1, wdl_utf8_parsechar(pChar, &codepoint));
+        const int glyph = stbtt_FindGlyphIndex(pInfo, codepoint);
+        int advance, leftSideBearing;
+        stbtt_GetGlyphHMetrics(pInfo, glyph, &advance, &leftSideBearing);
+
+        if (prevGlyph)
+          penX += stbtt_GetGlyphKernAdvance(pInfo, prevGlyph, glyph) * layout.mScale;
+
+        layout.mGlyphs.push_back(glyph);
+        layout.mXPositions.push_back(static_cast<float>(penX));
+        penX += advance * layout.mScale;
+        prevGlyph = glyph;
+      }
+
+      layout.mWidth = penX;
+    }
+
+    pLayout = mTextLayoutCache.Add(std::move(layout));
+  }
+
+  const double textWidth = pLayout->mWidth;
+  const double textHeight = text.mSize;
+  const double ascender = pLayout->mAscender;
+  const double descender = pLayout->mDescender;
+
+  switch (text.mAlign)
+  {
+    case EAlign::Near:     x = r.L;                          break;
+    case EAlign::Center:   x = r.MW() - (textWidth / 2.0);   break;
+    case EAlign::Far:      x = r.R - textWidth;              break;
+  }
+
+  switch (text.mVAlign)
+  {
+    case EVAlign::Top:      y = r.T - ascender;                            break;
+    case EVAlign::Middle:   y = r.MH() - descender + (textHeight / 2.0);   break;
+    case EVAlign::Bottom:   y = r.B - descender;                           break;
+  }
+
+  r = IRECT((float) x, (float) (y + ascender), (float) (x + textWidth), (float) (y + ascender + textHeight));
+
+  return *pLayout;
+}
+
+float IGraphicsLice::DoMeasureText(const IText& text, const char* str, IRECT& bounds) const
+{
+  IRECT r = bounds;
+  double x, y;
+  PrepareAndMeasureText(text, str, bounds, x, y);
+  DoMeasureTextRotation(text, r, bounds);
+  return bounds.W();
+}
+
+void IGraphicsLice::DoDrawText(const IText& text, const char* str, const IRECT& bounds, const IBlend* pBlend)
+{
+  IRECT measured = bounds;
+  double x, y;
+
+  const TextLayout& layout = PrepareAndMeasureText(text, str, measured, x, y);
+
+  if (layout.mGlyphs.empty() || !mRenderBitmap)
+    return;
+
+  PathTransformSave();
+  DoTextRotation(text, bounds, measured);
+
+  // The glyph outlines are built in a separate path, so that the current path is kept
+  std::swap(mPath, mTextPath);
+  const bool hadCurrentPoint = mPathHasCurrentPoint;
+  PathClear();
+
+  const stbtt_fontinfo* pInfo = &layout.mFont->mInfo;
+  const float s = static_cast<float>(layout.mScale);
+
+  for (size_t i = 0; i < layout.mGlyphs.size(); i++)
+  {
+    stbtt_vertex* pVertices = nullptr;
+    const int nVertices = stbtt_GetGlyphShape(pInfo, layout.mGlyphs[i], &pVertices);
+    const float originX = static_cast<float>(x + layout.mXPositions[i]);
+    const float originY = static_cast<float>(y);
+
+    for (int v = 0; v < nVertices; v++)
+    {
+      const stbtt_vertex& vertex = pVertices[v];
+      const float px = originX + vertex.x * s;
+      const float py = originY - vertex.y * s;
+
+      switch (vertex.type)
+      {
+        case STBTT_vmove:   PathMoveTo(px, py);   break;
+        case STBTT_vline:   PathLineTo(px, py);   break;
+        case STBTT_vcurve:  PathQuadraticBezierTo(originX + vertex.cx * s, originY - vertex.cy * s, px, py);   break;
+      }
+    }
+
+    stbtt_FreeShape(pInfo, pVertices);
+  }
+
+  mRasterizer->Reset(mClipL, mClipT, mClipR, mClipB);
+
+  for (const PathContour& contour : mPath.mContours)
+    mRasterizer->AddPolygon(mPath.mPoints.data() + contour.mStart, contour.mCount);
+
+  FillRasterizer(IPattern(text.mFGColor), pBlend, EFillRule::Winding);
+
+  std::swap(mPath, mTextPath);
+  mPathHasCurrentPoint = hadCurrentPoint;
+  PathTransformRestore();
+}
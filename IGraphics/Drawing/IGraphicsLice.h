@@ -0,0 +1,169 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+#include "IPlugPlatform.h"
+#include "IGraphics.h"
+
+#ifndef WDL_NO_DEFINE_MINMAX
+  #define WDL_NO_DEFINE_MINMAX // swell-types.h would otherwise define min and max macros
+#endif
+#include "lice/lice.h"
+
+#include <memory>
+#include <vector>
+
+BEGIN_IPLUG_NAMESPACE
+BEGIN_IGRAPHICS_NAMESPACE
+
+/** IGraphics draw class that renders on the CPU into LICE bitmaps, so it needs no window, GL or Metal context.
+ * Paths are flattened in device space and filled with a scanline rasterizer that computes the exact area coverage of each pixel.
+ * Strokes and text (from the font outlines, via stb_truetype) are converted to filled paths. Pixels are stored with premultiplied alpha
+ *   @ingroup DrawClasses */
+class IGraphicsLice : public IGraphics
+{
+private:
+  class Bitmap;
+  class Rasterizer;
+  struct Font;
+
+public:
+  IGraphicsLice(IGEditorDelegate& dlg, int w, int h, int fps, float scale);
+  ~IGraphicsLice();
+
+  const char* GetDrawingAPIStr() override { return "LICE | CPU"; }
+
+  void DrawResize() override;
+
+  void DrawBitmap(const IBitmap& bitmap, const IRECT& dest, int srcX, int srcY, const IBlend* pBlend) override;
+  void DrawFastDropShadow(const IRECT& innerBounds, const IRECT& outerBounds, float xyDrop, float roundness, float blur, IBlend* pBlend) override;
+
+  void PathClear() override;
+  void PathClose() override;
+  void PathArc(float cx, float cy, float r, float a1, float a2, EWinding winding) override;
+  void PathMoveTo(float x, float y) override;
+  void PathLineTo(float x, float y) override;
+  void PathCubicBezierTo(float c1x, float c1y, float c2x, float c2y, float x2, float y2) override;
+  void PathQuadraticBezierTo(float cx, float cy, float x2, float y2) override;
+  void PathStroke(const IPattern& pattern, float thickness, const IStrokeOptions& options, const IBlend* pBlend) override;
+  void PathFill(const IPattern& pattern, const IFillOptions& options, const IBlend* pBlend) override;
+
+  IColor GetPoint(int x, int y) override;
+  void* GetDrawContext() override { return (void*) mRenderBitmap; }
+
+  /** @return The bitmap of the main draw context, in device pixels with premultiplied alpha */
+  LICE_IBitmap* GetDrawBitmap() const { return mDrawBitmap.get(); }
+
+  /** Writes the main draw context to a PNG file
+   * @param path The path of the file to write
+   * @return \c true on success */
+  bool WriteDrawBitmapPNG(const char* path) const;
+
+  bool BitmapExtSupported(const char* ext) override;
+
+protected:
+  APIBitmap* LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext) override;
+  APIBitmap* LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale) override;
+  APIBitmap* CreateAPIBitmap(int width, int height, float scale, double drawScale, bool cacheable = false) override;
+
+  bool LoadAPIFont(const char* fontID, const PlatformFontPtr& font) override;
+
+  int AlphaChannel() const override { return LICE_PIXEL_A; }
+  bool FlippedBitmap() const override { return false; }
+
+  void GetLayerBitmapData(const ILayerPtr& layer, RawBitmapData& data) override;
+  void ApplyShadowMask(ILayerPtr& layer, RawBitmapData& mask, const IShadow& shadow) override;
+
+  float DoMeasureText(const IText& text, const char* str, IRECT& bounds) const override;
+  void DoDrawText(const IText& text, const char* str, const IRECT& bounds, const IBlend* pBlend) override;
+
+private:
+  struct PathPoint
+  {
+    float x;
+    float y;
+  };
+
+  /** A run of points in mPoints, in device space */
+  struct PathContour
+  {
+    int mStart;
+    int mCount;
+    bool mClosed;
+  };
+
+  struct Path
+  {
+    std::vector<PathPoint> mPoints;
+    std::vector<PathContour> mContours;
+
+    void Clear() { mPoints.clear(); mContours.clear(); }
+  };
+
+  /** The glyphs of a single line of text and their positions, relative to the origin */
+  struct TextLayout
+  {
+    const Font* mFont = nullptr;
+    std::vector<int> mGlyphs;
+    std::vector<float> mXPositions;
+    double mScale = 0.;
+    double mWidth = 0.;
+    double mAscender = 0.;
+    double mDescender = 0.;
+  };
+
+  const TextLayout& PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double& y) const;
+  const Font* FindFont(const char* fontID) const;
+
+  void PathTransformSetMatrix(const IMatrix& m) override;
+  void SetClipRegion(const IRECT& r) override;
+  void UpdateLayer() override;
+
+  /** Adds a point in device space, starting a new contour if needed */
+  void AddDevicePoint(float x, float y, bool newContour);
+
+  /** Flattens a cubic Bezier given in device space */
+  void AddDeviceCubic(PathPoint p0, PathPoint p1, PathPoint p2, PathPoint p3);
+
+  /** @return The point in device space that the next path segment starts from */
+  PathPoint GetCurrentDevicePoint() const;
+
+  /** @return The scale from user space to device space along a path, used for stroke widths and curve tolerances */
+  float GetDeviceScale() const;
+
+  /** Adds the outline of the current path's stroke to the rasterizer */
+  void StrokeToRasterizer(float width, const IStrokeOptions& options);
+
+  /** Composites the rasterizer's coverage onto the render target with a pattern */
+  void FillRasterizer(const IPattern& pattern, const IBlend* pBlend, EFillRule rule);
+
+  std::unique_ptr<LICE_MemBitmap> mDrawBitmap;
+  LICE_IBitmap* mRenderBitmap = nullptr;
+  std::unique_ptr<Rasterizer> mRasterizer;
+
+  Path mPath;
+  Path mTextPath;
+  Path mDashPath;
+  PathPoint mLastUserPoint = {0.f, 0.f};
+  bool mPathHasCurrentPoint = false;
+
+  IMatrix mFinalMatrix; // user space to device pixels
+  IMatrix mClipMatrix;
+  int mClipL = 0, mClipT = 0, mClipR = 0, mClipB = 0;
+
+  mutable TextLayoutCache<TextLayout> mTextLayoutCache;
+  mutable std::unordered_map<std::string, const Font*> mFontLookup; // per instance, avoids locking sFontCache when drawing
+
+  static StaticStorage<Font> sFontCache;
+};
+
+END_IGRAPHICS_NAMESPACE
+END_IPLUG_NAMESPACE
@@ -471,6 +471,7 @@ void IGraphicsNanoVG::OnViewDestroyed()
 
   StaticStorage<APIBitmap>::Accessor storage(mBitmapCache);
   storage.Clear();
+  mTextLayoutCache.Clear(); // font ids belong to the context
   
   if(mMainFrameBuffer != nullptr)
     nvgDeleteFramebuffer(mMainFrameBuffer);
@@ -620,36 +621,74 @@ IColor IGraphicsNanoVG::GetPoint(int x, int y)
   return COLOR_BLACK; //TODO:
 }
 
-void IGraphicsNanoVG::PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y) const
+void IGraphicsNanoVG::SetTextState(const IText& text, const TextLayout& layout) const
 {
-  float fbounds[4];
-  
-  assert(nvgFindFont(mVG, text.mFont) != -1 && "No font found - did you forget to load it?");
-  
   nvgFontBlur(mVG, 0);
   nvgFontSize(mVG, text.mSize);
-  nvgFontFace(mVG, text.mFont);
+  nvgFontFaceId(mVG, layout.mFontId);
+  nvgTextAlign(mVG, layout.mAlign);
+}
+
+void IGraphicsNanoVG::PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y) const
+{
+  // NanoVG measures glyphs at the device resolution, so the layout depends on the current transform scale
+  float xform[6];
+  nvgCurrentTransform(mVG, xform);
+  const float sx = std::sqrt(xform[0] * xform[0] + xform[2] * xform[2]);
+  const float sy = std::sqrt(xform[1] * xform[1] + xform[3] * xform[3]);
+  const float scale = (sx + sy) * 0.5f * GetScreenScale();
   
-  int align = 0;
+  const TextLayout* pLayout = mTextLayoutCache.Find(text.mFont, text.mSize, static_cast<int>(text.mAlign), static_cast<int>(text.mVAlign), str, scale);
+  
+  if (!pLayout)
+  {
+    TextLayout layout;
+    
+    layout.mFontId = nvgFindFont(mVG, text.mFont);
+    
+    assert(layout.mFontId != -1 && "No font found - did you forget to load it?");
+    
+    switch (text.mAlign)
+    {
+      case EAlign::Near:     layout.mAlign = NVG_ALIGN_LEFT;     break;
+      case EAlign::Center:   layout.mAlign = NVG_ALIGN_CENTER;   break;
+      case EAlign::Far:      layout.mAlign = NVG_ALIGN_RIGHT;    break;
+    }
+    
+    switch (text.mVAlign)
+    {
+      case EVAlign::Top:     layout.mAlign |= NVG_ALIGN_TOP;     break;
+      case EVAlign::Middle:  layout.mAlign |= NVG_ALIGN_MIDDLE;  break;
+      case EVAlign::Bottom:  layout.mAlign |= NVG_ALIGN_BOTTOM;  break;
+    }
+    
+    SetTextState(text, layout);
+    // N.B. glyph positions are rounded to device pixels, so bounds measured at the origin can differ from those at (x, y) by up to a device pixel
+    nvgTextBounds(mVG, 0.f, 0.f, str, NULL, layout.mBounds);
+    
+    pLayout = mTextLayoutCache.Add(std::move(layout));
+  }
+  else
+  {
+    SetTextState(text, *pLayout);
+  }
   
   switch (text.mAlign)
   {
-    case EAlign::Near:     align = NVG_ALIGN_LEFT;     x = r.L;        break;
-    case EAlign::Center:   align = NVG_ALIGN_CENTER;   x = r.MW();     break;
-    case EAlign::Far:      align = NVG_ALIGN_RIGHT;    x = r.R;        break;
+    case EAlign::Near:     x = r.L;        break;
+    case EAlign::Center:   x = r.MW();     break;
+    case EAlign::Far:      x = r.R;        break;
   }
   
   switch (text.mVAlign)
   {
-    case EVAlign::Top:     align |= NVG_ALIGN_TOP;     y = r.T;        break;
-    case EVAlign::Middle:  align |= NVG_ALIGN_MIDDLE;  y = r.MH();     break;
-    case EVAlign::Bottom:  align |= NVG_ALIGN_BOTTOM;  y = r.B;        break;
+    case EVAlign::Top:     y = r.T;        break;
+    case EVAlign::Middle:  y = r.MH();     break;
+    case EVAlign::Bottom:  y = r.B;        break;
   }
   
-  nvgTextAlign(mVG, align);
-  nvgTextBounds(mVG, x, y, str, NULL, fbounds);
-  
-  r = IRECT(fbounds[0], fbounds[1], fbounds[2], fbounds[3]);
+  const float* fbounds = pLayout->mBounds;
+  r = IRECT(fbounds[0] + (float) x, fbounds[1] + (float) y, fbounds[2] + (float) x, fbounds[3] + (float) y);
 }
 
 float IGraphicsNanoVG::DoMeasureText(const IText& text, const char* str, IRECT& bounds) const
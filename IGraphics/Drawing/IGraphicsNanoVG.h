@@ -157,6 +157,15 @@ protected:
   void DoDrawText(const IText& text, const char* str, const IRECT& bounds, const IBlend* pBlend) override;
 
 private:
+  /** The font and bounds of a single line of text, measured at the origin */
+  struct TextLayout
+  {
+    int mFontId = -1;
+    int mAlign = 0;
+    float mBounds[4] = {};
+  };
+
+  void SetTextState(const IText& text, const TextLayout& layout) const;
   void PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y) const;
   void PathTransformSetMatrix(const IMatrix& m) override;
   void SetClipRegion(const IRECT& r) override;
@@ -170,6 +179,7 @@ private:
   NVGcontext* mVG = nullptr;
   NVGframebuffer* mMainFrameBuffer = nullptr;
   int mInitialFBO = 0;
+  mutable TextLayoutCache<TextLayout> mTextLayoutCache;
 };
 
 END_IGRAPHICS_NAMESPACE
@@ -684,30 +684,57 @@ bool IGraphicsSkia::LoadAPIFont(const char* fontID, const PlatformFontPtr& font)
   return false;
 }
 
-void IGraphicsSkia::PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y, SkFont& font) const
+const IGraphicsSkia::Font* IGraphicsSkia::FindFont(const char* fontID) const
 {
-  SkFontMetrics metrics;
-  SkPaint paint;
-  //SkRect bounds;
+  // Fonts are never removed from sFontCache while this instance retains it, so the pointers can be kept without locking
+  auto it = mFontLookup.find(fontID);
   
-  StaticStorage<Font>::Accessor storage(sFontCache);
-  Font* pFont = storage.Find(text.mFont);
+  if (it != mFontLookup.end())
+    return it->second;
+  
+  const Font* pFont = sFontCache.FindShared(fontID);
   
-  assert(pFont && "No font found - did you forget to load it?");
+  if (pFont)
+    mFontLookup.emplace(fontID, pFont);
+  
+  return pFont;
+}
 
-  font.setTypeface(pFont->mTypeface);
-  font.setHinting(SkFontHinting::kSlight);
-  font.setForceAutoHinting(false);
-  font.setSubpixel(true);
-  font.setSize(text.mSize * pFont->mData->GetHeightEMRatio());
+const IGraphicsSkia::TextLayout& IGraphicsSkia::PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y) const
+{
+  const TextLayout* pLayout = mTextLayoutCache.Find(text.mFont, text.mSize, static_cast<int>(text.mAlign), static_cast<int>(text.mVAlign), str);
   
-  // Draw / measure
-  const double textWidth = font.measureText(str, strlen(str), SkTextEncoding::kUTF8, nullptr/* &bounds*/);
-  font.getMetrics(&metrics);
+  if (!pLayout)
+  {
+    const Font* pFont = FindFont(text.mFont);
+    
+    assert(pFont && "No font found - did you forget to load it?");
+    
+    TextLayout layout;
+    SkFont& font = layout.mFont;
+    SkFontMetrics metrics;
+    
+    font.setEdging(SkFont::Edging::kSubpixelAntiAlias);
+    font.setTypeface(pFont->mTypeface);
+    font.setHinting(SkFontHinting::kSlight);
+    font.setForceAutoHinting(false);
+    font.setSubpixel(true);
+    font.setSize(text.mSize * pFont->mData->GetHeightEMRatio());
+    
+    // Measure and shape once, the glyph run is then drawn at any position
+    layout.mWidth = font.measureText(str, strlen(str), SkTextEncoding::kUTF8, nullptr);
+    layout.mBlob = SkTextBlob::MakeFromString(str, font, SkTextEncoding::kUTF8);
+    font.getMetrics(&metrics);
+    layout.mAscender = metrics.fAscent;
+    layout.mDescender = metrics.fDescent;
+    
+    pLayout = mTextLayoutCache.Add(std::move(layout));
+  }
   
+  const double textWidth = pLayout->mWidth;
   const double textHeight = text.mSize;
-  const double ascender = metrics.fAscent;
-  const double descender = metrics.fDescent;
+  const double ascender = pLayout->mAscender;
+  const double descender = pLayout->mDescender;
   
   switch (text.mAlign)
   {
@@ -724,16 +751,15 @@ void IGraphicsSkia::PrepareAndMeasureText(const IText& text, const char* str, IR
   }
   
   r = IRECT((float) x, (float) y + ascender, (float) (x + textWidth), (float) (y + ascender + textHeight));
+  
+  return *pLayout;
 }
 
 float IGraphicsSkia::DoMeasureText(const IText& text, const char* str, IRECT& bounds) const
 {
-  SkFont font;
-  font.setEdging(SkFont::Edging::kSubpixelAntiAlias);
-
   IRECT r = bounds;
   double x, y;
-  PrepareAndMeasureText(text, str, bounds, x, y, font);
+  PrepareAndMeasureText(text, str, bounds, x, y);
   DoMeasureTextRotation(text, r, bounds);
   return bounds.W();
 }
@@ -741,18 +767,18 @@ float IGraphicsSkia::DoMeasureText(const IText& text, const char* str, IRECT& bo
 void IGraphicsSkia::DoDrawText(const IText& text, const char* str, const IRECT& bounds, const IBlend* pBlend)
 {
   IRECT measured = bounds;
-  
-  SkFont font;
-  font.setEdging(SkFont::Edging::kSubpixelAntiAlias);
-
   double x, y;
 
-  PrepareAndMeasureText(text, str, measured, x, y, font);
+  const TextLayout& layout = PrepareAndMeasureText(text, str, measured, x, y);
+  
+  if (!layout.mBlob) // empty string
+    return;
+  
   PathTransformSave();
   DoTextRotation(text, bounds, measured);
   SkPaint paint;
   paint.setColor(SkiaColor(text.mFGColor, pBlend));
-  mCanvas->drawSimpleText(str, strlen(str), SkTextEncoding::kUTF8, x, y, font, paint);
+  mCanvas->drawTextBlob(layout.mBlob, x, y, paint);
   PathTransformRestore();
 }
 
@@ -18,6 +18,8 @@
 #include "include/core/SkPath.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkImage.h"
+#include "include/core/SkFont.h"
+#include "include/core/SkTextBlob.h"
 #include "include/gpu/GrDirectContext.h"
 #pragma warning( pop )
 
@@ -139,8 +141,19 @@ protected:
 
   APIBitmap* LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext) override;
   APIBitmap* LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale) override;
-private:  
-  void PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y, SkFont& font) const;
+private:
+  /** The font, metrics and shaped glyphs of a single line of text, positioned relative to the origin */
+  struct TextLayout
+  {
+    SkFont mFont;
+    sk_sp<SkTextBlob> mBlob;
+    double mWidth = 0.;
+    double mAscender = 0.;
+    double mDescender = 0.;
+  };
+
+  const TextLayout& PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double & y) const;
+  const Font* FindFont(const char* fontID) const;
 
   void PathTransformSetMatrix(const IMatrix& m) override;
   void SetClipRegion(const IRECT& r) override;
@@ -174,6 +187,9 @@ private:
   void* mMTLLayer;
 #endif
 
+  mutable TextLayoutCache<TextLayout> mTextLayoutCache;
+  mutable std::unordered_map<std::string, const Font*> mFontLookup; // per instance, avoids locking sFontCache when drawing
+
   static StaticStorage<Font> sFontCache;
 };
 
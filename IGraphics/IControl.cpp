@@ -116,6 +116,10 @@ void IControl::SetParamIdx(int paramIdx, int valIdx)
 {
   assert(valIdx > kNoValIdx && valIdx < NVals());
   mVals.at(valIdx).idx = paramIdx;
+
+  if (mGraphics)
+    mGraphics->InvalidateParamControlIndex();
+
   SetDirty(false);
 }
 
@@ -203,6 +207,9 @@ void IControl::SetDirty(bool triggerAction, int valIdx)
   ForValIdx(valIdx, setValue);
   
   mDirty = true;
+
+  if (mGraphics)
+    mGraphics->OnControlDirty(this);
   
   if (triggerAction)
   {
@@ -300,6 +307,26 @@ void IControl::SetPosition(float x, float y)
   SetTargetRECT({tX, tY, tX + mTargetRECT.W(), tY + mTargetRECT.H()});
 }
 
+void IControl::NotifyBoundsChanged()
+{
+  if (mGraphics)
+    mGraphics->OnControlBoundsChanged(this);
+}
+
+void IControl::NotifyAnimationStarted()
+{
+  if (mGraphics && mAnimationFunc)
+    mGraphics->OnControlAnimationStarted(this);
+}
+
+void IControl::SetWantsDirtyPolling(bool poll)
+{
+  mWantsDirtyPolling = poll;
+
+  if (mGraphics)
+    mGraphics->InvalidateDirtyTracking();
+}
+
 void IControl::SetSize(float w, float h)
 {
   if (w < 0.f) w = 0.f;
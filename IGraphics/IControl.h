@@ -317,7 +317,7 @@ public:
 
   /** Set the rectangular draw area for this control, within the graphics context
    * @param bounds The control's bounds */
-  void SetRECT(const IRECT& bounds) { mRECT = bounds; mMouseIsOver = false; OnResize(); }
+  void SetRECT(const IRECT& bounds) { mRECT = bounds; mMouseIsOver = false; OnResize(); NotifyBoundsChanged(); }
   
   /** Get the rectangular mouse tracking target area, within the graphics context for this control
    * @return The control's target bounds within the graphics context */
@@ -325,11 +325,11 @@ public:
 
   /** Set the rectangular mouse tracking target area, within the graphics context for this control
    * @param bounds The control's new target bounds within the graphics context */
-  void SetTargetRECT(const IRECT& bounds) { mTargetRECT = bounds; mMouseIsOver = false; }
+  void SetTargetRECT(const IRECT& bounds) { mTargetRECT = bounds; mMouseIsOver = false; NotifyBoundsChanged(); }
   
   /** Set BOTH the draw rect and the target area, within the graphics context for this control
    * @param bounds The control's new draw and target bounds within the graphics context */
-  void SetTargetAndDrawRECTs(const IRECT& bounds) { mRECT = mTargetRECT = bounds; mMouseIsOver = false; OnResize(); }
+  void SetTargetAndDrawRECTs(const IRECT& bounds) { mRECT = mTargetRECT = bounds; mMouseIsOver = false; OnResize(); NotifyBoundsChanged(); }
 
   /** Set the position of the control, preserving the width and height. This may need to be overriden if you maintain custom positioning data in your control
    * @param x the new x coordinate of the top left corner of the control
@@ -412,9 +412,18 @@ public:
   void Animate();
 
   /** Called at each display refresh by the IGraphics draw loop, after IControl::Animate(), to determine if the control is marked as dirty. 
+   * If you override this to report changes that don't go through SetDirty(), call SetWantsDirtyPolling(true), see IGraphics::EnableIncrementalDirtyTracking()
    * @return \c true if the control is marked dirty. */
   virtual bool IsDirty();
 
+  /** Specify whether IsDirty() must be called on every display refresh when IGraphics incremental dirty tracking is enabled.
+   * Without this, IsDirty() is only called after SetDirty() or while the control is animating
+   * @param poll \c true if the control overrides IsDirty() to become dirty on its own */
+  void SetWantsDirtyPolling(bool poll);
+
+  /** @return \c true if the control's IsDirty() method must be called on every display refresh */
+  bool GetWantsDirtyPolling() const { return mWantsDirtyPolling; }
+
   /** Disable/enable default prompt for user input
    * @param disable Set true to disable prompt */
   void DisablePrompt(bool disable) { mDisablePrompt = disable; }
@@ -426,7 +435,7 @@ public:
   int GetTag() const { return GetUI()->GetControlTag(this); }
   
   /** Specify whether this control wants to know about MIDI messages sent to the UI. See OnMIDIMsg() */
-  void SetWantsMidi(bool enable = true) { mWantsMidi = enable; }
+  void SetWantsMidi(bool enable = true) { mWantsMidi = enable; if (mGraphics) mGraphics->InvalidateParamControlIndex(); }
 
   /** @return /c true if this control wants to know about MIDI messages send to the UI. See OnMIDIMsg() */
   bool GetWantsMidi() const { return mWantsMidi; }
@@ -494,12 +503,12 @@ public:
   
   /** Set the animation function
    * @param func A std::function conforming to IAnimationFunction */
-  void SetAnimation(IAnimationFunction func) { mAnimationFunc = func;}
+  void SetAnimation(IAnimationFunction func) { mAnimationFunc = func; NotifyAnimationStarted(); }
   
   /** Set the animation function and starts it
    * @param func A std::function conforming to IAnimationFunction
    * @param duration Duration in milliseconds for the animation */
-  void SetAnimation(IAnimationFunction func, int duration) { mAnimationFunc = func; StartAnimation(duration); }
+  void SetAnimation(IAnimationFunction func, int duration) { mAnimationFunc = func; NotifyAnimationStarted(); StartAnimation(duration); }
 
   /** Get the control's animation function, if it exists */
   IAnimationFunction GetAnimationFunction() { return mAnimationFunc; }
@@ -572,6 +581,9 @@ protected:
   {
     assert(nVals > 0);
     mVals.resize(nVals);
+
+    if (mGraphics)
+      mGraphics->InvalidateParamControlIndex();
   }
 
 #if defined VST3_API || defined VST3C_API
@@ -583,6 +595,14 @@ protected:
 #endif
   
 private:
+  /** Lets IGraphics update its mouse hit grid, if enabled */
+  void NotifyBoundsChanged();
+
+  /** Lets IGraphics add the control to its list of animating controls, if incremental dirty tracking is enabled */
+  void NotifyAnimationStarted();
+
+  friend class IGraphics;
+
   IContainerBase* mParent = nullptr;
   IGEditorDelegate* mDelegate = nullptr;
   IGraphics* mGraphics = nullptr;
@@ -594,6 +614,11 @@ private:
   std::vector<ParamTuple> mVals { {kNoParameter, 0.} };
   std::unordered_map<EGestureType, IGestureFunc> mGestureFuncs;
   EGestureType mLastGesture = EGestureType::Unknown;
+  // Incremental dirty tracking state, managed by IGraphics
+  bool mWantsDirtyPolling = false;
+  bool mDirtyTracked = false;
+  bool mInDirtyList = false;
+  bool mInAnimationList = false;
 };
 
 #pragma mark - Base Controls
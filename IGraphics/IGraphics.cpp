@@ -14,6 +14,10 @@
 #pragma warning(disable:4244) // float conversion
 #include "nanosvg.h"
 
+#ifdef SVG_USE_SKIA
+#include "include/core/SkPictureRecorder.h"
+#endif
+
 #if defined VST3_API
 #include "pluginterfaces/base/ustring.h"
 #include "IPlugVST3.h"
@@ -67,8 +71,10 @@ IGraphics::~IGraphics()
   RemoveAllControls();
     
   StaticStorage<APIBitmap>::Accessor bitmapStorage(sBitmapCache);
+  bitmapStorage.Release(mBitmapRefs);
   bitmapStorage.Release();
   StaticStorage<SVGHolder>::Accessor svgStorage(sSVGCache);
+  svgStorage.Release(mSVGRefs);
   svgStorage.Release();
 }
 
@@ -101,6 +107,7 @@ void IGraphics::Resize(int w, int h, float scale, bool needsPlatformResize)
   mDrawScale = scale;
   mWidth = w;
   mHeight = h;
+  InvalidateMouseHitGrid();
   
   if (mCornerResizer)
     mCornerResizer->OnRescale();
@@ -133,6 +140,9 @@ void IGraphics::RemoveControlWithTag(int ctrlTag)
 {
   mControls.DeletePtr(GetControlWithTag(ctrlTag), true);
   mCtrlTags.erase(ctrlTag);
+  InvalidateMouseHitGrid();
+  InvalidateDirtyTracking();
+  InvalidateParamControlIndex();
   SetAllControlsDirty();
 }
 
@@ -161,6 +171,9 @@ void IGraphics::RemoveControls(int fromIdx)
     mControls.Delete(idx--, true);
   }
   
+  InvalidateMouseHitGrid();
+  InvalidateDirtyTracking();
+  InvalidateParamControlIndex();
   SetAllControlsDirty();
 }
 
@@ -187,6 +200,9 @@ void IGraphics::RemoveControl(IControl* pControl)
     mCtrlTags.erase(pControl->GetTag());
   
   mControls.DeletePtr(pControl, true);
+  InvalidateMouseHitGrid();
+  InvalidateDirtyTracking();
+  InvalidateParamControlIndex();
   
   SetAllControlsDirty();
 }
@@ -209,6 +225,10 @@ void IGraphics::RemoveAllControls()
   
   mCtrlTags.clear();
   mControls.Empty(true);
+  mSVGRasterCache.clear();
+  InvalidateMouseHitGrid();
+  InvalidateDirtyTracking();
+  InvalidateParamControlIndex();
 }
 
 void IGraphics::SetControlPosition(IControl* pControl, float x, float y)
@@ -290,6 +310,9 @@ void IGraphics::AttachBackground(const char* fileName)
   IControl* pBG = new IBitmapControl(0, 0, LoadBitmap(fileName, 1, false), kNoParameter, EBlend::Default);
   pBG->SetDelegate(*GetDelegate());
   mControls.Insert(0, pBG);
+  InvalidateMouseHitGrid();
+  InvalidateDirtyTracking();
+  InvalidateParamControlIndex();
 }
 
 void IGraphics::AttachSVGBackground(const char* fileName)
@@ -297,6 +320,9 @@ void IGraphics::AttachSVGBackground(const char* fileName)
   IControl* pBG = new ISVGControl(GetBounds(), LoadSVG(fileName), true);
   pBG->SetDelegate(*GetDelegate());
   mControls.Insert(0, pBG);
+  InvalidateMouseHitGrid();
+  InvalidateDirtyTracking();
+  InvalidateParamControlIndex();
 }
 
 void IGraphics::AttachPanelBackground(const IPattern& color)
@@ -304,6 +330,9 @@ void IGraphics::AttachPanelBackground(const IPattern& color)
   IControl* pBG = new IPanelControl(GetBounds(), color);
   pBG->SetDelegate(*GetDelegate());
   mControls.Insert(0, pBG);
+  InvalidateMouseHitGrid();
+  InvalidateDirtyTracking();
+  InvalidateParamControlIndex();
 }
 
 IControl* IGraphics::AttachControl(IControl* pControl, int ctrlTag, const char* group)
@@ -320,6 +349,18 @@ IControl* IGraphics::AttachControl(IControl* pControl, int ctrlTag, const char*
   pControl->SetDelegate(*GetDelegate());
   pControl->SetGroup(group);
   mControls.Add(pControl);
+  InvalidateDirtyTracking();
+
+  if (mParamControlIndexValid)
+    AddToParamControlIndex(pControl);
+
+  if (mEnableMouseHitGrid && mHitGridValid)
+  {
+    // Appending doesn't shift any indices, so the new control can be indexed incrementally
+    mHitGridIndices[pControl] = NControls() - 1;
+    mHitGridRanges.push_back(HitGridRange());
+    mHitGridPending.push_back(pControl);
+  }
     
   pControl->OnAttached();
   return pControl;
@@ -500,6 +541,22 @@ void IGraphics::DisableControl(int paramIdx, bool disable)
 
 void IGraphics::ForControlWithParam(int paramIdx, IControlFunction func)
 {
+  if (paramIdx > kNoParameter)
+  {
+    IControl* pLastControl = nullptr;
+
+    // A control's links are adjacent in the index, only call func once per control
+    ForControlValuesWithParam(paramIdx, [&](IControl* pControl, int valIdx) {
+      if (pControl != pLastControl)
+      {
+        pLastControl = pControl;
+        func(pControl);
+      }
+    });
+
+    return;
+  }
+
   for (auto c = 0; c < NControls(); c++)
   {
     IControl* pControl = GetControl(c);
@@ -553,7 +610,11 @@ void IGraphics::ForStandardControlsFunc(IControlFunction func)
 void IGraphics::ForAllControlsFunc(IControlFunction func)
 {
   ForStandardControlsFunc(func);
-  
+  ForSpecialControlsFunc(func);
+}
+
+void IGraphics::ForSpecialControlsFunc(IControlFunction func)
+{
   if (mPerfDisplay)
     func(mPerfDisplay.get());
   
@@ -599,6 +660,26 @@ void IGraphics::SetAllControlsDirty()
 
 void IGraphics::SetAllControlsClean()
 {
+  if (mEnableIncrementalDirtyTracking && mDirtyTrackingValid)
+  {
+    for (IControl* pControl : mDirtyControls)
+    {
+      pControl->SetClean();
+      pControl->mInDirtyList = false;
+    }
+
+    mDirtyControls.clear();
+
+    for (IControl* pControl : mAnimatingControls)
+      pControl->SetClean();
+
+    for (IControl* pControl : mPolledControls)
+      pControl->SetClean();
+
+    ForSpecialControlsFunc([](IControl* pControl) { pControl->SetClean(); });
+    return;
+  }
+
   ForAllControls(&IControl::SetClean);
 }
 
@@ -613,23 +694,88 @@ void IGraphics::AssignParamNameToolTips()
   ForStandardControlsFunc(func);
 }
 
-void IGraphics::UpdatePeers(IControl* pCaller, int callerValIdx) // TODO: this could be really slow
+void IGraphics::UpdatePeers(IControl* pCaller, int callerValIdx)
 {
   double value = pCaller->GetValue(callerValIdx);
   int paramIdx = pCaller->GetParamIdx(callerValIdx);
+  IControl* pLastControl = nullptr;
     
-  auto func = [pCaller, paramIdx, value](IControl* pControl)
+  // Only the first value of each control linked to the parameter is updated, as with IControl::LinkedToParam()
+  auto func = [pCaller, value, &pLastControl](IControl* pControl, int valIdx)
   {
-    int valIdx = pControl->LinkedToParam(paramIdx);
-
     // Not actually called from the delegate, but we don't want to push the updates back to the delegate
-    if ((valIdx > kNoValIdx) && (pControl != pCaller))
+    if ((pControl != pLastControl) && (pControl != pCaller))
     {
       pControl->SetValueFromDelegate(value, valIdx);
     }
+
+    pLastControl = pControl;
   };
     
-  ForStandardControlsFunc(func);
+  ForControlValuesWithParam(paramIdx, func);
+}
+
+void IGraphics::ForMidiControlsFunc(IControlFunction func)
+{
+  UpdateParamControlIndex();
+
+  for (size_t i = 0; i < mMidiControls.size(); i++)
+  {
+    func(mMidiControls[i]);
+
+    if (!mParamControlIndexValid)
+    {
+      // As in ForControlValuesWithParam(), visit the rest of the stale index if the controls are still attached and want MIDI
+      const std::vector<IControl*> remaining(mMidiControls.begin() + i + 1, mMidiControls.end());
+
+      for (IControl* pControl : remaining)
+      {
+        if (GetControlIdx(pControl) > -1 && pControl->GetWantsMidi())
+          func(pControl);
+      }
+
+      return;
+    }
+  }
+}
+
+void IGraphics::UpdateParamControlIndex()
+{
+  if (mParamControlIndexValid)
+    return;
+
+  for (auto& links : mParamControls)
+    links.clear();
+
+  mMidiControls.clear();
+  mParamControlIndexValid = true;
+
+  for (int c = 0; c < NControls(); c++)
+    AddToParamControlIndex(GetControl(c));
+}
+
+void IGraphics::AddToParamControlIndex(IControl* pControl)
+{
+  for (int v = 0; v < pControl->NVals(); v++)
+  {
+    const int paramIdx = pControl->GetParamIdx(v);
+
+    if (paramIdx > kNoParameter)
+    {
+      if (paramIdx >= static_cast<int>(mParamControls.size()))
+        mParamControls.resize(paramIdx + 1);
+
+      mParamControls[paramIdx].push_back(std::make_pair(pControl, v));
+    }
+  }
+
+  if (pControl->GetWantsMidi())
+    mMidiControls.push_back(pControl);
+}
+
+bool IGraphics::IsControlLinkedToParam(IControl* pControl, int valIdx, int paramIdx) const
+{
+  return GetControlIdx(pControl) > -1 && valIdx < pControl->NVals() && pControl->GetParamIdx(valIdx) == paramIdx;
 }
 
 void IGraphics::PromptUserInput(IControl& control, const IRECT& bounds, int valIdx)
@@ -840,7 +986,10 @@ bool IGraphics::IsDirty(IRECTList& rects)
   if (mDisplayTickFunc)
     mDisplayTickFunc();
 
-  ForAllControlsFunc([](IControl* pControl) { pControl->Animate(); } );
+  if (mEnableIncrementalDirtyTracking)
+    AnimateTrackedControls();
+  else
+    ForAllControlsFunc([](IControl* pControl) { pControl->Animate(); } );
 
   bool dirty = false;
     
@@ -860,7 +1009,30 @@ bool IGraphics::IsDirty(IRECTList& rects)
     }
   };
     
-  ForAllControlsFunc(func);
+  if (mEnableIncrementalDirtyTracking)
+  {
+    UpdateDirtyTracking();
+
+    // A control can be in more than one list, but only needs to add its rect once
+    for (IControl* pControl : mDirtyControls)
+      func(pControl);
+
+    for (IControl* pControl : mAnimatingControls)
+    {
+      if (!pControl->mInDirtyList)
+        func(pControl);
+    }
+
+    for (IControl* pControl : mPolledControls)
+    {
+      if (!pControl->mInDirtyList && !pControl->mInAnimationList)
+        func(pControl);
+    }
+
+    ForSpecialControlsFunc(func);
+  }
+  else
+    ForAllControlsFunc(func);
 
 #ifdef USE_IDLE_CALLS
   if (dirty)
@@ -914,6 +1086,8 @@ void IGraphics::DrawControl(IControl* pControl, const IRECT& bounds, float scale
       pParent = pParent->GetParent();
     }
     
+    const double startTime = mControlDrawTimeFunc ? GetTimestamp() : 0.0;
+
     PrepareRegion(clipBounds);
     pControl->Draw(*this);
 #ifdef AAX_API
@@ -929,12 +1103,43 @@ void IGraphics::DrawControl(IControl* pControl, const IRECT& bounds, float scale
 #endif
     
     CompleteRegion(clipBounds);
+
+    if (mControlDrawTimeFunc)
+      mControlDrawTimeFunc(pControl, GetTimestamp() - startTime);
   }
 }
 
 void IGraphics::Draw(const IRECT& bounds, float scale)
 {
-  ForAllControlsFunc([this, bounds, scale](IControl* pControl) { DrawControl(pControl, bounds, scale); });
+  auto drawFunc = [this, bounds, scale](IControl* pControl) { DrawControl(pControl, bounds, scale); };
+
+  if (mEnableMouseHitGrid)
+  {
+    UpdateMouseHitGrid();
+
+    // Only visit the controls in the grid cells overlapping the region, padded to cover DrawControl()'s outline padding and pixel alignment
+    const HitGridRange range = GetMouseHitGridRange(bounds.GetPadded(2.f));
+    mDrawCandidates.clear();
+
+    for (int r = range.r0; r <= range.r1; r++)
+    {
+      for (int c = range.c0; c <= range.c1; c++)
+      {
+        const std::vector<int>& cell = mHitGridCells[r * mHitGridCols + c];
+        mDrawCandidates.insert(mDrawCandidates.end(), cell.begin(), cell.end());
+      }
+    }
+
+    std::sort(mDrawCandidates.begin(), mDrawCandidates.end());
+    mDrawCandidates.erase(std::unique(mDrawCandidates.begin(), mDrawCandidates.end()), mDrawCandidates.end());
+
+    for (int idx : mDrawCandidates)
+      drawFunc(GetControl(idx));
+
+    ForSpecialControlsFunc(drawFunc);
+  }
+  else
+    ForAllControlsFunc(drawFunc);
 
 #ifndef NDEBUG
   if (mShowAreaDrawn)
@@ -1298,12 +1503,47 @@ void IGraphics::ReleaseMouseCapture()
     HideMouseCursor(false);
 }
 
+bool IGraphics::IsControlHitByMouse(IControl* pControl, float x, float y, bool mouseOver) const
+{
+  if (pControl->IsHidden() || pControl->GetIgnoreMouse())
+    return false;
+
+  if (pControl->IsDisabled() && !(mouseOver ? pControl->GetMouseOverWhenDisabled() : pControl->GetMouseEventsWhenDisabled()))
+    return false;
+
+  return pControl->IsHit(x, y);
+}
+
 int IGraphics::GetMouseControlIdx(float x, float y, bool mouseOver)
 {
   if (!mouseOver || mEnableMouseOver)
   {
+    const int minIdx = mouseOver ? 1 : 0;
+
+#ifndef NDEBUG
+    if (mEnableMouseHitGrid && !mLiveEdit)
+#else
+    if (mEnableMouseHitGrid)
+#endif
+    {
+      UpdateMouseHitGrid();
+
+      const int col = Clip(static_cast<int>(std::floor(x / kHitGridCellSize)), 0, mHitGridCols - 1);
+      const int row = Clip(static_cast<int>(std::floor(y / kHitGridCellSize)), 0, mHitGridRows - 1);
+      const std::vector<int>& cell = mHitGridCells[row * mHitGridCols + col];
+
+      // Cells hold control indices in ascending order, so search from front to back
+      for (auto itr = cell.rbegin(); itr != cell.rend() && *itr >= minIdx; ++itr)
+      {
+        if (IsControlHitByMouse(GetControl(*itr), x, y, mouseOver))
+          return *itr;
+      }
+
+      return -1;
+    }
+
     // Search from front to back
-    for (auto c = NControls() - 1; c >= (mouseOver ? 1 : 0); --c)
+    for (auto c = NControls() - 1; c >= minIdx; --c)
     {
       IControl* pControl = GetControl(c);
 
@@ -1311,15 +1551,9 @@ int IGraphics::GetMouseControlIdx(float x, float y, bool mouseOver)
       if(!mLiveEdit)
       {
 #endif
-        if (!pControl->IsHidden() && !pControl->GetIgnoreMouse())
+        if (IsControlHitByMouse(pControl, x, y, mouseOver))
         {
-          if ((!pControl->IsDisabled() || (mouseOver ? pControl->GetMouseOverWhenDisabled() : pControl->GetMouseEventsWhenDisabled())))
-          {
-            if (pControl->IsHit(x, y))
-            {
-              return c;
-            }
-          }
+          return c;
         }
 #ifndef NDEBUG
       }
@@ -1334,6 +1568,198 @@ int IGraphics::GetMouseControlIdx(float x, float y, bool mouseOver)
   return -1;
 }
 
+void IGraphics::EnableMouseHitGrid(bool enable)
+{
+  mEnableMouseHitGrid = enable;
+  InvalidateMouseHitGrid();
+
+  if (!enable)
+  {
+    mHitGridCells.clear();
+    mHitGridRanges.clear();
+    mHitGridIndices.clear();
+  }
+}
+
+IGraphics::HitGridRange IGraphics::GetMouseHitGridRange(const IRECT& bounds) const
+{
+  auto toCell = [](float v, int nCells) {
+    return Clip(static_cast<int>(std::floor(v / kHitGridCellSize)), 0, nCells - 1);
+  };
+
+  HitGridRange range;
+  range.c0 = toCell(bounds.L, mHitGridCols);
+  range.c1 = toCell(bounds.R, mHitGridCols);
+  range.r0 = toCell(bounds.T, mHitGridRows);
+  range.r1 = toCell(bounds.B, mHitGridRows);
+  return range;
+}
+
+void IGraphics::AddToMouseHitGrid(int idx, const HitGridRange& range)
+{
+  for (int r = range.r0; r <= range.r1; r++)
+  {
+    for (int c = range.c0; c <= range.c1; c++)
+    {
+      std::vector<int>& cell = mHitGridCells[r * mHitGridCols + c];
+      cell.insert(std::lower_bound(cell.begin(), cell.end(), idx), idx);
+    }
+  }
+}
+
+void IGraphics::RemoveFromMouseHitGrid(int idx, const HitGridRange& range)
+{
+  for (int r = range.r0; r <= range.r1; r++)
+  {
+    for (int c = range.c0; c <= range.c1; c++)
+    {
+      std::vector<int>& cell = mHitGridCells[r * mHitGridCols + c];
+      auto itr = std::lower_bound(cell.begin(), cell.end(), idx);
+
+      if (itr != cell.end() && *itr == idx)
+        cell.erase(itr);
+    }
+  }
+}
+
+void IGraphics::UpdateMouseHitGrid()
+{
+  if (!mHitGridValid)
+  {
+    mHitGridCols = std::max(1, static_cast<int>(std::ceil(Width() / kHitGridCellSize)));
+    mHitGridRows = std::max(1, static_cast<int>(std::ceil(Height() / kHitGridCellSize)));
+    mHitGridCells.resize(mHitGridCols * mHitGridRows);
+
+    for (auto& cell : mHitGridCells)
+      cell.clear();
+
+    mHitGridRanges.resize(NControls());
+    mHitGridIndices.clear();
+
+    for (int c = 0; c < NControls(); c++)
+    {
+      IControl* pControl = GetControl(c);
+      mHitGridIndices[pControl] = c;
+      // IsHit() is usually tested against the RECT, but some controls test against the target RECT
+      mHitGridRanges[c] = GetMouseHitGridRange(pControl->GetRECT().Union(pControl->GetTargetRECT()));
+      AddToMouseHitGrid(c, mHitGridRanges[c]);
+    }
+
+    mHitGridPending.clear();
+    mHitGridValid = true;
+    return;
+  }
+
+  // Only controls that were attached or moved since the last query are re-indexed
+  for (IControl* pControl : mHitGridPending)
+  {
+    auto itr = mHitGridIndices.find(pControl);
+
+    if (itr == mHitGridIndices.end())
+      continue;
+
+    const int idx = itr->second;
+    RemoveFromMouseHitGrid(idx, mHitGridRanges[idx]);
+    mHitGridRanges[idx] = GetMouseHitGridRange(pControl->GetRECT().Union(pControl->GetTargetRECT()));
+    AddToMouseHitGrid(idx, mHitGridRanges[idx]);
+  }
+
+  mHitGridPending.clear();
+}
+
+void IGraphics::EnableIncrementalDirtyTracking(bool enable)
+{
+  mEnableIncrementalDirtyTracking = enable;
+  InvalidateDirtyTracking();
+
+  if (!enable)
+  {
+    mDirtyControls.clear();
+    mAnimatingControls.clear();
+    mPolledControls.clear();
+  }
+}
+
+void IGraphics::OnControlDirty(IControl* pControl)
+{
+  if (mEnableIncrementalDirtyTracking && mDirtyTrackingValid && pControl->mDirtyTracked && !pControl->mInDirtyList)
+  {
+    pControl->mInDirtyList = true;
+    mDirtyControls.push_back(pControl);
+  }
+}
+
+void IGraphics::OnControlAnimationStarted(IControl* pControl)
+{
+  if (mEnableIncrementalDirtyTracking && mDirtyTrackingValid && pControl->mDirtyTracked && !pControl->mInAnimationList)
+  {
+    pControl->mInAnimationList = true;
+    mAnimatingControls.push_back(pControl);
+  }
+}
+
+void IGraphics::UpdateDirtyTracking()
+{
+  if (mDirtyTrackingValid)
+    return;
+
+  // Special controls are not tracked, they are always visited
+  mDirtyControls.clear();
+  mAnimatingControls.clear();
+  mPolledControls.clear();
+
+  for (int c = 0; c < NControls(); c++)
+  {
+    IControl* pControl = GetControl(c);
+    pControl->mDirtyTracked = true;
+    pControl->mInDirtyList = pControl->mDirty;
+    pControl->mInAnimationList = pControl->GetAnimationFunction() != nullptr;
+
+    if (pControl->mInDirtyList)
+      mDirtyControls.push_back(pControl);
+
+    if (pControl->mInAnimationList)
+      mAnimatingControls.push_back(pControl);
+
+    if (pControl->GetWantsDirtyPolling())
+      mPolledControls.push_back(pControl);
+  }
+
+  mDirtyTrackingValid = true;
+}
+
+void IGraphics::AnimateTrackedControls()
+{
+  UpdateDirtyTracking();
+
+  // Animation functions may start or end animations, so iterate over a copy
+  mAnimatingControlsCopy = mAnimatingControls;
+
+  for (IControl* pControl : mAnimatingControlsCopy)
+  {
+    // if an animation function added or removed controls, the remaining pointers may be stale
+    if (!mDirtyTrackingValid)
+      break;
+
+    pControl->Animate();
+  }
+
+  if (mDirtyTrackingValid)
+  {
+    auto finished = [](IControl* pControl) {
+      if (pControl->GetAnimationFunction())
+        return false;
+
+      pControl->mInAnimationList = false;
+      return true;
+    };
+
+    mAnimatingControls.erase(std::remove_if(mAnimatingControls.begin(), mAnimatingControls.end(), finished), mAnimatingControls.end());
+  }
+
+  ForSpecialControlsFunc([](IControl* pControl) { pControl->Animate(); });
+}
+
 IControl* IGraphics::GetMouseControl(float x, float y, bool capture, bool mouseOver, ITouchID touchID)
 {
   IControl* pControl = nullptr;
@@ -1573,8 +1999,11 @@ void IGraphics::EnableLiveEdit(bool enable)
 #ifdef SVG_USE_SKIA
 ISVG IGraphics::LoadSVG(const char* fileName, const char* units, float dpi)
 {
+  if (SVGHolder* pCached = sSVGCache.FindShared(fileName, 1., &mSVGRefs))
+    return ISVG(pCached->mSVGDom, pCached->mPicture);
+  
   StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
-  SVGHolder* pHolder = storage.Find(fileName);
+  SVGHolder* pHolder = storage.Find(fileName, 1., &mSVGRefs);
   
   if(!pHolder)
   {
@@ -1589,13 +2018,16 @@ ISVG IGraphics::LoadSVG(const char* fileName, const char* units, float dpi)
     }
   }
   
-  return ISVG(pHolder->mSVGDom);
+  return ISVG(pHolder->mSVGDom, pHolder->mPicture);
 }
 
 ISVG IGraphics::LoadSVG(const char* name, const void* pData, int dataSize, const char* units, float dpi)
 {
+  if (SVGHolder* pCached = sSVGCache.FindShared(name, 1., &mSVGRefs))
+    return ISVG(pCached->mSVGDom, pCached->mPicture);
+  
   StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
-  SVGHolder* pHolder = storage.Find(name);
+  SVGHolder* pHolder = storage.Find(name, 1., &mSVGRefs);
 
   if (!pHolder)
   {
@@ -1625,18 +2057,26 @@ ISVG IGraphics::LoadSVG(const char* name, const void* pData, int dataSize, const
       nsvgDelete(pImage);
     }
 
-    pHolder = new SVGHolder(svgDOM);
-    storage.Add(pHolder, name);
+    // Walking the DOM is costly, so render it once into a picture that can be replayed
+    SkPictureRecorder recorder;
+    const SkSize size = svgDOM->containerSize();
+    svgDOM->render(recorder.beginRecording(SkRect::MakeWH(size.width(), size.height())));
+
+    pHolder = new SVGHolder(svgDOM, recorder.finishRecordingAsPicture());
+    storage.Add(pHolder, name, 1., &mSVGRefs);
   }
 
-  return ISVG(pHolder->mSVGDom);
+  return ISVG(pHolder->mSVGDom, pHolder->mPicture);
 }
 
 #else
 ISVG IGraphics::LoadSVG(const char* fileName, const char* units, float dpi)
 {
+  if (SVGHolder* pCached = sSVGCache.FindShared(fileName, 1., &mSVGRefs))
+    return ISVG(pCached->mImage, pCached->mDisplayList);
+  
   StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
-  SVGHolder* pHolder = storage.Find(fileName);
+  SVGHolder* pHolder = storage.Find(fileName, 1., &mSVGRefs);
 
   if(!pHolder)
   {
@@ -1651,13 +2091,16 @@ ISVG IGraphics::LoadSVG(const char* fileName, const char* units, float dpi)
     }
   }
 
-  return ISVG(pHolder->mImage);
+  return ISVG(pHolder->mImage, pHolder->mDisplayList);
 }
 
 ISVG IGraphics::LoadSVG(const char* name, const void* pData, int dataSize, const char* units, float dpi)
 {
+  if (SVGHolder* pCached = sSVGCache.FindShared(name, 1., &mSVGRefs))
+    return ISVG(pCached->mImage, pCached->mDisplayList);
+  
   StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
-  SVGHolder* pHolder = storage.Find(name);
+  SVGHolder* pHolder = storage.Find(name, 1., &mSVGRefs);
 
   if (!pHolder)
   {
@@ -1670,12 +2113,12 @@ ISVG IGraphics::LoadSVG(const char* name, const void* pData, int dataSize, const
     if (!pImage)
       return ISVG(nullptr);
     
-    pHolder = new SVGHolder(pImage);
+    pHolder = new SVGHolder(pImage, CompileSVG(pImage));
 
-    storage.Add(pHolder, name);
+    storage.Add(pHolder, name, 1., &mSVGRefs);
   }
 
-  return ISVG(pHolder->mImage);
+  return ISVG(pHolder->mImage, pHolder->mDisplayList);
 }
 #endif
 
@@ -1739,8 +2182,11 @@ IBitmap IGraphics::LoadBitmap(const char* name, int nStates, bool framesAreHoriz
   if (targetScale == 0)
     targetScale = GetRoundedScreenScale();
 
+  if (APIBitmap* pCached = sBitmapCache.FindShared(name, targetScale, &mBitmapRefs))
+    return IBitmap(pCached, nStates, framesAreHorizontal, name);
+  
   StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
-  APIBitmap* pAPIBitmap = storage.Find(name, targetScale);
+  APIBitmap* pAPIBitmap = storage.Find(name, targetScale, &mBitmapRefs);
 
   // If the bitmap is not already cached at the targetScale
   if (!pAPIBitmap)
@@ -1769,7 +2215,7 @@ IBitmap IGraphics::LoadBitmap(const char* name, int nStates, bool framesAreHoriz
     {
       // Try in the cache for a mismatched bitmap
       if (sourceScale != targetScale)
-        pAPIBitmap = storage.Find(name, sourceScale);
+        pAPIBitmap = storage.Find(name, sourceScale, &mBitmapRefs);
 
       // Load the resource if no match found
       if (!pAPIBitmap)
@@ -1801,8 +2247,11 @@ IBitmap IGraphics::LoadBitmap(const char *name, const void *pData, int dataSize,
   if (targetScale == 0)
     targetScale = GetRoundedScreenScale();
 
+  if (APIBitmap* pCached = sBitmapCache.FindShared(name, targetScale, &mBitmapRefs))
+    return IBitmap(pCached, nStates, framesAreHorizontal, name);
+  
   StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
-  APIBitmap* pAPIBitmap = storage.Find(name, targetScale);
+  APIBitmap* pAPIBitmap = storage.Find(name, targetScale, &mBitmapRefs);
 
   // If the bitmap is not already cached at the targetScale
   if (!pAPIBitmap)
@@ -1856,7 +2305,7 @@ void IGraphics::ReleaseBitmap(const IBitmap &bitmap)
 void IGraphics::RetainBitmap(const IBitmap& bitmap, const char* cacheName)
 {
   StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
-  storage.Add(bitmap.GetAPIBitmap(), cacheName, bitmap.GetScale());
+  storage.Add(bitmap.GetAPIBitmap(), cacheName, bitmap.GetScale(), &mBitmapRefs);
 }
 
 IBitmap IGraphics::ScaleBitmap(const IBitmap& inBitmap, const char* name, int scale)
@@ -1917,7 +2366,7 @@ APIBitmap* IGraphics::SearchBitmapInCache(const char* name, int targetScale, int
     
   for (sourceScale = targetScale; sourceScale > 0; SearchNextScale(sourceScale, targetScale))
   {
-    APIBitmap* pBitmap = storage.Find(name, sourceScale);
+    APIBitmap* pBitmap = storage.Find(name, sourceScale, &mBitmapRefs);
 
     if (pBitmap)
       return pBitmap;
@@ -2092,103 +2541,26 @@ void IGraphics::DrawRotatedLayer(const ILayerPtr& layer, double angle)
 
 void IGraphics::ApplyLayerDropShadow(ILayerPtr& layer, const IShadow& shadow)
 {
-  auto GaussianBlurSwap = [](uint8_t* out, uint8_t* in, uint8_t* kernel, int width, int height,
-                             int outStride, int inStride, int kernelSize, uint32_t norm)
-  {
-    int repeats = 0;
-    int fullKernelSize = kernelSize * 2 + 1;
-    uint32_t last = 0;
-
-    auto RepeatCheck = [&](int idx)
-    {
-      repeats = last == in[idx * 4] ? std::min(repeats + 1, fullKernelSize) : 1;
-      last = in[idx * 4];
-        
-      return repeats == fullKernelSize;
-    };
-      
-    for (int i = 0; i < height; i++, in += inStride)
-    {
-      for (int j = 0; j < kernelSize - 1; j++)
-      {
-        uint32_t accum = in[j * 4] * kernel[0];
-        for (int k = 1; k < j + 1; k++)
-          accum += kernel[k] * in[(j - k) * 4];
-        for (int k = 1; k < kernelSize; k++)
-          accum += kernel[k] * in[(j + k) * 4];
-        out[j * outStride + (i * 4)] = static_cast<uint8_t>(std::min(static_cast<uint32_t>(255), accum / norm));
-      }
-      for (int j = 0; j < kernelSize * 2 - 2; j++)
-        RepeatCheck(j);
-      for (int j = kernelSize - 1; j < (width - kernelSize) + 1; j++)
-      {
-        if (RepeatCheck(j + kernelSize - 1))
-        {
-            out[j * outStride + (i * 4)] = static_cast<uint8_t>(last);
-            continue;
-        }
-          
-        uint32_t accum = in[j * 4] * kernel[0];
-        for (int k = 1; k < kernelSize; k++)
-          accum += kernel[k] * (in[(j - k) * 4] + in[(j + k) * 4]);
-        out[j * outStride + (i * 4)] = static_cast<uint8_t>(std::min(static_cast<uint32_t>(255), accum / norm));
-      }
-      for (int j = (width - kernelSize) + 1; j < width; j++)
-      {
-        uint32_t accum = in[j * 4] * kernel[0];
-        for (int k = 1; k < kernelSize; k++)
-          accum += kernel[k] * in[(j - k) * 4];
-        for (int k = 1; k < width - j; k++)
-          accum += kernel[k] * in[(j + k) * 4];
-        out[j * outStride + (i * 4)] = static_cast<uint8_t>(std::min(static_cast<uint32_t>(255), accum / norm));
-      }
-    }
-  };
-  
-  RawBitmapData temp1;
-  RawBitmapData temp2;
-  RawBitmapData kernel;
+  RawBitmapData temp;
     
   // Get bitmap in 32-bit form
-  GetLayerBitmapData(layer, temp1);
+  GetLayerBitmapData(layer, temp);
     
-  if (!temp1.GetSize())
+  if (!temp.GetSize())
       return;
-  temp2.Resize(temp1.GetSize());
     
-  // Form kernel (reference blurSize from zero (which will be no blur))
-  bool flipped = FlippedBitmap();
+  // Reference blurSize from zero (which will be no blur), it spans three standard deviations of the Gaussian
   float scale = layer->GetAPIBitmap()->GetScale() * layer->GetAPIBitmap()->GetDrawScale();
   float blurSize = std::max(1.f, (shadow.mBlurSize * scale) + 1.f);
-  float blurConst = 4.5f / (blurSize * blurSize);
-  int iSize = static_cast<int>(ceil(blurSize));
   int width = layer->GetAPIBitmap()->GetWidth();
   int height = layer->GetAPIBitmap()->GetHeight();
-  int stride1 = temp1.GetSize() / width;
-  int stride2 = flipped ? -temp1.GetSize() / height : temp1.GetSize() / height;
-  int stride3 = flipped ? -stride2 : stride2;
-
-  kernel.Resize(iSize);
-        
-  for (int i = 0; i < iSize; i++)
-    kernel.Get()[i] = static_cast<uint8_t>(std::round(255.f * std::expf(-(i * i) * blurConst)));
+  int rowBytes = temp.GetSize() / height;
   
-  // Kernel normalisation
-  int normFactor = kernel.Get()[0];
-    
-  for (int i = 1; i < iSize; i++)
-    normFactor += kernel.Get()[i] + kernel.Get()[i];
-  
-  // Do blur
-  uint8_t* asRows = temp1.Get() + AlphaChannel();
-  uint8_t* inRows = flipped ? asRows + stride3 * (height - 1) : asRows;
-  uint8_t* asCols = temp2.Get() + AlphaChannel();
-  
-  GaussianBlurSwap(asCols, inRows, kernel.Get(), width, height, stride1, stride2, iSize, normFactor);
-  GaussianBlurSwap(asRows, asCols, kernel.Get(), height, width, stride3, stride1, iSize, normFactor);
+  // Blur the alpha channel. N.B. the blur is symmetric, so the orientation of the rows (FlippedBitmap()) does not matter
+  mShadowBlur.Process(temp.Get() + AlphaChannel(), width, height, rowBytes, 4, blurSize / 3.f);
   
   // Apply alphas to the pattern and recombine/replace the image
-  ApplyShadowMask(layer, temp1, shadow);
+  ApplyShadowMask(layer, temp, shadow);
 }
 
 bool IGraphics::LoadFont(const char* fontID, const char* fileNameOrResID)
@@ -2470,6 +2842,21 @@ void IGraphics::DrawData(const IColor& color, const IRECT& bounds, float* normYP
   if (nPoints == 0)
     return;
   
+  const int nColumns = static_cast<int>(std::ceil(bounds.W() * GetTotalScale()));
+
+  if (mEnableDataDecimation && IDataDecimator::IsWorthwhile(nPoints, nColumns))
+  {
+    const int nDecimated = mDataDecimator.Process(normYPoints, normXPoints, nPoints, nColumns);
+
+    if (nDecimated > 0)
+    {
+      // The decimated points always carry their x positions
+      normYPoints = const_cast<float*>(mDataDecimator.GetY());
+      normXPoints = const_cast<float*>(mDataDecimator.GetX());
+      nPoints = nDecimated;
+    }
+  }
+
   PathClear();
   
   float xPos = bounds.L;
@@ -2787,6 +3174,7 @@ void IGraphics::PathClipRegion(const IRECT r)
   PathTransformSetMatrix(IMatrix());
   SetClipRegion(clip);
   PathTransformSetMatrix(mTransform);
+  mClipRegion = clip;
 }
 
 void IGraphics::DrawFittedBitmap(const IBitmap& bitmap, const IRECT& bounds, const IBlend* pBlend)
@@ -2805,6 +3193,12 @@ void IGraphics::DrawSVG(const ISVG& svg, const IRECT& dest, const IBlend* pBlend
   float yScale = dest.H() / svg.H();
   float scale = xScale < yScale ? xScale : yScale;
   
+  if (mEnableSVGRasterCache && !pStrokeColor && !pFillColor && svg.IsValid())
+  {
+    DrawCachedSVG(svg, dest, scale, pBlend);
+    return;
+  }
+
   PathTransformSave();
   PathTransformTranslate(dest.L, dest.T);
   PathTransformScale(scale);
@@ -2812,6 +3206,47 @@ void IGraphics::DrawSVG(const ISVG& svg, const IRECT& dest, const IBlend* pBlend
   PathTransformRestore();
 }
 
+void IGraphics::EnableSVGRasterCache(bool enable)
+{
+  mEnableSVGRasterCache = enable;
+  mSVGRasterCache.clear();
+}
+
+void IGraphics::DrawCachedSVG(const ISVG& svg, const IRECT& dest, float scale, const IBlend* pBlend)
+{
+#ifdef SVG_USE_SKIA
+  const SVGRasterKey key {svg.mSVGDom.get(), scale};
+#else
+  const SVGRasterKey key {svg.mImage, scale};
+#endif
+  const IRECT layerBounds(0.f, 0.f, svg.W() * scale, svg.H() * scale);
+
+  auto itr = mSVGRasterCache.find(key);
+
+  if (itr == mSVGRasterCache.end() || !CheckLayer(itr->second))
+  {
+    if (mSVGRasterCache.size() >= kMaxSVGRasterCacheSize)
+      mSVGRasterCache.clear();
+
+    // Layers reset the transform and clip, so the caller's are saved around rendering.
+    // The enclosing layer, if any, is on top of the stack again after EndLayer(), and the saved clip lies within its bounds
+    const IRECT clip = mClipRegion;
+    PathTransformSave();
+    StartLayer(nullptr, layerBounds);
+    PathTransformScale(scale);
+    DoDrawSVG(svg);
+    ILayerPtr layer = EndLayer();
+    PathTransformRestore();
+    PathClipRegion(clip);
+
+    itr = mSVGRasterCache.insert_or_assign(key, std::move(layer)).first;
+  }
+
+  const ILayerPtr& layer = itr->second;
+  const IRECT& bounds = layer->Bounds();
+  DrawBitmap(layer->GetBitmap(), IRECT(dest.L, dest.T, dest.L + bounds.W(), dest.T + bounds.H()), 0, 0, pBlend);
+}
+
 void IGraphics::DrawRotatedSVG(const ISVG& svg, float destCtrX, float destCtrY, float width, float height, double angle, const IBlend* pBlend)
 {
   PathTransformSave();
@@ -2862,38 +3297,57 @@ IPattern IGraphics::GetSVGPattern(const NSVGpaint& paint, float opacity)
   }
 }
 
-void IGraphics::DoDrawSVG(const ISVG& svg, const IBlend* pBlend, const IColor* pStrokeColor, const IColor* pFillColor)
+#ifndef SVG_USE_SKIA
+/** A NanoSVG image prepared for drawing by IGraphics::CompileSVG() */
+struct iplug::igraphics::SVGDisplayList
 {
-#ifdef SVG_USE_SKIA
-  SkCanvas* canvas = static_cast<SkCanvas*>(GetDrawContext());
-  svg.mSVGDom->render(canvas); //TODO: blend
-#else
-  NSVGimage* pImage = svg.mImage;
-  
-  assert(pImage != nullptr);
-  
+  struct Path
+  {
+    int mFirstPt; // index of the first point in mPts, points are stored as x, y pairs
+    int mNPts;
+    bool mClosed;
+    bool mIsHole;
+  };
+
+  struct Shape
+  {
+    int mFirstPath;
+    int mNPaths;
+    bool mFill;
+    bool mStroke;
+    IPattern mFillPattern {IColor()};
+    IPattern mStrokePattern {IColor()};
+    float mStrokeWidth = 1.f;
+    IStrokeOptions mStrokeOptions;
+  };
+
+  std::vector<float> mPts;
+  std::vector<Path> mPaths;
+  std::vector<Shape> mShapes;
+};
+
+std::shared_ptr<const SVGDisplayList> IGraphics::CompileSVG(const NSVGimage* pImage)
+{
+  auto pList = std::make_shared<SVGDisplayList>();
+
   for (NSVGshape* pShape = pImage->shapes; pShape; pShape = pShape->next)
   {
     if (!(pShape->flags & NSVG_FLAGS_VISIBLE))
       continue;
-    
-    // Build a new path for each shape
-    PathClear();
-    
+
+    SVGDisplayList::Shape shape;
+    shape.mFirstPath = static_cast<int>(pList->mPaths.size());
+    shape.mNPaths = 0;
+
     // iterate subpaths in this shape
     for (NSVGpath* pPath = pShape->paths; pPath; pPath = pPath->next)
     {
-      PathMoveTo(pPath->pts[0], pPath->pts[1]);
-      
-      for (int i = 1; i < pPath->npts; i += 3)
-      {
-        float *p = &pPath->pts[i*2];
-        PathCubicBezierTo(p[0], p[1], p[2], p[3], p[4], p[5]);
-      }
-      
-      if (pPath->closed)
-        PathClose();
-      
+      SVGDisplayList::Path path;
+      path.mFirstPt = static_cast<int>(pList->mPts.size() / 2);
+      path.mNPts = pPath->npts;
+      path.mClosed = pPath->closed;
+      pList->mPts.insert(pList->mPts.end(), pPath->pts, pPath->pts + pPath->npts * 2);
+
       // Compute whether this path is a hole or a solid and set the winding direction accordingly.
       int crossings = 0;
       IVec2 p0{pPath->pts[0], pPath->pts[1]};
@@ -2921,23 +3375,21 @@ void IGraphics::DoDrawSVG(const ISVG& svg, const IBlend* pBlend, const IColor* p
           }
         }
       }
-      PathSetWinding(crossings % 2 != 0);
-    }
-    
-    // Fill combined path using windings set in subpaths
-    if (pShape->fill.type != NSVG_PAINT_NONE)
-    {
-      IFillOptions options;
-      options.mFillRule = EFillRule::Preserve;
-      
-      options.mPreserve = pShape->stroke.type != NSVG_PAINT_NONE;
-      PathFill(pFillColor ? IPattern(*pFillColor) : GetSVGPattern(pShape->fill, pShape->opacity), options, pBlend);
+      path.mIsHole = crossings % 2 != 0;
+
+      pList->mPaths.push_back(path);
+      shape.mNPaths++;
     }
-    
-    // Stroke
-    if (pShape->stroke.type != NSVG_PAINT_NONE)
+
+    shape.mFill = pShape->fill.type != NSVG_PAINT_NONE;
+    shape.mStroke = pShape->stroke.type != NSVG_PAINT_NONE;
+
+    if (shape.mFill)
+      shape.mFillPattern = GetSVGPattern(pShape->fill, pShape->opacity);
+
+    if (shape.mStroke)
     {
-      IStrokeOptions options;
+      IStrokeOptions& options = shape.mStrokeOptions;
       
       options.mMiterLimit = pShape->miterLimit;
       
@@ -2956,9 +3408,73 @@ void IGraphics::DoDrawSVG(const ISVG& svg, const IBlend* pBlend, const IColor* p
       }
       
       options.mDash.SetDash(pShape->strokeDashArray, pShape->strokeDashOffset, pShape->strokeDashCount);
-      
-      PathStroke(pStrokeColor ? IPattern(*pStrokeColor) : GetSVGPattern(pShape->stroke, pShape->opacity), pShape->strokeWidth, options, pBlend);
+
+      shape.mStrokePattern = GetSVGPattern(pShape->stroke, pShape->opacity);
+      shape.mStrokeWidth = pShape->strokeWidth;
     }
+
+    pList->mShapes.push_back(shape);
   }
+
+  return pList;
+}
 #endif
+
+void IGraphics::DoDrawSVG(const ISVG& svg, const IBlend* pBlend, const IColor* pStrokeColor, const IColor* pFillColor)
+{
+#ifdef SVG_USE_SKIA
+  SkCanvas* canvas = static_cast<SkCanvas*>(GetDrawContext());
+
+  if (svg.mPicture)
+    canvas->drawPicture(svg.mPicture); //TODO: blend
+  else
+    svg.mSVGDom->render(canvas); //TODO: blend
+#else
+  assert(svg.mImage != nullptr);
+
+  // An ISVG that wasn't made by LoadSVG() has no display list, so compile one for this draw
+  std::shared_ptr<const SVGDisplayList> pCompiled = svg.mDisplayList ? nullptr : CompileSVG(svg.mImage);
+  const SVGDisplayList& list = svg.mDisplayList ? *svg.mDisplayList : *pCompiled;
+
+  for (const SVGDisplayList::Shape& shape : list.mShapes)
+  {
+    // Build a new path for each shape
+    PathClear();
+
+    for (int pathIdx = shape.mFirstPath; pathIdx < shape.mFirstPath + shape.mNPaths; pathIdx++)
+    {
+      const SVGDisplayList::Path& path = list.mPaths[pathIdx];
+      const float* pts = &list.mPts[path.mFirstPt * 2];
+
+      PathMoveTo(pts[0], pts[1]);
+      
+      for (int i = 1; i < path.mNPts; i += 3)
+      {
+        const float *p = &pts[i*2];
+        PathCubicBezierTo(p[0], p[1], p[2], p[3], p[4], p[5]);
+      }
+      
+      if (path.mClosed)
+        PathClose();
+
+      PathSetWinding(path.mIsHole);
+    }
+    
+    // Fill combined path using windings set in subpaths
+    if (shape.mFill)
+    {
+      IFillOptions options;
+      options.mFillRule = EFillRule::Preserve;
+      
+      options.mPreserve = shape.mStroke;
+      PathFill(pFillColor ? IPattern(*pFillColor) : shape.mFillPattern, options, pBlend);
+    }
+    
+    // Stroke
+    if (shape.mStroke)
+    {
+      PathStroke(pStrokeColor ? IPattern(*pStrokeColor) : shape.mStrokePattern, shape.mStrokeWidth, shape.mStrokeOptions, pBlend);
+    }
   }
+#endif
+}
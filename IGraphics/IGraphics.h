@@ -31,7 +31,7 @@
  */
 
 #ifndef NO_IGRAPHICS
-#if defined(IGRAPHICS_NANOVG) + defined(IGRAPHICS_SKIA) != 1
+#if defined(IGRAPHICS_NANOVG) + defined(IGRAPHICS_SKIA) + defined(IGRAPHICS_LICE) != 1
 #error Either NO_IGRAPHICS or one and only one choice of graphics library must be defined!
 #endif
 #endif
@@ -47,6 +47,8 @@
 #include "IGraphicsConstants.h"
 #include "IGraphicsStructs.h"
 #include "IGraphicsPopupMenu.h"
+#include "IGraphicsBoxBlur.h"
+#include "IGraphicsDataDecimator.h"
 #include "IGraphicsEditorDelegate.h"
 
 #include "nanosvg.h"
@@ -382,12 +384,12 @@ public:
    * @return IBitmap The new IBitmap that has been added to the cache */
   virtual IBitmap ScaleBitmap(const IBitmap& inBitmap, const char* cacheName, int targetScale);
 
-  /** Adds an IBitmap to the cache/static storage
+  /** Adds an IBitmap to the cache/static storage. It is held by this instance, and deleted once no instance that has loaded it is open
    * @param bitmap The bitmap to cache
    * @param cacheName The name by which this bitmap is identified int the cache */
   virtual void RetainBitmap(const IBitmap& bitmap, const char* cacheName);
 
-  /** Releases an IBitmap from the cache/static storage
+  /** Releases an IBitmap from the cache/static storage, even if other instances have loaded it
    * @param bitmap The bitmap to release  */
   virtual void ReleaseBitmap(const IBitmap& bitmap);
 
@@ -496,7 +498,9 @@ public:
    * @param normXPoints Optional normailzed X positions of the points
    * @param pBlend Optional blend method
    * @param thickness Optional line thickness
-   * @param pFillColor Optional color for the fill area */
+   * @param pFillColor Optional color for the fill area
+   * If there are more than four points per pixel column the data is first reduced to the first, lowest, highest and last point of each column,
+   * which draws the same line including every peak, see EnableDataDecimation() */
   virtual void DrawData(const IColor& color, const IRECT& bounds, float* normYPoints, int nPoints, float* normXPoints = nullptr, const IBlend* pBlend = 0, float thickness = 1.f, const IColor* pFillColor = nullptr);
   
   /** Load a font to be used by the graphics context
@@ -561,6 +565,21 @@ public:
   * @param shadow - the shadow to add */
   virtual void ApplyLayerDropShadow(ILayerPtr& layer, const IShadow& shadow);
 
+  /** Sets how many threads are used to blur large layer shadows in ApplyLayerDropShadow()
+   * @param nThreads The number of threads including the UI thread, 1 (default) blurs on the UI thread only */
+  void SetShadowBlurThreads(int nThreads) { mShadowBlur.SetNThreads(nThreads); }
+
+  /** Enables or disables the per-pixel-column decimation of large data sets in DrawData(), which is enabled by default
+   * @param enable \c true to decimate */
+  void EnableDataDecimation(bool enable) { mEnableDataDecimation = enable; }
+
+  /** @return \c true if DrawData() decimates large data sets, see EnableDataDecimation() */
+  bool DataDecimationEnabled() const { return mEnableDataDecimation; }
+
+  /** Reduces data to at most four points per pixel column, used by DrawData() and controls that build their own data paths
+   * @return The decimator, whose buffers are shared by everything drawing on this graphics context */
+  IDataDecimator& GetDataDecimator() { return mDataDecimator; }
+
   /** Get the contents of a layer as Raw RGBA bitmap data
    * NOTE: you should only call this within IControl::Draw()
    * @param layer The layer to get the data from
@@ -773,6 +792,14 @@ private:
   IPattern GetSVGPattern(const NSVGpaint& paint, float opacity);
 
   void DoDrawSVG(const ISVG& svg, const IBlend* pBlend = nullptr, const IColor* pStrokeColor = nullptr, const IColor* pFillColor = nullptr);
+
+  /** Draws an SVG scaled to fit bounds, via a cached bitmap, see EnableSVGRasterCache() */
+  void DrawCachedSVG(const ISVG& svg, const IRECT& bounds, float scale, const IBlend* pBlend);
+
+#ifndef SVG_USE_SKIA
+  /** Converts a NanoSVG image into the paths, fill patterns and stroke options that DoDrawSVG() issues, so that this work is only done once per SVG */
+  std::shared_ptr<const SVGDisplayList> CompileSVG(const NSVGimage* pImage);
+#endif
   
   /** Prepare a particular area of the display for drawing, normally resulting in clipping of the region.
    * @param bounds The rectangular region to prepare  */
@@ -782,6 +809,7 @@ private:
     PathClear();
     SetClipRegion(bounds);
     mClipRECT = bounds;
+    mClipRegion = bounds;
   }
 
   /** Indicate that a particular area of the display has been drawn (for instance to transfer a temporary backing) Always called after a matching call to PrepareRegion.
@@ -1217,6 +1245,10 @@ public:
   /** Sets a function that is called when the OS appearance (light/dark mode) is changed
  * @param func The function to call */
   void SetUIAppearanceChangedFunc(IUIAppearanceChangedFunc func) { mAppearanceChangedFunc = func; }
+
+  /** Sets a function that is called after each control is drawn, with the time it took. Used for profiling, e.g. by IGraphicsHeadless::Benchmark()
+   * @param func The function to call, or nullptr to stop timing */
+  void SetControlDrawTimeFunc(IControlDrawTimeFunc func) { mControlDrawTimeFunc = func; }
   
   /** Set a function that is called when key presses are not intercepted by any controls
    * @param keyHandlerFunc A std::function conforming to IKeyHandlerFunc  */
@@ -1285,6 +1317,10 @@ public:
   /** For all standard controls in the main control stack perform a function
    * @param func A std::function to perform on each control */
   void ForStandardControlsFunc(IControlFunction func);
+
+  /** For the "special controls" only (corner resizer, popup menu, text entry etc.) perform a function
+   * @param func A std::function to perform on each control */
+  void ForSpecialControlsFunc(IControlFunction func);
   
   /** For all standard controls in the main control stack that are linked to a specific parameter, call a method
    * @param method The method to call
@@ -1303,6 +1339,50 @@ public:
    * @param func A std::function to perform on each control */
   void ForControlWithParam(const std::initializer_list<int>& params, IControlFunction func);
 
+  /** For all standard controls in the main control stack that are linked to a specific parameter, execute a function for every linked value.
+   * This looks up an index of parameter links rather than testing every control, see InvalidateParamControlIndex().
+   * If func removes or relinks controls, the remaining controls of the index as it was are still visited if they are attached and linked,
+   * but controls that func links to the parameter are not
+   * @param paramIdx The parameter index to match
+   * @param func A function with the signature void(IControl* pControl, int valIdx) */
+  template <typename F>
+  void ForControlValuesWithParam(int paramIdx, F func)
+  {
+    UpdateParamControlIndex();
+
+    if (paramIdx < 0 || paramIdx >= static_cast<int>(mParamControls.size()))
+      return;
+
+    // Indices rather than iterators, since func may attach controls, which appends to the index
+    for (size_t i = 0; i < mParamControls[paramIdx].size(); i++)
+    {
+      const auto link = mParamControls[paramIdx][i];
+      func(link.first, link.second);
+
+      if (!mParamControlIndexValid)
+      {
+        // func removed or relinked controls. Copy the rest of the stale index, since a nested call may rebuild it,
+        // and only visit the controls that are still attached and linked
+        const std::vector<std::pair<IControl*, int>> remaining(mParamControls[paramIdx].begin() + i + 1, mParamControls[paramIdx].end());
+
+        for (const auto& rlink : remaining)
+        {
+          if (IsControlLinkedToParam(rlink.first, rlink.second, paramIdx))
+            func(rlink.first, rlink.second);
+        }
+
+        return;
+      }
+    }
+  }
+
+  /** For all standard controls in the main control stack that want MIDI messages (see IControl::SetWantsMidi()), execute a function
+   * @param func A std::function to perform on each control */
+  void ForMidiControlsFunc(IControlFunction func);
+
+  /** Forces the index of parameter and MIDI links to be rebuilt before it is next used. IControl calls this when its links change */
+  void InvalidateParamControlIndex() { mParamControlIndexValid = false; }
+
   /** For all standard controls in the main control stack that are linked to a group, execute a function
    * @param group CString specifying the group name
    * @param func A std::function to perform on each control */
@@ -1504,8 +1584,91 @@ public:
    * @param idx The index of the control
    * @param r The new bounds for the control's target and draw rect */
   void SetControlBounds(IControl* pControl, const IRECT& r);
+
+  /** Enable or disable a uniform grid index of control bounds, used to find the control under the mouse without testing every control,
+   * and to skip controls outside of the dirty regions when drawing. This is worthwhile for interfaces with many controls. Hit testing gives the same results as without the index as long as IControl::IsHit()
+   * only returns true within a control's RECT or target RECT, and these are changed via the IControl setters or during IControl::OnResize().
+   * If you assign them elsewhere, call InvalidateMouseHitGrid()
+   * @param enable \c true to enable the index */
+  void EnableMouseHitGrid(bool enable);
+
+  /** @return \c true if the mouse hit grid is enabled */
+  bool MouseHitGridEnabled() const { return mEnableMouseHitGrid; }
+
+  /** Forces the mouse hit grid to be rebuilt before the next hit test */
+  void InvalidateMouseHitGrid() { mHitGridValid = false; mHitGridPending.clear(); }
+
+  /** Used internally by IControl to keep the mouse hit grid up to date when its bounds change
+   * @param pControl The control that moved */
+  void OnControlBoundsChanged(IControl* pControl)
+  {
+    if (!mEnableMouseHitGrid || !mHitGridValid)
+      return;
+
+    // If controls move repeatedly without any mouse events, a full rebuild is cheaper than replaying every move
+    if (mHitGridPending.size() >= mHitGridRanges.size())
+      InvalidateMouseHitGrid();
+    else
+      mHitGridPending.push_back(pControl);
+  }
+
+  /** Enable or disable incremental dirty tracking. By default, every control is animated and asked IControl::IsDirty() on each display refresh,
+   * so an idle interface costs time proportional to NControls(). With incremental tracking, IGraphics keeps lists of the controls that called
+   * IControl::SetDirty() or have an animation function, and only those are visited. Controls that override IControl::IsDirty() in order to
+   * become dirty on their own must call IControl::SetWantsDirtyPolling(true)
+   * @param enable \c true to enable incremental tracking */
+  void EnableIncrementalDirtyTracking(bool enable);
+
+  /** @return \c true if incremental dirty tracking is enabled */
+  bool IncrementalDirtyTrackingEnabled() const { return mEnableIncrementalDirtyTracking; }
+
+  /** Forces the incremental dirty tracking lists to be rebuilt from all controls on the next display refresh */
+  void InvalidateDirtyTracking() { mDirtyTrackingValid = false; }
+
+  /** Used internally by IControl::SetDirty() to add a control to the dirty list
+   * @param pControl The control that became dirty */
+  void OnControlDirty(IControl* pControl);
+
+  /** Used internally by IControl::SetAnimation() to add a control to the animation list
+   * @param pControl The control that started animating */
+  void OnControlAnimationStarted(IControl* pControl);
   
 private:
+  /** @return \c true if a control should receive a mouse event at x, y. This applies the same rules whether or not the mouse hit grid is used */
+  bool IsControlHitByMouse(IControl* pControl, float x, float y, bool mouseOver) const;
+
+  /** Brings the mouse hit grid up to date, either fully or by moving only the controls whose bounds changed */
+  void UpdateMouseHitGrid();
+
+  /** A range of mouse hit grid cells, inclusive */
+  struct HitGridRange
+  {
+    int c0 = 0, r0 = 0, c1 = -1, r1 = -1;
+  };
+
+  /** Adds or removes a control index to/from the grid cells covered by range. Cells are kept sorted by control index (z-order) */
+  void AddToMouseHitGrid(int idx, const HitGridRange& range);
+  void RemoveFromMouseHitGrid(int idx, const HitGridRange& range);
+
+  /** @return The cells covered by bounds, clamped to the grid */
+  HitGridRange GetMouseHitGridRange(const IRECT& bounds) const;
+
+  /** Rebuilds the index of parameter and MIDI links if it has been invalidated */
+  void UpdateParamControlIndex();
+
+  /** Adds the parameter and MIDI links of a control to the index. Controls must be added in z-order */
+  void AddToParamControlIndex(IControl* pControl);
+
+  /** @return \c true if pControl is still attached and its value valIdx is still linked to paramIdx. Used to check the links of a stale index.
+   * This is not inline, since IControl is incomplete where ForControlValuesWithParam() is defined */
+  bool IsControlLinkedToParam(IControl* pControl, int valIdx, int paramIdx) const;
+
+  /** Rebuilds the incremental dirty tracking lists if they have been invalidated */
+  void UpdateDirtyTracking();
+
+  /** Calls IControl::Animate() on the controls in the animation list and the special controls, then drops controls whose animation ended */
+  void AnimateTrackedControls();
+
   /** Get the index of the control at x and y coordinates on mouse event
    * @param x The X coordinate to test
    * @param y The Y coordinate to test
@@ -1692,6 +1855,15 @@ public:
    * @return An ISVG representing the image */
   virtual ISVG LoadSVG(const char* name, const void* pData, int dataSize, const char* units = "px", float dpi = 72.f);
 
+  /** Enable or disable caching SVGs as bitmaps. When enabled, DrawSVG() renders each SVG once per size into a layer and then draws that bitmap,
+   * which is much cheaper for static SVGs drawn every frame, e.g. knob backgrounds. SVGs drawn with stroke or fill color overrides are not cached.
+   * The bitmap is made at the size given to DrawSVG(), so SVGs that are scaled up with PathTransformScale() may look soft.
+   * @param enable \c true to enable the cache */
+  void EnableSVGRasterCache(bool enable);
+
+  /** @return \c true if SVGs are cached as bitmaps, see EnableSVGRasterCache() */
+  bool SVGRasterCacheEnabled() const { return mEnableSVGRasterCache; }
+
   /** Load a resource from the file system, the bundle, or a Windows resource, and returns its data
    * @param fileNameOrResID CString file name or resource ID
    * @param fileType Type of the file (e.g "png", "svg", "ttf")
@@ -1809,6 +1981,31 @@ private:
   WDL_PtrList<IControl> mControls;
   std::unordered_map<int, IControl*> mCtrlTags;
 
+  // Mouse hit grid, see EnableMouseHitGrid()
+  static constexpr float kHitGridCellSize = 32.f;
+  std::vector<std::vector<int>> mHitGridCells; // control indices in each cell, sorted back to front
+  std::vector<HitGridRange> mHitGridRanges; // the cells covered by each control when it was last indexed
+  std::unordered_map<IControl*, int> mHitGridIndices;
+  std::vector<IControl*> mHitGridPending; // controls whose bounds changed since the grid was updated
+  int mHitGridCols = 0;
+  int mHitGridRows = 0;
+  bool mHitGridValid = false;
+  bool mEnableMouseHitGrid = false;
+  std::vector<int> mDrawCandidates;
+
+  // Parameter and MIDI links, see ForControlValuesWithParam()
+  std::vector<std::vector<std::pair<IControl*, int>>> mParamControls; // (control, valIdx) for each parameter index, in z-order
+  std::vector<IControl*> mMidiControls;
+  bool mParamControlIndexValid = false;
+
+  // Incremental dirty tracking, see EnableIncrementalDirtyTracking()
+  std::vector<IControl*> mDirtyControls;
+  std::vector<IControl*> mAnimatingControls;
+  std::vector<IControl*> mPolledControls;
+  std::vector<IControl*> mAnimatingControlsCopy;
+  bool mDirtyTrackingValid = false;
+  bool mEnableIncrementalDirtyTracking = false;
+
   // Order (front-to-back) ToolTip / PopUp / TextEntry / LiveEdit / Corner / PerfDisplay
   std::unique_ptr<ICornerResizerControl> mCornerResizer;
   WDL_PtrList<IBubbleControl> mBubbleControls;
@@ -1862,6 +2059,11 @@ private:
   IKeyHandlerFunc mKeyHandlerFunc = nullptr;
   IDisplayTickFunc mDisplayTickFunc = nullptr;
   IUIAppearanceChangedFunc mAppearanceChangedFunc = nullptr;
+  IControlDrawTimeFunc mControlDrawTimeFunc = nullptr;
+
+  // The entries of the shared bitmap and SVG caches that this instance has loaded, released when it is destroyed
+  StaticStorage<APIBitmap>::References mBitmapRefs;
+  StaticStorage<SVGHolder>::References mSVGRefs;
   
 protected:
   IGEditorDelegate* mDelegate;
@@ -1877,9 +2079,30 @@ protected:
   friend class ICornerResizerControl;
   friend class ITextEntryControl;
   
+  // Rasterized SVGs, see EnableSVGRasterCache()
+  struct SVGRasterKey
+  {
+    const void* mSVG;
+    float mScale;
+    bool operator==(const SVGRasterKey& other) const { return mSVG == other.mSVG && mScale == other.mScale; }
+  };
+
+  struct SVGRasterKeyHash
+  {
+    size_t operator()(const SVGRasterKey& key) const { return std::hash<const void*>()(key.mSVG) ^ (std::hash<float>()(key.mScale) << 1); }
+  };
+
+  static constexpr int kMaxSVGRasterCacheSize = 256;
+  std::unordered_map<SVGRasterKey, ILayerPtr, SVGRasterKeyHash> mSVGRasterCache;
+  bool mEnableSVGRasterCache = false;
+  IBoxBlur mShadowBlur;
+  IDataDecimator mDataDecimator;
+  bool mEnableDataDecimation = true;
+
   std::stack<ILayer*> mLayers;
 
   IRECT mClipRECT;
+  IRECT mClipRegion; // the clip last applied by PrepareRegion() or PathClipRegion(), relative to the current layer
   IMatrix mTransform;
   std::stack<IMatrix> mTransformStates;
 };
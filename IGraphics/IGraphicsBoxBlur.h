@@ -0,0 +1,281 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IBoxBlur
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined IPLUG_SIMDE
+  #if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+  #else
+    #define SIMDE_ENABLE_NATIVE_ALIASES
+    #include "simde/x86/sse2.h"
+  #endif
+#endif
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+BEGIN_IGRAPHICS_NAMESPACE
+
+/** Blurs one 8-bit channel of an interleaved image, used by IGraphics::ApplyLayerDropShadow() on the alpha channel.
+ * A Gaussian is approximated by three successive box blurs, each computed with a running sum, so the cost does not depend on the radius.
+ * Pixels outside the image are treated as zero. The channel is copied to a planar float buffer, and each pass walks rows,
+ * so the inner loops operate on contiguous rows (SSE2 when IPLUG_SIMDE is defined) and the horizontal passes are done on a transposed copy.
+ * The columns can optionally be split between several threads. Buffers are kept between calls, so reuse one instance */
+class IBoxBlur
+{
+public:
+  static constexpr int kNPasses = 3;
+
+  /** Images with fewer pixels than this are always blurred on the calling thread */
+  static constexpr int kMinPixelsPerThread = 128 * 128;
+
+  IBoxBlur() = default;
+
+  IBoxBlur(const IBoxBlur&) = delete;
+  IBoxBlur& operator=(const IBoxBlur&) = delete;
+
+  /** @param nThreads The number of threads to use for large images, including the calling thread. 1 (default) does not spawn threads */
+  void SetNThreads(int nThreads) { mNThreads = std::max(1, nThreads); }
+
+  /** @return The number of threads used for large images */
+  int GetNThreads() const { return mNThreads; }
+
+  /** Calculates the widths of the box blurs that approximate a Gaussian
+   * @param sigma The standard deviation of the Gaussian in pixels
+   * @param radii Receives the radius of each pass, a box is 2 * radius + 1 pixels wide */
+  static void GetBoxRadii(float sigma, int radii[kNPasses])
+  {
+    const float wIdeal = std::sqrt((12.f * sigma * sigma / kNPasses) + 1.f);
+    int wl = static_cast<int>(std::floor(wIdeal));
+
+    if (!(wl & 1))
+      wl--;
+
+    wl = std::max(1, wl);
+
+    const float mIdeal = (12.f * sigma * sigma - kNPasses * wl * wl - 4.f * kNPasses * wl - 3.f * kNPasses) / (-4.f * wl - 4.f);
+    const int m = static_cast<int>(std::round(mIdeal));
+
+    for (int i = 0; i < kNPasses; i++)
+      radii[i] = ((i < m ? wl : wl + 2) - 1) / 2;
+  }
+
+  /** Blurs a channel in place
+   * @param pData Pointer to the first sample of the channel, e.g. the alpha byte of the first pixel
+   * @param width The width of the image in pixels
+   * @param height The height of the image in pixels
+   * @param rowBytes The distance between rows in bytes
+   * @param pixelBytes The distance between pixels in bytes, e.g. 4 for 32-bit pixels
+   * @param sigma The standard deviation of the Gaussian in pixels */
+  void Process(uint8_t* pData, int width, int height, int rowBytes, int pixelBytes, float sigma)
+  {
+    if (width <= 0 || height <= 0)
+      return;
+
+    int radii[kNPasses];
+    GetBoxRadii(sigma, radii);
+
+    if (radii[kNPasses - 1] <= 0)
+      return;
+
+    const size_t size = static_cast<size_t>(width) * height;
+
+    mPlanar.resize(size);
+    mTemp.resize(size);
+
+    for (int y = 0; y < height; y++)
+    {
+      const uint8_t* pIn = pData + static_cast<size_t>(y) * rowBytes;
+      float* pOut = mPlanar.data() + static_cast<size_t>(y) * width;
+
+      for (int x = 0; x < width; x++)
+        pOut[x] = pIn[x * pixelBytes];
+    }
+
+    // Vertical passes on the image, then on its transpose for the horizontal passes
+    ProcessPasses(mPlanar.data(), mTemp.data(), width, height, radii);
+    Transpose(mPlanar.data(), mTemp.data(), width, height);
+    ProcessPasses(mPlanar.data(), mTemp.data(), height, width, radii);
+
+    for (int y = 0; y < height; y++)
+    {
+      uint8_t* pOut = pData + static_cast<size_t>(y) * rowBytes;
+      const float* pIn = mTemp.data() + y;
+
+      for (int x = 0; x < width; x++)
+        pOut[x * pixelBytes] = static_cast<uint8_t>(std::clamp(pIn[static_cast<size_t>(x) * height] + 0.5f, 0.f, 255.f));
+    }
+  }
+
+private:
+  static_assert(kNPasses & 1, "an odd number of passes ends in the output buffer");
+
+  /** Runs all passes down the columns of a planar image, splitting the columns between threads if enabled.
+   * The result ends up in pOut and pIn is overwritten */
+  void ProcessPasses(float* pIn, float* pOut, int width, int height, const int radii[kNPasses])
+  {
+    const int nThreads = static_cast<int>(std::min<size_t>(mNThreads, static_cast<size_t>(width) * height / kMinPixelsPerThread));
+
+    auto processColumns = [&](int startX, int endX, std::vector<float>& sum) {
+      float* pA = pIn;
+      float* pB = pOut;
+
+      for (int pass = 0; pass < kNPasses; pass++)
+      {
+        BoxPass(pB, pA, sum, width, height, startX, endX, radii[pass]);
+        std::swap(pA, pB);
+      }
+    };
+
+    if (nThreads <= 1)
+    {
+      processColumns(0, width, mSum);
+      return;
+    }
+
+    // Chunks are multiples of 4 columns so that the SIMD loops stay aligned to the chunk
+    const int chunk = ((width + nThreads - 1) / nThreads + 3) & ~3;
+    std::vector<std::thread> threads;
+    std::vector<std::vector<float>> sums(nThreads);
+
+    for (int t = 1; t < nThreads; t++)
+    {
+      const int startX = std::min(width, t * chunk);
+      const int endX = std::min(width, startX + chunk);
+
+      if (startX < endX)
+        threads.emplace_back(processColumns, startX, endX, std::ref(sums[t]));
+    }
+
+    processColumns(0, std::min(width, chunk), sums[0]);
+
+    for (auto& thread : threads)
+      thread.join();
+  }
+
+  /** One box blur down the columns [startX, endX) of a planar image, using a running sum per column */
+  static void BoxPass(float* pOut, const float* pIn, std::vector<float>& sum, int width, int height, int startX, int endX, int radius)
+  {
+    const int n = endX - startX;
+    const float norm = 1.f / static_cast<float>(2 * radius + 1);
+
+    sum.assign(n, 0.f);
+
+    pIn += startX;
+    pOut += startX;
+
+    for (int y = 0; y < std::min(radius, height); y++)
+      AddRow(sum.data(), pIn + static_cast<size_t>(y) * width, n);
+
+    for (int y = 0; y < height; y++)
+    {
+      if (y + radius < height)
+        AddRow(sum.data(), pIn + static_cast<size_t>(y + radius) * width, n);
+
+      ScaleRow(pOut + static_cast<size_t>(y) * width, sum.data(), norm, n);
+
+      if (y - radius >= 0)
+        SubtractRow(sum.data(), pIn + static_cast<size_t>(y - radius) * width, n);
+    }
+  }
+
+  static void Transpose(float* pOut, const float* pIn, int width, int height)
+  {
+    // Blocked so that both sides stay in cache
+    constexpr int kBlock = 32;
+
+    for (int y0 = 0; y0 < height; y0 += kBlock)
+    {
+      for (int x0 = 0; x0 < width; x0 += kBlock)
+      {
+        const int yEnd = std::min(height, y0 + kBlock);
+        const int xEnd = std::min(width, x0 + kBlock);
+
+        for (int y = y0; y < yEnd; y++)
+          for (int x = x0; x < xEnd; x++)
+            pOut[static_cast<size_t>(x) * height + y] = pIn[static_cast<size_t>(y) * width + x];
+      }
+    }
+  }
+
+#if defined IPLUG_SIMDE
+  static void AddRow(float* pSum, const float* pRow, int n)
+  {
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+      _mm_storeu_ps(pSum + i, _mm_add_ps(_mm_loadu_ps(pSum + i), _mm_loadu_ps(pRow + i)));
+
+    for (; i < n; i++)
+      pSum[i] += pRow[i];
+  }
+
+  static void SubtractRow(float* pSum, const float* pRow, int n)
+  {
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+      _mm_storeu_ps(pSum + i, _mm_sub_ps(_mm_loadu_ps(pSum + i), _mm_loadu_ps(pRow + i)));
+
+    for (; i < n; i++)
+      pSum[i] -= pRow[i];
+  }
+
+  static void ScaleRow(float* pOut, const float* pSum, float norm, int n)
+  {
+    const __m128 vNorm = _mm_set1_ps(norm);
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+      _mm_storeu_ps(pOut + i, _mm_mul_ps(_mm_loadu_ps(pSum + i), vNorm));
+
+    for (; i < n; i++)
+      pOut[i] = pSum[i] * norm;
+  }
+#else
+  static void AddRow(float* pSum, const float* pRow, int n)
+  {
+    for (int i = 0; i < n; i++)
+      pSum[i] += pRow[i];
+  }
+
+  static void SubtractRow(float* pSum, const float* pRow, int n)
+  {
+    for (int i = 0; i < n; i++)
+      pSum[i] -= pRow[i];
+  }
+
+  static void ScaleRow(float* pOut, const float* pSum, float norm, int n)
+  {
+    for (int i = 0; i < n; i++)
+      pOut[i] = pSum[i] * norm;
+  }
+#endif
+
+  std::vector<float> mPlanar;
+  std::vector<float> mTemp;
+  std::vector<float> mSum;
+  int mNThreads = 1;
+};
+
+END_IGRAPHICS_NAMESPACE
+END_IPLUG_NAMESPACE
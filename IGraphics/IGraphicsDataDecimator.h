@@ -0,0 +1,231 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IDataDecimator
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined IPLUG_SIMDE
+  #if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+  #else
+    #define SIMDE_ENABLE_NATIVE_ALIASES
+    #include "simde/x86/sse2.h"
+  #endif
+#endif
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+BEGIN_IGRAPHICS_NAMESPACE
+
+/** Reduces a polyline with many more points than pixel columns, used by IGraphics::DrawData() and IVSpectrumAnalyzerControl.
+ * For each pixel column it keeps the first, minimum, maximum and last points, in their original order (M4 aggregation), so the line
+ * still reaches every peak and joins the neighbouring columns where it did before, and rasterizes to the same pixels.
+ * The min/max search uses SSE2 when IPLUG_SIMDE is defined. Buffers are kept between calls, so reuse one instance */
+class IDataDecimator
+{
+public:
+  /** The maximum number of points kept per column */
+  static constexpr int kPointsPerColumn = 4;
+
+  IDataDecimator() = default;
+
+  IDataDecimator(const IDataDecimator&) = delete;
+  IDataDecimator& operator=(const IDataDecimator&) = delete;
+
+  /** @return \c true if decimating nPoints for nColumns pixel columns would reduce the number of points */
+  static bool IsWorthwhile(int nPoints, int nColumns)
+  {
+    return nColumns > 0 && nPoints > kPointsPerColumn * nColumns;
+  }
+
+  /** Decimates a polyline. The results are available from GetX() and GetY()
+   * @param normYPoints The normalized Y positions of the points
+   * @param normXPoints The normalized X positions of the points, which must not decrease, or \c nullptr for points evenly spaced from 0 to 1
+   * @param nPoints The number of points
+   * @param nColumns The number of pixel columns the polyline spans
+   * @return The number of points kept, or -1 if normXPoints decreases somewhere, in which case the data should be drawn as it is */
+  int Process(const float* normYPoints, const float* normXPoints, int nPoints, int nColumns)
+  {
+    mX.resize(static_cast<size_t>(kPointsPerColumn) * nColumns + 2);
+    mY.resize(mX.size());
+    mNPoints = 0;
+
+    if (nPoints <= 0 || nColumns <= 0)
+      return 0;
+
+    int start = 0;
+    int prevColumn = -1;
+
+    while (start < nPoints)
+    {
+      int end;
+
+      if (normXPoints)
+      {
+        // Each run of points is in a later column than the one before, even where rounding puts a point that ended a run back in its column
+        const int column = std::min(std::max(Column(normXPoints[start], nColumns), prevColumn + 1), nColumns - 1);
+        prevColumn = column;
+        const float columnEnd = static_cast<float>(column + 1) / nColumns;
+        end = start + 1;
+
+        // NaN positions stay in the current column, so that the columns keep increasing
+        while (end < nPoints && (!(normXPoints[end] >= columnEnd) || column == nColumns - 1))
+        {
+          if (normXPoints[end] < normXPoints[end - 1])
+            return -1;
+
+          end++;
+        }
+
+        if (end < nPoints && normXPoints[end] < normXPoints[end - 1])
+          return -1;
+      }
+      else
+      {
+        // Point i is at i / (nPoints - 1), so column c holds the points with i * nColumns < (c + 1) * (nPoints - 1)
+        const int64_t column = nPoints > 1 ? std::min<int64_t>(static_cast<int64_t>(start) * nColumns / (nPoints - 1), nColumns - 1) : 0;
+        end = column == nColumns - 1 ? nPoints
+            : static_cast<int>(((column + 1) * (nPoints - 1) + nColumns - 1) / nColumns);
+        end = std::max(end, start + 1);
+      }
+
+      AddColumn(normYPoints, normXPoints, nPoints, start, end);
+      start = end;
+    }
+
+    return mNPoints;
+  }
+
+  /** @return The normalized X positions of the points kept by the last call to Process() */
+  const float* GetX() const { return mX.data(); }
+
+  /** @return The normalized Y positions of the points kept by the last call to Process() */
+  const float* GetY() const { return mY.data(); }
+
+  /** Finds the smallest and largest values in an array, ignoring NaNs
+   * @param pValues The values
+   * @param n The number of values, > 0
+   * @return \c false if all the values are NaN, in which case min and max are NaN */
+  static bool MinMax(const float* pValues, int n, float& min, float& max)
+  {
+    int i = 0;
+
+    while (i < n && std::isnan(pValues[i]))
+      i++;
+
+    if (i == n)
+    {
+      min = max = pValues[0];
+      return false;
+    }
+
+    min = max = pValues[i++];
+
+#if defined IPLUG_SIMDE
+    if (n - i >= 8)
+    {
+      // _mm_min_ps and _mm_max_ps return the second operand when either is NaN, so NaNs in v are skipped
+      __m128 vMin = _mm_set1_ps(min);
+      __m128 vMax = vMin;
+
+      for (; i + 4 <= n; i += 4)
+      {
+        const __m128 v = _mm_loadu_ps(pValues + i);
+        vMin = _mm_min_ps(v, vMin);
+        vMax = _mm_max_ps(v, vMax);
+      }
+
+      float mins[4], maxs[4];
+      _mm_storeu_ps(mins, vMin);
+      _mm_storeu_ps(maxs, vMax);
+      min = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+      max = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+      // Comparisons with NaN are false, so NaNs are skipped
+      if (pValues[i] < min)
+        min = pValues[i];
+
+      if (pValues[i] > max)
+        max = pValues[i];
+    }
+
+    return true;
+  }
+
+private:
+  static int Column(float normX, int nColumns)
+  {
+    // Also catches NaN, which cannot be converted to int
+    if (!(normX > 0.f))
+      return 0;
+
+    return static_cast<int>(std::min(normX * nColumns, static_cast<float>(nColumns - 1)));
+  }
+
+  /** Keeps the first, min, max and last points of [start, end), in order and without duplicates */
+  void AddColumn(const float* normYPoints, const float* normXPoints, int nPoints, int start, int end)
+  {
+    const int last = end - 1;
+    int minIdx = start, maxIdx = start;
+
+    float min, max;
+
+    // If the column is all NaN, only its first and last points are kept
+    if (end - start > 2 && MinMax(normYPoints + start, end - start, min, max))
+    {
+      // The first occurrences, which is where the line first reaches each extreme
+      minIdx = maxIdx = -1;
+
+      for (int i = start; i < end && (minIdx < 0 || maxIdx < 0); i++)
+      {
+        if (minIdx < 0 && normYPoints[i] == min)
+          minIdx = i;
+
+        if (maxIdx < 0 && normYPoints[i] == max)
+          maxIdx = i;
+      }
+    }
+
+    const int indices[kPointsPerColumn] = { start, std::min(minIdx, maxIdx), std::max(minIdx, maxIdx), last };
+    int prev = -1;
+
+    for (int idx : indices)
+    {
+      if (idx == prev)
+        continue;
+
+      mX[mNPoints] = normXPoints ? normXPoints[idx] : (nPoints > 1 ? static_cast<float>(idx) / (nPoints - 1) : 0.f);
+      mY[mNPoints] = normYPoints[idx];
+      mNPoints++;
+      prev = idx;
+    }
+  }
+
+  std::vector<float> mX;
+  std::vector<float> mY;
+  int mNPoints = 0;
+};
+
+END_IGRAPHICS_NAMESPACE
+END_IPLUG_NAMESPACE
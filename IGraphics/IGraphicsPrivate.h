@@ -15,8 +15,17 @@
  * @{
  */
 
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <list>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "mutex.h"
 #include "wdlstring.h"
@@ -35,6 +44,7 @@
   #pragma warning( disable : 5030 )
   #include "modules/svg/include/SkSVGDOM.h"
   #include "include/core/SkCanvas.h"
+  #include "include/core/SkPicture.h"
   #include "include/core/SkStream.h"
   #include "src/xml/SkDOM.h"
   #pragma warning( pop )
@@ -63,6 +73,9 @@
     sk_sp<SkSurface> mSurface;
   };
   #define BITMAP_DATA_TYPE SkiaDrawable*
+#elif defined IGRAPHICS_LICE
+  class LICE_IBitmap;
+  #define BITMAP_DATA_TYPE LICE_IBitmap*
 #else // NO_IGRAPHICS
   #define BITMAP_DATA_TYPE void*;
 #endif
@@ -75,6 +88,8 @@
   #define FONT_DESCRIPTOR_TYPE HFONT
 #elif defined OS_WEB
   #define FONT_DESCRIPTOR_TYPE std::pair<WDL_String, WDL_String>*
+#elif defined OS_LINUX
+  #define FONT_DESCRIPTOR_TYPE void*
 #else 
   // NO_IGRAPHICS
 #endif
@@ -456,16 +471,22 @@ protected:
 
 using PlatformFontPtr = std::unique_ptr<PlatformFont>;
 
+#ifndef SVG_USE_SKIA
+struct SVGDisplayList;
+#endif
+
 #ifdef SVG_USE_SKIA
 struct SVGHolder
 {
-  SVGHolder(sk_sp<SkSVGDOM> svgDom)
+  SVGHolder(sk_sp<SkSVGDOM> svgDom, sk_sp<SkPicture> picture)
   : mSVGDom(svgDom)
+  , mPicture(picture)
   {
   }
   
   ~SVGHolder()
   {
+    mPicture = nullptr;
     mSVGDom = nullptr;
   }
   
@@ -473,13 +494,15 @@ struct SVGHolder
   SVGHolder& operator=(const SVGHolder&) = delete;
   
   sk_sp<SkSVGDOM> mSVGDom;
+  sk_sp<SkPicture> mPicture; // the DOM rendered once at load, replayed when drawing
 };
 #else
 /** Used internally to manage SVG data*/
 struct SVGHolder
 {
-  SVGHolder(NSVGimage* pImage)
+  SVGHolder(NSVGimage* pImage, std::shared_ptr<const SVGDisplayList> displayList)
   : mImage(pImage)
+  , mDisplayList(displayList)
   {
   }
   
@@ -495,14 +518,42 @@ struct SVGHolder
   SVGHolder& operator=(const SVGHolder&) = delete;
   
   NSVGimage* mImage = nullptr;
+  std::shared_ptr<const SVGDisplayList> mDisplayList; // compiled once at load, see IGraphics::CompileSVG()
 };
 #endif
 
-/** Used internally to store data statically, making sure memory is not wasted when there are multiple plug-in instances loaded */
+/** Used internally to store data statically, making sure memory is not wasted when there are multiple plug-in instances loaded.
+ * Entries are indexed by a hash of their name and scale. An Accessor locks the storage for a find-or-add sequence and may be nested
+ * on the same thread. FindShared() only takes a reader lock, so when many instances open their editors at once the lookups of
+ * already loaded resources do not serialize.
+ * Each entry counts the References that hold it, and is deleted when the last of them is released. Entries that were added without
+ * References stay until they are removed, or until the storage is cleared when its own count, see Retain() and Release(), drops to zero */
 template <class T>
 class StaticStorage
 {
 public:
+  /** The entries that one user of the storage, such as an IGraphics instance, holds. Each entry is held at most once, however often it is
+   * looked up. Only used by its owner's thread, and must be released with Accessor::Release() before it is destroyed */
+  class References
+  {
+  public:
+    References() = default;
+    References(const References&) = delete;
+    References& operator=(const References&) = delete;
+
+    ~References()
+    {
+      assert(mEntries.empty() && "Release the References before destroying them");
+    }
+
+    /** @return The number of entries held */
+    int Size() const { return static_cast<int>(mEntries.size()); }
+
+  private:
+    friend class StaticStorage;
+    std::unordered_map<uint64_t, size_t> mEntries; // the ID of each entry held and the hash it is indexed by
+  };
+
   /** Accessor class that mantains thread safety when using static storage via RAII */
   class Accessor : private WDL_MutexLock
   {
@@ -512,12 +563,13 @@ public:
     , mStorage(storage) 
     {}
     
-    T* Find(const char* str, double scale = 1.)               { return mStorage.Find(str, scale); }
-    void Add(T* pData, const char* str, double scale = 1.)    { return mStorage.Add(pData, str, scale); }
-    void Remove(T* pData)                                     { return mStorage.Remove(pData); }
-    void Clear()                                              { return mStorage.Clear(); }
-    void Retain()                                             { return mStorage.Retain(); }
-    void Release()                                            { return mStorage.Release(); }
+    T* Find(const char* str, double scale = 1., References* pRefs = nullptr)            { return mStorage.Find(str, scale, pRefs); }
+    void Add(T* pData, const char* str, double scale = 1., References* pRefs = nullptr) { return mStorage.Add(pData, str, scale, pRefs); }
+    void Remove(T* pData)                                                                { return mStorage.Remove(pData); }
+    void Clear()                                                                         { return mStorage.Clear(); }
+    void Retain()                                                                        { return mStorage.Retain(); }
+    void Release()                                                                       { return mStorage.Release(); }
+    void Release(References& refs)                                                       { return mStorage.Release(refs); }
       
   private:
     StaticStorage& mStorage;
@@ -532,87 +584,147 @@ public:
 
   StaticStorage(const StaticStorage&) = delete;
   StaticStorage& operator=(const StaticStorage&) = delete;
+  
+  /** Finds cached data without taking the Accessor lock, so that several threads can look up data concurrently.
+   * Use it before falling back to an Accessor in order to add missing data
+   * @param str The key string to search for
+   * @param scale The scale factor to match
+   * @param pRefs If not nullptr, the entry found is held by these References
+   * @return Pointer to the cached data, or nullptr if not found */
+  T* FindShared(const char* str, double scale = 1., References* pRefs = nullptr)
+  {
+    std::shared_lock<std::shared_mutex> lock(mIndexMutex);
+    return Find(str, scale, pRefs);
+  }
     
 private:
   /** Internal structure for storing cached data with a string key and scale factor */
   struct DataKey
   {
-    // N.B. - hashID is not guaranteed to be unique
-    size_t hashID;
     WDL_String name;
     double scale;
+    size_t hash;
+    uint64_t id; // unique, so that References never mistake a later entry at the same address for one that was removed
+    std::atomic<int> refCount{0}; // incremented under a shared lock of mIndexMutex, and only decremented under an exclusive one
     std::unique_ptr<T> data;
   };
   
-  /** Computes a hash value for a string key
-   * @param str The string to hash
-   * @return The hash value */
-  size_t Hash(const char* str)
+  /** Computes a hash value for a key without allocating
+   * @param str The key string
+   * @param scale The scale factor
+   * @return The hash value, which is not guaranteed to be unique */
+  static size_t Hash(const char* str, double scale)
+  {
+    size_t hash = std::hash<std::string_view>()(std::string_view(str));
+    return hash ^ (std::hash<double>()(scale) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+  }
+
+  /** Adds a reference to an entry, unless the References already hold it. Called with mMutex or a shared lock of mIndexMutex held */
+  static void Hold(DataKey* pKey, References* pRefs)
   {
-    std::string string(str);
-    return std::hash<std::string>()(string);
+    if (pRefs && pRefs->mEntries.emplace(pKey->id, pKey->hash).second)
+      pKey->refCount.fetch_add(1, std::memory_order_relaxed);
   }
 
-  /** Finds cached data by name and scale
+  /** Finds cached data by name and scale. Called with either mMutex or a shared lock of mIndexMutex held
    * @param str The key string to search for
    * @param scale The scale factor to match
+   * @param pRefs If not nullptr, the entry found is held by these References
    * @return Pointer to the cached data, or nullptr if not found */
-  T* Find(const char* str, double scale = 1.)
+  T* Find(const char* str, double scale = 1., References* pRefs = nullptr)
   {
-    WDL_String cacheName(str);
-    cacheName.AppendFormatted((int) strlen(str) + 6, "-%.1fx", scale);
+    auto range = mDatas.equal_range(Hash(str, scale));
     
-    size_t hashID = Hash(cacheName.Get());
-    
-    int i, n = mDatas.GetSize();
-    for (i = 0; i < n; ++i)
+    // Use the hash for a quick search and then confirm with the scale and identifier to ensure uniqueness
+    for (auto it = range.first; it != range.second; ++it)
     {
-      DataKey* pKey = mDatas.Get(i);
+      DataKey* pKey = it->second.get();
 
-      // Use the hash id for a quick search and then confirm with the scale and identifier to ensure uniqueness
-      if (pKey->hashID == hashID && scale == pKey->scale && !strcmp(str, pKey->name.Get()))
+      if (scale == pKey->scale && !strcmp(str, pKey->name.Get()))
+      {
+        Hold(pKey, pRefs);
         return pKey->data.get();
+      }
     }
+    
     return nullptr;
   }
 
   /** Adds data to the cache
    * @param pData Pointer to the data to cache (takes ownership)
    * @param str The key string to associate with the data
-   * @param scale The scale factor (e.g. 2.0 for retina) */
-  void Add(T* pData, const char* str, double scale = 1.)
+   * @param scale The scale factor (e.g. 2.0 for retina)
+   * @param pRefs If not nullptr, the new entry is held by these References */
+  void Add(T* pData, const char* str, double scale = 1., References* pRefs = nullptr)
   {
-    DataKey* pKey = mDatas.Add(new DataKey);
-
-    WDL_String cacheName(str);
-    cacheName.AppendFormatted((int) strlen(str) + 6, "-%.1fx", scale);
-    
-    pKey->hashID = Hash(cacheName.Get());
+    std::unique_ptr<DataKey> pKey(new DataKey);
     pKey->data = std::unique_ptr<T>(pData);
     pKey->scale = scale;
     pKey->name.Set(str);
+    pKey->hash = Hash(str, scale);
+    pKey->id = ++mLastID;
+    Hold(pKey.get(), pRefs);
+
+    std::unique_lock<std::shared_mutex> lock(mIndexMutex);
+    const size_t hash = pKey->hash;
+    mDatas.emplace(hash, std::move(pKey));
 
     //DBGMSG("adding %s to the static storage at %.1fx the original scale\n", str, scale);
   }
 
-  /** Removes data from the cache
+  /** Removes data from the cache, whether or not any References hold it
    * @param pData Pointer to the data to remove */
   void Remove(T* pData)
   {
-    for (int i = 0; i < mDatas.GetSize(); ++i)
+    std::unique_ptr<DataKey> pRemoved; // deleted after the lock is released
+    std::unique_lock<std::shared_mutex> lock(mIndexMutex);
+    
+    for (auto it = mDatas.begin(); it != mDatas.end(); ++it)
     {
-      if (mDatas.Get(i)->data.get() == pData)
+      if (it->second->data.get() == pData)
       {
-        mDatas.Delete(i, true);
+        pRemoved = std::move(it->second);
+        mDatas.erase(it);
         break;
       }
     }
   }
 
+  /** Releases every entry held by a set of References, and deletes the entries that are no longer held by any
+   * @param refs The References to release, which are empty afterwards */
+  void Release(References& refs)
+  {
+    std::vector<std::unique_ptr<DataKey>> removed; // deleted after the lock is released
+    std::unique_lock<std::shared_mutex> lock(mIndexMutex);
+
+    for (const auto& entry : refs.mEntries)
+    {
+      auto range = mDatas.equal_range(entry.second);
+
+      // The entry is not found if it has been removed explicitly
+      for (auto it = range.first; it != range.second; ++it)
+      {
+        if (it->second->id == entry.first)
+        {
+          if (it->second->refCount.fetch_sub(1, std::memory_order_relaxed) == 1)
+          {
+            removed.push_back(std::move(it->second));
+            mDatas.erase(it);
+          }
+
+          break;
+        }
+      }
+    }
+
+    refs.mEntries.clear();
+  }
+
   /** Clears all cached data */
   void Clear()
   {
-    mDatas.Empty(true);
+    std::unique_lock<std::shared_mutex> lock(mIndexMutex);
+    mDatas.clear();
   };
 
   /** Increments the reference count for this storage */
@@ -629,8 +741,115 @@ private:
   }
     
   int mCount = 0;
-  WDL_Mutex mMutex;
-  WDL_PtrList<DataKey> mDatas;
+  uint64_t mLastID = 0; // only changed with mMutex held
+  WDL_Mutex mMutex; // serializes Accessors, recursive
+  std::shared_mutex mIndexMutex; // taken exclusively while mDatas is modified (with mMutex held) and shared by FindShared()
+  std::unordered_multimap<size_t, std::unique_ptr<DataKey>> mDatas;
+};
+
+/** Used internally by the drawing backends to cache the layout of single line text that is drawn repeatedly, such as value labels.
+ * Entries are keyed by font, size, alignment, draw scale and string, and the least recently used entry is evicted when the cache is full.
+ * Each IGraphics instance owns its own cache and only uses it on the UI thread, so no locking is needed */
+template <class T>
+class TextLayoutCache
+{
+public:
+  static constexpr int kDefaultCapacity = 512;
+
+  TextLayoutCache(int capacity = kDefaultCapacity)
+  : mCapacity(capacity)
+  {
+    mIndex.reserve(capacity);
+  }
+
+  TextLayoutCache(const TextLayoutCache&) = delete;
+  TextLayoutCache& operator=(const TextLayoutCache&) = delete;
+
+  /** Finds a layout and marks it as most recently used
+   * @param font The font identifier
+   * @param size The font size
+   * @param align The horizontal alignment, cast to int
+   * @param valign The vertical alignment, cast to int
+   * @param str The UTF8 string
+   * @param scale Any scale factor that the layout depends on
+   * @return Pointer to the layout, valid until the next call to Add() or Clear(), or nullptr if not found */
+  T* Find(const char* font, float size, int align, int valign, const char* str, float scale = 1.f)
+  {
+    // the lookup key is reused so that a hit does not allocate
+    mLookupKey.mFont.assign(font);
+    mLookupKey.mStr.assign(str);
+    mLookupKey.mSize = size;
+    mLookupKey.mScale = scale;
+    mLookupKey.mAlign = align;
+    mLookupKey.mVAlign = valign;
+
+    auto it = mIndex.find(mLookupKey);
+
+    if (it == mIndex.end())
+      return nullptr;
+
+    mEntries.splice(mEntries.begin(), mEntries, it->second);
+    return &it->second->second;
+  }
+
+  /** Adds the layout for the key of the last call to Find(), evicting the least recently used entry if the cache is full
+   * @param layout The layout to store
+   * @return Pointer to the stored layout, valid until the next call to Add() or Clear() */
+  T* Add(T&& layout)
+  {
+    if (static_cast<int>(mEntries.size()) >= mCapacity)
+    {
+      mIndex.erase(mEntries.back().first);
+      mEntries.pop_back();
+    }
+
+    mEntries.emplace_front(mLookupKey, std::move(layout));
+    mIndex.emplace(mEntries.front().first, mEntries.begin());
+    return &mEntries.front().second;
+  }
+
+  /** Removes all entries */
+  void Clear()
+  {
+    mIndex.clear();
+    mEntries.clear();
+  }
+
+private:
+  struct Key
+  {
+    std::string mFont;
+    std::string mStr;
+    float mSize = 0.f;
+    float mScale = 1.f;
+    int mAlign = 0;
+    int mVAlign = 0;
+
+    bool operator==(const Key& other) const
+    {
+      return mSize == other.mSize && mScale == other.mScale && mAlign == other.mAlign && mVAlign == other.mVAlign
+        && mStr == other.mStr && mFont == other.mFont;
+    }
+  };
+
+  struct KeyHash
+  {
+    size_t operator()(const Key& key) const
+    {
+      size_t hash = std::hash<std::string>()(key.mStr);
+      hash ^= std::hash<std::string>()(key.mFont) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      hash ^= std::hash<float>()(key.mSize) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      hash ^= std::hash<float>()(key.mScale) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      return hash ^ static_cast<size_t>(key.mAlign | (key.mVAlign << 4));
+    }
+  };
+
+  using EntryList = std::list<std::pair<Key, T>>;
+
+  EntryList mEntries; // most recently used first
+  std::unordered_map<Key, typename EntryList::iterator, KeyHash> mIndex;
+  Key mLookupKey;
+  int mCapacity;
 };
 
 /** Encapsulate an xy point in one struct */
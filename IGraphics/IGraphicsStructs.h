@@ -53,6 +53,7 @@ using IGestureFunc = std::function<void(IControl*, const IGestureInfo&)>;
 using IPopupFunction = std::function<void(IPopupMenu* pMenu)>;
 using IDisplayTickFunc = std::function<void()>;
 using IUIAppearanceChangedFunc = std::function<void(EUIAppearance appearance)>;
+using IControlDrawTimeFunc = std::function<void(IControl* pControl, double seconds)>;
 using ITouchID = uintptr_t;
 
 /** A click action function that does nothing */
@@ -165,8 +166,9 @@ private:
 #ifdef SVG_USE_SKIA
 struct ISVG
 {
-  ISVG(sk_sp<SkSVGDOM> svgDom)
+  ISVG(sk_sp<SkSVGDOM> svgDom, sk_sp<SkPicture> picture = nullptr)
   : mSVGDom(svgDom)
+  , mPicture(picture)
   {
   }
   
@@ -188,13 +190,15 @@ struct ISVG
   inline bool IsValid() const { return mSVGDom != nullptr; }
   
   sk_sp<SkSVGDOM> mSVGDom;
+  sk_sp<SkPicture> mPicture;
 };
 #else
 struct ISVG
 {  
-  ISVG(NSVGimage* pImage)
+  ISVG(NSVGimage* pImage, std::shared_ptr<const SVGDisplayList> displayList = nullptr)
   {
     mImage = pImage;
+    mDisplayList = displayList;
   }
   
   /** @return The width of the SVG */
@@ -215,6 +219,7 @@ struct ISVG
   inline bool IsValid() const { return mImage != nullptr; }
   
   NSVGimage* mImage = nullptr;
+  std::shared_ptr<const SVGDisplayList> mDisplayList; // if null, the image is compiled each time it is drawn
 };
 #endif
 
@@ -462,7 +467,7 @@ struct IColor
     };
 
     IColor col;
-    h = std::fmodf(h, 1.0f);
+    h = std::fmod(h, 1.0f);
     if (h < 0.0f) h += 1.0f;
     s = Clip(s, 0.0f, 1.0f);
     l = Clip(l, 0.0f, 1.0f);
@@ -21,7 +21,7 @@
 
 #ifndef NO_IGRAPHICS
 
-  #if defined OS_WEB
+  #if defined OS_WEB && !defined IGRAPHICS_HEADLESS
 
   #include <emscripten.h>
   #include <vector>
@@ -55,7 +55,12 @@
   BEGIN_IPLUG_NAMESPACE
   BEGIN_IGRAPHICS_NAMESPACE
 
-  #if defined OS_WIN
+  #if defined IGRAPHICS_HEADLESS
+  IGraphics* MakeGraphics(IGEditorDelegate& dlg, int w, int h, int fps = 0, float scale = 1.)
+  {
+    return new IGraphicsHeadless(dlg, w, h, fps, scale);
+  }
+  #elif defined OS_WIN
   IGraphics* MakeGraphics(IGEditorDelegate& dlg, int w, int h, int fps = 0, float scale = 1.)
   {
     IGraphicsWin* pGraphics = new IGraphicsWin(dlg, w, h, fps, scale);
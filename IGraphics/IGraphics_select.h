@@ -52,6 +52,9 @@
   #elif defined IGRAPHICS_SKIA
     #include "IGraphicsSkia.h"
     #define IGRAPHICS_DRAW_CLASS_TYPE IGraphicsSkia
+  #elif defined IGRAPHICS_LICE
+    #include "IGraphicsLice.h"
+    #define IGRAPHICS_DRAW_CLASS_TYPE IGraphicsLice
   #else
     #error NO IGRAPHICS_MODE defined
   #endif
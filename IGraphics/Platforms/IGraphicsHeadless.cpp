@@ -0,0 +1,397 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+#if defined __GNUC__
+  #include <cxxabi.h>
+#endif
+
+#include "IGraphicsHeadless.h"
+#include "IControl.h"
+#include "IPlugTimer.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+#pragma mark - Private Classes and Structs
+
+class IGraphicsHeadless::FileFont : public PlatformFont
+{
+public:
+  FileFont(const char* fontPath, const char* styleName, bool system)
+  : PlatformFont(system), mPath(fontPath), mStyleName(styleName)
+  {}
+
+  IFontDataPtr GetFontData() override;
+
+private:
+  WDL_String mPath;
+  WDL_String mStyleName;
+};
+
+IFontDataPtr IGraphicsHeadless::FileFont::GetFontData()
+{
+  IFontDataPtr fontData(new IFontData());
+  FILE* fp = fopen(mPath.Get(), "rb");
+
+  // Read in the font data.
+  if (!fp)
+    return fontData;
+
+  fseek(fp,0,SEEK_END);
+  fontData = std::make_unique<IFontData>((int) ftell(fp));
+
+  if (!fontData->GetSize())
+  {
+    fclose(fp);
+    return fontData;
+  }
+
+  fseek(fp,0,SEEK_SET);
+  size_t readSize = fread(fontData->Get(), 1, fontData->GetSize(), fp);
+  fclose(fp);
+
+  if (readSize && readSize == fontData->GetSize())
+  {
+    // Collections hold several faces, so pick the one with the requested style
+    const int faceIdx = mStyleName.GetLength() ? GetFaceIdx(fontData->Get(), fontData->GetSize(), mStyleName.Get()) : 0;
+    fontData->SetFaceIdx(std::max(faceIdx, 0));
+  }
+
+  return fontData;
+}
+
+class IGraphicsHeadless::MemoryFont : public PlatformFont
+{
+public:
+  MemoryFont(const void* pData, int dataSize)
+  : PlatformFont(false)
+  {
+    mData.Set((const uint8_t*)pData, dataSize);
+  }
+
+  IFontDataPtr GetFontData() override
+  {
+    return IFontDataPtr(new IFontData(mData.Get(), mData.GetSize(), 0));
+  }
+
+private:
+  WDL_TypedBuf<uint8_t> mData;
+};
+
+#pragma mark - Utilities
+
+/** @return The name in lower case, without spaces, dashes or underscores, so that e.g. "Roboto Bold" matches "Roboto-Bold.ttf" */
+static std::string NormalizeFontName(const std::string& name)
+{
+  std::string result;
+
+  for (char c : name)
+  {
+    if (c != ' ' && c != '-' && c != '_')
+      result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+
+  return result;
+}
+
+/** Searches the usual font directories for a font file by family and style name
+ * @return The path of the file, or an empty string if none is found */
+static std::string FindSystemFontFile(const char* fontName, ETextStyle style)
+{
+  namespace fs = std::filesystem;
+
+  const std::string family = NormalizeFontName(fontName);
+  const char* styleNames[] = { "regular", "bold", "italic" };
+  const std::string styled = family + styleNames[static_cast<int>(style)];
+
+  std::vector<fs::path> directories = { "/usr/share/fonts", "/usr/local/share/fonts", "/Library/Fonts", "/System/Library/Fonts" };
+
+  if (const char* home = getenv("HOME"))
+  {
+    directories.push_back(fs::path(home) / ".fonts");
+    directories.push_back(fs::path(home) / ".local/share/fonts");
+  }
+
+  if (const char* windir = getenv("WINDIR"))
+    directories.push_back(fs::path(windir) / "Fonts");
+
+  std::string familyMatch;
+  std::error_code error;
+
+  for (const fs::path& directory : directories)
+  {
+    for (fs::recursive_directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+    {
+      const fs::path& path = it->path();
+      std::string ext = path.extension().string();
+      std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+
+      if (ext != ".ttf" && ext != ".otf" && ext != ".ttc")
+        continue;
+
+      const std::string stem = NormalizeFontName(path.stem().string());
+
+      if (stem == styled)
+        return path.string();
+
+      if (stem == family && familyMatch.empty())
+        familyMatch = path.string();
+    }
+
+    error.clear();
+  }
+
+  return familyMatch;
+}
+
+#pragma mark -
+
+IGraphicsHeadless::IGraphicsHeadless(IGEditorDelegate& dlg, int w, int h, int fps, float scale)
+: IGRAPHICS_DRAW_CLASS(dlg, w, h, fps, scale)
+{
+}
+
+IGraphicsHeadless::~IGraphicsHeadless()
+{
+  CloseWindow();
+}
+
+void* IGraphicsHeadless::OpenWindow(void* pParent)
+{
+  OnViewInitialized(nullptr /* not used */);
+
+  mWindowOpen = true;
+  SetScreenScale(1.f);
+
+  GetDelegate()->LayoutUI(this);
+  SetAllControlsDirty();
+  GetDelegate()->OnUIOpen();
+
+  return nullptr;
+}
+
+void IGraphicsHeadless::CloseWindow()
+{
+  if (mWindowOpen)
+  {
+    mWindowOpen = false;
+    OnViewDestroyed();
+  }
+}
+
+EMsgBoxResult IGraphicsHeadless::ShowMessageBox(const char* str, const char* title, EMsgBoxType type, IMsgBoxCompletionHandlerFunc completionHandler)
+{
+  // There is nobody to answer, so the box is cancelled if it can be, otherwise accepted
+  EMsgBoxResult result = kOK;
+
+  switch (type)
+  {
+    case kMB_OK:            result = kOK;       break;
+    case kMB_OKCANCEL:      result = kCANCEL;   break;
+    case kMB_YESNOCANCEL:   result = kCANCEL;   break;
+    case kMB_YESNO:         result = kNO;       break;
+    case kMB_RETRYCANCEL:   result = kCANCEL;   break;
+  }
+
+  if (completionHandler)
+    completionHandler(result);
+
+  return result;
+}
+
+void IGraphicsHeadless::PromptForFile(WDL_String& fileName, WDL_String& path, EFileAction action, const char* ext, IFileDialogCompletionHandlerFunc completionHandler)
+{
+  fileName.Set("");
+
+  if (completionHandler)
+    completionHandler(fileName, path);
+}
+
+void IGraphicsHeadless::PromptForDirectory(WDL_String& dir, IFileDialogCompletionHandlerFunc completionHandler)
+{
+  WDL_String fileName;
+  dir.Set("");
+
+  if (completionHandler)
+    completionHandler(fileName, dir);
+}
+
+IPopupMenu* IGraphicsHeadless::CreatePlatformPopupMenu(IPopupMenu& menu, const IRECT bounds, bool& isAsync)
+{
+  // Dismissed without a selection
+  isAsync = false;
+  return nullptr;
+}
+
+PlatformFontPtr IGraphicsHeadless::LoadPlatformFont(const char* fontID, const char* fileNameOrResID)
+{
+  WDL_String fullPath;
+  const EResourceLocation fontLocation = LocateResource(fileNameOrResID, "ttf", fullPath, GetBundleID(), GetWinModuleHandle(), GetSharedResourcesSubPath());
+
+  if (fontLocation != kAbsolutePath)
+    return nullptr;
+
+  return PlatformFontPtr(new FileFont(fullPath.Get(), "", false));
+}
+
+PlatformFontPtr IGraphicsHeadless::LoadPlatformFont(const char* fontID, const char* fontName, ETextStyle style)
+{
+  const char* styles[] = { "Regular", "Bold", "Italic" };
+  const std::string path = FindSystemFontFile(fontName, style);
+
+  if (path.empty())
+    return nullptr;
+
+  return PlatformFontPtr(new FileFont(path.c_str(), styles[static_cast<int>(style)], true));
+}
+
+PlatformFontPtr IGraphicsHeadless::LoadPlatformFont(const char* fontID, void* pData, int dataSize)
+{
+  return PlatformFontPtr(new MemoryFont(pData, dataSize));
+}
+
+#pragma mark - Rendering
+
+bool IGraphicsHeadless::RenderFrame()
+{
+  Timer::ProcessTimers();
+
+  IRECTList rects;
+
+  if (!IsDirty(rects))
+    return false;
+
+  SetAllControlsClean();
+  Draw(rects);
+  return true;
+}
+
+bool IGraphicsHeadless::RenderToPNG(const char* path)
+{
+  SetAllControlsDirty();
+  RenderFrame();
+  return WriteDrawBitmapPNG(path);
+}
+
+IGraphicsHeadless::BenchmarkResults IGraphicsHeadless::Benchmark(int nFrames, EBenchmarkRegions regions)
+{
+  BenchmarkResults results;
+  std::unordered_map<IControl*, ControlDrawTime> times;
+  std::mt19937 randomGenerator(1);
+  const IRECT bounds = GetBounds();
+
+  SetControlDrawTimeFunc([&times](IControl* pControl, double seconds) {
+    ControlDrawTime& time = times[pControl];
+    time.pControl = pControl;
+    time.nDraws++;
+    time.totalSeconds += seconds;
+    time.maxSeconds = std::max(time.maxSeconds, seconds);
+  });
+
+  auto randomFloat = [&randomGenerator](float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(randomGenerator); };
+
+  for (int frame = 0; frame < nFrames; frame++)
+  {
+    IRECTList rects;
+
+    switch (regions)
+    {
+      case EBenchmarkRegions::FullFrame:
+        rects.Add(bounds);
+        break;
+
+      case EBenchmarkRegions::EachControl:
+        if (NControls())
+          rects.Add(GetControl(frame % NControls())->GetRECT());
+        break;
+
+      case EBenchmarkRegions::RandomRects:
+      {
+        const int nRects = 1 + static_cast<int>(randomGenerator() % 4);
+
+        for (int i = 0; i < nRects; i++)
+        {
+          const float w = randomFloat(0.05f, 0.5f) * bounds.W();
+          const float h = randomFloat(0.05f, 0.5f) * bounds.H();
+          const float l = randomFloat(bounds.L, bounds.R - w);
+          const float t = randomFloat(bounds.T, bounds.B - h);
+          rects.Add(IRECT(l, t, l + w, t + h));
+        }
+        break;
+      }
+    }
+
+    rects.PixelAlign(GetDrawScale());
+
+    const double startTime = GetTimestamp();
+    Draw(rects);
+    const double frameTime = GetTimestamp() - startTime;
+
+    results.meanFrameSeconds += frameTime;
+    results.maxFrameSeconds = std::max(results.maxFrameSeconds, frameTime);
+  }
+
+  SetControlDrawTimeFunc(nullptr);
+
+  results.nFrames = nFrames;
+  results.meanFrameSeconds /= std::max(nFrames, 1);
+
+  for (auto& entry : times)
+  {
+    entry.second.controlIdx = GetControlIdx(entry.first);
+    results.controls.push_back(entry.second);
+  }
+
+  std::sort(results.controls.begin(), results.controls.end(), [](const ControlDrawTime& a, const ControlDrawTime& b) {
+    return a.totalSeconds > b.totalSeconds;
+  });
+
+  return results;
+}
+
+void IGraphicsHeadless::BenchmarkResults::Print(FILE* pFile) const
+{
+  fprintf(pFile, "%i frames, mean %.3f ms, max %.3f ms\n", nFrames, meanFrameSeconds * 1000.0, maxFrameSeconds * 1000.0);
+  fprintf(pFile, "%6s %-40s %13s %8s %10s %10s\n", "idx", "control", "bounds", "draws", "mean ms", "max ms");
+
+  for (const ControlDrawTime& time : controls)
+  {
+    const IRECT& r = time.pControl->GetRECT();
+    char bounds[32];
+    snprintf(bounds, sizeof(bounds), "%gx%g", r.W(), r.H());
+
+    const char* name = typeid(*time.pControl).name();
+#if defined __GNUC__
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    std::string className = status == 0 && demangled ? demangled : name;
+    free(demangled);
+
+    // Drop the namespaces, which are the same for most controls
+    if (className.rfind("iplug::igraphics::", 0) == 0)
+      className.erase(0, strlen("iplug::igraphics::"));
+
+    name = className.c_str();
+#endif
+
+    fprintf(pFile, "%6i %-40.40s %13s %8i %10.4f %10.4f\n", time.controlIdx, name, bounds, time.nDraws,
+            time.totalSeconds * 1000.0 / std::max(time.nDraws, 1), time.maxSeconds * 1000.0);
+  }
+}
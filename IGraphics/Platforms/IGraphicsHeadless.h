@@ -0,0 +1,125 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+#include "IPlugPlatform.h"
+
+#include "IGraphics_select.h"
+
+#if !defined IGRAPHICS_LICE
+  #error IGraphicsHeadless requires the IGRAPHICS_LICE drawing backend
+#endif
+
+BEGIN_IPLUG_NAMESPACE
+BEGIN_IGRAPHICS_NAMESPACE
+
+/** IGraphics platform class with no window, which renders into a memory bitmap.
+ * Use it to render a UI on a machine without a display or GPU, e.g. for screenshots, visual regression tests or profiling.
+ * Frames are only drawn when RenderFrame() or Benchmark() is called, and all dialogs and menus are dismissed immediately.
+ * There is no window system timer: the app's run loop should call RenderFrame() regularly on the thread that owns the UI, which also fires the plug-in's timers
+ * @ingroup PlatformClasses */
+class IGraphicsHeadless final : public IGRAPHICS_DRAW_CLASS
+{
+  class FileFont;
+  class MemoryFont;
+public:
+  /** How Benchmark() makes the UI dirty for each frame */
+  enum class EBenchmarkRegions
+  {
+    FullFrame,    // The whole UI
+    EachControl,  // The bounds of one control per frame, in turn
+    RandomRects   // A few random rectangles, from a fixed seed
+  };
+
+  /** The draw times of a single control */
+  struct ControlDrawTime
+  {
+    IControl* pControl = nullptr;
+    int controlIdx = -1;
+    int nDraws = 0;
+    double totalSeconds = 0.;
+    double maxSeconds = 0.;
+  };
+
+  /** The results of Benchmark() */
+  struct BenchmarkResults
+  {
+    int nFrames = 0;
+    double meanFrameSeconds = 0.;
+    double maxFrameSeconds = 0.;
+    std::vector<ControlDrawTime> controls; // In order of total draw time, slowest first
+
+    /** Prints the frame times and the per control times as a table
+     * @param pFile The file to print to */
+    void Print(FILE* pFile = stdout) const;
+  };
+
+  IGraphicsHeadless(IGEditorDelegate& dlg, int w, int h, int fps, float scale);
+  ~IGraphicsHeadless();
+
+  const char* GetPlatformAPIStr() override { return "Headless"; }
+
+  void* OpenWindow(void* pParent) override;
+  void CloseWindow() override;
+  void* GetWindow() override { return nullptr; }
+  bool WindowIsOpen() override { return mWindowOpen; }
+
+  void GetMouseLocation(float& x, float&y) const override { x = mMouseX; y = mMouseY; }
+  void HideMouseCursor(bool hide, bool lock) override { mCursorHidden = hide; }
+  void MoveMouseCursor(float x, float y) override { mMouseX = x; mMouseY = y; }
+  void ForceEndUserEdit() override {}
+  void UpdateTooltips() override {}
+
+  bool GetTextFromClipboard(WDL_String& str) override { str.Set(mClipboardText.Get()); return true; }
+  bool SetTextInClipboard(const char* str) override { mClipboardText.Set(str); return true; }
+
+  EMsgBoxResult ShowMessageBox(const char* str, const char* title, EMsgBoxType type, IMsgBoxCompletionHandlerFunc completionHandler) override;
+  void PromptForFile(WDL_String& fileName, WDL_String& path, EFileAction action, const char* ext, IFileDialogCompletionHandlerFunc completionHandler) override;
+  void PromptForDirectory(WDL_String& dir, IFileDialogCompletionHandlerFunc completionHandler) override;
+  bool PromptForColor(IColor& color, const char* str, IColorPickerHandlerFunc func) override { return false; }
+  bool OpenURL(const char* url, const char* msgWindowTitle, const char* confirmMsg, const char* errMsgOnFailure) override { return false; }
+
+  /** Calls the functions of any due timers (see Timer::ProcessTimers()), then draws any dirty controls
+   * @return \c true if anything was drawn */
+  bool RenderFrame();
+
+  /** Draws the whole UI and writes it to a PNG file
+   * @param path The path of the file to write
+   * @return \c true on success */
+  bool RenderToPNG(const char* path);
+
+  /** Draws a number of frames and measures the time each control takes to draw
+   * @param nFrames The number of frames to draw
+   * @param regions How each frame is made dirty
+   * @return The frame times and the draw times of every control that was drawn */
+  BenchmarkResults Benchmark(int nFrames, EBenchmarkRegions regions = EBenchmarkRegions::FullFrame);
+
+protected:
+  IPopupMenu* CreatePlatformPopupMenu(IPopupMenu& menu, const IRECT bounds, bool& isAsync) override;
+  void CreatePlatformTextEntry(int paramIdx, const IText& text, const IRECT& bounds, int length, const char* str) override {}
+
+private:
+  PlatformFontPtr LoadPlatformFont(const char* fontID, const char* fileNameOrResID) override;
+  PlatformFontPtr LoadPlatformFont(const char* fontID, const char* fontName, ETextStyle style) override;
+  PlatformFontPtr LoadPlatformFont(const char* fontID, void* pData, int dataSize) override;
+  void CachePlatformFont(const char* fontID, const PlatformFontPtr& font) override {}
+
+  bool mWindowOpen = false;
+  float mMouseX = 0.f;
+  float mMouseY = 0.f;
+  WDL_String mClipboardText;
+};
+
+END_IGRAPHICS_NAMESPACE
+END_IPLUG_NAMESPACE
@@ -239,6 +239,7 @@ AAX_Result IPlugAAX::UpdateParameterNormalizedValue(AAX_CParamID paramID, double
   {
     ENTER_PARAMS_MUTEX
     GetParam(paramIdx)->SetNormalized(iValue);
+    INVALIDATE_PARAM_SNAPSHOT(paramIdx)
     SendParameterValueFromAPI(paramIdx, iValue, true);
     OnParamChange(paramIdx, kHost);
     LEAVE_PARAMS_MUTEX
@@ -361,6 +362,7 @@ void IPlugAAX::RenderAudio(AAX_SIPlugRenderInfo* pRenderInfo, const TParamValPai
       ProcessMidiMsg(msg);
     }
     
+    APPLY_PARAMS_SNAPSHOT
     ENTER_PARAMS_MUTEX
     ProcessBuffers(0.0f, numSamples);
     LEAVE_PARAMS_MUTEX
@@ -610,6 +612,5 @@ void IPlugAAX::SetLatency(int latency)
 
 bool IPlugAAX::SendMidiMsg(const IMidiMsg& msg)
 {
-  mMidiOutputQueue.Add(msg);
-  return true;
+  return mMidiOutputQueue.Add(msg);
 }
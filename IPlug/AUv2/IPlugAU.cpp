@@ -1575,6 +1575,7 @@ OSStatus IPlugAU::SetParamProc(void* pPlug, AudioUnitParameterID paramID, AudioU
   IPlugAU* _this = (IPlugAU*) pPlug;
   ENTER_PARAMS_MUTEX_STATIC
   _this->GetParam(paramID)->Set(value);
+  INVALIDATE_PARAM_SNAPSHOT_STATIC(paramID)
   _this->SendParameterValueFromAPI(paramID, value, false);
   _this->OnParamChange(paramID, kHost, offsetFrames);
   LEAVE_PARAMS_MUTEX_STATIC
@@ -1754,6 +1755,7 @@ OSStatus IPlugAU::RenderProc(void* pPlug, AudioUnitRenderActionFlags* pFlags, co
       }
       
       _this->PreProcess();
+      APPLY_PARAMS_SNAPSHOT_STATIC
       ENTER_PARAMS_MUTEX_STATIC
       _this->ProcessBuffers((AudioSampleType) 0, nFrames);
       LEAVE_PARAMS_MUTEX_STATIC
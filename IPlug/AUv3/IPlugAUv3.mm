@@ -129,6 +129,7 @@ bool IPlugAUv3::EditorResize(int viewWidth, int viewHeight)
 void IPlugAUv3::ProcessWithEvents(AudioTimeStamp const* pTimestamp, uint32_t frameCount, AURenderEvent const* pEvents, ITimeInfo& timeInfo)
 {
   SetTimeInfo(timeInfo);
+  APPLY_PARAMS_SNAPSHOT
   
   IMidiMsg midiMsg;
   while (mMidiMsgsFromEditor.Pop(midiMsg))
@@ -167,6 +168,7 @@ void IPlugAUv3::ProcessWithEvents(AudioTimeStamp const* pTimestamp, uint32_t fra
           const int sampleOffset = (int) (paramEvent.eventSampleTime - now);
           ENTER_PARAMS_MUTEX
           GetParam(paramIdx)->Set(value);
+          INVALIDATE_PARAM_SNAPSHOT(paramIdx)
           LEAVE_PARAMS_MUTEX
           OnParamChange(paramIdx, EParamSource::kHost, sampleOffset);
         }
@@ -235,6 +237,7 @@ void IPlugAUv3::SetParameterFromValueObserver(uint64_t address, float value)
     IParam* pParam = GetParam(paramIdx);
     assert(pParam);
     pParam->Set((double) value);
+    INVALIDATE_PARAM_SNAPSHOT(paramIdx)
     LEAVE_PARAMS_MUTEX
     OnParamChange(paramIdx, kHost, -1);
   }
@@ -131,16 +131,14 @@ void IPlugCLAP::SetLatency(int samples)
 
 bool IPlugCLAP::SendMidiMsg(const IMidiMsg& msg)
 {
-  mMidiToHost.Add(msg);
-  return true;
+  return mMidiToHost.Add(msg);
 }
 
 bool IPlugCLAP::SendSysEx(const ISysEx& msg)
 {
   // TODO - don't copy the data
   SysExData data(msg.mOffset, msg.mSize, msg.mData);
-  mSysExToHost.Add(data);
-  return true;
+  return mSysExToHost.Add(data);
 }
 
 // clap_plugin
@@ -236,6 +234,7 @@ clap_process_status IPlugCLAP::process(const clap_process* pProcess) noexcept
   }
   
   // Input Events
+  APPLY_PARAMS_SNAPSHOT
   ProcessInputEvents(pProcess->in_events);
   
   while (mMidiMsgsFromEditor.Pop(msg))
@@ -521,6 +520,9 @@ void IPlugCLAP::paramsFlush(const clap_input_events* pInputParamChanges, const c
 void IPlugCLAP::ProcessInputEvents(const clap_input_events* pInputEvents) noexcept
 {
   IMidiMsg msg;
+  
+  if (mParamAutomation.IsEnabled())
+    mParamAutomation.Clear();
 
   if (pInputEvents)
   {
@@ -581,11 +583,15 @@ void IPlugCLAP::ProcessInputEvents(const clap_input_events* pInputEvents) noexce
           IParam* pParam = GetParam(paramIdx);
           const bool isDoubleType = pParam->Type() == IParam::kTypeDouble;
           
+          if (mParamAutomation.IsEnabled())
+            mParamAutomation.Add(paramIdx, pEvent->time, isDoubleType ? value : pParam->ToNormalized(value), pParam->GetNormalized());
+          
           if (isDoubleType)
             pParam->SetNormalized(value);
           else
             pParam->Set(value);
           
+          INVALIDATE_PARAM_SNAPSHOT(paramIdx)
           SendParameterValueFromAPI(paramIdx, value, isDoubleType);
           OnParamChange(paramIdx, EParamSource::kHost, pEvent->time);
           break;
@@ -596,6 +602,9 @@ void IPlugCLAP::ProcessInputEvents(const clap_input_events* pInputEvents) noexce
       }
     }
   }
+  
+  if (mParamAutomation.IsEnabled())
+    mParamAutomation.Finalize(false);
 }
   
 void IPlugCLAP::ProcessOutputParams(const clap_output_events* pOutputParamChanges) noexcept
@@ -0,0 +1,543 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc Convolver
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "IPlugPlatform.h"
+
+#include "convoengine.h"
+#include "resample.h"
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  #define CONVOLVER_NO_THREADS
+#endif
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Multichannel convolution with WDL_ConvolutionEngine_Div, which loads impulse responses on a background thread and swaps them in with a crossfade.
+ * An impulse is either applied to each channel (mono or stereo IRs), or as a matrix of paths from nInputs inputs to nOutputs outputs,
+ * e.g. true-stereo or ambisonic IRs. In a matrix, each input has one engine that holds the impulses to all the outputs and is fed
+ * the same input on every channel, so the engine transforms the input once for each pair of outputs and uses that spectrum for both.
+ * Resampling the impulse to the sample rate and transforming its partitions happen on the loading thread. ProcessBlock() never waits for them,
+ * it keeps playing the previous impulse until the new one is ready. Without threads (WebAssembly), impulses are prepared by the caller instead.
+ * The latency is always zero.
+ * Needs WDL/convoengine.cpp, WDL/fft.c and WDL/resample.cpp
+ * @tparam T The sample type */
+template <typename T = double>
+class Convolver final
+{
+public:
+  /** How the channels of an impulse are routed */
+  enum class ERouting
+  {
+    Parallel, // Channel c is convolved with impulse channel c % NChannels, e.g. a mono or stereo IR
+    Matrix    // Impulse channel i * nOutputs + o is the path from input i to output o, e.g. LL, LR, RL, RR for true-stereo
+  };
+
+  /** @param crossfadeMs The length of the crossfade when an impulse or the sample rate changes
+   * @param nTailThreads The number of background threads per input that compute the tails of long impulses, see WDL_ConvolutionEngine_Div::SetTailThreads() */
+  Convolver(double crossfadeMs = 50., int nTailThreads = 1)
+  : mCrossfadeMs(crossfadeMs)
+  , mNTailThreads(nTailThreads)
+  {
+#ifndef CONVOLVER_NO_THREADS
+    mLoader = std::thread(&Convolver::LoaderLoop, this);
+#endif
+  }
+
+  ~Convolver()
+  {
+#ifndef CONVOLVER_NO_THREADS
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mRunning = false;
+    }
+    mCV.notify_one();
+    mLoader.join();
+#endif
+
+    delete mPending.exchange(nullptr);
+    delete mRetired.exchange(nullptr);
+    delete mCurrent;
+    delete mFadingOut;
+  }
+
+  Convolver(const Convolver&) = delete;
+  Convolver& operator=(const Convolver&) = delete;
+
+  /** Loads a new impulse, which replaces the current one once it has been prepared. Must not be called from the audio thread
+   * @param impulse The impulse, at impulse.samplerate. It is copied
+   * @param routing How the channels of the impulse are routed
+   * @param nInputs For ERouting::Matrix, the number of inputs. The number of outputs is impulse.GetNumChannels() / nInputs */
+  void LoadImpulse(WDL_ImpulseBuffer& impulse, ERouting routing = ERouting::Parallel, int nInputs = 1)
+  {
+    auto pSource = std::make_shared<Source>();
+    const int nChans = impulse.GetNumChannels();
+    const int length = impulse.GetLength();
+
+    pSource->impulse.samplerate = impulse.samplerate;
+    pSource->impulse.SetNumChannels(nChans, false);
+    pSource->impulse.SetLength(length);
+
+    for (int c = 0; c < nChans; c++)
+      memcpy(pSource->impulse.impulses[c].Get(), impulse.impulses[c].Get(), length * sizeof(WDL_FFT_REAL));
+
+    pSource->routing = routing;
+    pSource->nInputs = routing == ERouting::Matrix ? std::max(nInputs, 1) : nChans;
+    pSource->nOutputs = routing == ERouting::Matrix ? std::max(nChans / pSource->nInputs, 1) : nChans;
+
+    Request([&]() { mSource = pSource; });
+  }
+
+  /** Sets the processing parameters, and prepares the impulse again if they have changed. Call it from OnReset(), it does not block
+   * @param sampleRate The sample rate
+   * @param maxBlockSize The largest nFrames that will be passed to ProcessBlock()
+   * @param maxChannels The largest number of channels that will be passed to ProcessBlock() */
+  void Prepare(double sampleRate, int maxBlockSize, int maxChannels)
+  {
+    Request([&]() {
+      mSampleRate = sampleRate;
+      mMaxBlockSize = maxBlockSize;
+      mMaxChannels = maxChannels;
+    });
+  }
+
+  /** @return \c true if an impulse is being prepared or has not been swapped in yet */
+  bool IsLoading() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mBuiltGeneration != mRequestGeneration || mPending.load(std::memory_order_acquire) != nullptr;
+  }
+
+  /** Convolves a block, replacing the contents of outputs. The outputs must not be the same buffers as the inputs
+   * @param inputs The input channels
+   * @param nInputs The number of input channels. Inputs of a matrix impulse that are missing are silent
+   * @param outputs The output channels
+   * @param nOutputs The number of output channels. Outputs without an impulse are silent
+   * @param nFrames The number of frames */
+  void ProcessBlock(T** inputs, int nInputs, T** outputs, int nOutputs, int nFrames)
+  {
+    // swap in a new impulse, once the one that was faded out before has been deleted
+    if (!mFadingOut && !mRetired.load(std::memory_order_acquire))
+    {
+      if (EngineSet* pNew = mPending.exchange(nullptr, std::memory_order_acq_rel))
+      {
+        mFadingOut = mCurrent;
+        mCurrent = pNew;
+        mFadePos = 0;
+        mFadeLength = std::max(1, static_cast<int>(mCurrent->sampleRate * mCrossfadeMs / 1000.));
+      }
+    }
+
+    for (int c = 0; c < nOutputs; c++)
+      memset(outputs[c], 0, nFrames * sizeof(T));
+
+    if (!mCurrent)
+      return;
+
+    for (int start = 0; start < nFrames;)
+    {
+      int n = std::min(nFrames - start, mCurrent->maxBlockSize);
+
+      if (mFadingOut)
+        n = std::min(n, mFadingOut->maxBlockSize);
+
+      Render(*mCurrent, inputs, nInputs, start, n);
+
+      const int nNew = std::min(nOutputs, mCurrent->nOutputs);
+
+      if (mFadingOut)
+      {
+        Render(*mFadingOut, inputs, nInputs, start, n);
+
+        const int nOld = std::min(nOutputs, mFadingOut->nOutputs);
+        const T step = static_cast<T>(1.) / static_cast<T>(mFadeLength);
+
+        for (int c = 0; c < nOutputs; c++)
+        {
+          const WDL_FFT_REAL* pNew = c < nNew ? mCurrent->Output(c) : nullptr;
+          const WDL_FFT_REAL* pOld = c < nOld ? mFadingOut->Output(c) : nullptr;
+          T* pOut = outputs[c] + start;
+
+          for (int s = 0; s < n; s++)
+          {
+            const T gain = std::min(static_cast<T>(mFadePos + s) * step, static_cast<T>(1.));
+
+            if (pNew)
+              pOut[s] += gain * static_cast<T>(pNew[s]);
+            if (pOld)
+              pOut[s] += (static_cast<T>(1.) - gain) * static_cast<T>(pOld[s]);
+          }
+        }
+
+        mFadePos += n;
+
+        if (mFadePos >= mFadeLength)
+        {
+#ifdef CONVOLVER_NO_THREADS
+          delete mFadingOut; // there is no other thread to do it
+#else
+          mRetired.store(mFadingOut, std::memory_order_release); // deleted on the loading thread
+#endif
+          mFadingOut = nullptr;
+        }
+      }
+      else
+      {
+        for (int c = 0; c < nNew; c++)
+        {
+          const WDL_FFT_REAL* pNew = mCurrent->Output(c);
+          T* pOut = outputs[c] + start;
+
+          for (int s = 0; s < n; s++)
+            pOut[s] = static_cast<T>(pNew[s]);
+        }
+      }
+
+      start += n;
+    }
+  }
+
+private:
+  /** An impulse as it was loaded */
+  struct Source
+  {
+    WDL_ImpulseBuffer impulse;
+    ERouting routing = ERouting::Parallel;
+    int nInputs = 1;
+    int nOutputs = 1;
+  };
+
+  /** The engines for one impulse at one sample rate, and the buffers the audio thread uses with them */
+  struct EngineSet
+  {
+    std::vector<std::unique_ptr<WDL_ConvolutionEngine_Div>> engines; // One per input for ERouting::Matrix, one for all channels for ERouting::Parallel
+    ERouting routing = ERouting::Parallel;
+    int nInputs = 0;
+    int nOutputs = 0;
+    int maxBlockSize = 0;
+    double sampleRate = 0.;
+    std::vector<WDL_FFT_REAL> inputs; // Converted inputs, followed by a block of silence
+    std::vector<WDL_FFT_REAL> outputs;
+    std::vector<WDL_FFT_REAL*> ptrs;
+
+    WDL_FFT_REAL* Input(int i) { return inputs.data() + i * maxBlockSize; }
+    WDL_FFT_REAL* Silence() { return inputs.data() + nInputs * maxBlockSize; }
+    WDL_FFT_REAL* Output(int o) { return outputs.data() + o * maxBlockSize; }
+  };
+
+  /** Changes the request under the lock and wakes the loading thread, or without threads, prepares the impulse here */
+  template <typename F>
+  void Request(F&& change)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      change();
+      mRequestGeneration++;
+    }
+
+#ifdef CONVOLVER_NO_THREADS
+    Load();
+#else
+    mCV.notify_one();
+#endif
+  }
+
+  /** Convolves n frames from offset start of the inputs into the set's output buffers */
+  void Render(EngineSet& set, T** inputs, int nInputs, int start, int n)
+  {
+    // Inputs of other types are converted to WDL_FFT_REAL
+    auto getInput = [&](int i) -> WDL_FFT_REAL* {
+      if (i >= nInputs)
+        return set.Silence();
+
+      if constexpr (std::is_same<T, WDL_FFT_REAL>::value)
+        return inputs[i] + start;
+      else
+      {
+        WDL_FFT_REAL* pConverted = set.Input(i);
+        for (int s = 0; s < n; s++)
+          pConverted[s] = static_cast<WDL_FFT_REAL>(inputs[i][start + s]);
+        return pConverted;
+      }
+    };
+
+    std::fill(set.outputs.begin(), set.outputs.end(), static_cast<WDL_FFT_REAL>(0.));
+
+    if (set.routing == ERouting::Parallel)
+    {
+      const int nChans = std::min(nInputs, set.nOutputs);
+
+      if (nChans < 1)
+        return;
+
+      for (int c = 0; c < nChans; c++)
+        set.ptrs[c] = getInput(c);
+
+      Accumulate(set, *set.engines[0], nChans, n);
+    }
+    else
+    {
+      for (int i = 0; i < set.nInputs; i++)
+      {
+        // The same input on every channel, which lets the engine share its spectrum between pairs of outputs
+        WDL_FFT_REAL* pInput = getInput(i);
+
+        for (int o = 0; o < set.nOutputs; o++)
+          set.ptrs[o] = pInput;
+
+        Accumulate(set, *set.engines[i], set.nOutputs, n);
+      }
+    }
+  }
+
+  /** Feeds set.ptrs to an engine and adds its output to the set's output buffers */
+  static void Accumulate(EngineSet& set, WDL_ConvolutionEngine_Div& engine, int nChans, int n)
+  {
+    engine.Add(set.ptrs.data(), n, nChans);
+
+    const int nAvailable = std::min(engine.Avail(n), n);
+
+    if (nAvailable <= 0)
+      return;
+
+    WDL_FFT_REAL** pWet = engine.Get();
+
+    for (int c = 0; c < nChans; c++)
+    {
+      WDL_FFT_REAL* pOut = set.Output(c) + n - nAvailable;
+
+      for (int s = 0; s < nAvailable; s++)
+        pOut[s] += pWet[c][s];
+    }
+
+    engine.Advance(nAvailable);
+  }
+
+  /** Resamples one channel of an impulse, preserving its gain */
+  static void ResampleChannel(const WDL_FFT_REAL* pSrc, int srcLength, double srcRate, WDL_FFT_REAL* pDst, int dstLength, double dstRate)
+  {
+    if (srcRate == dstRate)
+    {
+      const int n = std::min(srcLength, dstLength);
+      memcpy(pDst, pSrc, n * sizeof(WDL_FFT_REAL));
+      memset(pDst + n, 0, (dstLength - n) * sizeof(WDL_FFT_REAL));
+      return;
+    }
+
+    static constexpr int kChunkSize = 1024;
+    const double scale = srcRate / dstRate;
+    std::vector<WDL_ResampleSample> buffer(static_cast<size_t>(kChunkSize / scale) + 64);
+
+    WDL_Resampler resampler;
+    resampler.SetMode(false, 0, true); // Sinc, default size
+    resampler.SetFeedMode(true); // Input driven
+    resampler.SetRates(srcRate, dstRate);
+
+    int read = 0, written = 0;
+
+    // Keeps feeding silence after the end of the impulse to flush the filter
+    while (written < dstLength && read < srcLength + kChunkSize * 4)
+    {
+      WDL_ResampleSample* pIn;
+      const int nIn = resampler.ResamplePrepare(kChunkSize, 1, &pIn);
+
+      for (int s = 0; s < nIn; s++, read++)
+        pIn[s] = read < srcLength ? static_cast<WDL_ResampleSample>(pSrc[read]) : 0;
+
+      const int nOut = std::min(resampler.ResampleOut(buffer.data(), nIn, static_cast<int>(buffer.size()), 1), dstLength - written);
+
+      for (int s = 0; s < nOut; s++)
+        pDst[written++] = static_cast<WDL_FFT_REAL>(scale * buffer[s]);
+    }
+
+    memset(pDst + written, 0, (dstLength - written) * sizeof(WDL_FFT_REAL));
+  }
+
+  /** Resamples the impulse and builds its engines, this is the slow part */
+  std::unique_ptr<EngineSet> Build(Source& source, double sampleRate, int maxBlockSize, int maxChannels) const
+  {
+    auto pSet = std::make_unique<EngineSet>();
+    EngineSet& set = *pSet;
+    WDL_ImpulseBuffer& src = source.impulse;
+    const int nChans = src.GetNumChannels();
+    const int srcLength = src.GetLength();
+    const int length = static_cast<int>(sampleRate / src.samplerate * srcLength + 0.5);
+
+    set.routing = source.routing;
+    set.sampleRate = sampleRate;
+    set.maxBlockSize = maxBlockSize;
+
+    // Tail partitions start where there is at least one block of slack
+    const int tailFFTSize = std::max(4096, maxBlockSize * 8);
+
+    auto addEngine = [&](WDL_ImpulseBuffer& impulse) {
+      auto pEngine = std::make_unique<WDL_ConvolutionEngine_Div>();
+      pEngine->SetTailThreads(mNTailThreads, tailFFTSize);
+      pEngine->SetImpulse(&impulse); // Brute force head, so no latency
+      set.engines.push_back(std::move(pEngine));
+    };
+
+    WDL_ImpulseBuffer resampled;
+    resampled.samplerate = sampleRate;
+    resampled.SetNumChannels(nChans, false);
+    resampled.SetLength(length);
+
+    for (int c = 0; c < nChans; c++)
+      ResampleChannel(src.impulses[c].Get(), srcLength, src.samplerate, resampled.impulses[c].Get(), length, sampleRate);
+
+    if (source.routing == ERouting::Parallel)
+    {
+      set.nInputs = set.nOutputs = std::max(maxChannels, 1);
+      addEngine(resampled);
+    }
+    else
+    {
+      set.nInputs = source.nInputs;
+      set.nOutputs = source.nOutputs;
+
+      for (int i = 0; i < set.nInputs; i++)
+      {
+        WDL_ImpulseBuffer paths;
+        paths.samplerate = sampleRate;
+        paths.SetNumChannels(set.nOutputs, false);
+        paths.SetLength(length);
+
+        for (int o = 0; o < set.nOutputs; o++)
+        {
+          const int c = i * set.nOutputs + o;
+          WDL_FFT_REAL* pDst = paths.impulses[o].Get();
+
+          if (c < nChans)
+            memcpy(pDst, resampled.impulses[c].Get(), length * sizeof(WDL_FFT_REAL));
+          else
+            memset(pDst, 0, length * sizeof(WDL_FFT_REAL));
+        }
+
+        addEngine(paths);
+      }
+    }
+
+    set.inputs.assign((set.nInputs + 1) * maxBlockSize, 0.);
+    set.outputs.assign(set.nOutputs * maxBlockSize, 0.);
+    set.ptrs.assign(std::max(set.nInputs, set.nOutputs), nullptr);
+
+    // The first Add() allocates each engine's channel history, output delay and tail queues, so it happens here with a
+    // silent block rather than on the audio thread. Reset() keeps those allocations
+    std::fill(set.ptrs.begin(), set.ptrs.end(), set.Silence());
+
+    for (auto& pEngine : set.engines)
+    {
+      pEngine->Add(set.ptrs.data(), maxBlockSize, set.nOutputs);
+      pEngine->Get();
+      pEngine->Reset();
+    }
+
+    return pSet;
+  }
+
+  /** Deletes a set that has been faded out, and builds the latest request if it has not been built yet */
+  void Load()
+  {
+    delete mRetired.exchange(nullptr, std::memory_order_acq_rel);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mBuiltGeneration == mRequestGeneration)
+      return;
+
+    const uint64_t generation = mRequestGeneration;
+    std::shared_ptr<Source> pSource = mSource;
+    const double sampleRate = mSampleRate;
+    const int maxBlockSize = mMaxBlockSize;
+    const int maxChannels = mMaxChannels;
+
+    if (!pSource || sampleRate <= 0. || maxBlockSize < 1)
+    {
+      mBuiltGeneration = generation;
+      return;
+    }
+
+    lock.unlock();
+    std::unique_ptr<EngineSet> pSet = Build(*pSource, sampleRate, maxBlockSize, maxChannels);
+    lock.lock();
+
+    // if another request came in meanwhile, the next call builds that instead
+    if (generation == mRequestGeneration)
+      delete mPending.exchange(pSet.release(), std::memory_order_acq_rel);
+
+    mBuiltGeneration = generation;
+  }
+
+#ifndef CONVOLVER_NO_THREADS
+  void LoaderLoop()
+  {
+    while (true)
+    {
+      Load();
+
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      if (!mRunning)
+        return;
+
+      // wakes up regularly to delete sets that have been faded out, since the audio thread does not notify
+      if (mBuiltGeneration == mRequestGeneration)
+        mCV.wait_for(lock, std::chrono::milliseconds(100));
+    }
+  }
+#endif
+
+  const double mCrossfadeMs;
+  const int mNTailThreads;
+
+  // Owned by the audio thread
+  EngineSet* mCurrent = nullptr;
+  EngineSet* mFadingOut = nullptr;
+  int mFadePos = 0;
+  int mFadeLength = 1;
+
+  // Handed between the threads
+  std::atomic<EngineSet*> mPending {nullptr}; // Built, waiting to be swapped in
+  std::atomic<EngineSet*> mRetired {nullptr}; // Faded out, waiting to be deleted
+
+  // The request, guarded by mMutex
+  mutable std::mutex mMutex;
+  std::condition_variable mCV;
+  std::shared_ptr<Source> mSource;
+  double mSampleRate = 0.;
+  int mMaxBlockSize = 0;
+  int mMaxChannels = 0;
+  uint64_t mRequestGeneration = 0;
+  uint64_t mBuiltGeneration = 0;
+  bool mRunning = true;
+
+#ifndef CONVOLVER_NO_THREADS
+  std::thread mLoader;
+#endif
+};
+
+END_IPLUG_NAMESPACE
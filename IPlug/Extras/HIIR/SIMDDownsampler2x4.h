@@ -0,0 +1,124 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/*
+SIMDDownsampler2x4.h
+
+Downsamples by a factor 2 four channels at once, one channel per SIMD lane.
+See SIMDStageProc4.h for the data layout.
+
+Template parameters:
+- NC: number of coefficients, > 0
+- T: float or double
+*/
+
+#include <cassert>
+
+#include "SIMDStageProc4.h"
+
+namespace hiir
+{
+
+template <int NC, typename T>
+class Downsampler2x4SIMD
+{
+public:
+
+  enum { NBR_COEFS = NC };
+  enum { NBR_CHANS = 4 };
+
+  typedef Lanes4 <T> L;
+  typedef typename L::Vec Vec;
+
+  Downsampler2x4SIMD ()
+  {
+    for (int i = 0; i < NBR_COEFS; ++i)
+    {
+      _coef [i] = L::set1 (0);
+    }
+    clear_buffers ();
+  }
+
+  /*
+  Name: set_coefs
+  Description:
+    Sets filter coefficients, the same for all channels.
+    Call this function before doing any processing.
+  Input parameters:
+    - coef_arr: Array of NBR_COEFS coefficients.
+  */
+  void set_coefs (const double coef_arr [NBR_COEFS])
+  {
+    assert (coef_arr != 0);
+
+    for (int i = 0; i < NBR_COEFS; ++i)
+    {
+      _coef [i] = L::set1 (static_cast <T> (coef_arr [i]));
+    }
+  }
+
+  /*
+  Name: process_block
+  Description:
+    Downsamples (x2) an interleaved block of four channels.
+    Input and output blocks may overlap, see assert() for details.
+  Input parameters:
+    - in_ptr: Input array, containing nbr_spl * 2 * 4 samples.
+    - nbr_spl: Number of output frames to generate, > 0
+  Output parameters:
+    - out_ptr: Output array, capacity: nbr_spl * 4 samples.
+  */
+  void process_block (T out_ptr [], const T in_ptr [], long nbr_spl)
+  {
+    assert (out_ptr != 0);
+    assert (in_ptr != 0);
+    assert (out_ptr <= in_ptr || out_ptr >= in_ptr + nbr_spl * 2 * NBR_CHANS);
+    assert (nbr_spl > 0);
+
+    const Vec half = L::set1 (static_cast <T> (0.5f));
+
+    for (long pos = 0; pos < nbr_spl; ++pos)
+    {
+      Vec spl_0 = L::load (in_ptr + pos * 2 * NBR_CHANS + NBR_CHANS);
+      Vec spl_1 = L::load (in_ptr + pos * 2 * NBR_CHANS);
+      StageProc4SIMD <NBR_COEFS, T>::process_sample_pos (spl_0, spl_1, _coef, _x, _y);
+      L::store (out_ptr + pos * NBR_CHANS, L::mul (L::add (spl_0, spl_1), half));
+    }
+  }
+
+  /*
+  Name: clear_buffers
+  Description:
+    Clears filter memory, as if it processed silence since an infinite amount
+    of time.
+  */
+  void clear_buffers ()
+  {
+    for (int i = 0; i < NBR_COEFS; ++i)
+    {
+      _x [i] = L::set1 (0);
+      _y [i] = L::set1 (0);
+    }
+  }
+
+private:
+  Vec _coef [NBR_COEFS];
+  Vec _x [NBR_COEFS];
+  Vec _y [NBR_COEFS];
+
+private:
+  Downsampler2x4SIMD (const Downsampler2x4SIMD &other);
+  Downsampler2x4SIMD& operator = (const Downsampler2x4SIMD &other);
+
+};  // class Downsampler2x4SIMD
+
+} // namespace hiir
@@ -0,0 +1,152 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/*
+SIMDStageProc4.h
+
+Four-lane vector type and allpass cascade shared by Upsampler2x4SIMD and
+Downsampler2x4SIMD. Each lane holds one channel, so four channels run through
+the same cascade at once. The data is interleaved: lane c of frame i is at
+index i * 4 + c.
+
+Define IPLUG_SIMDE at project level to use SSE2 (and AVX for double when the
+compiler targets it). On non-x86 targets include the SIMDE library in your
+search paths in order to translate the intel intrinsics to e.g. NEON. Without
+IPLUG_SIMDE a plain array is used, which compilers will usually vectorize.
+*/
+
+#if defined IPLUG_SIMDE
+  #if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #if defined(__AVX__)
+      #include <immintrin.h>
+    #endif
+  #else
+    #define SIMDE_ENABLE_NATIVE_ALIASES
+    #include "simde/x86/sse2.h"
+  #endif
+#endif
+
+namespace hiir
+{
+
+template <typename T>
+struct Lanes4
+{
+  enum { NBR_LANES = 4 };
+
+  struct Vec { T v[NBR_LANES]; };
+
+  static inline Vec load(const T* ptr) { Vec r; for (int i = 0; i < NBR_LANES; ++i) r.v[i] = ptr[i]; return r; }
+  static inline void store(T* ptr, const Vec& a) { for (int i = 0; i < NBR_LANES; ++i) ptr[i] = a.v[i]; }
+  static inline Vec set1(T x) { Vec r; for (int i = 0; i < NBR_LANES; ++i) r.v[i] = x; return r; }
+  static inline Vec add(const Vec& a, const Vec& b) { Vec r; for (int i = 0; i < NBR_LANES; ++i) r.v[i] = a.v[i] + b.v[i]; return r; }
+  static inline Vec sub(const Vec& a, const Vec& b) { Vec r; for (int i = 0; i < NBR_LANES; ++i) r.v[i] = a.v[i] - b.v[i]; return r; }
+  static inline Vec mul(const Vec& a, const Vec& b) { Vec r; for (int i = 0; i < NBR_LANES; ++i) r.v[i] = a.v[i] * b.v[i]; return r; }
+};
+
+#if defined IPLUG_SIMDE
+template <>
+struct Lanes4 <float>
+{
+  enum { NBR_LANES = 4 };
+
+  typedef __m128 Vec;
+
+  static inline Vec load(const float* ptr) { return _mm_loadu_ps(ptr); }
+  static inline void store(float* ptr, Vec a) { _mm_storeu_ps(ptr, a); }
+  static inline Vec set1(float x) { return _mm_set1_ps(x); }
+  static inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+  static inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+  static inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+};
+
+#if defined(__AVX__)
+template <>
+struct Lanes4 <double>
+{
+  enum { NBR_LANES = 4 };
+
+  typedef __m256d Vec;
+
+  static inline Vec load(const double* ptr) { return _mm256_loadu_pd(ptr); }
+  static inline void store(double* ptr, Vec a) { _mm256_storeu_pd(ptr, a); }
+  static inline Vec set1(double x) { return _mm256_set1_pd(x); }
+  static inline Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+  static inline Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+  static inline Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+};
+#else
+template <>
+struct Lanes4 <double>
+{
+  enum { NBR_LANES = 4 };
+
+  // Two SSE2 registers of two doubles each
+  struct Vec { __m128d lo; __m128d hi; };
+
+  static inline Vec load(const double* ptr) { return { _mm_loadu_pd(ptr), _mm_loadu_pd(ptr + 2) }; }
+  static inline void store(double* ptr, const Vec& a) { _mm_storeu_pd(ptr, a.lo); _mm_storeu_pd(ptr + 2, a.hi); }
+  static inline Vec set1(double x) { return { _mm_set1_pd(x), _mm_set1_pd(x) }; }
+  static inline Vec add(const Vec& a, const Vec& b) { return { _mm_add_pd(a.lo, b.lo), _mm_add_pd(a.hi, b.hi) }; }
+  static inline Vec sub(const Vec& a, const Vec& b) { return { _mm_sub_pd(a.lo, b.lo), _mm_sub_pd(a.hi, b.hi) }; }
+  static inline Vec mul(const Vec& a, const Vec& b) { return { _mm_mul_pd(a.lo, b.lo), _mm_mul_pd(a.hi, b.hi) }; }
+};
+#endif
+#endif
+
+/*
+Runs the two polyphase paths through the allpass cascade, with the same
+arithmetic as StageProcFPU::process_sample_pos() so that each lane gives the
+same result as the FPU version. NC is a compile time constant, so the loop is
+unrolled by the compiler.
+*/
+template <int NC, typename T>
+class StageProc4SIMD
+{
+public:
+  typedef Lanes4 <T> L;
+  typedef typename L::Vec Vec;
+
+  static inline void process_sample_pos (Vec &spl_0, Vec &spl_1, const Vec coef [NC], Vec x [NC], Vec y [NC])
+  {
+    int cnt = 0;
+
+    for (; cnt + 1 < NC; cnt += 2)
+    {
+      const Vec temp_0 = L::add (L::mul (L::sub (spl_0, y [cnt + 0]), coef [cnt + 0]), x [cnt + 0]);
+      const Vec temp_1 = L::add (L::mul (L::sub (spl_1, y [cnt + 1]), coef [cnt + 1]), x [cnt + 1]);
+
+      x [cnt + 0] = spl_0;
+      x [cnt + 1] = spl_1;
+
+      y [cnt + 0] = temp_0;
+      y [cnt + 1] = temp_1;
+
+      spl_0 = temp_0;
+      spl_1 = temp_1;
+    }
+
+    if (cnt < NC)
+    {
+      const Vec temp = L::add (L::mul (L::sub (spl_0, y [cnt]), coef [cnt]), x [cnt]);
+      x [cnt] = spl_0;
+      y [cnt] = temp;
+      spl_0 = temp;
+    }
+  }
+
+private:
+  StageProc4SIMD();
+};
+
+} // namespace hiir
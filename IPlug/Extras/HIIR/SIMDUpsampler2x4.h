@@ -0,0 +1,123 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/*
+SIMDUpsampler2x4.h
+
+Upsamples by a factor 2 four channels at once, one channel per SIMD lane.
+See SIMDStageProc4.h for the data layout.
+
+Template parameters:
+- NC: number of coefficients, > 0
+- T: float or double
+*/
+
+#include <cassert>
+
+#include "SIMDStageProc4.h"
+
+namespace hiir
+{
+
+template <int NC, typename T>
+class Upsampler2x4SIMD
+{
+public:
+
+  enum { NBR_COEFS = NC };
+  enum { NBR_CHANS = 4 };
+
+  typedef Lanes4 <T> L;
+  typedef typename L::Vec Vec;
+
+  Upsampler2x4SIMD ()
+  {
+    for (int i = 0; i < NBR_COEFS; ++i)
+    {
+      _coef [i] = L::set1 (0);
+    }
+    clear_buffers ();
+  }
+
+  /*
+  Name: set_coefs
+  Description:
+    Sets filter coefficients, the same for all channels.
+    Call this function before doing any processing.
+  Input parameters:
+    - coef_arr: Array of NBR_COEFS coefficients.
+  */
+  void set_coefs (const double coef_arr [NBR_COEFS])
+  {
+    assert (coef_arr != 0);
+
+    for (int i = 0; i < NBR_COEFS; ++i)
+    {
+      _coef [i] = L::set1 (static_cast <T> (coef_arr [i]));
+    }
+  }
+
+  /*
+  Name: process_block
+  Description:
+    Upsamples (x2) an interleaved block of four channels.
+  Input parameters:
+    - in_ptr: Input array, containing nbr_spl * 4 samples.
+    - nbr_spl: Number of input frames to process, > 0
+  Output parameters:
+    - out_ptr: Output array, capacity: nbr_spl * 2 * 4 samples.
+      Must not overlap the input.
+  */
+  void process_block (T out_ptr [], const T in_ptr [], long nbr_spl)
+  {
+    assert (out_ptr != 0);
+    assert (in_ptr != 0);
+    assert (out_ptr >= in_ptr + nbr_spl * NBR_CHANS || in_ptr >= out_ptr + nbr_spl * 2 * NBR_CHANS);
+    assert (nbr_spl > 0);
+
+    for (long pos = 0; pos < nbr_spl; ++pos)
+    {
+      Vec even = L::load (in_ptr + pos * NBR_CHANS);
+      Vec odd = even;
+      StageProc4SIMD <NBR_COEFS, T>::process_sample_pos (even, odd, _coef, _x, _y);
+      L::store (out_ptr + pos * 2 * NBR_CHANS, even);
+      L::store (out_ptr + pos * 2 * NBR_CHANS + NBR_CHANS, odd);
+    }
+  }
+
+  /*
+  Name: clear_buffers
+  Description:
+    Clears filter memory, as if it processed silence since an infinite amount
+    of time.
+  */
+  void clear_buffers ()
+  {
+    for (int i = 0; i < NBR_COEFS; ++i)
+    {
+      _x [i] = L::set1 (0);
+      _y [i] = L::set1 (0);
+    }
+  }
+
+private:
+  Vec _coef [NBR_COEFS];
+  Vec _x [NBR_COEFS];
+  Vec _y [NBR_COEFS];
+
+private:
+  Upsampler2x4SIMD (const Upsampler2x4SIMD &other);
+  Upsampler2x4SIMD& operator = (const Upsampler2x4SIMD &other);
+
+};  // class Upsampler2x4SIMD
+
+} // namespace hiir
@@ -0,0 +1,388 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * Linear-phase half-band FIR filters for 2x up-sampling and down-sampling, used by OverSampler with EOverSamplingFilter::kLinearPhaseFIR.
+ * The filters are implemented in polyphase form: half of the taps of a half-band filter are zero, so one phase is a pure delay and the
+ * other a symmetric FIR with (N + 1) / 2 taps. Define OVERSAMPLER_FIR_FFT at project level to convolve long kernels with a uniformly
+ * partitioned FFT (the first partition is still convolved directly, so the latency does not change). This requires WDL/fft.c in your project,
+ * and WDL_FFT_REALSIZE 8 if the stop band attenuation is more than about 130 dB, since the FFT is single precision by default.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#ifdef OVERSAMPLER_FIR_FFT
+#include "fft.h"
+#endif
+
+#include "IPlugPlatform.h"
+#include "IPlugConstants.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Designs a Kaiser-windowed half-band low-pass filter, with its cutoff at a quarter of the sampling rate
+ * @param transitionWidth The width of the transition band, as a fraction of the sampling rate
+ * @param stopbandDB The stop band attenuation in dB. The pass band ripple of a half-band filter is the same as the stop band ripple.
+ * The length is Kaiser's estimate, which is optimistic for short filters: with a wide transition band they can fall a few dB short
+ * @return The filter taps. The length is always 4k + 3, so that the centre tap is at an odd index */
+static inline std::vector<double> DesignHalfBandFIR(double transitionWidth, double stopbandDB)
+{
+  auto besselI0 = [](double x) {
+    double sum = 1., term = 1.;
+
+    for (auto k = 1; k < 64 && term > sum * 1e-12; k++)
+    {
+      term *= (x * x) / (4. * k * k);
+      sum += term;
+    }
+
+    return sum;
+  };
+
+  const double beta = stopbandDB > 50. ? 0.1102 * (stopbandDB - 8.7)
+                    : stopbandDB > 21. ? 0.5842 * std::pow(stopbandDB - 21., 0.4) + 0.07886 * (stopbandDB - 21.)
+                    : 0.;
+
+  const int minTaps = static_cast<int>(std::ceil((stopbandDB - 7.95) / (14.36 * transitionWidth))) + 1;
+  const int k = std::max(0, (minTaps - 3 + 3) / 4);
+  const int nTaps = 4 * k + 3;
+  const int centre = (nTaps - 1) / 2;
+
+  std::vector<double> taps(nTaps, 0.);
+
+  for (auto n = 0; n < nTaps; n++)
+  {
+    const int offset = n - centre;
+
+    if (offset == 0)
+      taps[n] = 0.5;
+    else if (offset & 1)
+    {
+      const double r = static_cast<double>(offset) / centre;
+      const double window = besselI0(beta * std::sqrt(1. - r * r)) / besselI0(beta);
+      taps[n] = std::sin(PI * 0.5 * offset) / (PI * offset) * window;
+    }
+  }
+
+  return taps;
+}
+
+/** A FIR filter that processes one sample at a time. Long kernels can be convolved with a uniformly partitioned FFT, see OVERSAMPLER_FIR_FFT */
+template <typename T = double>
+class PolyphaseFIRBranch
+{
+public:
+  /** Kernels at least this long use the FFT when OVERSAMPLER_FIR_FFT is defined */
+  static constexpr int kMinFFTKernelSize = 128;
+  /** The partition size of the FFT convolution, which is also the number of taps convolved directly */
+  static constexpr int kPartitionSize = 32;
+
+  void SetKernel(const std::vector<T>& kernel)
+  {
+    mKernel = kernel;
+
+#ifdef OVERSAMPLER_FIR_FFT
+    mNPartitions = 0;
+
+    if (static_cast<int>(kernel.size()) >= kMinFFTKernelSize)
+    {
+      WDL_fft_init();
+
+      constexpr int fftSize = 2 * kPartitionSize;
+      mNPartitions = (static_cast<int>(kernel.size()) - 1) / kPartitionSize; // excluding the first, direct partition
+      mKernel.resize(kPartitionSize);
+      mKernelSpectra.assign(mNPartitions * fftSize, 0.f);
+
+      for (auto p = 0; p < mNPartitions; p++)
+      {
+        WDL_FFT_REAL* pSpectrum = mKernelSpectra.data() + p * fftSize;
+
+        for (auto i = 0; i < kPartitionSize; i++)
+        {
+          const size_t idx = (p + 1) * kPartitionSize + i;
+          // A product of two WDL_real_fft() spectra comes back from the inverse transform scaled by 4 * fftSize
+          pSpectrum[i] = idx < kernel.size() ? static_cast<WDL_FFT_REAL>(kernel[idx] * 0.25 / fftSize) : 0.f;
+        }
+
+        WDL_real_fft(pSpectrum, fftSize, 0);
+      }
+    }
+#endif
+
+    Reset();
+  }
+
+  int GetKernelSize() const
+  {
+#ifdef OVERSAMPLER_FIR_FFT
+    if (mNPartitions)
+      return (mNPartitions + 1) * kPartitionSize;
+#endif
+    return static_cast<int>(mKernel.size());
+  }
+
+  void Reset()
+  {
+    const size_t size = mKernel.size();
+    mHistory.assign(2 * std::max<size_t>(size, 1), T(0));
+    mHistoryPos = 0;
+
+#ifdef OVERSAMPLER_FIR_FFT
+    constexpr int fftSize = 2 * kPartitionSize;
+    mInputBlocks.assign(fftSize, 0.f);
+    mInputSpectra.assign(mNPartitions * fftSize, 0.f);
+    mAccum.assign(fftSize, 0.f);
+    mTail.assign(kPartitionSize, 0.f);
+    mBlockPos = 0;
+    mSpectrumPos = 0;
+#endif
+  }
+
+  /** @param input The next input sample
+   * @return The next output sample */
+  inline T Process(T input)
+  {
+    const int size = static_cast<int>(mKernel.size());
+
+    // The history is stored twice, newest first, so the window is always contiguous
+    mHistoryPos = (mHistoryPos == 0 ? size : mHistoryPos) - 1;
+    mHistory[mHistoryPos] = mHistory[mHistoryPos + size] = input;
+
+    const T* pX = mHistory.data() + mHistoryPos;
+    const T* pK = mKernel.data();
+    T sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+    int i = 0;
+
+    for (; i + 4 <= size; i += 4)
+    {
+      sum0 += pX[i] * pK[i];
+      sum1 += pX[i + 1] * pK[i + 1];
+      sum2 += pX[i + 2] * pK[i + 2];
+      sum3 += pX[i + 3] * pK[i + 3];
+    }
+
+    for (; i < size; i++)
+      sum0 += pX[i] * pK[i];
+
+    T output = (sum0 + sum1) + (sum2 + sum3);
+
+#ifdef OVERSAMPLER_FIR_FFT
+    if (mNPartitions)
+    {
+      output += static_cast<T>(mTail[mBlockPos]);
+      mInputBlocks[kPartitionSize + mBlockPos] = static_cast<WDL_FFT_REAL>(input);
+
+      if (++mBlockPos == kPartitionSize)
+      {
+        ProcessPartitions();
+        mBlockPos = 0;
+      }
+    }
+#endif
+
+    return output;
+  }
+
+private:
+#ifdef OVERSAMPLER_FIR_FFT
+  /** Called once a block of input is complete. Computes the contribution of all but the first partition to the next block of output, overlap-save style */
+  void ProcessPartitions()
+  {
+    constexpr int fftSize = 2 * kPartitionSize;
+    constexpr int nBins = kPartitionSize; // WDL_real_fft() packs the Nyquist bin into the imaginary part of bin 0
+
+    mSpectrumPos = (mSpectrumPos == 0 ? mNPartitions : mSpectrumPos) - 1;
+    WDL_FFT_REAL* pNewest = mInputSpectra.data() + mSpectrumPos * fftSize;
+    std::copy(mInputBlocks.begin(), mInputBlocks.end(), pNewest);
+    WDL_real_fft(pNewest, fftSize, 0);
+
+    // keep the block just completed as the first half of the next FFT input
+    std::copy(mInputBlocks.begin() + kPartitionSize, mInputBlocks.end(), mInputBlocks.begin());
+
+    std::fill(mAccum.begin(), mAccum.end(), 0.f);
+    WDL_FFT_COMPLEX* pAccum = reinterpret_cast<WDL_FFT_COMPLEX*>(mAccum.data());
+
+    // partition p + 1 is applied to the input spectrum of p blocks ago
+    for (auto p = 0; p < mNPartitions; p++)
+    {
+      const int slot = (mSpectrumPos + p) % mNPartitions;
+      const WDL_FFT_COMPLEX* pX = reinterpret_cast<const WDL_FFT_COMPLEX*>(mInputSpectra.data() + slot * fftSize);
+      const WDL_FFT_COMPLEX* pH = reinterpret_cast<const WDL_FFT_COMPLEX*>(mKernelSpectra.data() + p * fftSize);
+
+      pAccum[0].re += pX[0].re * pH[0].re;
+      pAccum[0].im += pX[0].im * pH[0].im;
+
+      for (auto b = 1; b < nBins; b++)
+      {
+        pAccum[b].re += pX[b].re * pH[b].re - pX[b].im * pH[b].im;
+        pAccum[b].im += pX[b].re * pH[b].im + pX[b].im * pH[b].re;
+      }
+    }
+
+    WDL_real_fft(mAccum.data(), fftSize, 1);
+    std::copy(mAccum.begin() + kPartitionSize, mAccum.end(), mTail.begin());
+  }
+
+  int mNPartitions = 0;
+  int mBlockPos = 0;
+  int mSpectrumPos = 0;
+  std::vector<WDL_FFT_REAL> mKernelSpectra;
+  std::vector<WDL_FFT_REAL> mInputSpectra;
+  std::vector<WDL_FFT_REAL> mInputBlocks;
+  std::vector<WDL_FFT_REAL> mAccum;
+  std::vector<WDL_FFT_REAL> mTail;
+#endif
+
+  std::vector<T> mKernel;
+  std::vector<T> mHistory;
+  int mHistoryPos = 0;
+};
+
+/** A fixed delay of a few samples, for the pure delay phase of a half-band filter */
+template <typename T = double>
+class PolyphaseDelayBranch
+{
+public:
+  void SetDelay(int delay)
+  {
+    mBuffer.assign(delay, T(0));
+    mPos = 0;
+  }
+
+  void Reset()
+  {
+    std::fill(mBuffer.begin(), mBuffer.end(), T(0));
+    mPos = 0;
+  }
+
+  inline T Process(T input)
+  {
+    if (mBuffer.empty())
+      return input;
+
+    const T output = mBuffer[mPos];
+    mBuffer[mPos] = input;
+
+    if (++mPos == static_cast<int>(mBuffer.size()))
+      mPos = 0;
+
+    return output;
+  }
+
+private:
+  std::vector<T> mBuffer;
+  int mPos = 0;
+};
+
+/** Up-samples by a factor of 2 with a linear-phase half-band FIR filter */
+template <typename T = double>
+class HalfBandFIRUpsampler2x
+{
+public:
+  /** @param taps A half-band filter from DesignHalfBandFIR() */
+  void SetTaps(const std::vector<double>& taps)
+  {
+    const int nTaps = static_cast<int>(taps.size());
+    assert((nTaps & 3) == 3);
+
+    // The even taps form one phase, scaled by 2 to make up for the zeros stuffed between input samples. The odd phase is the centre tap only
+    std::vector<T> kernel((nTaps + 1) / 2);
+
+    for (auto i = 0; i < static_cast<int>(kernel.size()); i++)
+      kernel[i] = static_cast<T>(2. * taps[2 * i]);
+
+    mFIR.SetKernel(kernel);
+    mDelay.SetDelay((nTaps - 3) / 4);
+    mLatency = (nTaps - 1) / 2;
+  }
+
+  /** @return The group delay in samples at the higher sampling rate */
+  int GetLatency() const { return mLatency; }
+
+  void Reset()
+  {
+    mFIR.Reset();
+    mDelay.Reset();
+  }
+
+  /** @param pOut Output array, capacity: nFrames * 2 samples
+   * @param pIn Input array, containing nFrames samples */
+  void ProcessBlock(T* pOut, const T* pIn, int nFrames)
+  {
+    for (auto i = 0; i < nFrames; i++)
+    {
+      const T input = pIn[i];
+      pOut[2 * i] = mFIR.Process(input);
+      pOut[2 * i + 1] = mDelay.Process(input);
+    }
+  }
+
+private:
+  PolyphaseFIRBranch<T> mFIR;
+  PolyphaseDelayBranch<T> mDelay;
+  int mLatency = 0;
+};
+
+/** Down-samples by a factor of 2 with a linear-phase half-band FIR filter */
+template <typename T = double>
+class HalfBandFIRDownsampler2x
+{
+public:
+  /** @param taps A half-band filter from DesignHalfBandFIR() */
+  void SetTaps(const std::vector<double>& taps)
+  {
+    const int nTaps = static_cast<int>(taps.size());
+    assert((nTaps & 3) == 3);
+
+    std::vector<T> kernel((nTaps + 1) / 2);
+
+    for (auto i = 0; i < static_cast<int>(kernel.size()); i++)
+      kernel[i] = static_cast<T>(taps[2 * i]);
+
+    mFIR.SetKernel(kernel);
+    mDelay.SetDelay((nTaps + 1) / 4);
+    mLatency = (nTaps - 1) / 2;
+  }
+
+  /** @return The group delay in samples at the higher sampling rate */
+  int GetLatency() const { return mLatency; }
+
+  void Reset()
+  {
+    mFIR.Reset();
+    mDelay.Reset();
+  }
+
+  /** @param pOut Output array, capacity: nFrames samples
+   * @param pIn Input array, containing nFrames * 2 samples. May be the same as pOut */
+  void ProcessBlock(T* pOut, const T* pIn, int nFrames)
+  {
+    for (auto i = 0; i < nFrames; i++)
+    {
+      const T even = pIn[2 * i];
+      const T odd = pIn[2 * i + 1];
+      // the odd sample of the previous pair lines up with the centre tap
+      pOut[i] = mFIR.Process(even) + T(0.5) * mDelay.Process(odd);
+    }
+  }
+
+private:
+  PolyphaseFIRBranch<T> mFIR;
+  PolyphaseDelayBranch<T> mDelay;
+  int mLatency = 0;
+};
+
+END_IPLUG_NAMESPACE
@@ -59,13 +59,17 @@
 #include <utility>
 #include <cmath>
 #include <cstring>
+#include <mutex>
 
 #if defined IPLUG_SIMDE
-  #if defined(__arm64__)
+  #if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #if defined(__AVX__)
+      #include <immintrin.h>
+    #endif
+  #else
     #define SIMDE_ENABLE_NATIVE_ALIASES
     #include "simde/x86/sse2.h"
-  #else
-    #include <emmintrin.h>
   #endif
 #endif
 
@@ -73,12 +77,187 @@
 
 namespace iplug
 {
+/* LanczosTable
+ *
+ * The Lanczos kernel sampled at kTablePoints + 1 fractional positions, and the
+ * differences between neighbouring positions for linear interpolation.
+ * Each row holds the 2A taps for one position, in the order they are applied to
+ * the input. The table only depends on T and A, so every LanczosResampler with
+ * the same sample type and filter size shares it, whatever its channel count.
+ *
+ * @tparam T the sampletype
+ * @tparam A The Lanczos filter size
+ */
+template<typename T, size_t A>
+class LanczosTable
+{
+public:
+  // The filter width. 2x because the filter goes from -A to A
+  static constexpr size_t kFilterWidth = A * 2;
+  // The discretization resolution for the filter table.
+  static constexpr size_t kTablePoints = 8192;
+
+  /** Builds the table on the first call. This is thread-safe, and calls after
+   * the first one return immediately */
+  static void Init()
+  {
+    static std::once_flag flag;
+    std::call_once(flag, Build);
+  }
+
+  static const T* Row(int tableIndex) { return sTable[tableIndex]; }
+  static const T* DeltaRow(int tableIndex) { return sDeltaTable[tableIndex]; }
+
+private:
+  static void Build()
+  {
+    const double pi = iplug::PI;
+
+    for (auto t=0; t<kTablePoints+1; ++t)
+    {
+      const double x0 = static_cast<double>(t) / kTablePoints;
+      // sin(pi * (x0 + i - A)) only differs from sin(pi * x0) in sign
+      const double sinPiX0 = std::sin(pi * x0);
+
+      for (auto i=0; i<kFilterWidth; ++i)
+      {
+        const double x = x0 + i - static_cast<double>(A);
+
+        if (std::fabs(x) < 1e-7)
+          sTable[t][i] = T(1.0);
+        else
+        {
+          const double sinPiX = ((i + A) & 1) ? -sinPiX0 : sinPiX0;
+          sTable[t][i] = T(A * sinPiX * std::sin(pi * x / A) / (pi * pi * x * x));
+        }
+      }
+    }
+
+    for (auto t=0; t<kTablePoints; ++t)
+    {
+      for (auto i=0; i<kFilterWidth; ++i)
+      {
+        sDeltaTable[t][i] = sTable[t + 1][i] - sTable[t][i];
+      }
+    }
+
+    for (auto i=0; i<kFilterWidth; ++i)
+    {
+      // Wrap at the end - delta is the same
+      sDeltaTable[kTablePoints][i] = sDeltaTable[0][i];
+    }
+  }
+
+  static T sTable alignas(32)[kTablePoints + 1][kFilterWidth];
+  static T sDeltaTable alignas(32)[kTablePoints + 1][kFilterWidth];
+};
+
+template<typename T, size_t A>
+T LanczosTable<T, A>::sTable alignas(32) [LanczosTable<T, A>::kTablePoints + 1][LanczosTable<T, A>::kFilterWidth];
+
+template<typename T, size_t A>
+T LanczosTable<T, A>::sDeltaTable alignas(32) [LanczosTable<T, A>::kTablePoints + 1][LanczosTable<T, A>::kFilterWidth];
+
+#if defined IPLUG_SIMDE
+/* LanczosLanes
+ *
+ * The vector type LanczosResampler uses for each sample type: the widest one the
+ * compiler targets, so AVX when it is enabled and SSE2 otherwise (NEON via SIMDE).
+ */
+template<typename T>
+struct LanczosLanes;
+
+#if defined(__AVX__)
+template<>
+struct LanczosLanes<float>
+{
+  static constexpr int kWidth = 8;
+  using Vec = __m256;
+
+  static inline Vec Zero() { return _mm256_setzero_ps(); }
+  static inline Vec Set1(float x) { return _mm256_set1_ps(x); }
+  static inline Vec Load(const float* ptr) { return _mm256_loadu_ps(ptr); }
+  static inline void Store(float* ptr, Vec a) { _mm256_storeu_ps(ptr, a); }
+  static inline Vec Add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+  static inline Vec Mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+
+  static inline float Sum(Vec a)
+  {
+    __m128 v = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)));
+  }
+};
+
+template<>
+struct LanczosLanes<double>
+{
+  static constexpr int kWidth = 4;
+  using Vec = __m256d;
+
+  static inline Vec Zero() { return _mm256_setzero_pd(); }
+  static inline Vec Set1(double x) { return _mm256_set1_pd(x); }
+  static inline Vec Load(const double* ptr) { return _mm256_loadu_pd(ptr); }
+  static inline void Store(double* ptr, Vec a) { _mm256_storeu_pd(ptr, a); }
+  static inline Vec Add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+  static inline Vec Mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+
+  static inline double Sum(Vec a)
+  {
+    const __m128d v = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+  }
+};
+#else
+template<>
+struct LanczosLanes<float>
+{
+  static constexpr int kWidth = 4;
+  using Vec = __m128;
+
+  static inline Vec Zero() { return _mm_setzero_ps(); }
+  static inline Vec Set1(float x) { return _mm_set1_ps(x); }
+  static inline Vec Load(const float* ptr) { return _mm_loadu_ps(ptr); }
+  static inline void Store(float* ptr, Vec a) { _mm_storeu_ps(ptr, a); }
+  static inline Vec Add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+  static inline Vec Mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+
+  static inline float Sum(Vec a)
+  {
+    const __m128 v = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)));
+  }
+};
+
+template<>
+struct LanczosLanes<double>
+{
+  static constexpr int kWidth = 2;
+  using Vec = __m128d;
+
+  static inline Vec Zero() { return _mm_setzero_pd(); }
+  static inline Vec Set1(double x) { return _mm_set1_pd(x); }
+  static inline Vec Load(const double* ptr) { return _mm_loadu_pd(ptr); }
+  static inline void Store(double* ptr, Vec a) { _mm_storeu_pd(ptr, a); }
+  static inline Vec Add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+  static inline Vec Mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+
+  static inline double Sum(Vec a) { return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a))); }
+};
+#endif
+#endif
+
 /* LanczosResampler
  *
  * A class that implements Lanczos resampling, optionally using SIMD instructions.
  * Define IPLUG_SIMDE at project level in order to use SIMD and if on non-x86_64
  * include the SIMDE library in your search paths in order to translate intel
- * intrinsics to e.g. arm64
+ * intrinsics to e.g. arm64. Both float and double are vectorized, with AVX when
+ * the compiler targets it.
+ *
+ * The kernel table is shared (see LanczosTable) and built by the first
+ * constructor. Call InitTables() ahead of time, e.g. in the plug-in constructor,
+ * to avoid that cost when the first resampler is created.
  *
  * See https://en.wikipedia.org/wiki/Lanczos_resampling
  *
@@ -92,18 +271,13 @@ template<typename T = double, int NCHANS=2, size_t A=12>
 class LanczosResampler
 {
 private:
-#if IPLUG_SIMDE
-  static_assert(std::is_same<T, float>::value, "LanczosResampler requires T to be float when using SIMD instructions");
-#endif
+  using Table = LanczosTable<T, A>;
 
   // The buffer size. This needs to be at least as large as the largest block of samples
   // that the input side will see.
   static constexpr size_t kBufferSize = 4096;
-  // The filter width. 2x because the filter goes from -A to A
-  static constexpr size_t kFilterWidth = A * 2;
-  // The discretization resolution for the filter table.
-  static constexpr size_t kTablePoints = 8192;
-  static constexpr double kDeltaX = 1.0 / (kTablePoints);
+  static constexpr size_t kFilterWidth = Table::kFilterWidth;
+  static constexpr size_t kTablePoints = Table::kTablePoints;
 
 public:
   /** Constructor
@@ -116,43 +290,14 @@ public:
   , mPhaseOutIncr(mInputSampleRate / mOutputSamplerate)
   {
     ClearBuffer();
-    
-    auto kernel = [](double x) {
-      if (std::fabs(x) < 1e-7)
-        return T(1.0);
-      
-      const auto pi = iplug::PI;
-      return T(A * std::sin(pi * x) * std::sin(pi * x / A) / (pi * pi * x * x));
-    };
-    
-    if (!sTablesInitialized)
-    {
-      for (auto t=0; t<kTablePoints+1; ++t)
-      {
-        const double x0 = kDeltaX * t;
-        
-        for (auto i=0; i<kFilterWidth; ++i)
-        {
-          const double x = x0 + i - A;
-          sTable[t][i] = kernel(x);
-        }
-      }
-      
-      for (auto t=0; t<kTablePoints; ++t)
-      {
-        for (auto i=0; i<kFilterWidth; ++i)
-        {
-          sDeltaTable[t][i] = sTable[t + 1][i] - sTable[t][i];
-        }
-      }
-      
-      for (auto i=0; i<kFilterWidth; ++i)
-      {
-        // Wrap at the end - delta is the same
-        sDeltaTable[kTablePoints][i] = sDeltaTable[0][i];
-      }
-      sTablesInitialized = true;
-    }
+    InitTables();
+  }
+
+  /** Builds the kernel table shared by all resamplers with this sample type and
+   * filter size, if it has not been built yet. Thread-safe */
+  static void InitTables()
+  {
+    Table::Init();
   }
   
   inline size_t GetNumSamplesRequiredFor(size_t nOutputSamples) const
@@ -170,17 +315,24 @@ public:
   
   inline void PushBlock(T** inputs, size_t nFrames, int nChans)
   {
-    for (auto s=0; s<nFrames; s++)
+    size_t framesDone = 0;
+
+    // Copied a channel at a time, in runs that end where the ring buffer wraps
+    while (framesDone < nFrames)
     {
+      const size_t n = std::min(nFrames - framesDone, kBufferSize - mWritePos);
+
       for (auto c=0; c<nChans; c++)
       {
-        mInputBuffer[c][mWritePos] = inputs[c][s];
-        mInputBuffer[c][mWritePos + kBufferSize] = inputs[c][s]; // this way we can always wrap
+        memcpy(&mInputBuffer[c][mWritePos], inputs[c] + framesDone, n * sizeof(T));
+        memcpy(&mInputBuffer[c][mWritePos + kBufferSize], inputs[c] + framesDone, n * sizeof(T)); // this way we can always wrap
       }
-      
-      mWritePos = (mWritePos + 1) & (kBufferSize - 1);
-      mPhaseIn += mPhaseInIncr;
+
+      mWritePos = (mWritePos + n) & (kBufferSize - 1);
+      framesDone += n;
     }
+
+    mPhaseIn += mPhaseInIncr * nFrames;
   }
   
   size_t PopBlock(T** outputs, size_t max, int nChans)
@@ -212,70 +364,10 @@ public:
   }
   
 private:
-#ifdef IPLUG_SIMDE
-  inline void ReadSamples(double xBack, T** outputs, int s, int nChans) const
-  {
-    float bufferReadPosition = static_cast<float>(mWritePos - xBack);
-    int bufferReadIndex = static_cast<int>(std::floor(bufferReadPosition));
-    float bufferFracPosition = 1.0f - (bufferReadPosition - static_cast<float>(bufferReadIndex));
-    
-    bufferReadIndex = (bufferReadIndex + kBufferSize) & (kBufferSize - 1);
-    bufferReadIndex += (bufferReadIndex <= static_cast<int>(A)) * kBufferSize;
-    
-    float tablePosition = bufferFracPosition * kTablePoints;
-    int tableIndex = static_cast<int>(tablePosition);
-    float tableFracPosition = (tablePosition - tableIndex);
-    
-    __m128 sum[NCHANS];
-    for (auto & v : sum) {
-      v = _mm_setzero_ps(); // Initialize sum vectors to zero
-    }
-    
-    for (int i=0; i<A; i+=4) // Process four samples at a time
-    {
-      // Load filter coefficients and input samples into SSE registers
-      __m128 f0 = _mm_load_ps(&sTable[tableIndex][i]);
-      __m128 df0 = _mm_load_ps(&sDeltaTable[tableIndex][i]);
-      __m128 f1 = _mm_load_ps(&sTable[tableIndex][A + i]);
-      __m128 df1 = _mm_load_ps(&sDeltaTable[tableIndex][A + i]);
-      
-      // Interpolate filter coefficients
-      __m128 tfp = _mm_set1_ps(tableFracPosition);
-      f0 = _mm_add_ps(f0, _mm_mul_ps(df0, tfp));
-      f1 = _mm_add_ps(f1, _mm_mul_ps(df1, tfp));
-      
-      for (int c=0; c<nChans; c++)
-      {
-        // Load input data
-        __m128 d0 = _mm_set_ps(mInputBuffer[c][bufferReadIndex - A + i + 3],
-                               mInputBuffer[c][bufferReadIndex - A + i + 2],
-                               mInputBuffer[c][bufferReadIndex - A + i + 1],
-                               mInputBuffer[c][bufferReadIndex - A + i]);
-        __m128 d1 = _mm_set_ps(mInputBuffer[c][bufferReadIndex + i + 3],
-                               mInputBuffer[c][bufferReadIndex + i + 2],
-                               mInputBuffer[c][bufferReadIndex + i + 1],
-                               mInputBuffer[c][bufferReadIndex + i]);
-        
-        // Perform multiplication and accumulate
-        __m128 result0 = _mm_mul_ps(f0, d0);
-        __m128 result1 = _mm_mul_ps(f1, d1);
-        sum[c] = _mm_add_ps(sum[c], _mm_add_ps(result0, result1));
-      }
-    }
-    
-    // Extract the final sums and store them in the output
-    for (int c=0; c<nChans; c++)
-    {
-      float sumArray[4];
-      _mm_store_ps(sumArray, sum[c]);
-      outputs[c][s] = sumArray[0] + sumArray[1] + sumArray[2] + sumArray[3];
-    }
-  }
-#else // scalar
   inline void ReadSamples(double xBack, T** outputs, int s, int nChans) const
   {
     double bufferReadPosition = mWritePos - xBack;
-    int bufferReadIndex = std::floor(bufferReadPosition);
+    int bufferReadIndex = static_cast<int>(std::floor(bufferReadPosition));
     double bufferFracPosition = 1.0 - (bufferReadPosition - bufferReadIndex);
 
     bufferReadIndex = (bufferReadIndex + kBufferSize) & (kBufferSize - 1);
@@ -283,40 +375,73 @@ private:
 
     double tablePosition = bufferFracPosition * kTablePoints;
     int tableIndex = static_cast<int>(tablePosition);
-    double tableFracPosition = (tablePosition - tableIndex);
+    const T tableFracPosition = static_cast<T>(tablePosition - tableIndex);
 
-    T sum[NCHANS] = {0.0};
+    // Tap i of the table row applies to input sample bufferReadIndex - A + i. The input
+    // is written twice, so the taps are contiguous in both and can be read with vector loads
+    const T* pTable = Table::Row(tableIndex);
+    const T* pDelta = Table::DeltaRow(tableIndex);
+    const int readStart = bufferReadIndex - static_cast<int>(A);
 
-    for (auto i=0; i<A; i++)
+    // Interpolate filter coefficients once, for all channels
+    alignas(32) T kernel[kFilterWidth];
+
+#ifdef IPLUG_SIMDE
+    using L = LanczosLanes<T>;
+    constexpr int kVectorTaps = static_cast<int>(kFilterWidth) / L::kWidth * L::kWidth;
+
+    const auto frac = L::Set1(tableFracPosition);
+
+    for (int i=0; i<kVectorTaps; i+=L::kWidth)
+    {
+      L::Store(kernel + i, L::Add(L::Load(pTable + i), L::Mul(L::Load(pDelta + i), frac)));
+    }
+
+    for (int i=kVectorTaps; i<kFilterWidth; i++)
     {
-      auto f0 = sTable[tableIndex][i];
-      const auto df0 = sDeltaTable[tableIndex][i];
-      f0 += df0 * tableFracPosition;
+      kernel[i] = pTable[i] + pDelta[i] * tableFracPosition;
+    }
+
+    for (auto c=0; c<nChans; c++)
+    {
+      const T* pInput = &mInputBuffer[c][readStart];
+      auto vecSum = L::Zero();
+
+      for (int i=0; i<kVectorTaps; i+=L::kWidth)
+      {
+        vecSum = L::Add(vecSum, L::Mul(L::Load(kernel + i), L::Load(pInput + i)));
+      }
 
-      auto f1 = sTable[tableIndex][A+i];
-      const auto df1 = sDeltaTable[tableIndex][A+i];
-      f1 += df1 * tableFracPosition;
+      T sum = L::Sum(vecSum);
 
-      for (auto c=0; c<nChans;c++)
+      for (int i=kVectorTaps; i<kFilterWidth; i++)
       {
-        const auto d0 = mInputBuffer[c][bufferReadIndex - A + i];
-        const auto d1 = mInputBuffer[c][bufferReadIndex + i];
-        const auto rv = (f0 * d0) + (f1 * d1);
-        sum[c] += rv;
+        sum += kernel[i] * pInput[i];
       }
+
+      outputs[c][s] = sum;
+    }
+#else // scalar
+    for (int i=0; i<kFilterWidth; i++)
+    {
+      kernel[i] = pTable[i] + pDelta[i] * tableFracPosition;
     }
 
-    for (auto c=0; c<nChans;c++)
+    for (auto c=0; c<nChans; c++)
     {
-      outputs[c][s] = sum[c];
+      const T* pInput = &mInputBuffer[c][readStart];
+      T sum = 0.0;
+
+      for (int i=0; i<kFilterWidth; i++)
+      {
+        sum += kernel[i] * pInput[i];
+      }
+
+      outputs[c][s] = sum;
     }
-  }
 #endif
-  
-  static T sTable alignas(16)[kTablePoints + 1][kFilterWidth];
-  static T sDeltaTable alignas(16)[kTablePoints + 1][kFilterWidth];
-  static bool sTablesInitialized;
-  
+  }
+
   T mInputBuffer[NCHANS][kBufferSize * 2];
   int mWritePos = 0;
   const float mInputSampleRate;
@@ -327,14 +452,4 @@ private:
   double mPhaseOutIncr = 0.0;
 } WDL_FIXALIGN;
 
-template<typename T, int NCHANS, size_t A>
-T LanczosResampler<T, NCHANS, A>::sTable alignas(16) [LanczosResampler<T, NCHANS, A>::kTablePoints + 1][LanczosResampler::kFilterWidth];
-
-template<typename T, int NCHANS, size_t A>
-T LanczosResampler<T, NCHANS, A>::sDeltaTable alignas(16) [LanczosResampler<T, NCHANS, A>::kTablePoints + 1][LanczosResampler::kFilterWidth];
-
-template<typename T, int NCHANS, size_t A>
-bool LanczosResampler<T, NCHANS, A>::sTablesInitialized{false};
-
 } // namespace iplug
-
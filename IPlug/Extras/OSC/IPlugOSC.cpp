@@ -47,6 +47,9 @@ void OSCReceiver::SetReceivePort(int port)
 {
   if (port != mPort)
   {
+    // The receive thread reads the device list
+    StopReceiveThread();
+
     // Remove old device before creating new one to prevent memory leak
     RemoveDevice(mDevice);
     mDevice = nullptr;
@@ -57,5 +60,19 @@ void OSCReceiver::SetReceivePort(int port)
 
     if (mLogFunc)
       mLogFunc(log);
+
+    if (mUseReceiveThread)
+      StartReceiveThread(mDelivery);
   }
 }
+
+void OSCReceiver::SetReceiveThread(bool enable, EOSCDelivery delivery)
+{
+  mUseReceiveThread = enable;
+  mDelivery = delivery;
+
+  if (enable)
+    StartReceiveThread(delivery);
+  else
+    StopReceiveThread();
+}
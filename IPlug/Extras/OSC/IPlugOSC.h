@@ -65,6 +65,13 @@ public:
    * @param port The port number on which to listen for messages
    * @param logFunc std::function to log connection details  */
   OSCReceiver(int port = 8000, OSCLogFunc logFunc = nullptr, OSCMessageReceivedFunc receiveFunc = nullptr);
+
+  /** The receive thread must have been stopped with StopReceiving() before this runs */
+  virtual ~OSCReceiver()
+  {
+    assert(!IsReceiveThreadRunning() && "Call StopReceiving() before destroying an OSCReceiver that uses the receive thread");
+    StopReceiveThread();
+  }
   
   /** Set the port number on which to listen for OSC messages
    * @param port The port number on which to listen for messages*/
@@ -74,6 +81,32 @@ public:
    * @param logFunc std::function to log connection details */
   void SetLogFunc(OSCLogFunc logFunc) { OSCInterface::SetLogFunc(logFunc); }
 
+  /** Receive on a dedicated thread that wakes as soon as a packet arrives, instead of polling the socket from the main thread timer every OSC_TIMER_RATE ms.
+   * On Linux several datagrams are read per system call. Messages longer than MAX_OSC_MSG_LEN, or that do not fit in the queue, are dropped
+   * @param enable \c true to start the thread, \c false to stop it and go back to polling
+   * @param delivery Where messages are dispatched. With EOSCDelivery::kReceiveThread or EOSCDelivery::kManual, handlers and OnOSCMessage()
+   * are called on that thread, not the main thread */
+  void SetReceiveThread(bool enable, EOSCDelivery delivery = EOSCDelivery::kMainThread);
+
+  /** Stops the receive thread, if it is running, and waits for it to finish. This must be called before an OSCReceiver that uses the receive thread is destroyed,
+   * i.e. in the destructor of the most derived class. OnOSCMessage() is virtual, and by the time ~OSCReceiver() runs the derived class that overrides it is already gone.
+   * Afterwards messages are polled on the main thread, as if the receive thread was never started */
+  void StopReceiving() { SetReceiveThread(false); }
+
+  /** Registers a handler for an OSC address such as "/synth/1/cutoff". Incoming address patterns with wildcards are matched against it,
+   * see OSCDispatcher. Handlers are called before OnOSCMessage(). Add handlers before enabling the receive thread
+   * @param address The address, without wildcards
+   * @param func The function to call with the message */
+  void AddOSCHandler(const char* address, OSCMessageReceivedFunc func) { mDispatcher.AddHandler(address, func); }
+
+  /** When using EOSCDelivery::kManual, dispatches the messages that have arrived since the last call. Realtime safe if the handlers are,
+   * so it can be called at the start of ProcessBlock() in order to handle messages on the audio thread
+   * @return The number of messages dispatched */
+  int ProcessOSCMessages() { return ProcessQueuedMessages(); }
+
+  /** @return The number of messages dropped by the receive thread because they were too long or the queue was full */
+  int GetNDroppedOSCMessages() const { return mNDroppedMessages.load(std::memory_order_relaxed); }
+
   /** Override to handle incoming OSC messages in a derived class */
   virtual void OnOSCMessage(OscMessageRead& msg)
   {
@@ -87,6 +120,8 @@ private:
   OSCMessageReceivedFunc mReceiveFunc = nullptr;
   OSCDevice* mDevice = nullptr;
   int mPort = 0;
+  bool mUseReceiveThread = false;
+  EOSCDelivery mDelivery = EOSCDelivery::kMainThread;
 };
 
 END_IPLUG_NAMESPACE
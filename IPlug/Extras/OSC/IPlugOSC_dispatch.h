@@ -0,0 +1,298 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file IPlug Open Sound Control (OSC) support - address space and pattern dispatch
+ */
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "IPlugPlatform.h"
+#include "IPlugOSC_msg.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Dispatches OSC messages to handlers registered for method addresses such as "/synth/1/cutoff".
+ * The addresses are stored in a trie of path segments, so an incoming address is matched one segment at a time with a hash lookup.
+ * Segments of the incoming address pattern may use the OSC wildcards ? * [abc] [!a-z] and {foo,bar}, in which case the children of that level are
+ * matched one by one. Dispatch() does not allocate, so it can be called on the audio thread.
+ * Handlers must be added or removed while nothing is being dispatched */
+class OSCDispatcher
+{
+public:
+  using HandlerFunc = std::function<void(OscMessageRead& msg)>;
+
+  OSCDispatcher() = default;
+
+  OSCDispatcher(const OSCDispatcher&) = delete;
+  OSCDispatcher& operator=(const OSCDispatcher&) = delete;
+
+  /** Registers a handler, replacing any existing handler for the address
+   * @param address The method address, e.g. "/synth/1/cutoff", without wildcards
+   * @param func The function to call for messages whose address pattern matches */
+  void AddHandler(const char* address, HandlerFunc func)
+  {
+    Node* pNode = &mRoot;
+
+    ForEachSegment(address, [&](std::string_view segment) {
+      auto it = pNode->mChildren.find(segment);
+
+      if (it == pNode->mChildren.end())
+      {
+        auto pChild = std::make_unique<Node>();
+        pChild->mName.assign(segment);
+        // the key views the child's own copy of the name, which does not move with the node
+        const std::string_view key(pChild->mName);
+        it = pNode->mChildren.emplace(key, std::move(pChild)).first;
+      }
+
+      pNode = it->second.get();
+    });
+
+    if (!pNode->mHandler)
+      mNHandlers++;
+
+    pNode->mHandler = std::move(func);
+  }
+
+  /** Removes all handlers */
+  void Clear()
+  {
+    mRoot.mChildren.clear();
+    mRoot.mHandler = nullptr;
+    mNHandlers = 0;
+  }
+
+  /** @return \c true if no handlers have been added */
+  bool Empty() const { return mNHandlers == 0; }
+
+  /** Calls the handler of every address that matches the address pattern of a message. Each handler reads its own copy of the message
+   * @param pData The raw message, starting with the address pattern
+   * @param len The size of the message in bytes, at most MAX_OSC_MSG_LEN
+   * @return The number of handlers called */
+  int Dispatch(const char* pData, int len) const
+  {
+    if (len <= 1 || len > MAX_OSC_MSG_LEN || pData[0] != '/')
+      return 0;
+
+    const char* pEnd = static_cast<const char*>(memchr(pData, 0, len));
+
+    if (!pEnd)
+      return 0;
+
+    int nCalled = 0;
+
+    auto callHandler = [&](const HandlerFunc& handler) {
+      char buf[MAX_OSC_MSG_LEN];
+      memcpy(buf, pData, len);
+      OscMessageRead msg(buf, len);
+      handler(msg);
+      nCalled++;
+    };
+
+    Match(&mRoot, pData + 1, pEnd, callHandler);
+
+    return nCalled;
+  }
+
+  /** Matches a single address segment against a pattern segment using the OSC wildcard rules
+   * @return \c true if the name matches */
+  static bool MatchPattern(const char* pPattern, const char* pPatternEnd, const char* pName, const char* pNameEnd)
+  {
+    while (pPattern < pPatternEnd)
+    {
+      switch (*pPattern)
+      {
+        case '*':
+        {
+          while (pPattern < pPatternEnd && *pPattern == '*')
+            pPattern++;
+
+          if (pPattern == pPatternEnd)
+            return true;
+
+          for (const char* p = pName; p <= pNameEnd; p++)
+          {
+            if (MatchPattern(pPattern, pPatternEnd, p, pNameEnd))
+              return true;
+          }
+
+          return false;
+        }
+        case '?':
+        {
+          if (pName == pNameEnd)
+            return false;
+
+          pPattern++;
+          pName++;
+          break;
+        }
+        case '[':
+        {
+          if (pName == pNameEnd)
+            return false;
+
+          const char c = *pName++;
+          const bool negate = ++pPattern < pPatternEnd && *pPattern == '!';
+          bool found = false;
+
+          if (negate)
+            pPattern++;
+
+          for (; pPattern < pPatternEnd && *pPattern != ']'; pPattern++)
+          {
+            if (pPattern + 2 < pPatternEnd && pPattern[1] == '-' && pPattern[2] != ']')
+            {
+              found |= c >= pPattern[0] && c <= pPattern[2];
+              pPattern += 2;
+            }
+            else
+            {
+              found |= c == *pPattern;
+            }
+          }
+
+          if (pPattern == pPatternEnd || found == negate)
+            return false;
+
+          pPattern++; // ']'
+          break;
+        }
+        case '{':
+        {
+          const char* pClose = static_cast<const char*>(memchr(pPattern, '}', pPatternEnd - pPattern));
+
+          if (!pClose)
+            return false;
+
+          for (const char* pOption = pPattern + 1; pOption <= pClose;)
+          {
+            const char* pOptionEnd = pOption;
+
+            while (pOptionEnd < pClose && *pOptionEnd != ',')
+              pOptionEnd++;
+
+            const size_t optionLen = pOptionEnd - pOption;
+
+            if (static_cast<size_t>(pNameEnd - pName) >= optionLen && !strncmp(pOption, pName, optionLen)
+                && MatchPattern(pClose + 1, pPatternEnd, pName + optionLen, pNameEnd))
+              return true;
+
+            pOption = pOptionEnd + 1;
+          }
+
+          return false;
+        }
+        default:
+        {
+          if (pName == pNameEnd || *pName != *pPattern)
+            return false;
+
+          pPattern++;
+          pName++;
+          break;
+        }
+      }
+    }
+
+    return pName == pNameEnd;
+  }
+
+private:
+  struct Node
+  {
+    std::string mName;
+    HandlerFunc mHandler;
+    std::unordered_map<std::string_view, std::unique_ptr<Node>> mChildren;
+  };
+
+  template <typename F>
+  static void ForEachSegment(const char* address, F func)
+  {
+    const char* pSegment = address;
+
+    while (*pSegment)
+    {
+      if (*pSegment == '/')
+      {
+        pSegment++;
+        continue;
+      }
+
+      const char* pSegmentEnd = strchr(pSegment, '/');
+
+      if (!pSegmentEnd)
+        pSegmentEnd = pSegment + strlen(pSegment);
+
+      func(std::string_view(pSegment, pSegmentEnd - pSegment));
+      pSegment = pSegmentEnd;
+    }
+  }
+
+  static bool HasWildcards(const char* pSegment, const char* pSegmentEnd)
+  {
+    for (const char* p = pSegment; p < pSegmentEnd; p++)
+    {
+      if (*p == '*' || *p == '?' || *p == '[' || *p == '{')
+        return true;
+    }
+
+    return false;
+  }
+
+  /** Matches the segment starting at pSegment against the children of pNode, recursing into the remaining segments */
+  template <typename F>
+  static void Match(const Node* pNode, const char* pSegment, const char* pAddressEnd, F& func)
+  {
+    const char* pSegmentEnd = static_cast<const char*>(memchr(pSegment, '/', pAddressEnd - pSegment));
+    const bool isLast = !pSegmentEnd;
+
+    if (isLast)
+      pSegmentEnd = pAddressEnd;
+
+    auto visit = [&](const Node* pChild) {
+      if (!isLast)
+        Match(pChild, pSegmentEnd + 1, pAddressEnd, func);
+      else if (pChild->mHandler)
+        func(pChild->mHandler);
+    };
+
+    if (!HasWildcards(pSegment, pSegmentEnd))
+    {
+      auto it = pNode->mChildren.find(std::string_view(pSegment, pSegmentEnd - pSegment));
+
+      if (it != pNode->mChildren.end())
+        visit(it->second.get());
+    }
+    else
+    {
+      for (const auto& child : pNode->mChildren)
+      {
+        const std::string& name = child.second->mName;
+
+        if (MatchPattern(pSegment, pSegmentEnd, name.data(), name.data() + name.size()))
+          visit(child.second.get());
+      }
+    }
+  }
+
+  Node mRoot;
+  int mNHandlers = 0;
+};
+
+END_IPLUG_NAMESPACE
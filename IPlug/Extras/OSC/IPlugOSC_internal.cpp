@@ -8,6 +8,42 @@ using namespace iplug;
 void XSleep(int ms) { usleep(ms?ms*1000:100); }
 #endif
 
+#if defined __linux__
+#include <sys/socket.h>
+#endif
+
+static constexpr int kMaxPacketSize = 16384;
+#if defined __linux__
+static constexpr int kReceiveBatchSize = 16; // datagrams per recvmmsg() call
+#else
+static constexpr int kReceiveBatchSize = 1;
+#endif
+
+/** Calls func(pData, len) for each message in a packet, which is either a single message or a bundle of messages */
+template <typename F>
+static void ForEachPacketMessage(char* pData, int len, F func)
+{
+  int rd_pos = 0;
+  int rd_sz = len;
+  if (len > 20 && !strcmp(pData, "#bundle"))
+  {
+    rd_sz = *(int*)(pData + 16);
+    OSC_MAKEINTMEM4BE(&rd_sz);
+    rd_pos += 20;
+  }
+
+  while (rd_pos + rd_sz <= len && rd_sz >= 0)
+  {
+    func(pData + rd_pos, rd_sz);
+
+    rd_pos += rd_sz + 4;
+    if (rd_pos >= len) break;
+
+    rd_sz = *(int*)(pData + rd_pos - 4);
+    OSC_MAKEINTMEM4BE(&rd_sz);
+  }
+}
+
 OSCDevice::OSCDevice(const char* dest, int maxpacket, int sendsleep, sockaddr_in* listen_addr)
 {
   mHasOutput = dest != nullptr;
@@ -222,11 +258,15 @@ void OSCInterface::OnTimer(Timer& timer)
   // Process OUR devices only (instance-owned, not global)
   const int nDevices = mDevices.GetSize();
 
-  for (auto i = 0; i < nDevices; i++)
+  // with the receive thread running, input arrives through mReceiveQueue instead
+  if (!mReceiveThreadRunning.load(std::memory_order_relaxed))
   {
-    auto* pDev = mDevices.Get(i);
-    if (pDev->mHasInput)
-      pDev->RunInput();
+    for (auto i = 0; i < nDevices; i++)
+    {
+      auto* pDev = mDevices.Get(i);
+      if (pDev->mHasInput)
+        pDev->RunInput();
+    }
   }
 
   if (mIncomingEvents.GetSize())
@@ -249,32 +289,13 @@ void OSCInterface::OnTimer(Timer& timer)
       if (pos + this_sz > endpos) break;
       pos += this_sz;
 
-      int rd_pos = 0;
-      int rd_sz = evt->sz;
-      if (evt->sz > 20 && !strcmp((char*)evt->msg, "#bundle"))
-      {
-        rd_sz = *(int*)(evt->msg + 16);
-        OSC_MAKEINTMEM4BE(&rd_sz);
-        rd_pos += 20;
-      }
-
-      while (rd_pos + rd_sz <= evt->sz && rd_sz >= 0)
-      {
-        OscMessageRead rmsg((char*)evt->msg + rd_pos, rd_sz);
-
-        const char* mstr = rmsg.GetMessage();
-        if (mstr && *mstr)
-          OnOSCMessage(rmsg);
-
-        rd_pos += rd_sz + 4;
-        if (rd_pos >= evt->sz) break;
-
-        rd_sz = *(int*)(evt->msg + rd_pos - 4);
-        OSC_MAKEINTMEM4BE(&rd_sz);
-      }
+      ForEachPacketMessage((char*)evt->msg, evt->sz, [this](char* pData, int len) { DispatchOSCMessage(pData, len); });
     }
   }
 
+  if (mReceiveThreadRunning.load(std::memory_order_relaxed) && mDelivery == EOSCDelivery::kMainThread)
+    ProcessQueuedMessages();
+
   for (auto i = 0; i < nDevices; i++)
   {
     auto* pDev = mDevices.Get(i);
@@ -294,6 +315,8 @@ OSCInterface::OSCInterface(OSCLogFunc logFunc)
 
 OSCInterface::~OSCInterface()
 {
+  StopReceiveThread();
+
   // Stop timer first to prevent callbacks during destruction.
   // Timer::Stop() synchronously invalidates the timer on all platforms,
   // and both the timer callback and destructor run on the main thread,
@@ -366,6 +389,9 @@ OSCDevice* OSCInterface::CreateReceiver(WDL_String& log, int port)
 
     if (!isReuse)
       mDevices.Add(r);  // Add to OUR device list only
+
+    if (!mReceiveQueue)
+      mReceiveQueue = std::make_unique<IPlugQueue<QueuedMessage>>(OSC_RECEIVE_QUEUE_SIZE);
   }
 
   return r;
@@ -419,3 +445,164 @@ OSCDevice* OSCInterface::CreateSender(WDL_String& log, const char* ip, int port)
 
   return r;
 }
+
+void OSCInterface::DispatchOSCMessage(char* pData, int len)
+{
+  if (!mDispatcher.Empty())
+    mDispatcher.Dispatch(pData, len);
+
+  OscMessageRead rmsg(pData, len);
+
+  const char* mstr = rmsg.GetMessage();
+  if (mstr && *mstr)
+    OnOSCMessage(rmsg);
+}
+
+void OSCInterface::StartReceiveThread(EOSCDelivery delivery)
+{
+  StopReceiveThread();
+
+  mDelivery = delivery;
+  mReceiveBuffer.resize(kReceiveBatchSize * kMaxPacketSize);
+  mReceiveThreadRunning.store(true, std::memory_order_release);
+  mReceiveThread = std::thread(&OSCInterface::ReceiveThreadLoop, this);
+}
+
+bool OSCInterface::StopReceiveThread()
+{
+  if (!mReceiveThread.joinable())
+    return false;
+
+  mReceiveThreadRunning.store(false, std::memory_order_release);
+  mReceiveThread.join();
+  return true;
+}
+
+int OSCInterface::ProcessQueuedMessages()
+{
+  if (!mReceiveQueue)
+    return 0;
+
+  QueuedMessage msg;
+  int nMessages = 0;
+
+  while (mReceiveQueue->Pop(msg))
+  {
+    DispatchOSCMessage(msg.mData, msg.mSize);
+    nMessages++;
+  }
+
+  return nMessages;
+}
+
+void OSCInterface::ReceiveThreadLoop()
+{
+  while (mReceiveThreadRunning.load(std::memory_order_acquire))
+  {
+    // Block until a socket is readable. The timeout bounds how long StopReceiveThread() waits
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    SOCKET maxSocket = 0;
+    int nSockets = 0;
+
+    for (auto i = 0; i < mDevices.GetSize(); i++)
+    {
+      OSCDevice* pDev = mDevices.Get(i);
+
+      if (pDev->mHasInput && pDev->mSendSocket != INVALID_SOCKET)
+      {
+        FD_SET(pDev->mSendSocket, &readSet);
+        maxSocket = std::max(maxSocket, pDev->mSendSocket);
+        nSockets++;
+      }
+    }
+
+    if (!nSockets)
+    {
+      XSleep(OSC_TIMER_RATE);
+      continue;
+    }
+
+    struct timeval timeout = { 0, 50000 };
+
+    if (select((int) maxSocket + 1, &readSet, nullptr, nullptr, &timeout) <= 0)
+      continue;
+
+    for (auto i = 0; i < mDevices.GetSize(); i++)
+    {
+      OSCDevice* pDev = mDevices.Get(i);
+
+      if (pDev->mHasInput && pDev->mSendSocket != INVALID_SOCKET && FD_ISSET(pDev->mSendSocket, &readSet))
+        ReceivePackets(pDev);
+    }
+  }
+}
+
+void OSCInterface::ReceivePackets(OSCDevice* pDevice)
+{
+  // The socket is non-blocking, read until it is empty
+#if defined __linux__
+  struct mmsghdr msgs[kReceiveBatchSize];
+  struct iovec iovecs[kReceiveBatchSize];
+
+  for (;;)
+  {
+    memset(msgs, 0, sizeof(msgs));
+
+    for (int i = 0; i < kReceiveBatchSize; i++)
+    {
+      iovecs[i].iov_base = mReceiveBuffer.data() + i * kMaxPacketSize;
+      iovecs[i].iov_len = kMaxPacketSize;
+      msgs[i].msg_hdr.msg_iov = &iovecs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const int nPackets = recvmmsg(pDevice->mSendSocket, msgs, kReceiveBatchSize, MSG_DONTWAIT, nullptr);
+
+    if (nPackets < 1)
+      break;
+
+    for (int i = 0; i < nPackets; i++)
+    {
+      ForEachPacketMessage(mReceiveBuffer.data() + i * kMaxPacketSize, (int) msgs[i].msg_len, [this](char* pData, int len) {
+        QueueOrDispatchOSCMessage(pData, len);
+      });
+    }
+  }
+#else
+  for (;;)
+  {
+    const int len = (int) recvfrom(pDevice->mSendSocket, mReceiveBuffer.data(), kMaxPacketSize, 0, nullptr, nullptr);
+
+    if (len < 1)
+      break;
+
+    ForEachPacketMessage(mReceiveBuffer.data(), len, [this](char* pData, int len) {
+      QueueOrDispatchOSCMessage(pData, len);
+    });
+  }
+#endif
+}
+
+void OSCInterface::QueueOrDispatchOSCMessage(char* pData, int len)
+{
+  if (mDelivery == EOSCDelivery::kReceiveThread)
+  {
+    DispatchOSCMessage(pData, len);
+    return;
+  }
+
+  QueuedMessage msg;
+
+  if (len > MAX_OSC_MSG_LEN || len < 0)
+  {
+    mNDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  msg.mSize = len;
+  memcpy(msg.mData, pData, len);
+
+  if (!mReceiveQueue->Push(msg))
+    mNDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+}
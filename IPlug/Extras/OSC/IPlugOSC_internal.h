@@ -17,16 +17,22 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <ctime>
 #include <functional>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "jnetlib/jnetlib.h"
 
 #include "IPlugPlatform.h"
 #include "IPlugLogger.h"
 #include "IPlugOSC_msg.h"
+#include "IPlugOSC_dispatch.h"
+#include "IPlugQueue.h"
 #include "IPlugTimer.h"
 
 
@@ -36,6 +42,18 @@ BEGIN_IPLUG_NAMESPACE
 static constexpr int OSC_TIMER_RATE = 100;
 #endif
 
+#ifndef OSC_RECEIVE_QUEUE_SIZE
+static constexpr int OSC_RECEIVE_QUEUE_SIZE = 256;
+#endif
+
+/** Where messages received on the receive thread are dispatched, see OSCReceiver::SetReceiveThread() */
+enum class EOSCDelivery
+{
+  kMainThread,    // queued and dispatched from the main thread timer
+  kReceiveThread, // dispatched on the receive thread as soon as they arrive
+  kManual         // queued and dispatched by calling OSCReceiver::ProcessOSCMessages(), e.g. from ProcessBlock()
+};
+
 using OSCLogFunc = std::function<void(WDL_String& log)>;
 
 class OSCDevice
@@ -81,6 +99,12 @@ class OSCInterface
     unsigned char msg[3];
   };
 
+  struct QueuedMessage
+  {
+    int mSize;
+    char mData[MAX_OSC_MSG_LEN];
+  };
+
 public:
   OSCInterface(OSCLogFunc logFunc = nullptr);
 
@@ -101,10 +125,34 @@ protected:
    * @param device The device to remove */
   void RemoveDevice(OSCDevice* device);
 
+  /** Starts a thread that waits on the input devices and receives messages as soon as they arrive, rather than polling from the timer.
+   * Devices must not be added or removed while it runs
+   * @param delivery Where the received messages are dispatched */
+  void StartReceiveThread(EOSCDelivery delivery);
+
+  /** Stops the receive thread
+   * @return \c true if it was running */
+  bool StopReceiveThread();
+
+  /** @return \c true if the receive thread has been started and not stopped */
+  bool IsReceiveThreadRunning() const { return mReceiveThread.joinable(); }
+
+  /** Dispatches the messages queued by the receive thread. Call from a single thread at a time
+   * @return The number of messages dispatched */
+  int ProcessQueuedMessages();
+
+  /** Dispatches a single message to the handlers in mDispatcher and then to OnOSCMessage()
+   * @param pData The raw message, which is overwritten
+   * @param len The size of the message in bytes */
+  void DispatchOSCMessage(char* pData, int len);
+
 private:
   static void MessageCallback(void *d1, int dev_idx, int msglen, void *msg);
 
   void OnTimer(Timer& timer);
+  void ReceiveThreadLoop();
+  void ReceivePackets(OSCDevice* pDevice);
+  void QueueOrDispatchOSCMessage(char* pData, int len);
 
   WDL_PtrList<OSCDevice> mDevices;
 
@@ -113,6 +161,15 @@ protected:
   std::unique_ptr<Timer> mTimer;
   WDL_HeapBuf mIncomingEvents;  // incomingEvent list, each is 8-byte aligned
   WDL_Mutex mIncomingEvents_mutex;
+  OSCDispatcher mDispatcher;
+  std::unique_ptr<IPlugQueue<QueuedMessage>> mReceiveQueue; // created with the first receiver, so it exists before any consumer runs
+  std::atomic<int> mNDroppedMessages {0};
+
+private:
+  std::thread mReceiveThread;
+  std::atomic<bool> mReceiveThreadRunning {false};
+  EOSCDelivery mDelivery = EOSCDelivery::kMainThread;
+  std::vector<char> mReceiveBuffer;
 };
 
 END_IPLUG_NAMESPACE
@@ -12,11 +12,15 @@
 
 #define OVERSAMPLING_FACTORS_VA_LIST "None", "2x", "4x", "8x", "16x"
 
+#include <algorithm>
 #include <functional>
 #include <cmath>
 
 #include "HIIR/FPUUpsampler2x.h"
 #include "HIIR/FPUDownsampler2x.h"
+#include "HIIR/SIMDUpsampler2x4.h"
+#include "HIIR/SIMDDownsampler2x4.h"
+#include "HalfBandFIR.h"
 
 #include "heapbuf.h"
 #include "ptrlist.h"
@@ -37,16 +41,33 @@ enum EFactor
   kNumFactors
 };
 
+/** The anti-aliasing filters used by OverSampler */
+enum class EOverSamplingFilter
+{
+  kIIR,            // Polyphase IIR half-band filters (HIIR): cheap and nearly latency free, but not linear phase
+  kLinearPhaseFIR  // Polyphase half-band FIR filters (HalfBandFIR.h): linear phase, with a latency reported by GetLatency()
+};
+
+/** Up-samples, processes and down-samples audio with a cascade of 2x half-band filters, see EOverSamplingFilter.
+ * With IIR filters and two or more input (or output) channels, ProcessBlock() runs the filters of up to four channels at once,
+ * one channel per SIMD lane (see HIIR/SIMDStageProc4.h), otherwise each channel has its own scalar filters.
+ * Process() and ProcessGen() always use the scalar filters of the first channel */
 template<typename T = double>
 class OverSampler
 {
 public:
   using BlockProcessFunc = std::function<void(T**, T**, int)>;
   
-  OverSampler(EFactor factor = kNone, bool blockProcessing = true, int nInChannels = 1, int nOutChannels = 1)
+  static constexpr int kNLanes = Lanes4<T>::NBR_LANES;
+  
+  static constexpr int kNStages = kNumFactors - 1;
+  
+  OverSampler(EFactor factor = kNone, bool blockProcessing = true, int nInChannels = 1, int nOutChannels = 1, EOverSamplingFilter filter = EOverSamplingFilter::kIIR)
   : mBlockProcessing(blockProcessing)
   , mNInChannels(nInChannels)
   , mNOutChannels(nOutChannels)
+  , mUpsampleInLanes(nInChannels >= 2)
+  , mDownsampleInLanes(nOutChannels >= 2)
   {
     
     static constexpr double coeffs2x[12] = { 0.036681502163648017, 0.13654762463195794, 0.27463175937945444, 0.42313861743656711, 0.56109869787919531, 0.67754004997416184, 0.76974183386322703, 0.83988962484963892, 0.89226081800387902, 0.9315419599631839, 0.96209454837808417, 0.98781637073289585 };
@@ -85,7 +106,34 @@ public:
       // ptr location doesn't matter at this stage
       mNextOutputPtrs.Add(mDown2x.Get());
     }
+    
+    for (auto g = 0; mUpsampleInLanes && g < NGroups(mNInChannels); g++)
+    {
+      mUpsampler2xLanes.Add(new Upsampler2x4SIMD<12, T>());
+      mUpsampler4xLanes.Add(new Upsampler2x4SIMD<4, T>());
+      mUpsampler8xLanes.Add(new Upsampler2x4SIMD<3, T>());
+      mUpsampler16xLanes.Add(new Upsampler2x4SIMD<2, T>());
+      
+      mUpsampler2xLanes.Get(g)->set_coefs(coeffs2x);
+      mUpsampler4xLanes.Get(g)->set_coefs(coeffs4x);
+      mUpsampler8xLanes.Get(g)->set_coefs(coeffs8x);
+      mUpsampler16xLanes.Get(g)->set_coefs(coeffs16x);
+    }
+    
+    for (auto g = 0; mDownsampleInLanes && g < NGroups(mNOutChannels); g++)
+    {
+      mDownsampler2xLanes.Add(new Downsampler2x4SIMD<12, T>());
+      mDownsampler4xLanes.Add(new Downsampler2x4SIMD<4, T>());
+      mDownsampler8xLanes.Add(new Downsampler2x4SIMD<3, T>());
+      mDownsampler16xLanes.Add(new Downsampler2x4SIMD<2, T>());
+      
+      mDownsampler2xLanes.Get(g)->set_coefs(coeffs2x);
+      mDownsampler4xLanes.Get(g)->set_coefs(coeffs4x);
+      mDownsampler8xLanes.Get(g)->set_coefs(coeffs8x);
+      mDownsampler16xLanes.Get(g)->set_coefs(coeffs16x);
+    }
         
+    SetFilter(filter);
     SetOverSampling(factor);
     
     Reset();
@@ -101,6 +149,22 @@ public:
     mDownsampler8x.Empty(true);
     mUpsampler16x.Empty(true);
     mDownsampler16x.Empty(true);
+    mUpsampler2xLanes.Empty(true);
+    mDownsampler2xLanes.Empty(true);
+    mUpsampler4xLanes.Empty(true);
+    mDownsampler4xLanes.Empty(true);
+    mUpsampler8xLanes.Empty(true);
+    mDownsampler8xLanes.Empty(true);
+    mUpsampler16xLanes.Empty(true);
+    mDownsampler16xLanes.Empty(true);
+    
+    for (auto s = 0; s < kNStages; s++)
+    {
+      mFIRUpsamplers[s].Empty(true);
+      mFIRDownsamplers[s].Empty(true);
+    }
+    
+    mFIRAlignDelays.Empty(true);
   }
 
   OverSampler(const OverSampler&) = delete;
@@ -165,6 +229,40 @@ public:
       mDown8BufferPtrs.Add(mDown8x.Get() + (c * 8 * blockSize));
       mDown16BufferPtrs.Add(mDown16x.Get() + (c * 16 * blockSize));
     }
+    
+    for (auto g = 0; g < mUpsampler2xLanes.GetSize(); g++)
+    {
+      mUpsampler2xLanes.Get(g)->clear_buffers();
+      mUpsampler4xLanes.Get(g)->clear_buffers();
+      mUpsampler8xLanes.Get(g)->clear_buffers();
+      mUpsampler16xLanes.Get(g)->clear_buffers();
+    }
+    
+    for (auto g = 0; g < mDownsampler2xLanes.GetSize(); g++)
+    {
+      mDownsampler2xLanes.Get(g)->clear_buffers();
+      mDownsampler4xLanes.Get(g)->clear_buffers();
+      mDownsampler8xLanes.Get(g)->clear_buffers();
+      mDownsampler16xLanes.Get(g)->clear_buffers();
+    }
+    
+    for (auto s = 0; s < kNStages; s++)
+    {
+      for (auto c = 0; c < mFIRUpsamplers[s].GetSize(); c++)
+        mFIRUpsamplers[s].Get(c)->Reset();
+      
+      for (auto c = 0; c < mFIRDownsamplers[s].GetSize(); c++)
+        mFIRDownsamplers[s].Get(c)->Reset();
+    }
+    
+    for (auto c = 0; c < mFIRAlignDelays.GetSize(); c++)
+      mFIRAlignDelays.Get(c)->Reset();
+    
+    if (mUpsampleInLanes || mDownsampleInLanes)
+    {
+      mLanesA.Resize(16 * blockSize * kNLanes);
+      mLanesB.Resize(16 * blockSize * kNLanes);
+    }
   }
 
   /** Over sample an input block with a per-block function (up sample input -> process with function -> down sample)
@@ -205,7 +303,14 @@ public:
       mPrevRate = mRate;
     }
 
-    for (auto c = 0; c < nInChans; c++) {
+    if (mFilter == EOverSamplingFilter::kLinearPhaseFIR) {
+      for (auto c = 0; c < nInChans && mRate >= 2; c++)
+        UpsampleFIR(c, inputs[c], nFrames);
+    }
+    else if (mUpsampleInLanes && mRate >= 2) {
+      UpsampleInLanes(inputs, nFrames, nInChans);
+    }
+    else for (auto c = 0; c < nInChans; c++) {
       if (mRate >= 2) {
         mUpsampler2x.Get(c)->process_block(mUp2BufferPtrs.Get(c), inputs[c], nFrames);
       }
@@ -232,7 +337,14 @@ public:
       }
     }
     
-    for (auto c = 0; c < nOutChans; c++) {
+    if (mFilter == EOverSamplingFilter::kLinearPhaseFIR) {
+      for (auto c = 0; c < nOutChans && mRate >= 2; c++)
+        DownsampleFIR(c, outputs[c], nFrames);
+    }
+    else if (mDownsampleInLanes && mRate >= 2) {
+      DownsampleInLanes(outputs, nFrames, nOutChans);
+    }
+    else for (auto c = 0; c < nOutChans; c++) {
       if (mRate == 16) {
         mDownsampler16x.Get(c)->process_block(mDown8BufferPtrs.Get(c), mDown16BufferPtrs.Get(c), nFrames * 8);
       }
@@ -256,7 +368,19 @@ public:
   {
     T output;
 
-    if (mRate == 16)
+    if (mFilter == EOverSamplingFilter::kLinearPhaseFIR && mRate >= 2)
+    {
+      const int topStage = NStages() - 1;
+      UpsampleFIR(0, &input, 1);
+      
+      for (auto i = 0; i < mRate; i++)
+      {
+        DownBuffer(topStage, 0)[i] = func(UpBuffer(topStage, 0)[i]);
+      }
+      
+      DownsampleFIR(0, &output, 1);
+    }
+    else if (mRate == 16)
     {
       mUpsampler2x.Get(0)->process_sample(mUp2x.Get()[0], mUp2x.Get()[1], input);
       mUpsampler4x.Get(0)->process_block(mUp4x.Get(), mUp2x.Get(), 2);
@@ -381,6 +505,17 @@ public:
 
     T output;
 
+    if (mFilter == EOverSamplingFilter::kLinearPhaseFIR && mRate >= 2)
+    {
+      for (auto i = 0; i < mRate; i++)
+      {
+        DownBuffer(NStages() - 1, 0)[i] = genFunc();
+      }
+      
+      DownsampleFIR(0, &output, 1);
+      return output;
+    }
+
     for (int j = 0; j < mRate; j++)
     {
       output = genFunc();
@@ -408,6 +543,7 @@ public:
       mFactor = factor;
       mRate = std::pow(2, (int) factor);
       
+      UpdateFIRLatency();
       Reset();
     }
   }
@@ -429,9 +565,221 @@ public:
   {
     return mRate;
   }
+  
+  /** Selects the anti-aliasing filters. This allocates memory, so don't call it on the audio thread
+   * @param filter The type of filter
+   * @param stopbandDB The stop band attenuation of the FIR filters in dB
+   * @param passbandEdge The end of the pass band of the FIR filters, as a fraction of the original sampling rate. Must be less than 0.5 */
+  void SetFilter(EOverSamplingFilter filter, double stopbandDB = 120., double passbandEdge = 0.45)
+  {
+    mFilter = filter;
+    
+    if (filter == EOverSamplingFilter::kLinearPhaseFIR)
+    {
+      assert(passbandEdge > 0. && passbandEdge < 0.5);
+      
+      for (auto s = 0; s < kNStages; s++)
+      {
+        // At stage s the sampling rate is 2^(s + 1) times the original, and only the original pass band needs to be preserved
+        const double edge = passbandEdge / (2 << s);
+        const std::vector<double> taps = DesignHalfBandFIR(0.5 - 2. * edge, stopbandDB);
+        
+        while (mFIRUpsamplers[s].GetSize() < mNInChannels)
+          mFIRUpsamplers[s].Add(new HalfBandFIRUpsampler2x<T>());
+        
+        while (mFIRDownsamplers[s].GetSize() < mNOutChannels)
+          mFIRDownsamplers[s].Add(new HalfBandFIRDownsampler2x<T>());
+        
+        for (auto c = 0; c < mNInChannels; c++)
+          mFIRUpsamplers[s].Get(c)->SetTaps(taps);
+        
+        for (auto c = 0; c < mNOutChannels; c++)
+          mFIRDownsamplers[s].Get(c)->SetTaps(taps);
+      }
+      
+      while (mFIRAlignDelays.GetSize() < mNOutChannels)
+        mFIRAlignDelays.Add(new PolyphaseDelayBranch<T>());
+    }
+    
+    UpdateFIRLatency();
+  }
+  
+  EOverSamplingFilter GetFilter() const
+  {
+    return mFilter;
+  }
+  
+  /** @return The latency in samples at the original sampling rate, to add to the plug-in's latency (see IPlugProcessor::SetLatency()).
+   * The FIR filters are linear phase, so this is exact. The IIR filters have a frequency dependent group delay of a few samples, for which 0 is returned */
+  int GetLatency() const
+  {
+    return mFilter == EOverSamplingFilter::kLinearPhaseFIR ? mFIRLatency : 0;
+  }
 
 private:
+  /** @return The number of 2x stages at the current rate */
+  int NStages() const
+  {
+    return static_cast<int>(mFactor);
+  }
+  
+  /** @return The up-sampled buffer of a channel after stage s, at 2^(s + 1) times the original rate */
+  T* UpBuffer(int stage, int c)
+  {
+    WDL_PtrList<T>* pLists[kNStages] = { &mUp2BufferPtrs, &mUp4BufferPtrs, &mUp8BufferPtrs, &mUp16BufferPtrs };
+    return pLists[stage]->Get(c);
+  }
+  
+  /** @return The buffer of a channel to be down-sampled by stage s, at 2^(s + 1) times the original rate */
+  T* DownBuffer(int stage, int c)
+  {
+    WDL_PtrList<T>* pLists[kNStages] = { &mDown2BufferPtrs, &mDown4BufferPtrs, &mDown8BufferPtrs, &mDown16BufferPtrs };
+    return pLists[stage]->Get(c);
+  }
+  
+  void UpsampleFIR(int c, const T* pInput, int nFrames)
+  {
+    const T* pIn = pInput;
+    
+    for (auto s = 0; s < NStages(); s++)
+    {
+      mFIRUpsamplers[s].Get(c)->ProcessBlock(UpBuffer(s, c), pIn, nFrames << s);
+      pIn = UpBuffer(s, c);
+    }
+  }
+  
+  void DownsampleFIR(int c, T* pOutput, int nFrames)
+  {
+    const int topStage = NStages() - 1;
+    T* pTop = DownBuffer(topStage, c);
+    PolyphaseDelayBranch<T>* pAlignDelay = mFIRAlignDelays.Get(c);
+    
+    for (auto i = 0; i < nFrames * mRate; i++)
+      pTop[i] = pAlignDelay->Process(pTop[i]);
+    
+    for (auto s = topStage; s >= 0; s--)
+    {
+      T* pOut = s > 0 ? DownBuffer(s - 1, c) : pOutput;
+      mFIRDownsamplers[s].Get(c)->ProcessBlock(pOut, DownBuffer(s, c), nFrames << s);
+    }
+  }
+  
+  /** Sums the latencies of the FIR stages in use, and pads them with a delay at the highest rate so that the total is a whole number of samples at the original rate */
+  void UpdateFIRLatency()
+  {
+    mFIRLatency = 0;
+    
+    if (mFilter != EOverSamplingFilter::kLinearPhaseFIR)
+      return;
+    
+    const int nStages = NStages();
+    int delay = 0; // in samples at the highest rate
+    
+    for (auto s = 0; s < nStages; s++)
+    {
+      const int upDelay = mFIRUpsamplers[s].GetSize() ? mFIRUpsamplers[s].Get(0)->GetLatency() : 0;
+      const int downDelay = mFIRDownsamplers[s].GetSize() ? mFIRDownsamplers[s].Get(0)->GetLatency() : 0;
+      delay += (upDelay + downDelay) << (nStages - 1 - s);
+    }
+    
+    const int pad = (mRate - delay % mRate) % mRate;
+    
+    for (auto c = 0; c < mFIRAlignDelays.GetSize(); c++)
+      mFIRAlignDelays.Get(c)->SetDelay(pad);
+    
+    mFIRLatency = (delay + pad) / mRate;
+  }
+  
+  static int NGroups(int nChans)
+  {
+    return (nChans + kNLanes - 1) / kNLanes;
+  }
+  
+  /** Copies up to kNLanes planar channels into an interleaved buffer, zeroing the unused lanes */
+  static void Interleave(T* pDest, T** ppSrc, int nChans, int nFrames)
+  {
+    for (auto i = 0; i < nFrames; i++)
+    {
+      for (auto c = 0; c < kNLanes; c++)
+        pDest[i * kNLanes + c] = c < nChans ? ppSrc[c][i] : T(0);
+    }
+  }
+  
+  /** Copies the first nChans lanes of an interleaved buffer into planar channels */
+  static void Deinterleave(T** ppDest, const T* pSrc, int nChans, int nFrames)
+  {
+    for (auto i = 0; i < nFrames; i++)
+    {
+      for (auto c = 0; c < nChans; c++)
+        ppDest[c][i] = pSrc[i * kNLanes + c];
+    }
+  }
+  
+  /** Up-samples the inputs into the buffers at the current rate, kNLanes channels at a time */
+  void UpsampleInLanes(T** inputs, int nFrames, int nInChans)
+  {
+    for (auto g = 0; g < NGroups(nInChans); g++)
+    {
+      const int startChan = g * kNLanes;
+      const int nChans = std::min(kNLanes, nInChans - startChan);
+      T* pIn = mLanesA.Get();
+      T* pOut = mLanesB.Get();
+      
+      Interleave(pIn, inputs + startChan, nChans, nFrames);
+      
+      mUpsampler2xLanes.Get(g)->process_block(pOut, pIn, nFrames);
+      
+      if (mRate >= 4) {
+        std::swap(pIn, pOut);
+        mUpsampler4xLanes.Get(g)->process_block(pOut, pIn, nFrames * 2);
+      }
+      if (mRate >= 8) {
+        std::swap(pIn, pOut);
+        mUpsampler8xLanes.Get(g)->process_block(pOut, pIn, nFrames * 4);
+      }
+      if (mRate == 16) {
+        std::swap(pIn, pOut);
+        mUpsampler16xLanes.Get(g)->process_block(pOut, pIn, nFrames * 8);
+      }
+      
+      Deinterleave(mInPtrLoopSrc->GetList() + startChan, pOut, nChans, nFrames * mRate);
+    }
+  }
+  
+  /** Down-samples the buffers at the current rate into the outputs, kNLanes channels at a time */
+  void DownsampleInLanes(T** outputs, int nFrames, int nOutChans)
+  {
+    for (auto g = 0; g < NGroups(nOutChans); g++)
+    {
+      const int startChan = g * kNLanes;
+      const int nChans = std::min(kNLanes, nOutChans - startChan);
+      T* pIn = mLanesA.Get();
+      T* pOut = mLanesB.Get();
+      
+      Interleave(pIn, mOutPtrLoopSrc->GetList() + startChan, nChans, nFrames * mRate);
+      
+      if (mRate == 16) {
+        mDownsampler16xLanes.Get(g)->process_block(pOut, pIn, nFrames * 8);
+        std::swap(pIn, pOut);
+      }
+      if (mRate >= 8) {
+        mDownsampler8xLanes.Get(g)->process_block(pOut, pIn, nFrames * 4);
+        std::swap(pIn, pOut);
+      }
+      if (mRate >= 4) {
+        mDownsampler4xLanes.Get(g)->process_block(pOut, pIn, nFrames * 2);
+        std::swap(pIn, pOut);
+      }
+      
+      mDownsampler2xLanes.Get(g)->process_block(pOut, pIn, nFrames);
+      
+      Deinterleave(outputs + startChan, pOut, nChans, nFrames);
+    }
+  }
+  
   EFactor mFactor = kNone;
+  EOverSamplingFilter mFilter = EOverSamplingFilter::kIIR;
+  int mFIRLatency = 0;
   int mPrevRate = 0;
   int mRate = 1;
   int mWritePos = 0;
@@ -439,6 +787,8 @@ private:
   bool mBlockProcessing; // false
   int mNInChannels; // 1
   int mNOutChannels;
+  bool mUpsampleInLanes;
+  bool mDownsampleInLanes;
   
   // the actual data
   WDL_TypedBuf<T> mUp16x;
@@ -451,6 +801,10 @@ private:
   WDL_TypedBuf<T> mDown4x;
   WDL_TypedBuf<T> mDown2x;
   
+  // interleaved scratch buffers for the SIMD filters, 16x the block size for kNLanes channels
+  WDL_TypedBuf<T> mLanesA;
+  WDL_TypedBuf<T> mLanesB;
+  
   //Ptrs into buffer data
   WDL_PtrList<T> mUp16BufferPtrs;
   WDL_PtrList<T> mUp8BufferPtrs;
@@ -479,6 +833,22 @@ private:
   WDL_PtrList<Downsampler2xFPU<4, T>> mDownsampler4x;  // decimator for 4x to 2x SR
   WDL_PtrList<Downsampler2xFPU<3, T>> mDownsampler8x;  // decimator for 8x to 4x SR
   WDL_PtrList<Downsampler2xFPU<2, T>> mDownsampler16x; // decimator for 16x to 8x SR
+  
+  //Ptrs to oversamplers for each group of kNLanes channels, if processing in lanes
+  WDL_PtrList<Upsampler2x4SIMD<12, T>> mUpsampler2xLanes;
+  WDL_PtrList<Upsampler2x4SIMD<4, T>> mUpsampler4xLanes;
+  WDL_PtrList<Upsampler2x4SIMD<3, T>> mUpsampler8xLanes;
+  WDL_PtrList<Upsampler2x4SIMD<2, T>> mUpsampler16xLanes;
+  
+  WDL_PtrList<Downsampler2x4SIMD<12, T>> mDownsampler2xLanes;
+  WDL_PtrList<Downsampler2x4SIMD<4, T>> mDownsampler4xLanes;
+  WDL_PtrList<Downsampler2x4SIMD<3, T>> mDownsampler8xLanes;
+  WDL_PtrList<Downsampler2x4SIMD<2, T>> mDownsampler16xLanes;
+  
+  //Ptrs to the FIR oversamplers for each channel, per stage (1x to 2x SR ... 8x to 16x SR), if used
+  WDL_PtrList<HalfBandFIRUpsampler2x<T>> mFIRUpsamplers[kNStages];
+  WDL_PtrList<HalfBandFIRDownsampler2x<T>> mFIRDownsamplers[kNStages];
+  WDL_PtrList<PolyphaseDelayBranch<T>> mFIRAlignDelays;
 };
 
 END_IPLUG_NAMESPACE
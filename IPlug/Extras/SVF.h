@@ -16,8 +16,18 @@
  * - http://www.cytomic.com/files/dsp/SvfLinearTrapOptimised2.pdf
  */
 
+#include <algorithm>
 #include <complex>
 
+#if defined IPLUG_SIMDE
+  #if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+  #else
+    #define SIMDE_ENABLE_NATIVE_ALIASES
+    #include "simde/x86/sse2.h"
+  #endif
+#endif
+
 #include "IPlugPlatform.h"
 
 BEGIN_IPLUG_NAMESPACE
@@ -29,6 +39,9 @@ class SVF
 {
 public:
 
+  /** The number of samples for which ProcessBlockModulated() computes coefficients at once */
+  static constexpr int kModulationChunkSize = 32;
+
   enum EMode
   {
     kLowPass = 0,
@@ -121,6 +134,101 @@ public:
     }
   }
 
+  /** Processes a block with the cutoff frequency, and optionally the Q, set for every sample, e.g. from an envelope or LFO, so that modulation does not step at block boundaries.
+   * Coefficients are computed for kModulationChunkSize samples at a time using TanPi() rather than std::tan(). When IPLUG_SIMDE is defined, they are computed
+   * two samples per SSE2 instruction, and the filter state of pairs of channels is updated two channels per instruction, so an odd channel is updated in scalar code.
+   * The mode, gain and sample rate are taken from the setters as in ProcessBlock(), which remains the cheaper choice when nothing is modulated
+   * @param pFreqCPS nFrames cutoff frequencies in Hz, applied to all channels
+   * @param pQ nFrames Q values, or \c nullptr to use the value from SetQ() */
+  void ProcessBlockModulated(T** inputs, T** outputs, int nChans, int nFrames, const T* pFreqCPS, const T* pQ = nullptr)
+  {
+    assert(nChans <= NC);
+
+    if(mState != mNewState)
+      UpdateCoefficients();
+
+    // In every mode a1..a3 follow from g and k, and m1 = m1k * k + m1c, see UpdateCoefficients()
+    const double A = std::pow(10., mState.gain/40.);
+    double gScale = 1., m0 = 0., m1k = 0., m1c = 0., m2 = 0.;
+
+    switch(mState.mode)
+    {
+      case kLowPass: m2 = 1.; break;
+      case kHighPass: m0 = 1.; m1k = -1.; m2 = -1.; break;
+      case kBandPass: m1c = 1.; break;
+      case kNotch: m0 = 1.; m1k = -1.; break;
+      case kPeak: m0 = 1.; m1k = -1.; m2 = -2.; break;
+      case kBell: m0 = 1.; m1k = A * A - 1.; break;
+      case kLowPassShelf: gScale = 1. / std::sqrt(A); m0 = 1.; m1k = A - 1.; m2 = A * A - 1.; break;
+      case kHighPassShelf: gScale = 1. / std::sqrt(A); m0 = A * A; m1k = (1. - A) * A; m2 = 1. - A * A; break;
+      default: break;
+    }
+
+    ModulationChunk chunk;
+    chunk.minFreq = 10. / mState.sampleRate;
+    chunk.maxFreq = std::min(20000. / mState.sampleRate, 0.49);
+    chunk.gScale = gScale;
+    chunk.m1k = m1k;
+    chunk.m1c = m1c;
+
+    const double invSampleRate = 1. / mState.sampleRate;
+
+    for (auto start = 0; start < nFrames; start += kModulationChunkSize)
+    {
+      const int n = std::min(kModulationChunkSize, nFrames - start);
+
+      for (auto i = 0; i < n; i++)
+        chunk.freq[i] = static_cast<double>(pFreqCPS[start + i]) * invSampleRate;
+
+      for (auto i = 0; i < n; i++)
+        chunk.q[i] = pQ ? static_cast<double>(pQ[start + i]) : mState.Q;
+
+      chunk.ComputeCoefficients(n);
+
+#if defined IPLUG_SIMDE
+      int c = 0;
+
+      for (; c + 2 <= nChans; c += 2)
+        ProcessChannelPair(chunk, inputs, outputs, c, start, n, m0, m2);
+
+      if (c < nChans)
+        ProcessChannel(chunk, inputs, outputs, c, start, n, m0, m2);
+#else
+      // The channels are walked for each sample, so every coefficient is loaded once for all channels, and their updates overlap
+      for (auto i = 0; i < n; i++)
+      {
+        const int s = start + i;
+
+        for (auto c = 0; c < nChans; c++)
+        {
+          const double v0 = static_cast<double>(inputs[c][s]);
+
+          mV3[c] = v0 - mIc2eq[c];
+          mV1[c] = chunk.a1[i] * mIc1eq[c] + chunk.a2[i] * mV3[c];
+          mV2[c] = mIc2eq[c] + chunk.a2[i] * mIc1eq[c] + chunk.a3[i] * mV3[c];
+          mIc1eq[c] = 2.0 * mV1[c] - mIc1eq[c];
+          mIc2eq[c] = 2.0 * mV2[c] - mIc2eq[c];
+
+          outputs[c][s] = static_cast<T>(m0 * v0 + chunk.m1[i] * mV1[c] + m2 * mV2[c]);
+        }
+      }
+#endif
+    }
+  }
+
+  /** A branch-free approximation of tan(pi * x) for x in [0, 0.5), with a relative error below 2e-13.
+   * Above pi / 4 it uses tan(pi / 2 - a) = 1 / tan(a), so the Pade approximant is only evaluated on [0, pi / 4] */
+  static inline double TanPi(double x)
+  {
+    const double a = PI * x;
+    const bool reflect = a > 0.25 * PI;
+    const double b = reflect ? 0.5 * PI - a : a;
+    const double b2 = b * b;
+    const double num = b * (135135. - b2 * (17325. - b2 * (378. - b2)));
+    const double den = 135135. - b2 * (62370. - b2 * (3150. - 28. * b2));
+    return (reflect ? den : num) / (reflect ? num : den);
+  }
+
   void Reset()
   {
     for (auto c = 0; c < NC; c++)
@@ -134,6 +242,128 @@ public:
   }
 
 private:
+  /** Per-sample coefficients for ProcessBlockModulated() */
+  struct ModulationChunk
+  {
+    double freq[kModulationChunkSize]; // normalized to the sample rate
+    double q[kModulationChunkSize];
+    double a1[kModulationChunkSize];
+    double a2[kModulationChunkSize];
+    double a3[kModulationChunkSize];
+    double m1[kModulationChunkSize];
+    double minFreq, maxFreq, gScale, m1k, m1c;
+
+    void ComputeCoefficients(int n)
+    {
+      int i = 0;
+
+#if defined IPLUG_SIMDE
+      const __m128d vMinFreq = _mm_set1_pd(minFreq), vMaxFreq = _mm_set1_pd(maxFreq);
+      const __m128d vMinQ = _mm_set1_pd(0.1), vMaxQ = _mm_set1_pd(100.);
+      const __m128d vPi = _mm_set1_pd(PI), vQuarterPi = _mm_set1_pd(0.25 * PI), vHalfPi = _mm_set1_pd(0.5 * PI);
+      const __m128d vOne = _mm_set1_pd(1.), vGScale = _mm_set1_pd(gScale), vM1k = _mm_set1_pd(m1k), vM1c = _mm_set1_pd(m1c);
+
+      auto select = [](__m128d mask, __m128d a, __m128d b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); };
+      auto poly = [](__m128d x, double c0, double c1, double c2, double c3) {
+        return _mm_add_pd(_mm_set1_pd(c0), _mm_mul_pd(x, _mm_add_pd(_mm_set1_pd(c1), _mm_mul_pd(x, _mm_add_pd(_mm_set1_pd(c2), _mm_mul_pd(x, _mm_set1_pd(c3)))))));
+      };
+
+      for (; i + 2 <= n; i += 2)
+      {
+        // TanPi(), two samples at a time
+        const __m128d a = _mm_mul_pd(_mm_min_pd(_mm_max_pd(_mm_loadu_pd(freq + i), vMinFreq), vMaxFreq), vPi);
+        const __m128d reflect = _mm_cmpgt_pd(a, vQuarterPi);
+        const __m128d b = select(reflect, _mm_sub_pd(vHalfPi, a), a);
+        const __m128d b2 = _mm_mul_pd(b, b);
+        const __m128d num = _mm_mul_pd(b, poly(b2, 135135., -17325., 378., -1.));
+        const __m128d den = poly(b2, 135135., -62370., 3150., -28.);
+        const __m128d g = _mm_mul_pd(_mm_div_pd(select(reflect, den, num), select(reflect, num, den)), vGScale);
+
+        const __m128d k = _mm_div_pd(vOne, _mm_min_pd(_mm_max_pd(_mm_loadu_pd(q + i), vMinQ), vMaxQ));
+        const __m128d a1v = _mm_div_pd(vOne, _mm_add_pd(vOne, _mm_mul_pd(g, _mm_add_pd(g, k))));
+        const __m128d a2v = _mm_mul_pd(g, a1v);
+
+        _mm_storeu_pd(a1 + i, a1v);
+        _mm_storeu_pd(a2 + i, a2v);
+        _mm_storeu_pd(a3 + i, _mm_mul_pd(g, a2v));
+        _mm_storeu_pd(m1 + i, _mm_add_pd(_mm_mul_pd(vM1k, k), vM1c));
+      }
+#endif
+
+      for (; i < n; i++)
+      {
+        const double g = TanPi(std::min(std::max(freq[i], minFreq), maxFreq)) * gScale;
+        const double k = 1. / std::min(std::max(q[i], 0.1), 100.);
+        a1[i] = 1. / (1. + g * (g + k));
+        a2[i] = g * a1[i];
+        a3[i] = g * a2[i];
+        m1[i] = m1k * k + m1c;
+      }
+    }
+  };
+
+#if defined IPLUG_SIMDE
+  /** Runs the filter for channel c over n samples of a chunk, with its state in locals rather than the member arrays */
+  void ProcessChannel(const ModulationChunk& chunk, T** inputs, T** outputs, int c, int start, int n, double m0, double m2)
+  {
+    const T* pInput = inputs[c] + start;
+    T* pOutput = outputs[c] + start;
+    double ic1eq = mIc1eq[c], ic2eq = mIc2eq[c], v1 = 0., v2 = 0., v3 = 0.;
+
+    for (auto i = 0; i < n; i++)
+    {
+      const double v0 = static_cast<double>(pInput[i]);
+
+      v3 = v0 - ic2eq;
+      v1 = chunk.a1[i] * ic1eq + chunk.a2[i] * v3;
+      v2 = ic2eq + chunk.a2[i] * ic1eq + chunk.a3[i] * v3;
+      ic1eq = 2.0 * v1 - ic1eq;
+      ic2eq = 2.0 * v2 - ic2eq;
+
+      pOutput[i] = static_cast<T>(m0 * v0 + chunk.m1[i] * v1 + m2 * v2);
+    }
+
+    mIc1eq[c] = ic1eq;
+    mIc2eq[c] = ic2eq;
+    mV1[c] = v1;
+    mV2[c] = v2;
+    mV3[c] = v3;
+  }
+
+  /** Runs the filter for channels c and c + 1 over n samples of a chunk, with the state of both channels in one SSE2 register */
+  void ProcessChannelPair(const ModulationChunk& chunk, T** inputs, T** outputs, int c, int start, int n, double m0, double m2)
+  {
+    const __m128d vM0 = _mm_set1_pd(m0), vM2 = _mm_set1_pd(m2), vTwo = _mm_set1_pd(2.);
+    __m128d ic1eq = _mm_loadu_pd(mIc1eq + c), ic2eq = _mm_loadu_pd(mIc2eq + c);
+    __m128d v1 = _mm_setzero_pd(), v2 = _mm_setzero_pd(), v3 = _mm_setzero_pd();
+    const T* pInputs[2] = { inputs[c] + start, inputs[c + 1] + start };
+    T* pOutputs[2] = { outputs[c] + start, outputs[c + 1] + start };
+    alignas(16) double output[2];
+
+    for (auto i = 0; i < n; i++)
+    {
+      const __m128d v0 = _mm_set_pd(static_cast<double>(pInputs[1][i]), static_cast<double>(pInputs[0][i]));
+      const __m128d a1 = _mm_set1_pd(chunk.a1[i]), a2 = _mm_set1_pd(chunk.a2[i]), a3 = _mm_set1_pd(chunk.a3[i]);
+
+      v3 = _mm_sub_pd(v0, ic2eq);
+      v1 = _mm_add_pd(_mm_mul_pd(a1, ic1eq), _mm_mul_pd(a2, v3));
+      v2 = _mm_add_pd(_mm_add_pd(ic2eq, _mm_mul_pd(a2, ic1eq)), _mm_mul_pd(a3, v3));
+      ic1eq = _mm_sub_pd(_mm_mul_pd(vTwo, v1), ic1eq);
+      ic2eq = _mm_sub_pd(_mm_mul_pd(vTwo, v2), ic2eq);
+
+      _mm_store_pd(output, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vM0, v0), _mm_mul_pd(_mm_set1_pd(chunk.m1[i]), v1)), _mm_mul_pd(vM2, v2)));
+      pOutputs[0][i] = static_cast<T>(output[0]);
+      pOutputs[1][i] = static_cast<T>(output[1]);
+    }
+
+    _mm_storeu_pd(mIc1eq + c, ic1eq);
+    _mm_storeu_pd(mIc2eq + c, ic2eq);
+    _mm_storeu_pd(mV1 + c, v1);
+    _mm_storeu_pd(mV2 + c, v2);
+    _mm_storeu_pd(mV3 + c, v3);
+  }
+#endif
+
   void UpdateCoefficients()
   {
     mState = mNewState;
@@ -118,6 +118,15 @@ public:
     mVoiceAllocator.SetControlGlideTime(t);
   }
 
+  /** Render voices on several cores. See VoiceAllocator::SetNumRenderThreads(). Call this outside of the audio thread, e.g. in the plug-in constructor
+   * @param nThreads The total number of threads to render voices on, including the audio thread. 1 disables multi-core rendering
+   * @param maxOutputChannels The maximum number of output channels that will be passed to ProcessBlock()
+   * @param idleSpinUs How long idle workers spin before they sleep, see VoiceRenderPool::SetIdleSpinTime() */
+  void SetNumRenderThreads(int nThreads, int maxOutputChannels, int idleSpinUs = VoiceRenderPool::kDefaultIdleSpinUs)
+  {
+    mVoiceAllocator.SetNumRenderThreads(nThreads, maxOutputChannels, idleSpinUs);
+  }
+
   SynthVoice* GetVoice(int voiceIdx)
   {
     return mVoiceAllocator.GetVoice(voiceIdx);
@@ -140,9 +149,17 @@ public:
     mVoiceAllocator.AddVoice(pVoice, zone);
   }
 
-  void AddMidiMsgToQueue(const IMidiMsg& msg)
+  /** Queues a MIDI message for the next ProcessBlock(). Realtime safe, the queue is sized in SetSampleRateAndBlockSize()
+   * @return \c false if the queue was full and the message was dropped */
+  bool AddMidiMsgToQueue(const IMidiMsg& msg)
+  {
+    return mMidiQueue.Add(msg);
+  }
+
+  /** @return The number of MIDI messages dropped because the queue was full */
+  int GetMidiOverflowCount() const
   {
-    mMidiQueue.Add(msg);
+    return mMidiQueue.GetOverflowCount();
   }
 
   /** Processes a block of audio samples
@@ -34,6 +34,44 @@ VoiceAllocator::VoiceAllocator()
 
 VoiceAllocator::~VoiceAllocator()
 {
+  mRenderPool.Stop();
+}
+
+void VoiceAllocator::SetSampleRateAndBlockSize(double sampleRate, int blockSize)
+{
+  mSampleRate = sampleRate;
+  mBlockSize = blockSize;
+  CalcGlideTimesInSamples();
+  ResizeRenderBuses();
+}
+
+void VoiceAllocator::SetNumRenderThreads(int nThreads, int maxOutputChannels, int idleSpinUs)
+{
+  mRenderPool.Stop();
+  mRenderChannels = maxOutputChannels;
+  mRenderBuses.clear();
+
+  if (nThreads > 1)
+  {
+    mRenderBuses.resize(nThreads);
+    ResizeRenderBuses();
+    mRenderPool.Start(nThreads - 1, idleSpinUs);
+  }
+}
+
+void VoiceAllocator::ResizeRenderBuses()
+{
+  for (auto& bus : mRenderBuses)
+  {
+    bus.voices.reserve(mVoicePtrs.size());
+    bus.data.assign(static_cast<size_t>(mRenderChannels) * mBlockSize, 0.);
+    bus.channelPtrs.resize(mRenderChannels);
+
+    for (int c = 0; c < mRenderChannels; c++)
+    {
+      bus.channelPtrs[c] = bus.data.data() + static_cast<size_t>(c) * mBlockSize;
+    }
+  }
 }
 
 void VoiceAllocator::Clear()
@@ -62,6 +100,9 @@ void VoiceAllocator::AddVoice(SynthVoice* pVoice, uint8_t zone)
 
     // make a glides structures for the control ramps of the new voice
     mVoiceGlides.emplace_back(ControlRampProcessor::Create(pVoice->mInputs));
+
+    for (auto& bus : mRenderBuses)
+      bus.voices.reserve(mVoicePtrs.size());
   }
   else
   {
@@ -527,11 +568,69 @@ void VoiceAllocator::NoteOff(VoiceInputEvent e, int64_t sampleTime)
   }
 }
 
+void VoiceAllocator::RenderBus(void* pContext, int busIdx)
+{
+  VoiceAllocator* pAllocator = static_cast<VoiceAllocator*>(pContext);
+  const RenderArgs& args = pAllocator->mRenderArgs;
+  RenderBusState& bus = pAllocator->mRenderBuses[busIdx];
+
+  for (int c = 0; c < args.nOutputs; c++)
+  {
+    std::fill_n(bus.channelPtrs[c] + args.startIndex, args.blockSize, 0.);
+  }
+
+  for (auto pVoice : bus.voices)
+  {
+    pVoice->ProcessSamplesAccumulating(args.inputs, bus.channelPtrs.data(), args.nInputs, args.nOutputs, args.startIndex, args.blockSize);
+  }
+}
+
 void VoiceAllocator::ProcessVoices(sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIndex, int blockSize)
 {
+  const int nBuses = static_cast<int>(mRenderBuses.size());
+
+  if (nBuses && nOutputs <= mRenderChannels && startIndex + blockSize <= mBlockSize)
+  {
+    for (auto& bus : mRenderBuses)
+      bus.voices.clear();
+
+    // deal busy voices out round-robin, so that the bus each voice lands on only depends on the set of busy voices
+    int nBusy = 0;
+
+    for (auto pVoice : mVoicePtrs)
+    {
+      if (pVoice->GetBusy())
+      {
+        mRenderBuses[nBusy % nBuses].voices.push_back(pVoice);
+        nBusy++;
+      }
+    }
+
+    if (nBusy > 1)
+    {
+      const int nActiveBuses = std::min(nBusy, nBuses);
+      mRenderArgs = {inputs, nInputs, nOutputs, startIndex, blockSize};
+      mRenderPool.Run(nActiveBuses, &VoiceAllocator::RenderBus, this);
+
+      // sum in bus order, so the result does not depend on which thread rendered which bus
+      for (int b = 0; b < nActiveBuses; b++)
+      {
+        for (int c = 0; c < nOutputs; c++)
+        {
+          const sample* pBus = mRenderBuses[b].channelPtrs[c];
+
+          for (int s = startIndex; s < startIndex + blockSize; s++)
+          {
+            outputs[c][s] += pBus[s];
+          }
+        }
+      }
+      return;
+    }
+  }
+
   for(auto pVoice : mVoicePtrs)
   {
-    // TODO distribute voices across cores
     if(pVoice->GetBusy())
     {
       pVoice->ProcessSamplesAccumulating(inputs, outputs, nInputs, nOutputs, startIndex, blockSize);
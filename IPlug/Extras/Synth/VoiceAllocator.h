@@ -20,12 +20,14 @@
 #include <stdint.h>
 #include <functional>
 #include <bitset>
+#include <climits>
 //#include <iostream>
 
 #include "IPlugLogger.h"
 #include "IPlugQueue.h"
 
 #include "SynthVoice.h"
+#include "VoiceRenderPool.h"
 
 BEGIN_IPLUG_NAMESPACE
 
@@ -109,7 +111,7 @@ public:
 
   void Clear();
 
-  void SetSampleRateAndBlockSize(double sampleRate, int blockSize) { mSampleRate = sampleRate; CalcGlideTimesInSamples(); }
+  void SetSampleRateAndBlockSize(double sampleRate, int blockSize);
   void SetNoteGlideTime(double t) { mNoteGlideTime = t; CalcGlideTimesInSamples(); }
   void SetControlGlideTime(double t) { mControlGlideTime = t; CalcGlideTimesInSamples(); }
 
@@ -137,6 +139,16 @@ public:
 
   void ProcessVoices(sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIndex, int blockSize);
 
+  /** Enables multi-core voice rendering. Busy voices are dealt out to one scratch bus per thread, which are then summed into the outputs in a fixed order.
+   * Voices must not share mutable state in ProcessSamplesAccumulating() when this is enabled. Must not be called from the audio thread.
+   * @param nThreads The total number of threads to render voices on, including the audio thread. 1 or less disables the worker pool
+   * @param maxOutputChannels The maximum number of output channels that will be passed to ProcessVoices(). Blocks with more channels are rendered serially
+   * @param idleSpinUs How long idle workers spin before they sleep, see VoiceRenderPool::SetIdleSpinTime() */
+  void SetNumRenderThreads(int nThreads, int maxOutputChannels, int idleSpinUs = VoiceRenderPool::kDefaultIdleSpinUs);
+
+  /** @return The number of threads voices are rendered on, including the audio thread */
+  int GetNumRenderThreads() const { return mRenderPool.NWorkers() + 1; }
+
   size_t GetNVoices() const {return mVoicePtrs.size();}
   SynthVoice* GetVoice(int voiceIndex) const {return mVoicePtrs[voiceIndex];}
   void SetPitchOffset(float offset) { mPitchOffset = offset; }
@@ -164,6 +176,27 @@ private:
   void NoteOn(VoiceInputEvent e, int64_t sampleTime);
   void NoteOff(VoiceInputEvent e, int64_t sampleTime);
 
+  void ResizeRenderBuses();
+  static void RenderBus(void* pContext, int busIdx);
+
+  /** One thread's worth of voices and the scratch bus they are summed into */
+  struct RenderBusState
+  {
+    std::vector<SynthVoice*> voices;
+    std::vector<sample> data;
+    std::vector<sample*> channelPtrs;
+  };
+
+  /** Arguments of the ProcessVoices() call being distributed across the render pool */
+  struct RenderArgs
+  {
+    sample** inputs;
+    int nInputs;
+    int nOutputs;
+    int startIndex;
+    int blockSize;
+  };
+
   IPlugQueue<VoiceInputEvent> mInputQueue{1024};
 
   std::vector<SynthVoice*> mVoicePtrs;
@@ -179,7 +212,12 @@ private:
   int mNoteGlideSamples{0}; // glide for note-to-note portamento
   int mControlGlideSamples{0}; // glide for controls including pitch bend
   double mSampleRate;
-  int mBlockSize;
+  int mBlockSize{0};
+
+  VoiceRenderPool mRenderPool;
+  std::vector<RenderBusState> mRenderBuses;
+  RenderArgs mRenderArgs{};
+  int mRenderChannels{0};
 
   bool mRotateVoices{true};
   int mVoiceRotateIndex{0};
@@ -0,0 +1,277 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc VoiceRenderPool
+ */
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || _M_IX86_FP >= 2
+  #include <immintrin.h>
+#endif
+
+#include "IPlugPlatform.h"
+
+#if defined OS_WIN
+  #include <windows.h>
+#elif defined OS_MAC || defined OS_IOS
+  #include <pthread.h>
+  #include <sys/qos.h>
+#else
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A small pool of pre-spawned worker threads used by the VoiceAllocator to render voices on multiple cores.
+ * Run() hands out a number of jobs which are claimed by the workers and by the calling (audio) thread itself,
+ * so the block is always finished even if the workers have been descheduled.
+ * The calling thread never locks or allocates: workers spin briefly after a block, in case the next one follows at once,
+ * then sleep on a condition variable until Run() wakes them with a notify.
+ * Workers run at a raised priority where the OS allows it, and, like the calling thread during Run(), flush denormals to zero,
+ * so that the result does not depend on which thread rendered a job. */
+class VoiceRenderPool final
+{
+public:
+  /** Called for each job. Jobs of the same Run() may execute concurrently on different threads */
+  using JobFunc = void(*)(void* pContext, int jobIdx);
+
+  /** The default time that workers spin after a job before they go to sleep until the next Run(), see SetIdleSpinTime().
+   * This is kept short, since workers run at a raised priority and would otherwise take the CPU from other threads between blocks */
+  static constexpr int kDefaultIdleSpinUs = 10;
+
+  /** The largest number of jobs of a single Run() */
+  static constexpr int kMaxJobs = 0xFFFF;
+
+  VoiceRenderPool() = default;
+
+  ~VoiceRenderPool()
+  {
+    Stop();
+  }
+
+  VoiceRenderPool(const VoiceRenderPool&) = delete;
+  VoiceRenderPool& operator=(const VoiceRenderPool&) = delete;
+
+  /** Spawns the worker threads, stopping any existing ones first. Must not be called from the audio thread.
+   * @param nWorkers The number of additional threads to use. The calling thread of Run() is not included
+   * @param idleSpinUs See SetIdleSpinTime() */
+  void Start(int nWorkers, int idleSpinUs = kDefaultIdleSpinUs)
+  {
+    Stop();
+    SetIdleSpinTime(idleSpinUs);
+
+    mRunning.store(true, std::memory_order_release);
+
+    for (int i = 0; i < nWorkers; i++)
+      mWorkers.emplace_back(&VoiceRenderPool::WorkerLoop, this);
+  }
+
+  /** Joins all worker threads. Must not be called from the audio thread or while Run() is in progress */
+  void Stop()
+  {
+    if (mWorkers.empty())
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      mRunning.store(false, std::memory_order_release);
+    }
+
+    mWakeCV.notify_all();
+
+    for (auto& worker : mWorkers)
+      worker.join();
+
+    mWorkers.clear();
+  }
+
+  /** @return The number of worker threads, excluding the calling thread */
+  int NWorkers() const { return static_cast<int>(mWorkers.size()); }
+
+  /** Sets how long workers spin-yield after a job before they go to sleep. A longer time costs CPU between blocks, and with the raised
+   * worker priority it can starve other threads on the same cores. A shorter one means that workers have to be woken for a block,
+   * and then the calling thread renders more of it. Can be called on any thread
+   * @param idleSpinUs The time in microseconds. 0 sends workers to sleep as soon as they are idle */
+  void SetIdleSpinTime(int idleSpinUs) { mIdleSpinUs.store(idleSpinUs > 0 ? idleSpinUs : 0, std::memory_order_relaxed); }
+
+  /** @return The time in microseconds that workers spin before they go to sleep */
+  int GetIdleSpinTime() const { return mIdleSpinUs.load(std::memory_order_relaxed); }
+
+  /** Executes func(pContext, i) for i in [0, nJobs) across the workers and the calling thread, returning once all jobs are complete
+   * @param nJobs The number of jobs, up to kMaxJobs
+   * @param func The function to call for each job
+   * @param pContext Passed as the first argument of func */
+  void Run(int nJobs, JobFunc func, void* pContext)
+  {
+    assert(nJobs >= 0 && nJobs <= kMaxJobs);
+
+    mFunc.store(func, std::memory_order_relaxed);
+    mContext.store(pContext, std::memory_order_relaxed);
+    mJobsDone.store(0, std::memory_order_relaxed);
+
+    // Publish a new generation with its job count and the job index reset, this releases the job description above.
+    // The job count is in the same word, so that a worker still looking at the previous generation cannot claim a job of this one.
+    // This is sequentially consistent with the load of mNSleeping below and its increment in WorkerLoop(), so that either a worker going to sleep sees the new generation, or this sees the worker
+    const uint64_t generation = (mState.load(std::memory_order_relaxed) >> 32) + 1;
+    mState.store((generation << 32) | (static_cast<uint64_t>(nJobs) << 16), std::memory_order_seq_cst);
+
+    if (mNSleeping.load(std::memory_order_seq_cst) > 0)
+      mWakeCV.notify_all();
+
+    const FPState fpState = FlushDenormals();
+
+    RunJobs(static_cast<uint32_t>(generation));
+
+    // The calling thread has finished every job that was unclaimed, so this only waits for jobs that workers are executing.
+    // Workers run at a raised priority (see SetWorkerPriority()) so that they are not preempted by the threads this yields to
+    while (mJobsDone.load(std::memory_order_acquire) < nJobs)
+      std::this_thread::yield();
+
+    RestoreFPState(fpState);
+  }
+
+private:
+#if defined(__SSE2__) || defined(_M_X64) || _M_IX86_FP >= 2
+  using FPState = unsigned int;
+  static constexpr FPState kFlushDenormalsMask = 0x8040; // FTZ and DAZ
+  static FPState GetFPState() { return _mm_getcsr(); }
+  static void SetFPState(FPState state) { _mm_setcsr(state); }
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+  using FPState = uint64_t;
+  static constexpr FPState kFlushDenormalsMask = 1 << 24; // FZ, which flushes both inputs and results on AArch64
+  static FPState GetFPState() { uint64_t state; asm volatile("mrs %0, fpcr" : "=r"(state)); return state; }
+  static void SetFPState(FPState state) { asm volatile("msr fpcr, %0" : : "r"(state)); }
+#else
+  using FPState = int;
+  static constexpr FPState kFlushDenormalsMask = 0;
+  static FPState GetFPState() { return 0; }
+  static void SetFPState(FPState) {}
+#endif
+
+  /** Enables flush to zero and denormals are zero on this thread
+   * @return The previous state, for RestoreFPState() */
+  static FPState FlushDenormals()
+  {
+    const FPState state = GetFPState();
+
+    if ((state & kFlushDenormalsMask) != kFlushDenormalsMask)
+      SetFPState(state | kFlushDenormalsMask);
+
+    return state;
+  }
+
+  static void RestoreFPState(FPState state)
+  {
+    if ((state & kFlushDenormalsMask) != kFlushDenormalsMask)
+      SetFPState(state);
+  }
+
+  /** Raises the priority of the calling worker thread towards that of an audio thread, where the OS allows it without privileges.
+   * Otherwise, e.g. on Linux without an RTPRIO limit, the worker keeps the default priority */
+  static void SetWorkerPriority()
+  {
+#if defined OS_WIN
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#elif defined OS_MAC || defined OS_IOS
+    pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+#else
+    sched_param param {};
+    param.sched_priority = (sched_get_priority_min(SCHED_FIFO) + sched_get_priority_max(SCHED_FIFO)) / 2;
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+  }
+
+  /** Claims and executes jobs of the given generation until there are none left */
+  void RunJobs(uint32_t generation)
+  {
+    uint64_t state = mState.load(std::memory_order_acquire);
+
+    while (true)
+    {
+      if (static_cast<uint32_t>(state >> 32) != generation)
+        return;
+
+      const int nJobs = static_cast<int>((state >> 16) & kMaxJobs);
+      const int jobIdx = static_cast<int>(state & kMaxJobs);
+
+      if (jobIdx >= nJobs)
+        return;
+
+      if (mState.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+      {
+        mFunc.load(std::memory_order_relaxed)(mContext.load(std::memory_order_relaxed), jobIdx);
+        mJobsDone.fetch_add(1, std::memory_order_release);
+        state = mState.load(std::memory_order_acquire);
+      }
+    }
+  }
+
+  void WorkerLoop()
+  {
+    SetWorkerPriority();
+    FlushDenormals();
+
+    uint32_t lastGeneration = static_cast<uint32_t>(mState.load(std::memory_order_acquire) >> 32);
+    auto lastWorkTime = std::chrono::steady_clock::now();
+
+    while (mRunning.load(std::memory_order_acquire))
+    {
+      const uint32_t generation = static_cast<uint32_t>(mState.load(std::memory_order_acquire) >> 32);
+
+      if (generation != lastGeneration)
+      {
+        lastGeneration = generation;
+        RunJobs(generation);
+        lastWorkTime = std::chrono::steady_clock::now();
+      }
+      else if (std::chrono::steady_clock::now() - lastWorkTime < std::chrono::microseconds(mIdleSpinUs.load(std::memory_order_relaxed)))
+      {
+        std::this_thread::yield();
+      }
+      else
+      {
+        // Run() notifies without taking the mutex, so a notify between the check of the predicate and the wait can be missed: the timeout bounds that case.
+        // The audio thread never waits for a sleeping worker since it claims any unclaimed jobs itself
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mNSleeping.fetch_add(1, std::memory_order_seq_cst);
+        mWakeCV.wait_for(lock, std::chrono::milliseconds(1), [&]() {
+          return !mRunning.load(std::memory_order_acquire) || static_cast<uint32_t>(mState.load(std::memory_order_seq_cst) >> 32) != lastGeneration;
+        });
+        mNSleeping.fetch_sub(1, std::memory_order_acq_rel);
+      }
+    }
+  }
+
+  std::vector<std::thread> mWorkers;
+  std::atomic<bool> mRunning{false};
+  std::atomic<uint64_t> mState{0}; // generation in the high 32 bits, then the number of jobs and the next job index in 16 bits each
+  std::atomic<int> mJobsDone{0};
+  std::atomic<JobFunc> mFunc{nullptr};
+  std::atomic<void*> mContext{nullptr};
+  std::atomic<int> mNSleeping{0};
+  std::atomic<int> mIdleSpinUs{kDefaultIdleSpinUs};
+  std::mutex mWakeMutex;
+  std::condition_variable mWakeCV;
+};
+
+END_IPLUG_NAMESPACE
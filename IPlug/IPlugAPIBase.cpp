@@ -43,6 +43,7 @@ IPlugAPIBase::IPlugAPIBase(Config c, EAPI plugAPI)
   Trace(TRACELOC, "%s:%s", c.pluginName, CurrentTime());
   
   mParamDisplayStr.Set("", MAX_PARAM_DISPLAY_LEN);
+  mParamChangeFromProcessor.Resize(c.nParams);
 }
 
 IPlugAPIBase::~IPlugAPIBase()
@@ -118,6 +119,7 @@ void IPlugAPIBase::SetParameterValue(int idx, double normalizedValue)
 {
   Trace(TRACELOC, "%d:%f", idx, normalizedValue);
   GetParam(idx)->SetNormalized(normalizedValue);
+  INVALIDATE_PARAM_SNAPSHOT(idx)
   InformHostOfParamChange(idx, normalizedValue);
   OnParamChange(idx, kUI);
 }
@@ -136,22 +138,26 @@ void IPlugAPIBase::SendParameterValueFromAPI(int paramIdx, double value, bool no
   if (normalized)
     value = GetParam(paramIdx)->FromNormalized(value);
   
-  mParamChangeFromProcessor.PushFromArgs(paramIdx, value);
+  mParamChangeFromProcessor.Push(paramIdx, value);
 }
 
 void IPlugAPIBase::OnTimer(Timer& t)
 {
 // VST3 ********************************************************************************
 #if defined VST3P_API || defined VST3_API
-  while (mMidiMsgsFromProcessor.ElementsAvailable())
+  IMidiMsg msgs[QUEUE_BATCH_SIZE];
+  int nMsgs;
+
+  while ((nMsgs = mMidiMsgsFromProcessor.PopBatch(msgs, QUEUE_BATCH_SIZE)) > 0)
   {
-    IMidiMsg msg;
-    mMidiMsgsFromProcessor.Pop(msg);
+    for (auto i = 0; i < nMsgs; i++)
+    {
 #ifdef VST3P_API // distributed
-    TransmitMidiMsgFromProcessor(msg);
+      TransmitMidiMsgFromProcessor(msgs[i]);
 #else
-    SendMidiMsgFromDelegate(msg);
+      SendMidiMsgFromDelegate(msgs[i]);
 #endif
+    }
   }
 
   while (mSysExDataFromProcessor.ElementsAvailable())
@@ -166,18 +172,17 @@ void IPlugAPIBase::OnTimer(Timer& t)
     }
 // !VST3 ******************************************************************************
 #else
-    while(mParamChangeFromProcessor.ElementsAvailable())
-    {
-      ParamTuple p;
-      mParamChangeFromProcessor.Pop(p);
-      SendParameterValueFromDelegate(p.idx, p.value, false);
-    }
+    mParamChangeFromProcessor.Drain([this](int paramIdx, double value) {
+      SendParameterValueFromDelegate(paramIdx, value, false);
+    });
     
-    while (mMidiMsgsFromProcessor.ElementsAvailable())
+    IMidiMsg msgs[QUEUE_BATCH_SIZE];
+    int nMsgs;
+
+    while ((nMsgs = mMidiMsgsFromProcessor.PopBatch(msgs, QUEUE_BATCH_SIZE)) > 0)
     {
-      IMidiMsg msg;
-      mMidiMsgsFromProcessor.Pop(msg);
-      SendMidiMsgFromDelegate(msg);
+      for (auto i = 0; i < nMsgs; i++)
+        SendMidiMsgFromDelegate(msgs[i]);
     }
     
     while (mSysExDataFromProcessor.ElementsAvailable())
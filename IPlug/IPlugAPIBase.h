@@ -24,7 +24,9 @@
 #include "IPlugUtilities.h"
 #include "IPlugParameter.h"
 #include "IPlugQueue.h"
+#include "IPlugParamChangeQueue.h"
 #include "IPlugTimer.h"
+#include "IPlugParamAutomation.h"
 
 /**
  * @file
@@ -117,6 +119,23 @@ public:
    * @param normalizedValue The new (normalised) value */
   void SetParameterValue(int paramIdx, double normalizedValue);
   
+  /** Call this in your plug-in constructor, after the parameters have been initialized, to receive every host automation point
+   * of a block via GetParamAutomation() rather than just the last value. Supported in VST3 and CLAP. Not realtime safe.
+   * @param enable \c true to enable sample accurate automation
+   * @param maxPointsPerBlock Storage for this many points across all parameters is preallocated, further points in a block are dropped */
+  void SetSampleAccurateAutomation(bool enable, int maxPointsPerBlock = PARAM_AUTOMATION_SIZE)
+  {
+    mParamAutomation.Resize(enable ? NParams() : 0, enable ? maxPointsPerBlock : 0);
+  }
+
+  /** @return \c true if SetSampleAccurateAutomation() has been enabled */
+  bool GetSampleAccurateAutomation() const { return mParamAutomation.IsEnabled(); }
+
+  /** Call this in ProcessBlock() to read the automation points received for the current block, grouped per parameter and sorted by offset.
+   * Parameter values are still set to the last point of the block before ProcessBlock() is called.
+   * @return The automation points of the current block. Empty unless SetSampleAccurateAutomation() has been enabled */
+  const IParamAutomation& GetParamAutomation() const { return mParamAutomation; }
+
   /** Get the color of the track that the plug-in is inserted on */
   virtual void GetTrackColor(int& r, int& g, int& b) { r = 0; g = 0; b = 0; }
 
@@ -222,6 +241,7 @@ private:
   friend class IPlugVST3;
   friend class IPlugVST3Controller;
   friend class IPlugVST3Processor;
+  friend class IPlugVST3ProcessorBase;
   friend class IPlugWAM;
   friend class IPlugWEB;
   friend class IPlugWasmDSP;
@@ -230,12 +250,13 @@ private:
   WDL_String mParamDisplayStr;
   std::unique_ptr<Timer> mTimer;
   
-  IPlugQueue<ParamTuple> mParamChangeFromProcessor {PARAM_TRANSFER_SIZE};
+  IParamChangeQueue mParamChangeFromProcessor; // latest value of each parameter changed by the processor, to send to the editor
   IPlugQueue<IMidiMsg> mMidiMsgsFromEditor {MIDI_TRANSFER_SIZE}; // a queue of midi messages generated in the editor by clicking keyboard UI etc
   IPlugQueue<IMidiMsg> mMidiMsgsFromProcessor {MIDI_TRANSFER_SIZE}; // a queue of MIDI messages received (potentially on the high priority thread), by the processor to send to the editor
   IPlugQueue<SysExData> mSysExDataFromEditor {SYSEX_TRANSFER_SIZE}; // a queue of SYSEX data to send to the processor
   IPlugQueue<SysExData> mSysExDataFromProcessor {SYSEX_TRANSFER_SIZE}; // a queue of SYSEX data to send to the editor
   SysExData mSysexBuf;
+  IParamAutomation mParamAutomation;
 };
 
 END_IPLUG_NAMESPACE
@@ -116,8 +116,13 @@ static const int MAX_PARAM_DISPLAY_PRECISION = 6;
 #endif
 
 #define PARAM_TRANSFER_SIZE 512
+
+#ifndef PARAM_AUTOMATION_SIZE
+#define PARAM_AUTOMATION_SIZE 4096 // max automation points per block when sample accurate automation is enabled
+#endif
 #define MIDI_TRANSFER_SIZE 32
 #define SYSEX_TRANSFER_SIZE 4
+#define QUEUE_BATCH_SIZE 32 // max elements popped from a transfer queue at once when draining it on the main thread
 
 // All version ints are stored as 0xVVVVRRMM: V = version, R = revision, M = minor revision.
 #define IPLUG_VERSION 0x010000
@@ -676,15 +676,19 @@ void MyPlug::ProcessBlock(double** inputs, double** outputs, int nFrames)
 #endif
 
 /** A class to help with queuing timestamped MIDI messages
+  * The queue has a fixed capacity, set by the constructor or Resize(), and never allocates on the audio thread:
+  * messages that don't fit are dropped and counted, see GetOverflowCount().
+  * Messages are kept sorted by mOffset. Appending a message that is not earlier than the last one is O(1),
+  * out of order messages only move the messages that are later than them.
   * @ingroup IPlugUtilities */
 template <class T>
 class IMidiQueueBase
 {
 public:
   IMidiQueueBase(int size = DEFAULT_BLOCK_SIZE)
-  : mBuf(NULL), mSize(0), mGrow(Granulize(size)), mFront(0), mBack(0)
+  : mBuf(NULL), mSize(0), mMask(0), mFront(0), mBack(0), mOverflowCount(0)
   {
-    Expand();
+    Resize(size);
   }
   
   ~IMidiQueueBase()
@@ -692,35 +696,36 @@ public:
     free(mBuf);
   }
 
-  // Adds a MIDI message at the back of the queue. If the queue is full,
-  // it will automatically expand itself.
-  void Add(const T& msg)
+  IMidiQueueBase(const IMidiQueueBase&) = delete;
+  IMidiQueueBase& operator=(const IMidiQueueBase&) = delete;
+
+  // Adds a MIDI message to the queue, at the position given by its offset.
+  // Returns false if the queue is full, in which case the message is dropped.
+  bool Add(const T& msg)
   {
-    if (mBack >= mSize)
+    if (mBack - mFront >= mSize)
     {
-      if (mFront > 0)
-        Compact();
-      else if (!Expand()) return;
+      mOverflowCount++;
+      return false;
     }
 
+    int i = mBack;
+
 #ifndef DONT_SORT_IMIDIQUEUE
-    // Insert the MIDI message at the right offset.
-    if (mBack > mFront && msg.mOffset < mBuf[mBack - 1].mOffset)
+    // Insert the MIDI message at the right offset, moving later messages back by one.
+    while (i > mFront && msg.mOffset < mBuf[(i - 1) & mMask].mOffset)
     {
-      int i = mBack - 2;
-      while (i >= mFront && msg.mOffset < mBuf[i].mOffset) --i;
-      i++;
-      memmove(&mBuf[i + 1], &mBuf[i], (mBack - i) * sizeof(T));
-      mBuf[i] = msg;
+      mBuf[i & mMask] = mBuf[(i - 1) & mMask];
+      --i;
     }
-    else
 #endif
-      mBuf[mBack] = msg;
+
+    mBuf[i & mMask] = msg;
     ++mBack;
+    return true;
   }
 
-  // Removes a MIDI message from the front of the queue (but does *not*
-  // free up its space until Compact() is called).
+  // Removes a MIDI message from the front of the queue.
   inline void Remove() { ++mFront; }
 
   // Returns true if the queue is empty.
@@ -729,82 +734,71 @@ public:
   // Returns the number of MIDI messages in the queue.
   inline int ToDo() const { return mBack - mFront; }
 
-  // Returns the number of MIDI messages for which memory has already been
-  // allocated.
+  // Returns the capacity of the queue.
   inline int GetSize() const { return mSize; }
 
+  // Returns the number of MIDI messages that were dropped because the queue was full.
+  inline int GetOverflowCount() const { return mOverflowCount; }
+
   // Returns the "next" MIDI message (all the way in the front of the
   // queue), but does *not* remove it from the queue.
-  inline T& Peek() const { return mBuf[mFront]; }
+  inline T& Peek() const { return mBuf[mFront & mMask]; }
 
-  // Moves back MIDI messages all the way to the front of the queue, thus
-  // freeing up space at the back, and updates the sample offset of the
-  // remaining MIDI messages by substracting nFrames.
+  // Updates the sample offset of the remaining MIDI messages by substracting nFrames.
   inline void Flush(int nFrames)
   {
-    // Move everything all the way to the front.
-    if (mFront > 0) Compact();
+    // Keep the indices small, subtracting a multiple of the capacity doesn't move any message.
+    const int wrap = mFront & ~mMask;
+    mFront -= wrap;
+    mBack -= wrap;
 
-    // Update the sample offset.
-    for (int i = 0; i < mBack; ++i) mBuf[i].mOffset -= nFrames;
+    for (int i = mFront; i < mBack; ++i) mBuf[i & mMask].mOffset -= nFrames;
   }
 
   // Clears the queue.
   inline void Clear() { mFront = mBack = 0; }
 
-  // Resizes (grows or shrinks) the queue, returns the new size.
+  // Resizes (grows or shrinks) the queue, returns the new size. This allocates, so don't call it on the audio thread.
   int Resize(int size)
   {
-    if (mFront > 0) Compact();
-    mGrow = size = Granulize(size);
+    size = Granulize(size);
     // Don't shrink below the number of currently queued MIDI messages.
-    if (size < mBack) size = Granulize(mBack);
+    if (size < ToDo()) size = Granulize(ToDo());
     if (size == mSize) return mSize;
 
-    void* buf = realloc(mBuf, size * sizeof(T));
+    T* buf = (T*)malloc(size * sizeof(T));
     if (!buf) return mSize;
 
-    mBuf = (T*)buf;
-    mSize = size;
-    return size;
-  }
-
-protected:
-  // Automatically expands the queue.
-  bool Expand()
-  {
-    if (!mGrow) return false;
-    int size = (mSize / mGrow + 1) * mGrow;
+    const int n = ToDo();
+    for (int i = 0; i < n; ++i) buf[i] = mBuf[(mFront + i) & mMask];
 
-    void* buf = realloc(mBuf, size * sizeof(T));
-    if (!buf) return false;
-
-    mBuf = (T*)buf;
+    free(mBuf);
+    mBuf = buf;
     mSize = size;
-    return true;
-  }
-
-  // Moves everything all the way to the front.
-  inline void Compact()
-  {
-    mBack -= mFront;
-    if (mBack > 0) memmove(&mBuf[0], &mBuf[mFront], mBack * sizeof(T));
+    mMask = size - 1;
     mFront = 0;
+    mBack = n;
+    return size;
   }
 
-  // Rounds the MIDI queue size up to the next 4 kB memory page size.
+protected:
+  // Rounds the MIDI queue size up to the next 4 kB memory page size, and then to a power of two.
   inline int Granulize(int size) const
   {
     int bytes = size * sizeof(T);
     int rest = bytes % 4096;
     if (rest) size = (bytes - rest + 4096) / sizeof(T);
-    return size;
+
+    int pow2 = 1;
+    while (pow2 < size) pow2 <<= 1;
+    return pow2;
   }
 
   T* mBuf;
 
-  int mSize, mGrow;
+  int mSize, mMask;
   int mFront, mBack;
+  int mOverflowCount;
 };
 
 using IMidiQueue = IMidiQueueBase<IMidiMsg>;
@@ -0,0 +1,240 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IParamAutomation
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "IPlugPlatform.h"
+#include "IPlugConstants.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A single host automation point within a processing block
+ * @ingroup IPlugStructs */
+struct IParamAutomationPoint
+{
+  int mOffset; // sample offset from the start of the block
+  double mValue; // normalized value
+};
+
+/** Holds every host automation point received for the current processing block, grouped per parameter and sorted by sample offset.
+ * All storage is preallocated by Resize(), so the API classes can fill it on the audio thread without allocating.
+ * Points that do not fit are dropped and counted, see GetOverflowCount().
+ * Read it in ProcessBlock() via IPlugAPIBase::GetParamAutomation(), for example:
+ * @code
+ * const IParamAutomation& automation = GetParamAutomation();
+ * if (automation.NPoints(kGain))
+ *   automation.Render(kGain, mGainBuffer.Get(), nFrames);
+ * @endcode */
+class IParamAutomation
+{
+public:
+  IParamAutomation() = default;
+
+  IParamAutomation(const IParamAutomation&) = delete;
+  IParamAutomation& operator=(const IParamAutomation&) = delete;
+
+  /** Allocates storage. Not realtime safe
+   * @param nParams The number of parameters of the plug-in
+   * @param maxPoints The maximum number of points across all parameters in a single block */
+  void Resize(int nParams, int maxPoints)
+  {
+    mInput.resize(maxPoints);
+    mPoints.resize(maxPoints);
+    mParams.assign(nParams, ParamState());
+    mChangedParams.resize(nParams);
+    mNInput = 0;
+    mNChangedParams = 0;
+  }
+
+  /** @return \c true if storage has been allocated */
+  bool IsEnabled() const { return !mPoints.empty(); }
+
+  /** Called by the API class at the start of each block, only touches the parameters that changed in the previous block */
+  void Clear()
+  {
+    for (int i = 0; i < mNChangedParams; i++)
+    {
+      mParams[mChangedParams[i]].mNPoints = 0;
+    }
+
+    mNInput = 0;
+    mNChangedParams = 0;
+  }
+
+  /** Called by the API class on the audio thread for each incoming automation point
+   * @param paramIdx The parameter index
+   * @param offset The sample offset in the block
+   * @param normalizedValue The normalized value at that offset
+   * @param previousNormalizedValue The normalized value of the parameter before this point, used as the start value if this is the first point of the block
+   * @return \c false if the point was dropped because storage is full */
+  bool Add(int paramIdx, int offset, double normalizedValue, double previousNormalizedValue)
+  {
+    if (paramIdx < 0 || paramIdx >= static_cast<int>(mParams.size()))
+      return false;
+
+    if (mNInput >= static_cast<int>(mInput.size()))
+    {
+      mOverflowCount++;
+      return false;
+    }
+
+    ParamState& state = mParams[paramIdx];
+
+    if (state.mNPoints == 0)
+    {
+      state.mStartValue = previousNormalizedValue;
+      mChangedParams[mNChangedParams++] = paramIdx;
+    }
+
+    state.mNPoints++;
+    mInput[mNInput++] = {paramIdx, {offset, normalizedValue}};
+    return true;
+  }
+
+  /** Called by the API class once all points of a block have been added. Groups the points per parameter (counting sort, stable)
+   * and orders each parameter's points by offset. Cost is proportional to the number of points.
+   * @param interpolate \c true if values ramp linearly between points (VST3), \c false if each point is a step (CLAP) */
+  void Finalize(bool interpolate)
+  {
+    mInterpolate = interpolate;
+
+    int start = 0;
+
+    for (int i = 0; i < mNChangedParams; i++)
+    {
+      ParamState& state = mParams[mChangedParams[i]];
+      state.mStart = start;
+      start += state.mNPoints;
+      state.mNPoints = 0;
+    }
+
+    for (int i = 0; i < mNInput; i++)
+    {
+      ParamState& state = mParams[mInput[i].mParamIdx];
+      IParamAutomationPoint* pPoints = &mPoints[state.mStart];
+      int j = state.mNPoints++;
+
+      // hosts deliver points in order, so this insertion step is normally a no-op
+      while (j > 0 && pPoints[j - 1].mOffset > mInput[i].mPoint.mOffset)
+      {
+        pPoints[j] = pPoints[j - 1];
+        j--;
+      }
+
+      pPoints[j] = mInput[i].mPoint;
+    }
+  }
+
+  /** @return The number of parameters that received automation in this block */
+  int NChangedParams() const { return mNChangedParams; }
+
+  /** @param changedIdx Index in [0, NChangedParams())
+   * @return The parameter index */
+  int GetChangedParam(int changedIdx) const { return mChangedParams[changedIdx]; }
+
+  /** @return The number of automation points for a parameter in this block, 0 if it was not automated */
+  int NPoints(int paramIdx) const
+  {
+    return (paramIdx >= 0 && paramIdx < static_cast<int>(mParams.size())) ? mParams[paramIdx].mNPoints : 0;
+  }
+
+  /** @return An automation point of a parameter, points are sorted by offset */
+  const IParamAutomationPoint& GetPoint(int paramIdx, int pointIdx) const
+  {
+    assert(pointIdx < NPoints(paramIdx));
+    return mPoints[mParams[paramIdx].mStart + pointIdx];
+  }
+
+  /** @return The normalized value of the parameter at the start of the block */
+  double GetStartValue(int paramIdx) const { return mParams[paramIdx].mStartValue; }
+
+  /** Writes one normalized value per sample for a parameter that has points in this block
+   * @param paramIdx The parameter index
+   * @param pOutput Buffer of at least nFrames values
+   * @param nFrames The block size */
+  template <typename T>
+  void Render(int paramIdx, T* pOutput, int nFrames) const
+  {
+    const int nPoints = NPoints(paramIdx);
+    double value = GetStartValue(paramIdx);
+    int pos = 0;
+
+    for (int p = 0; p < nPoints && pos < nFrames; p++)
+    {
+      const IParamAutomationPoint& point = GetPoint(paramIdx, p);
+
+      if (mInterpolate)
+      {
+        // VST3 semantics: the value ramps linearly from the previous point and reaches this point's value at its offset
+        const int end = std::min(point.mOffset + 1, nFrames);
+
+        if (end > pos)
+        {
+          const double inc = (point.mValue - value) / static_cast<double>(point.mOffset + 1 - pos);
+
+          for (; pos < end; pos++)
+          {
+            value += inc;
+            pOutput[pos] = static_cast<T>(value);
+          }
+        }
+      }
+      else
+      {
+        const int end = std::min(point.mOffset, nFrames);
+
+        for (; pos < end; pos++)
+          pOutput[pos] = static_cast<T>(value);
+      }
+
+      value = point.mValue;
+    }
+
+    for (; pos < nFrames; pos++)
+      pOutput[pos] = static_cast<T>(value);
+  }
+
+  /** @return The total number of points dropped because the storage was full */
+  int GetOverflowCount() const { return mOverflowCount; }
+
+private:
+  struct ParamState
+  {
+    int mStart = 0;
+    int mNPoints = 0;
+    double mStartValue = 0.;
+  };
+
+  struct InputPoint
+  {
+    int mParamIdx;
+    IParamAutomationPoint mPoint;
+  };
+
+  std::vector<InputPoint> mInput;
+  std::vector<IParamAutomationPoint> mPoints;
+  std::vector<ParamState> mParams;
+  std::vector<int> mChangedParams;
+  int mNInput = 0;
+  int mNChangedParams = 0;
+  int mOverflowCount = 0;
+  bool mInterpolate = false;
+};
+
+END_IPLUG_NAMESPACE
@@ -0,0 +1,110 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IParamChangeQueue
+ */
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <stdint.h>
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Transfers parameter values from the processor to the UI, keeping only the latest value of each parameter.
+ * Unlike IPlugQueue, pushing never fails and memory use is fixed by the number of parameters rather than the update rate:
+ * each parameter has an atomic value slot and a bit in a dirty bitset. Drain() visits the parameters whose bit is set,
+ * so a parameter that changes every block is only delivered once per UI tick, with its final value. Push() is wait-free
+ * and can be called from several threads. Drain() must only be called from a single (consumer) thread. */
+class IParamChangeQueue
+{
+public:
+  IParamChangeQueue() = default;
+
+  IParamChangeQueue(const IParamChangeQueue&) = delete;
+  IParamChangeQueue& operator=(const IParamChangeQueue&) = delete;
+
+  /** Allocates storage and clears all pending changes. Not realtime safe
+   * @param nParams The number of parameters */
+  void Resize(int nParams)
+  {
+    mNParams = nParams;
+    mNWords = (nParams + kBitsPerWord - 1) / kBitsPerWord;
+    mValues = std::make_unique<std::atomic<double>[]>(nParams);
+    mDirty = std::make_unique<std::atomic<uint64_t>[]>(mNWords);
+
+    for (int i = 0; i < nParams; i++)
+      mValues[i].store(0., std::memory_order_relaxed);
+
+    for (int w = 0; w < mNWords; w++)
+      mDirty[w].store(0, std::memory_order_relaxed);
+  }
+
+  /** Sets the latest value of a parameter and marks it as changed. Realtime safe
+   * @param paramIdx The parameter index
+   * @param value The value, which is delivered as is */
+  void Push(int paramIdx, double value)
+  {
+    assert(paramIdx >= 0 && paramIdx < mNParams);
+
+    mValues[paramIdx].store(value, std::memory_order_relaxed);
+    // release: the value above is visible to a consumer that sees the bit
+    mDirty[paramIdx / kBitsPerWord].fetch_or(uint64_t(1) << (paramIdx % kBitsPerWord), std::memory_order_release);
+  }
+
+  /** Calls func(paramIdx, value) once for every parameter that changed since the last call, in ascending parameter order.
+   * A value pushed while this is running is either delivered now or on the next call, never lost
+   * @param func A function with the signature void(int paramIdx, double value)
+   * @return The number of parameters delivered */
+  template <typename F>
+  int Drain(F func)
+  {
+    int nChanged = 0;
+
+    for (int w = 0; w < mNWords; w++)
+    {
+      if (!mDirty[w].load(std::memory_order_relaxed))
+        continue;
+
+      uint64_t bits = mDirty[w].exchange(0, std::memory_order_acquire);
+
+      for (int b = 0; bits; b++, bits >>= 1)
+      {
+        if (bits & 1)
+        {
+          const int paramIdx = w * kBitsPerWord + b;
+          func(paramIdx, mValues[paramIdx].load(std::memory_order_relaxed));
+          nChanged++;
+        }
+      }
+    }
+
+    return nChanged;
+  }
+
+  /** @return The number of parameters */
+  int NParams() const { return mNParams; }
+
+private:
+  static constexpr int kBitsPerWord = 64;
+
+  std::unique_ptr<std::atomic<double>[]> mValues;
+  std::unique_ptr<std::atomic<uint64_t>[]> mDirty;
+  int mNParams = 0;
+  int mNWords = 0;
+};
+
+END_IPLUG_NAMESPACE
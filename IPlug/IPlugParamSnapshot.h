@@ -0,0 +1,123 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IParamSnapshot
+ */
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "IPlugPlatform.h"
+#include "IPlugConstants.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A triple-buffered copy of all parameter values, used when PARAMS_SNAPSHOT is defined instead of PARAMS_MUTEX.
+ * Non-realtime threads (state and preset recall) write a complete set of values with Write(), and the audio thread picks up
+ * the most recent set at the start of a block with Claim(). The audio thread never locks or waits: concurrent writers
+ * are serialized with a mutex that only they take, and a set that is replaced before the audio thread sees it is skipped.
+ * Single parameter changes by the host or the UI are recorded with Invalidate(), so that IsCurrent() tells whether a set still holds the latest value of a parameter. */
+class IParamSnapshot
+{
+public:
+  /** One complete set of parameter values */
+  struct Slot
+  {
+    std::vector<double> mValues;
+    EParamSource mSource = kUnknown;
+    uint64_t mSequence = 0; // When the set was written, see IsCurrent()
+  };
+
+  IParamSnapshot() = default;
+
+  IParamSnapshot(const IParamSnapshot&) = delete;
+  IParamSnapshot& operator=(const IParamSnapshot&) = delete;
+
+  /** Allocates storage. Not realtime safe, call before processing starts
+   * @param nParams The number of parameters */
+  void Resize(int nParams)
+  {
+    for (auto& slot : mSlots)
+      slot.mValues.resize(nParams);
+
+    mChangeSequences.reset(new std::atomic<uint64_t>[nParams]);
+
+    for (int i = 0; i < nParams; i++)
+      mChangeSequences[i].store(0);
+  }
+
+  /** Fills a slot and publishes it. Call on any thread except the audio thread
+   * @param getValue A function taking a parameter index and returning its value
+   * @param source The source that will be reported when the values are applied */
+  template <typename F>
+  void Write(F&& getValue, EParamSource source)
+  {
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+
+    Slot& slot = mSlots[mWriteIdx];
+
+    // Taken before the values are read, so that a change that is not in the set is later than it
+    slot.mSequence = mSequence.fetch_add(1) + 1;
+
+    for (int i = 0; i < static_cast<int>(slot.mValues.size()); i++)
+      slot.mValues[i] = getValue(i);
+
+    slot.mSource = source;
+    mWriteIdx = mShared.exchange(mWriteIdx | kDirtyFlag, std::memory_order_acq_rel) & kIdxMask;
+  }
+
+  /** Takes ownership of the most recently written slot. Call on the audio thread, this is realtime safe
+   * @return Pointer to the slot, valid until the next call to Claim(), or nullptr if nothing was written since the last claim */
+  const Slot* Claim()
+  {
+    if (!(mShared.load(std::memory_order_relaxed) & kDirtyFlag))
+      return nullptr;
+
+    mReadIdx = mShared.exchange(mReadIdx, std::memory_order_acq_rel) & kIdxMask;
+    return &mSlots[mReadIdx];
+  }
+
+  /** Records that a single parameter was changed after the sets written so far. Call on any thread after the IParam has been set, this is realtime safe
+   * @param paramIdx The index of the parameter */
+  void Invalidate(int paramIdx)
+  {
+    assert(paramIdx >= 0 && paramIdx < static_cast<int>(mSlots[0].mValues.size()));
+    mChangeSequences[paramIdx].store(mSequence.fetch_add(1) + 1);
+  }
+
+  /** @param slot A set returned by Claim()
+   * @param paramIdx The index of the parameter
+   * @return \c true if the parameter has not been changed by itself since slot was written, so that slot holds its latest value */
+  bool IsCurrent(const Slot& slot, int paramIdx) const
+  {
+    return mChangeSequences[paramIdx].load() < slot.mSequence;
+  }
+
+private:
+  static constexpr int kIdxMask = 3;
+  static constexpr int kDirtyFlag = 4;
+
+  Slot mSlots[3];
+  int mWriteIdx = 0;
+  int mReadIdx = 2;
+  std::atomic<int> mShared {1};
+  std::mutex mWriteMutex;
+  std::atomic<uint64_t> mSequence {0}; // Counts Write() and Invalidate() calls
+  std::unique_ptr<std::atomic<uint64_t>[]> mChangeSequences; // The sequence of the last Invalidate() of each parameter
+};
+
+END_IPLUG_NAMESPACE
@@ -23,6 +23,10 @@
 #include <windows.h>
 #include <Shlobj.h>
 #include <Shlwapi.h>
+#elif defined OS_LINUX
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
 #endif
 
 BEGIN_IPLUG_NAMESPACE
@@ -284,6 +288,94 @@ EResourceLocation LocateResource(const char* name, const char* type, WDL_String&
   return EResourceLocation::kNotFound;
 }
 
+#elif defined OS_LINUX
+#pragma mark - OS_LINUX
+
+void UserHomePath(WDL_String& path)
+{
+  const char* pHome = getenv("HOME");
+  path.Set(pHome ? pHome : "");
+}
+
+void DesktopPath(WDL_String& path)
+{
+  UserHomePath(path);
+  path.Append("/Desktop");
+}
+
+void AppSupportPath(WDL_String& path, bool isSystem)
+{
+  const char* pConfig = getenv("XDG_CONFIG_HOME");
+
+  if (isSystem)
+    path.Set("/etc");
+  else if (pConfig && pConfig[0])
+    path.Set(pConfig);
+  else
+  {
+    UserHomePath(path);
+    path.Append("/.config");
+  }
+}
+
+void VST3PresetsPath(WDL_String& path, const char* mfrName, const char* pluginName, bool isSystem)
+{
+  if (isSystem)
+    path.Set("/usr/share/vst3/presets");
+  else
+  {
+    UserHomePath(path);
+    path.Append("/.vst3/presets");
+  }
+
+  path.AppendFormatted(MAX_WIN32_PATH_LEN, "/%s/%s", mfrName, pluginName);
+}
+
+static bool FileExists(const char* path)
+{
+  struct stat info;
+  return stat(path, &info) == 0 && S_ISREG(info.st_mode);
+}
+
+EResourceLocation LocateResource(const char* name, const char* type, WDL_String& result, const char*, void*, const char*)
+{
+  if (CStringHasContents(name))
+  {
+    if (FileExists(name))
+    {
+      result.Set(name);
+      return EResourceLocation::kAbsolutePath;
+    }
+
+    // Otherwise look in the resources folders of the project layout, relative to the working directory and then to the executable
+    WDL_String fileName(name);
+    const char* subFolder = (strcmp(type, "ttf") == 0 || strcmp(type, "TTF") == 0) ? "fonts" : "img";
+    WDL_String exeDir;
+    char exePath[4096] = {};
+
+    if (readlink("/proc/self/exe", exePath, sizeof(exePath) - 1) > 0)
+    {
+      exeDir.Set(exePath);
+      exeDir.remove_filepart();
+    }
+
+    const char* roots[] = { ".", exeDir.Get() };
+
+    for (const char* root : roots)
+    {
+      if (!CStringHasContents(root))
+        continue;
+
+      result.SetFormatted(MAX_WIN32_PATH_LEN, "%s/resources/%s/%s", root, subFolder, fileName.get_filepart());
+
+      if (FileExists(result.Get()))
+        return EResourceLocation::kAbsolutePath;
+    }
+  }
+
+  return EResourceLocation::kNotFound;
+}
+
 #endif
 
 END_IPLUG_NAMESPACE
@@ -49,6 +49,10 @@
 #include <cstring>
 #include <cstdlib>
 
+#if defined PARAMS_MUTEX && defined PARAMS_SNAPSHOT
+  #error PARAMS_MUTEX and PARAMS_SNAPSHOT are mutually exclusive
+#endif
+
 #ifdef PARAMS_MUTEX
   #define ENTER_PARAMS_MUTEX mParams_mutex.Enter(); Trace(TRACELOC, "%s", "ENTER_PARAMS_MUTEX");
   #define LEAVE_PARAMS_MUTEX mParams_mutex.Leave(); Trace(TRACELOC, "%s", "LEAVE_PARAMS_MUTEX");
@@ -61,6 +65,20 @@
   #define LEAVE_PARAMS_MUTEX_STATIC
 #endif
 
+// With PARAMS_SNAPSHOT the API classes apply parameter values recalled on other threads at the start of each block, see IPluginBase::ApplyParamSnapshot(),
+// and record single parameter changes by the host or the UI, see IPluginBase::InvalidateParamSnapshotValue()
+#ifdef PARAMS_SNAPSHOT
+  #define APPLY_PARAMS_SNAPSHOT ApplyParamSnapshot();
+  #define APPLY_PARAMS_SNAPSHOT_STATIC _this->ApplyParamSnapshot();
+  #define INVALIDATE_PARAM_SNAPSHOT(idx) InvalidateParamSnapshotValue(idx);
+  #define INVALIDATE_PARAM_SNAPSHOT_STATIC(idx) _this->InvalidateParamSnapshotValue(idx);
+#else
+  #define APPLY_PARAMS_SNAPSHOT
+  #define APPLY_PARAMS_SNAPSHOT_STATIC
+  #define INVALIDATE_PARAM_SNAPSHOT(idx)
+  #define INVALIDATE_PARAM_SNAPSHOT_STATIC(idx)
+#endif
+
 #define BEGIN_IPLUG_NAMESPACE namespace iplug {
 #define END_IPLUG_NAMESPACE }
 
@@ -24,6 +24,10 @@ IPluginBase::IPluginBase(int nParams, int nPresets)
 {  
   for (int i = 0; i < nPresets; ++i)
     mPresets.Add(new IPreset());
+
+#ifdef PARAMS_SNAPSHOT
+  mParamSnapshot.Resize(nParams);
+#endif
 }
 
 IPluginBase::~IPluginBase()
@@ -138,12 +142,57 @@ int IPluginBase::UnserializeParams(const IByteChunk& chunk, int startPos)
     }
   }
 
+#ifdef PARAMS_SNAPSHOT
+  // DSP updates happen on the audio thread when the snapshot is applied, only update the UI here
+  PublishParamSnapshot(kPresetRecall);
+
+  for (i = 0; i < n; ++i)
+    OnParamChangeUI(i, kPresetRecall);
+#else
   OnParamReset(kPresetRecall);
+#endif
   LEAVE_PARAMS_MUTEX
 
   return pos;
 }
 
+#ifdef PARAMS_SNAPSHOT
+void IPluginBase::PublishParamSnapshot(EParamSource source)
+{
+  mParamSnapshot.Write([&](int paramIdx) { return GetParam(paramIdx)->Value(); }, source);
+}
+
+void IPluginBase::ApplyParamSnapshot()
+{
+  if (const IParamSnapshot::Slot* pSlot = mParamSnapshot.Claim())
+  {
+    // the IParams were already set by the recalling thread, the DSP reads this copy with GetParamSnapshotValue()
+    mAppliedParamSnapshot = pSlot;
+    OnParamResetDSP(pSlot->mSource);
+  }
+}
+
+void IPluginBase::OnParamResetDSP(EParamSource source)
+{
+  for (int i = 0; i < NParams(); ++i)
+    OnParamChangeDSP(i, GetParamSnapshotValue(i), source);
+}
+
+void IPluginBase::OnParamChangeDSP(int paramIdx, double value, EParamSource source)
+{
+  if (GetParam(paramIdx)->Value() == value)
+    OnParamChange(paramIdx, source);
+}
+
+double IPluginBase::GetParamSnapshotValue(int paramIdx) const
+{
+  if (mAppliedParamSnapshot && mParamSnapshot.IsCurrent(*mAppliedParamSnapshot, paramIdx))
+    return mAppliedParamSnapshot->mValues[paramIdx];
+
+  return GetParam(paramIdx)->Value();
+}
+#endif
+
 void IPluginBase::InitParamRange(int startIdx, int endIdx, int countStart, const char* nameFmtStr, double defaultVal, double minVal, double maxVal, double step, const char *label, int flags, const char *group, const IParam::Shape& shape, IParam::EParamUnit unit, IParam::DisplayFunc displayFunc)
 {
   WDL_String nameStr;
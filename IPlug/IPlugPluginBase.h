@@ -19,6 +19,9 @@
 #include "IPlugParameter.h"
 #include "IPlugStructs.h"
 #include "IPlugLogger.h"
+#ifdef PARAMS_SNAPSHOT
+#include "IPlugParamSnapshot.h"
+#endif
 
 BEGIN_IPLUG_NAMESPACE
 
@@ -439,6 +442,54 @@ protected:
   /** Lock when accessing mParams (including via GetParam) from the audio thread */
   WDL_Mutex mParams_mutex;
 #endif  
+
+#ifdef PARAMS_SNAPSHOT
+public:
+  /** With PARAMS_SNAPSHOT, the audio thread counterpart of OnParamReset(). Called by ApplyParamSnapshot() at the start of the first block after
+   * state or a preset is recalled, while OnParamReset() is not called. Override it instead of OnParamReset() to update DSP state, which should read
+   * the recalled values with GetParamSnapshotValue(). UI updates happen on the recalling thread via OnParamChangeUI(). Must be realtime safe.
+   * The default implementation calls OnParamChangeDSP() for each parameter with its value from GetParamSnapshotValue()
+   * @param source Specifies the source of the parameter changes */
+  virtual void OnParamResetDSP(EParamSource source);
+
+  /** With PARAMS_SNAPSHOT, called by the default OnParamResetDSP() for each parameter. Override it to update DSP state from value,
+   * which unlike GetParam()->Value() is not changed by a recall that is in progress on another thread. Must be realtime safe.
+   * The default implementation calls OnParamChange(), which reads the IParams, but only if the IParam still has value.
+   * If it does not, the parameter has been set again since, by the host or the UI, which call OnParamChange() themselves, or by another recall, which is applied at the next block
+   * @param paramIdx The index of the parameter
+   * @param value The value to apply
+   * @param source Specifies the source of the parameter change */
+  virtual void OnParamChangeDSP(int paramIdx, double value, EParamSource source);
+
+  /** Get a parameter value from the snapshot most recently applied on the audio thread. Unlike GetParam()->Value(), the values are consistent
+   * with each other and are not changed by a recall while a block is processed. Once the host or the UI sets the parameter by itself, this returns
+   * the IParam value instead, until the next snapshot is applied. Call on the audio thread
+   * @param paramIdx The index of the parameter
+   * @return The value, or the current IParam value if no snapshot has been applied yet or the parameter has been set since */
+  double GetParamSnapshotValue(int paramIdx) const;
+
+  /** Records that the host or the UI has set a single parameter, so that GetParamSnapshotValue() returns its new value.
+   * Called by the API classes after they set an IParam (see INVALIDATE_PARAM_SNAPSHOT), on any thread. Realtime safe
+   * @param paramIdx The index of the parameter */
+  void InvalidateParamSnapshotValue(int paramIdx) { mParamSnapshot.Invalidate(paramIdx); }
+
+protected:
+  /** Called on a non-realtime thread after a complete set of parameter values has been changed (e.g. state or preset recall).
+   * Copies the current values into mParamSnapshot, to be applied on the audio thread by ApplyParamSnapshot()
+   * @param source The source passed to OnParamChange() when the values are applied */
+  void PublishParamSnapshot(EParamSource source);
+
+  /** Called by the API classes on the audio thread at the start of each block (see APPLY_PARAMS_SNAPSHOT).
+   * If a snapshot has been published since the last block, makes it the source of GetParamSnapshotValue() and calls OnParamResetDSP(),
+   * so that DSP state only ever changes between blocks and on the audio thread. The shared IParams are not written. Realtime safe */
+  void ApplyParamSnapshot();
+
+  /** Parameter values published by non-realtime threads, replaces mParams_mutex */
+  IParamSnapshot mParamSnapshot;
+
+  /** The slot last claimed by ApplyParamSnapshot(), owned by the audio thread until the next claim */
+  const IParamSnapshot::Slot* mAppliedParamSnapshot = nullptr;
+#endif
 };
 
 END_IPLUG_NAMESPACE
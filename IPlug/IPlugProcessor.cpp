@@ -14,6 +14,7 @@
  */
 
 #include "IPlugProcessor.h"
+#include "IPlugSampleConversion.h"
 
 #ifdef OS_WIN
 #define strtok_r strtok_s
@@ -482,7 +483,7 @@ void IPlugProcessor::AttachBuffers(ERoute direction, int idx, int n, PLUG_SAMPLE
       if (direction == ERoute::kInput)
       {
         PLUG_SAMPLE_DST* pScratch = pChannel->mScratchBuf.Get();
-        CastCopy(pScratch, *(ppData++), nFrames);
+        ConvertSamples(pScratch, *(ppData++), nFrames);
         *(pChannel->mData) = pScratch;
       }
       else // output
@@ -515,7 +516,7 @@ void IPlugProcessor::PassThroughBuffers(PLUG_SAMPLE_SRC type, int nFrames)
     IChannelData<>* pOutChannel = *ppOutChannel;
     if (pOutChannel->mConnected)
     {
-      CastCopy(pOutChannel->mIncomingData, *(pOutChannel->mData), nFrames);
+      ConvertSamples(pOutChannel->mIncomingData, *(pOutChannel->mData), nFrames);
     }
   }
 }
@@ -537,7 +538,7 @@ void IPlugProcessor::ProcessBuffers(PLUG_SAMPLE_SRC type, int nFrames)
 
     if (pOutChannel->mConnected)
     {
-      CastCopy(pOutChannel->mIncomingData, *(pOutChannel->mData), nFrames);
+      ConvertSamples(pOutChannel->mIncomingData, *(pOutChannel->mData), nFrames);
     }
   }
 }
@@ -553,12 +554,8 @@ void IPlugProcessor::ProcessBuffersAccumulating(int nFrames)
     IChannelData<>* pOutChannel = *ppOutChannel;
     if (pOutChannel->mConnected)
     {
-      PLUG_SAMPLE_SRC* pDest = pOutChannel->mIncomingData;
-      PLUG_SAMPLE_DST* pSrc = *(pOutChannel->mData); // TODO : check this: PLUG_SAMPLE_DST will allways be float, because this is only for VST2 accumulating
-      for (int j = 0; j < nFrames; ++j, ++pDest, ++pSrc)
-      {
-        *pDest += (PLUG_SAMPLE_SRC) *pSrc;
-      }
+      // TODO : check this: PLUG_SAMPLE_DST will allways be float, because this is only for VST2 accumulating
+      ConvertAndAccumulateSamples(pOutChannel->mIncomingData, *(pOutChannel->mData), nFrames);
     }
   }
 }
@@ -570,13 +567,13 @@ void IPlugProcessor::ZeroScratchBuffers()
   for (i = 0; i < nIn; ++i)
   {
     IChannelData<>* pInChannel = mChannelData[ERoute::kInput].Get(i);
-    memset(pInChannel->mScratchBuf.Get(), 0, mBlockSize * sizeof(PLUG_SAMPLE_DST));
+    ZeroSamples(pInChannel->mScratchBuf.Get(), mBlockSize);
   }
 
   for (i = 0; i < nOut; ++i)
   {
     IChannelData<>* pOutChannel = mChannelData[ERoute::kOutput].Get(i);
-    memset(pOutChannel->mScratchBuf.Get(), 0, mBlockSize * sizeof(PLUG_SAMPLE_DST));
+    ZeroSamples(pOutChannel->mScratchBuf.Get(), mBlockSize);
   }
 }
 
@@ -590,14 +587,14 @@ void IPlugProcessor::SetBlockSize(int blockSize)
     {
       IChannelData<>* pInChannel = mChannelData[ERoute::kInput].Get(i);
       pInChannel->mScratchBuf.Resize(blockSize);
-      memset(pInChannel->mScratchBuf.Get(), 0, blockSize * sizeof(PLUG_SAMPLE_DST));
+      ZeroSamples(pInChannel->mScratchBuf.Get(), blockSize);
     }
 
     for (i = 0; i < nOut; ++i)
     {
       IChannelData<>* pOutChannel = mChannelData[ERoute::kOutput].Get(i);
       pOutChannel->mScratchBuf.Resize(blockSize);
-      memset(pOutChannel->mScratchBuf.Get(), 0, blockSize * sizeof(PLUG_SAMPLE_DST));
+      ZeroSamples(pOutChannel->mScratchBuf.Get(), blockSize);
     }
 
     mBlockSize = blockSize;
@@ -26,13 +26,16 @@ BEGIN_IPLUG_NAMESPACE
 
 /** A lock-free SPSC queue used to transfer data between threads
  * based on MLQueue.h by Randy Jones
- * based on https://kjellkod.wordpress.com/2012/11/28/c-debt-paid-in-full-wait-free-lock-free-queue/ */
+ * based on https://kjellkod.wordpress.com/2012/11/28/c-debt-paid-in-full-wait-free-lock-free-queue/
+ * The capacity is rounded up to a power of two. The producer and consumer indices live on separate cache lines
+ * and each side caches the other side's index, so the shared indices are only re-read when the queue looks full/empty.
+ * PushBatch() and PopBatch() transfer several elements with a single release store */
 template<typename T>
 class IPlugQueue final
 {
 public:
   /** IPlugQueue constructor
-   * @param size The queue capacity (number of elements) */
+   * @param size The queue capacity (number of elements), rounded up to a power of two */
   IPlugQueue(int size)
   {
     Resize(size);
@@ -43,13 +46,25 @@ public:
   IPlugQueue(const IPlugQueue&) = delete;
   IPlugQueue& operator=(const IPlugQueue&) = delete;
     
-  /** Changes the queue capacity
-   * @param size The new queue capacity (number of elements) */
+  /** Changes the queue capacity and empties the queue. Not thread safe
+   * @param size The new queue capacity (number of elements), rounded up to a power of two */
   void Resize(int size)
   {
-    mData.Resize(size + 1);
+    size_t capacity = 1;
+    while (capacity < static_cast<size_t>(size))
+      capacity <<= 1;
+
+    mData.Resize(static_cast<int>(capacity));
+    mMask = capacity - 1;
+    mWriteIndex.store(0);
+    mReadIndex.store(0);
+    mCachedReadIndex = 0;
+    mCachedWriteIndex = 0;
   }
 
+  /** @return The queue capacity (number of elements) */
+  size_t Capacity() const { return mMask + 1; }
+
   /** Adds an item to the queue
    * @param item The item to add to the queue
    * @return true if the item was successfully added
@@ -57,14 +72,31 @@ public:
   bool Push(const T& item)
   {
     const auto currentWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
-    const auto nextWriteIndex = Increment(currentWriteIndex);
-    if(nextWriteIndex != mReadIndex.load(std::memory_order_acquire))
-    {
-      mData.Get()[currentWriteIndex] = item;
-      mWriteIndex.store(nextWriteIndex, std::memory_order_release);
-      return true;
-    }
-    return false;
+    if (FreeSpace(currentWriteIndex, 1) == 0)
+      return false;
+
+    mData.Get()[currentWriteIndex & mMask] = item;
+    mWriteIndex.store(currentWriteIndex + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Adds as many items as fit in the queue, publishing them all at once
+   * @param pItems Pointer to the items to add
+   * @param nItems The number of items to add
+   * @return The number of items that were added, which is less than nItems if the queue became full */
+  int PushBatch(const T* pItems, int nItems)
+  {
+    const auto currentWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
+    const auto n = static_cast<int>(FreeSpace(currentWriteIndex, static_cast<size_t>(nItems)));
+    T* pData = mData.Get();
+
+    for (auto i = 0; i < n; i++)
+      pData[(currentWriteIndex + i) & mMask] = pItems[i];
+
+    if (n > 0)
+      mWriteIndex.store(currentWriteIndex + n, std::memory_order_release);
+
+    return n;
   }
 
   /** Removes and retrieves an item from the queue
@@ -74,15 +106,34 @@ public:
   bool Pop(T& item)
   {
     const auto currentReadIndex = mReadIndex.load(std::memory_order_relaxed);
-    if(currentReadIndex == mWriteIndex.load(std::memory_order_acquire))
+    if (Available(currentReadIndex, 1) == 0)
     {
       return false; // empty the queue
     }
-    item = mData.Get()[currentReadIndex];
-    mReadIndex.store(Increment(currentReadIndex), std::memory_order_release);
+    item = mData.Get()[currentReadIndex & mMask];
+    mReadIndex.store(currentReadIndex + 1, std::memory_order_release);
     return true;
   }
 
+  /** Removes and retrieves up to maxItems items from the queue, releasing their slots all at once
+   * @param pItems Pointer to storage for at least maxItems items
+   * @param maxItems The maximum number of items to retrieve
+   * @return The number of items retrieved, 0 if the queue is empty */
+  int PopBatch(T* pItems, int maxItems)
+  {
+    const auto currentReadIndex = mReadIndex.load(std::memory_order_relaxed);
+    const auto n = static_cast<int>(Available(currentReadIndex, static_cast<size_t>(maxItems)));
+    const T* pData = mData.Get();
+
+    for (auto i = 0; i < n; i++)
+      pItems[i] = pData[(currentReadIndex + i) & mMask];
+
+    if (n > 0)
+      mReadIndex.store(currentReadIndex + n, std::memory_order_release);
+
+    return n;
+  }
+
   /** Constructs and adds an item to the queue in-place from arguments
    * @param args... Arguments to forward to the item's constructor
    * @return true if the item was successfully added
@@ -91,14 +142,12 @@ public:
   bool PushFromArgs(Args ...args)
   {
     const auto currentWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
-    const auto nextWriteIndex = Increment(currentWriteIndex);
-    if(nextWriteIndex != mReadIndex.load(std::memory_order_acquire))
-    {
-      mData.Get()[currentWriteIndex] = T(args...);
-      mWriteIndex.store(nextWriteIndex, std::memory_order_release);
-      return true;
-    }
-    return false;
+    if (FreeSpace(currentWriteIndex, 1) == 0)
+      return false;
+
+    mData.Get()[currentWriteIndex & mMask] = T(args...);
+    mWriteIndex.store(currentWriteIndex + 1, std::memory_order_release);
+    return true;
   }
   
   /** Returns the number of elements currently in the queue
@@ -108,7 +157,7 @@ public:
     size_t write = mWriteIndex.load(std::memory_order_acquire);
     size_t read = mReadIndex.load(std::memory_order_relaxed);
 
-    return (read > write) ? mData.GetSize() - (read - write) : write - read;
+    return write - read;
   }
 
   /** Returns a const reference to the next item without removing it
@@ -118,7 +167,7 @@ public:
   const T& Peek()
   {
     const auto currentReadIndex = mReadIndex.load(std::memory_order_relaxed);
-    return mData.Get()[currentReadIndex];
+    return mData.Get()[currentReadIndex & mMask];
   }
 
   /** Checks if the queue is currently empty
@@ -134,22 +183,55 @@ public:
    * @return false if the queue has space for more elements */
   bool WasFull() const
   {
-    const auto nextWriteIndex = Increment(mWriteIndex.load());
-    return (nextWriteIndex == mReadIndex.load());
+    return (mWriteIndex.load() - mReadIndex.load() == Capacity());
   }
 
 private:
-  /** Increments an index in the circular buffer, wrapping around when necessary
-   * @param idx The index to increment
-   * @return The incremented index, wrapped to stay within bounds */
-  size_t Increment(size_t idx) const
+  static constexpr size_t kCacheLineSize = 64;
+
+  /** Called on the producer thread. Only reloads the consumer's index if the cached one doesn't leave enough room
+   * @param writeIdx The current write index
+   * @param nWanted The number of slots the caller would like to fill
+   * @return The number of slots that can be filled, at most nWanted */
+  size_t FreeSpace(size_t writeIdx, size_t nWanted)
+  {
+    size_t space = Capacity() - (writeIdx - mCachedReadIndex);
+
+    if (space < nWanted)
+    {
+      mCachedReadIndex = mReadIndex.load(std::memory_order_acquire);
+      space = Capacity() - (writeIdx - mCachedReadIndex);
+    }
+
+    return space < nWanted ? space : nWanted;
+  }
+
+  /** Called on the consumer thread. Only reloads the producer's index if the cached one doesn't have enough elements
+   * @param readIdx The current read index
+   * @param nWanted The number of elements the caller would like to read
+   * @return The number of elements that can be read, at most nWanted */
+  size_t Available(size_t readIdx, size_t nWanted)
   {
-    return (idx + 1) % (mData.GetSize());
+    size_t available = mCachedWriteIndex - readIdx;
+
+    if (available < nWanted)
+    {
+      mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+      available = mCachedWriteIndex - readIdx;
+    }
+
+    return available < nWanted ? available : nWanted;
   }
 
+  // Indices increase monotonically and are masked when accessing mData, so all slots can be used
   WDL_TypedBuf<T> mData;
-  std::atomic<size_t> mWriteIndex{0};
-  std::atomic<size_t> mReadIndex{0};
+  size_t mMask = 0;
+
+  // the producer and consumer state each start a new cache line, avoiding false sharing
+  alignas(kCacheLineSize) std::atomic<size_t> mWriteIndex{0};
+  size_t mCachedReadIndex = 0; // producer's copy of mReadIndex
+  alignas(kCacheLineSize) std::atomic<size_t> mReadIndex{0};
+  size_t mCachedWriteIndex = 0; // consumer's copy of mWriteIndex
 };
 
 END_IPLUG_NAMESPACE
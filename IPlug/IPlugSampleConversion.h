@@ -0,0 +1,135 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * Kernels used by IPlugProcessor to convert, accumulate and zero sample buffers when the host's sample format differs from PLUG_SAMPLE_DST.
+ * Define IPLUG_SIMDE at project level in order to use SSE2 instructions for the float <-> double kernels. On non-x86 targets
+ * include the SIMDE library in your search paths in order to translate the intel intrinsics to e.g. NEON (see LanczosResampler.h).
+ * Define SAMPLE_TYPE_FLOAT (or set the IPLUG2_SAMPLE_TYPE_FLOAT CMake option) to process in single precision, which avoids
+ * the conversion altogether for hosts that supply float buffers.
+ * @ingroup IPlugUtilities
+ */
+
+#include <cstring>
+
+#if defined IPLUG_SIMDE
+  #if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #include <emmintrin.h>
+  #else
+    #define SIMDE_ENABLE_NATIVE_ALIASES
+    #include "simde/x86/sse2.h"
+  #endif
+#endif
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Copies a buffer of samples, converting them to the destination type
+ * @param pDest Ptr to the destination buffer
+ * @param pSrc Ptr to the source buffer
+ * @param n The number of samples */
+template <class SRC, class DEST>
+inline void ConvertSamples(DEST* pDest, const SRC* pSrc, int n)
+{
+  for (int i = 0; i < n; ++i)
+    pDest[i] = static_cast<DEST>(pSrc[i]);
+}
+
+/** Adds a buffer of samples to another, converting them to the destination type
+ * @param pDest Ptr to the destination buffer, which is accumulated into
+ * @param pSrc Ptr to the source buffer
+ * @param n The number of samples */
+template <class SRC, class DEST>
+inline void ConvertAndAccumulateSamples(DEST* pDest, const SRC* pSrc, int n)
+{
+  for (int i = 0; i < n; ++i)
+    pDest[i] += static_cast<DEST>(pSrc[i]);
+}
+
+/** Zeros a buffer of samples. memset is already vectorized by the C runtime
+ * @param pDest Ptr to the buffer
+ * @param n The number of samples */
+template <class T>
+inline void ZeroSamples(T* pDest, int n)
+{
+  memset(pDest, 0, n * sizeof(T));
+}
+
+#if defined IPLUG_SIMDE
+template <>
+inline void ConvertSamples(double* pDest, const float* pSrc, int n)
+{
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m128 f = _mm_loadu_ps(pSrc + i);
+    _mm_storeu_pd(pDest + i, _mm_cvtps_pd(f));
+    _mm_storeu_pd(pDest + i + 2, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+  }
+
+  for (; i < n; ++i)
+    pDest[i] = static_cast<double>(pSrc[i]);
+}
+
+template <>
+inline void ConvertSamples(float* pDest, const double* pSrc, int n)
+{
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(pSrc + i));
+    const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(pSrc + i + 2));
+    _mm_storeu_ps(pDest + i, _mm_movelh_ps(lo, hi));
+  }
+
+  for (; i < n; ++i)
+    pDest[i] = static_cast<float>(pSrc[i]);
+}
+
+template <>
+inline void ConvertAndAccumulateSamples(double* pDest, const float* pSrc, int n)
+{
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m128 f = _mm_loadu_ps(pSrc + i);
+    _mm_storeu_pd(pDest + i, _mm_add_pd(_mm_loadu_pd(pDest + i), _mm_cvtps_pd(f)));
+    _mm_storeu_pd(pDest + i + 2, _mm_add_pd(_mm_loadu_pd(pDest + i + 2), _mm_cvtps_pd(_mm_movehl_ps(f, f))));
+  }
+
+  for (; i < n; ++i)
+    pDest[i] += static_cast<double>(pSrc[i]);
+}
+
+template <>
+inline void ConvertAndAccumulateSamples(float* pDest, const double* pSrc, int n)
+{
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(pSrc + i));
+    const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(pSrc + i + 2));
+    _mm_storeu_ps(pDest + i, _mm_add_ps(_mm_loadu_ps(pDest + i), _mm_movelh_ps(lo, hi)));
+  }
+
+  for (; i < n; ++i)
+    pDest[i] += static_cast<float>(pSrc[i]);
+}
+#endif
+
+END_IPLUG_NAMESPACE
@@ -24,6 +24,10 @@ Timer* Timer::Create(ITimerFunction func, uint32_t intervalMs)
   return new Timer_impl(func, intervalMs);
 }
 
+void Timer::ProcessTimers()
+{
+}
+
 Timer_impl::Timer_impl(ITimerFunction func, uint32_t intervalMs)
 : mTimerFunc(func)
 , mIntervalMs(intervalMs)
@@ -68,6 +72,10 @@ Timer* Timer::Create(ITimerFunction func, uint32_t intervalMs)
   return new Timer_impl(func, intervalMs);
 }
 
+void Timer::ProcessTimers()
+{
+}
+
 WDL_Mutex Timer_impl::sMutex;
 WDL_PtrList<Timer_impl> Timer_impl::sTimers;
 
@@ -122,6 +130,10 @@ Timer* Timer::Create(ITimerFunction func, uint32_t intervalMs)
   return new Timer_impl(func, intervalMs);
 }
 
+void Timer::ProcessTimers()
+{
+}
+
 Timer_impl::Timer_impl(ITimerFunction func, uint32_t intervalMs)
 : mTimerFunc(func)
 {
@@ -143,4 +155,60 @@ void Timer_impl::TimerProc(void* userData)
   Timer_impl* itimer = (Timer_impl*) userData;
   itimer->mTimerFunc(*itimer);
 }
+#elif defined OS_LINUX
+Timer* Timer::Create(ITimerFunction func, uint32_t intervalMs)
+{
+  return new Timer_impl(func, intervalMs);
+}
+
+void Timer::ProcessTimers()
+{
+  Timer_impl::ProcessTimers();
+}
+
+WDL_Mutex Timer_impl::sMutex;
+WDL_PtrList<Timer_impl> Timer_impl::sTimers;
+
+Timer_impl::Timer_impl(ITimerFunction func, uint32_t intervalMs)
+: mTimerFunc(func)
+, mInterval(std::chrono::milliseconds(intervalMs))
+, mNextTick(std::chrono::steady_clock::now() + mInterval)
+{
+  WDL_MutexLock lock(&sMutex);
+  sTimers.Add(this);
+}
+
+Timer_impl::~Timer_impl()
+{
+  Stop();
+}
+
+void Timer_impl::Stop()
+{
+  WDL_MutexLock lock(&sMutex);
+  sTimers.DeletePtr(this);
+}
+
+void Timer_impl::ProcessTimers()
+{
+  WDL_MutexLock lock(&sMutex);
+  const auto now = std::chrono::steady_clock::now();
+
+  for (auto i = 0; i < sTimers.GetSize(); i++)
+  {
+    Timer_impl* pTimer = sTimers.Get(i);
+
+    if (now < pTimer->mNextTick)
+      continue;
+
+    // Skip the ticks that were missed rather than firing them in a burst
+    pTimer->mNextTick = std::max(pTimer->mNextTick + pTimer->mInterval, now);
+    pTimer->mTimerFunc(*pTimer);
+
+    // The function may have stopped or deleted its own timer or others, so carry on after wherever this one is now.
+    // pTimer is only compared, since it may have been deleted
+    const auto idx = sTimers.Find(pTimer);
+    i = idx >= 0 ? idx : i - 1;
+  }
+}
 #endif
@@ -31,6 +31,9 @@
 #include <CoreFoundation/CoreFoundation.h>
 #elif defined OS_WEB
 #include <emscripten/html5.h>
+#elif defined OS_LINUX
+#include <algorithm>
+#include <chrono>
 #endif
 
 BEGIN_IPLUG_NAMESPACE
@@ -45,6 +48,11 @@ struct Timer
   using ITimerFunction = std::function<void(Timer& t)>;
 
   static Timer* Create(ITimerFunction func, uint32_t intervalMs);
+
+  /** Calls the functions of the timers that are due, on the calling thread. Only does anything on Linux, where there is no OS run loop
+   * for the timers to post to, so the run loop of the app or host must call it from the main thread, e.g. via IGraphicsHeadless::RenderFrame() */
+  static void ProcessTimers();
+
   virtual ~Timer() {};
   virtual void Stop() = 0;
 };
@@ -95,6 +103,23 @@ private:
   long ID = 0;
   ITimerFunction mTimerFunc;
 };
+#elif defined OS_LINUX
+/** There is no main run loop to post to on Linux, so the timers are polled by Timer::ProcessTimers(), which the run loop calls */
+class Timer_impl : public Timer
+{
+public:
+  Timer_impl(ITimerFunction func, uint32_t intervalMs);
+  ~Timer_impl();
+  void Stop() override;
+  static void ProcessTimers();
+
+private:
+  static WDL_Mutex sMutex;
+  static WDL_PtrList<Timer_impl> sTimers;
+  ITimerFunction mTimerFunc;
+  std::chrono::steady_clock::duration mInterval;
+  std::chrono::steady_clock::time_point mNextTick;
+};
 #else
   #error NOT IMPLEMENTED
 #endif
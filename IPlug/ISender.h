@@ -21,7 +21,15 @@
 
 #include "IPlugPlatform.h"
 #include "IPlugQueue.h"
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #if defined OS_IOS || defined OS_MAC
 #include <Accelerate/Accelerate.h>
@@ -60,34 +68,116 @@ struct ISenderData
   }
 };
 
-/** ISender is a utility class which can be used to defer data from the realtime audio processing and send it to the GUI for visualization */
+/** Pass as the QUEUE_SIZE of an ISender (or derived sender) to transfer data via an ISenderTripleBuffer rather than a queue.
+ * Use it for large packets such as scope buffers, where the UI only needs the most recent data.
+ * Not for ISpectrumSender, which needs every hop to build its STFT frames */
+static constexpr int kSenderTripleBuffer = 0;
+
+/** A lock-free single producer, single consumer triple buffer. The producer fills its slot in place and publishes it,
+ * the consumer claims the most recently published slot by index. Nothing is copied, and frames that the consumer
+ * has not claimed before the next publish are dropped rather than queued. */
+template <typename T>
+class ISenderTripleBuffer final
+{
+public:
+  ISenderTripleBuffer()
+  : mSlots(3)
+  {
+  }
+
+  ISenderTripleBuffer(const ISenderTripleBuffer&) = delete;
+  ISenderTripleBuffer& operator=(const ISenderTripleBuffer&) = delete;
+
+  /** @return The slot owned by the producer, which can be written in place. Call on the producer thread */
+  T& GetWriteSlot() { return mSlots[mWriteIdx]; }
+
+  /** Hands the write slot to the consumer, and takes back the previously published slot to write into next. Call on the producer thread */
+  void Publish()
+  {
+    const int prev = mShared.exchange(mWriteIdx | kDirtyFlag, std::memory_order_acq_rel);
+    mWriteIdx = prev & kIdxMask;
+
+    if (prev & kDirtyFlag)
+      mNDropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Takes ownership of the most recently published slot. Call on the consumer thread
+   * @return Pointer to the slot, valid until the next call to Claim(), or nullptr if nothing was published since the last claim */
+  T* Claim()
+  {
+    if (!(mShared.load(std::memory_order_relaxed) & kDirtyFlag))
+      return nullptr;
+
+    mReadIdx = mShared.exchange(mReadIdx, std::memory_order_acq_rel) & kIdxMask;
+    return &mSlots[mReadIdx];
+  }
+
+  /** @return The slot last returned by Claim(). Call on the consumer thread */
+  const T& GetReadSlot() const { return mSlots[mReadIdx]; }
+
+  /** @return The number of published slots that were replaced before the consumer claimed them */
+  int GetNDropped() const { return mNDropped.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr int kIdxMask = 3;
+  static constexpr int kDirtyFlag = 4;
+
+  std::vector<T> mSlots;
+  int mWriteIdx = 0;
+  int mReadIdx = 2;
+  std::atomic<int> mShared {1};
+  std::atomic<int> mNDropped {0};
+};
+
+/** ISender is a utility class which can be used to defer data from the realtime audio processing and send it to the GUI for visualization.
+ * If QUEUE_SIZE is kSenderTripleBuffer, data is transferred without copies through an ISenderTripleBuffer and only the latest packet is sent each time TransmitData() is called */
 template <int MAXNC = 1, int QUEUE_SIZE = 64, typename T = float>
 class ISender
 {
 public:
   static constexpr int kUpdateMessage = 0;
+  static constexpr bool kUsesTripleBuffer = QUEUE_SIZE == kSenderTripleBuffer;
+
+  using TSenderData = ISenderData<MAXNC, T>;
+  using TTransport = std::conditional_t<kUsesTripleBuffer, ISenderTripleBuffer<TSenderData>, IPlugQueue<TSenderData>>;
 
   /** Pushes a data element onto the queue. This can be called on the realtime audio thread. */
-  void PushData(const ISenderData<MAXNC, T>& d)
+  void PushData(const TSenderData& d)
   {
-    mQueue.Push(d);
+    if constexpr (kUsesTripleBuffer)
+    {
+      mQueue.GetWriteSlot() = d;
+      mQueue.Publish();
+    }
+    else
+      mQueue.Push(d);
   }
 
   /** This is called on the main thread and can be used to transform the data, e.g. take an FFT. */
-  virtual void PrepareDataForUI(ISenderData<MAXNC, T>& d) { /* NO-OP*/ }
+  virtual void PrepareDataForUI(TSenderData& d) { /* NO-OP*/ }
   
   /** Pops elements off the queue and sends messages to controls.
    *  This must be called on the main thread - typically in MyPlugin::OnIdle() */
   void TransmitData(IEditorDelegate& dlg)
   {
-    while (mQueue.ElementsAvailable())
+    if constexpr (kUsesTripleBuffer)
+    {
+      if (TSenderData* pData = mQueue.Claim())
+      {
+        assert(pData->ctrlTag != kNoTag && "You must supply a control tag");
+        PrepareDataForUI(*pData);
+        dlg.SendControlMsgFromDelegate(pData->ctrlTag, kUpdateMessage, sizeof(TSenderData), (void*) pData);
+      }
+    }
+    else
     {
-      ISenderData<MAXNC, T> d;
-      mQueue.Pop(d);
-      assert(d.ctrlTag != kNoTag && "You must supply a control tag");
-      PrepareDataForUI(d);
-      dlg.SendControlMsgFromDelegate(d.ctrlTag, kUpdateMessage, sizeof(ISenderData<MAXNC, T>), (void*) &d);
-      mLastData = d;
+      // pop straight into mLastData, packets can be large so avoid an extra copy per packet
+      while (mQueue.Pop(mLastData))
+      {
+        assert(mLastData.ctrlTag != kNoTag && "You must supply a control tag");
+        PrepareDataForUI(mLastData);
+        dlg.SendControlMsgFromDelegate(mLastData.ctrlTag, kUpdateMessage, sizeof(TSenderData), (void*) &mLastData);
+      }
     }
   }
   
@@ -96,24 +186,51 @@ public:
    @param ctrlTags A list of control tags that should receive the updates from this sender */
   void TransmitDataToControlsWithTags(IEditorDelegate& dlg, const std::initializer_list<int>& ctrlTags)
   {
-    while(mQueue.ElementsAvailable())
+    if constexpr (kUsesTripleBuffer)
     {
-      ISenderData<MAXNC, T> d;
-      mQueue.Pop(d);
-      
-      for (auto tag : ctrlTags)
+      if (TSenderData* pData = mQueue.Claim())
       {
-        d.ctrlTag = tag;
-        dlg.SendControlMsgFromDelegate(tag, kUpdateMessage, sizeof(ISenderData<MAXNC, T>), (void*) &d);
+        for (auto tag : ctrlTags)
+        {
+          pData->ctrlTag = tag;
+          dlg.SendControlMsgFromDelegate(tag, kUpdateMessage, sizeof(TSenderData), (void*) pData);
+        }
+      }
+    }
+    else
+    {
+      TSenderData d;
+
+      while (mQueue.Pop(d))
+      {
+        for (auto tag : ctrlTags)
+        {
+          d.ctrlTag = tag;
+          dlg.SendControlMsgFromDelegate(tag, kUpdateMessage, sizeof(TSenderData), (void*) &d);
+        }
       }
     }
   }
 
   /** Gets the last data item sent to the UI  */
-  ISenderData<MAXNC, T> GetLastData() { return mLastData; }
+  TSenderData GetLastData()
+  {
+    if constexpr (kUsesTripleBuffer)
+      return mQueue.GetReadSlot();
+    else
+      return mLastData;
+  }
   
 protected:
-  IPlugQueue<ISenderData<MAXNC, T>> mQueue {QUEUE_SIZE};
+  static TTransport MakeTransport()
+  {
+    if constexpr (kUsesTripleBuffer)
+      return TTransport();
+    else
+      return TTransport(QUEUE_SIZE);
+  }
+
+  TTransport mQueue = MakeTransport();
   ISenderData<MAXNC, T> mLastData;
 };
 
@@ -468,20 +585,27 @@ public:
 
         if (sum > mThreshold || mPreviousSum > mThreshold)
         {
-          mBuffer.ctrlTag = ctrlTag;
-          mBuffer.nChans = nChans;
-          mBuffer.chanOffset = chanOffset;
-          TSender::PushData(mBuffer);
+          ISenderData<MAXNC, TDataPacket>& buffer = GetBuffer();
+          buffer.ctrlTag = ctrlTag;
+          buffer.nChans = nChans;
+          buffer.chanOffset = chanOffset;
+
+          if constexpr (TSender::kUsesTripleBuffer)
+            TSender::mQueue.Publish(); // the buffer was filled in place
+          else
+            TSender::PushData(buffer);
         }
 
         mPreviousSum = sum;
         mBufCount = 0;
       }
       
+      ISenderData<MAXNC, TDataPacket>& buffer = GetBuffer();
+
       for (auto c = chanOffset; c < (chanOffset + nChans); c++)
       {
         const float inputSample = static_cast<float>(inputs[c][s]);
-        mBuffer.vals[c][mBufCount] = inputSample;
+        buffer.vals[c][mBufCount] = inputSample;
         mRunningSum[c] += std::fabs(inputSample);
       }
 
@@ -501,6 +625,15 @@ public:
   int GetBufferSize() const { return mBufferSize; }
   
 private:
+  /** With a triple buffer, samples are written directly into the producer's slot */
+  ISenderData<MAXNC, TDataPacket>& GetBuffer()
+  {
+    if constexpr (TSender::kUsesTripleBuffer)
+      return TSender::mQueue.GetWriteSlot();
+    else
+      return mBuffer;
+  }
+
   ISenderData<MAXNC, TDataPacket> mBuffer;
   int mBufCount = 0;
   int mBufferSize = MAXBUF;
@@ -509,13 +642,23 @@ private:
   float mThreshold = 0.01f;
 };
 
-/** ISpectrumSender is designed for sending Spectral Data from the plug-in to the UI */
+/** ISpectrumSender is designed for sending Spectral Data from the plug-in to the UI.
+ * By default the STFT is computed on the main thread in TransmitData(). Call SetAnalysisThread() to compute it on a dedicated worker thread instead,
+ * in which case TransmitData() only sends the most recent finished frame. SetNumOutputPoints() reduces each frame to log-spaced bands,
+ * so that the UI receives as many points as it can display. */
 template <int MAXNC = 1, int QUEUE_SIZE = 64, int MAX_FFT_SIZE = 4096>
 class ISpectrumSender : public IBufferSender<MAXNC, QUEUE_SIZE, MAX_FFT_SIZE>
 {
+  // each STFT frame is built from consecutive hops, so a transport that drops hops would give wrong spectra
+  static_assert(QUEUE_SIZE != kSenderTripleBuffer, "ISpectrumSender needs a queue, use SetAnalysisThread() to send only the latest frame");
+
 public:
   using TDataPacket = std::array<float, MAX_FFT_SIZE>;
   using TBufferSender = IBufferSender<MAXNC, QUEUE_SIZE, MAX_FFT_SIZE>;
+  using TSenderData = ISenderData<MAXNC, TDataPacket>;
+
+  /** ProcessBlock() wakes the analysis thread without taking its mutex, so a wakeup can be missed. This bounds the resulting delay */
+  static constexpr int kAnalysisWakeTimeoutMs = 20;
   
   enum class EWindowType {
     Hann = 0,
@@ -539,6 +682,115 @@ public:
     SetFFTSizeAndOverlap(fftSize, overlap);
   }
 
+  ~ISpectrumSender()
+  {
+    SetAnalysisThread(false);
+  }
+
+  /** Starts or stops the analysis worker thread. Call on the main thread
+   * @param enable If \c true the STFT is computed on a worker thread rather than in TransmitData() */
+  void SetAnalysisThread(bool enable)
+  {
+    if (enable == mAnalysisThread.joinable())
+      return;
+
+    if (enable)
+    {
+      mAnalysisRunning = true;
+      mAnalysisThread = std::thread(&ISpectrumSender::AnalysisLoop, this);
+      mNotifyAnalysis.store(true, std::memory_order_release);
+    }
+    else
+    {
+      mNotifyAnalysis.store(false, std::memory_order_release);
+
+      {
+        std::lock_guard<std::mutex> lock(mAnalysisMutex);
+        mAnalysisRunning = false;
+      }
+
+      mAnalysisCV.notify_one();
+      mAnalysisThread.join();
+    }
+  }
+
+  /** @return \c true if the STFT is computed on the analysis worker thread */
+  bool GetAnalysisThread() const { return mAnalysisThread.joinable(); }
+
+  /** As IBufferSender::ProcessBlock(), and wakes the analysis thread if hops are waiting. This can be called on the realtime audio thread */
+  void ProcessBlock(sample** inputs, int nFrames, int ctrlTag = kNoTag, int nChans = MAXNC, int chanOffset = 0)
+  {
+    TBufferSender::ProcessBlock(inputs, nFrames, ctrlTag, nChans, chanOffset);
+
+    // notify without the mutex, which the analysis thread holds while it transforms a hop
+    if (mNotifyAnalysis.load(std::memory_order_acquire) && this->mQueue.ElementsAvailable())
+      mAnalysisCV.notify_one();
+  }
+
+  /** Pops elements off the queue and sends messages to controls. When the analysis thread is running,
+   * only the most recent finished frame is sent. This must be called on the main thread - typically in MyPlugin::OnIdle() */
+  void TransmitData(IEditorDelegate& dlg)
+  {
+    if (GetAnalysisThread())
+    {
+      if (TSenderData* pData = mResults.Claim())
+      {
+        assert(pData->ctrlTag != kNoTag && "You must supply a control tag");
+        dlg.SendControlMsgFromDelegate(pData->ctrlTag, TBufferSender::kUpdateMessage, sizeof(TSenderData), (void*) pData);
+      }
+    }
+    else
+    {
+      TBufferSender::TransmitData(dlg);
+    }
+  }
+
+  /** As TransmitData(), but sending to several controls, see ISender::TransmitDataToControlsWithTags() */
+  void TransmitDataToControlsWithTags(IEditorDelegate& dlg, const std::initializer_list<int>& ctrlTags)
+  {
+    if (GetAnalysisThread())
+    {
+      if (TSenderData* pData = mResults.Claim())
+      {
+        for (auto tag : ctrlTags)
+        {
+          pData->ctrlTag = tag;
+          dlg.SendControlMsgFromDelegate(tag, TBufferSender::kUpdateMessage, sizeof(TSenderData), (void*) pData);
+        }
+      }
+    }
+    else
+    {
+      TBufferSender::TransmitDataToControlsWithTags(dlg, ctrlTags);
+    }
+  }
+
+  /** Reduce each magnitude frame to a number of log-spaced bands, between the first bin and nyquist.
+   * Each band holds the peak magnitude of the bins it spans, or the interpolated magnitude where a band is narrower than a bin.
+   * Only the first nPoints values of each channel are then valid, and phases are not sent. Only applies to EOutputType::MagPhase
+   * @param nPoints The number of bands, typically the pixel width of the display. 0 sends all bins */
+  void SetNumOutputPoints(int nPoints)
+  {
+    std::lock_guard<std::mutex> lock(mAnalysisMutex);
+    mNumOutputPoints = std::min(nPoints, MAX_FFT_SIZE);
+    CalculateBandEdges();
+  }
+
+  int GetNumOutputPoints() const
+  {
+    return mNumOutputPoints;
+  }
+
+  /** @return The bin position (which may be fractional) at the centre of a band, when the output is reduced with SetNumOutputPoints()
+   * @param fftSize The FFT size
+   * @param nPoints The number of bands
+   * @param pointIdx The index of the band */
+  static float GetBandCenterBin(int fftSize, int nPoints, int pointIdx)
+  {
+    const float lastBin = static_cast<float>(fftSize / 2 - 1);
+    return nPoints > 1 ? std::pow(lastBin, static_cast<float>(pointIdx) / static_cast<float>(nPoints - 1)) : 1.0f;
+  }
+
   void SetFFTSize(int fftSize)
   {
     SetFFTSizeAndOverlap(fftSize, mOverlap);
@@ -546,6 +798,7 @@ public:
 
   void SetFFTSizeAndOverlap(int fftSize, int overlap)
   {
+    std::lock_guard<std::mutex> lock(mAnalysisMutex);
     mFFTSize = fftSize;
     mOverlap = overlap;
     int hopSize = fftSize / overlap;
@@ -553,16 +806,19 @@ public:
     InitSTFTFrames();
     CalculateWindow();
     CalculateScalingFactors();
+    CalculateBandEdges();
   }
   
   void SetWindowType(EWindowType windowType)
   {
+    std::lock_guard<std::mutex> lock(mAnalysisMutex);
     mWindowType = windowType;
     CalculateWindow();
   }
   
   void SetOutputType(EOutputType outputType)
   {
+    std::lock_guard<std::mutex> lock(mAnalysisMutex);
     mOutputType = outputType;
   }
   
@@ -592,7 +848,11 @@ public:
           for (auto ch = 0; ch < MAXNC; ch++)
           {
             Permute(ch, stftFrameIdx);
-            memcpy(d.vals[ch].data(), mSTFTOutput[ch].data(), mFFTSize * sizeof(float));
+
+            if (mNumOutputPoints > 0 && mOutputType == EOutputType::MagPhase)
+              ReduceToBands(mSTFTOutput[ch].data(), d.vals[ch].data());
+            else
+              memcpy(d.vals[ch].data(), mSTFTOutput[ch].data(), mFFTSize * sizeof(float));
           }
         }
       }
@@ -620,6 +880,57 @@ public:
   }
 
 private:
+  void AnalysisLoop()
+  {
+    std::unique_lock<std::mutex> lock(mAnalysisMutex);
+
+    while (mAnalysisRunning)
+    {
+      // every hop is popped in order, since each STFT frame spans several of them.
+      // Hops are popped straight into the result slot and transformed in place
+      while (this->mQueue.Pop(mResults.GetWriteSlot()))
+      {
+        PrepareDataForUI(mResults.GetWriteSlot());
+        mResults.Publish();
+      }
+
+      mAnalysisCV.wait_for(lock, std::chrono::milliseconds(kAnalysisWakeTimeoutMs), [&]() { return !mAnalysisRunning || this->mQueue.ElementsAvailable(); });
+    }
+  }
+
+  void CalculateBandEdges()
+  {
+    const int nBins = mFFTSize / 2;
+
+    for (auto i = 0; i <= mNumOutputPoints; i++)
+    {
+      // geometric midpoints between band centres
+      const float edge = GetBandCenterBin(mFFTSize, mNumOutputPoints, i) / std::sqrt(GetBandCenterBin(mFFTSize, mNumOutputPoints, 1));
+      mBandEdges[i] = std::min(static_cast<int>(std::ceil(edge)), nBins);
+    }
+  }
+
+  void ReduceToBands(const float* pMagnitudes, float* pOutput) const
+  {
+    for (auto i = 0; i < mNumOutputPoints; i++)
+    {
+      const int lo = mBandEdges[i];
+      const int hi = mBandEdges[i + 1];
+
+      if (hi > lo)
+      {
+        pOutput[i] = *std::max_element(pMagnitudes + lo, pMagnitudes + hi);
+      }
+      else // narrower than a bin
+      {
+        const float pos = GetBandCenterBin(mFFTSize, mNumOutputPoints, i);
+        const int bin = std::min(static_cast<int>(pos), mFFTSize / 2 - 2);
+        const float frac = pos - static_cast<float>(bin);
+        pOutput[i] = pMagnitudes[bin] + frac * (pMagnitudes[bin + 1] - pMagnitudes[bin]);
+      }
+    }
+  }
+
   void InitSTFTFrames()
   {
     if (mSTFTFrames.size() != mOverlap)
@@ -738,6 +1049,14 @@ private:
   std::vector<STFTFrame> mSTFTFrames;
   std::array<std::array<float, MAX_FFT_SIZE>, MAXNC> mSTFTOutput;
   float mScalingFactor = 0.0f;
+  int mNumOutputPoints = 0;
+  std::array<int, MAX_FFT_SIZE + 1> mBandEdges;
+  ISenderTripleBuffer<TSenderData> mResults;
+  std::thread mAnalysisThread;
+  std::mutex mAnalysisMutex;
+  std::condition_variable mAnalysisCV;
+  bool mAnalysisRunning = false;
+  std::atomic<bool> mNotifyAnalysis {false};
 };
 
 END_IPLUG_NAMESPACE
@@ -416,6 +416,7 @@ VstIntPtr VSTCALLBACK IPlugVST2::VSTDispatcher(AEffect *pEffect, VstInt32 opCode
           IParam* pParam = _this->GetParam(idx);
           const double v = pParam->StringToValue((const char *)ptr);
           pParam->Set(v);
+          INVALIDATE_PARAM_SNAPSHOT_STATIC(idx)
           _this->SendParameterValueFromAPI(idx, v, false);
           _this->OnParamChange(idx, kHost);
           LEAVE_PARAMS_MUTEX_STATIC
@@ -986,6 +987,7 @@ void VSTCALLBACK IPlugVST2::VSTProcess(AEffect* pEffect, float** inputs, float**
   TRACE
   IPlugVST2* _this = (IPlugVST2*) pEffect->object;
   _this->VSTPreProcess(inputs, outputs, nFrames);
+  APPLY_PARAMS_SNAPSHOT_STATIC
   ENTER_PARAMS_MUTEX_STATIC
   _this->ProcessBuffersAccumulating(nFrames);
   LEAVE_PARAMS_MUTEX_STATIC
@@ -997,6 +999,7 @@ void VSTCALLBACK IPlugVST2::VSTProcessReplacing(AEffect* pEffect, float** inputs
   TRACE
   IPlugVST2* _this = (IPlugVST2*) pEffect->object;
   _this->VSTPreProcess(inputs, outputs, nFrames);
+  APPLY_PARAMS_SNAPSHOT_STATIC
   ENTER_PARAMS_MUTEX_STATIC
   _this->ProcessBuffers((float) 0.0f, nFrames);
   LEAVE_PARAMS_MUTEX_STATIC
@@ -1008,6 +1011,7 @@ void VSTCALLBACK IPlugVST2::VSTProcessDoubleReplacing(AEffect* pEffect, double**
   TRACE
   IPlugVST2* _this = (IPlugVST2*) pEffect->object;
   _this->VSTPreProcess(inputs, outputs, nFrames);
+  APPLY_PARAMS_SNAPSHOT_STATIC
   ENTER_PARAMS_MUTEX_STATIC
   _this->ProcessBuffers((double) 0.0, nFrames);
   LEAVE_PARAMS_MUTEX_STATIC
@@ -1037,6 +1041,7 @@ void VSTCALLBACK IPlugVST2::VSTSetParameter(AEffect *pEffect, VstInt32 idx, floa
   {
     ENTER_PARAMS_MUTEX_STATIC
     _this->GetParam(idx)->SetNormalized(value);
+    INVALIDATE_PARAM_SNAPSHOT_STATIC(idx)
     _this->SendParameterValueFromAPI(idx, value, true);
     _this->OnParamChange(idx, kHost);
     LEAVE_PARAMS_MUTEX_STATIC
@@ -103,6 +103,8 @@ tresult PLUGIN_API IPlugVST3::process(ProcessData& data)
 {
   TRACE
 
+  // apply any state recalled on other threads first, so that this block's automation takes precedence
+  APPLY_PARAMS_SNAPSHOT
   Process(data, processSetup, audioInputs, audioOutputs, mMidiMsgsFromEditor, mMidiMsgsFromProcessor, mSysExDataFromEditor, mSysexBuf);
   return kResultOk;
 }
@@ -222,6 +222,9 @@ public:
       if (pParam)
       {
         pParam->SetNormalized(value);
+#ifdef PARAMS_SNAPSHOT
+        pPlug->InvalidateParamSnapshotValue(tag);
+#endif
         pPlug->OnParamChangeUI(tag, kHost);
         pPlug->SendParameterValueFromDelegate(tag, value, true);
       }
@@ -274,6 +274,10 @@ void IPlugVST3ProcessorBase::PrepareProcessContext(ProcessData& data, ProcessSet
 void IPlugVST3ProcessorBase::ProcessParameterChanges(ProcessData& data, IPlugQueue<IMidiMsg>& fromProcessor)
 {
   IParameterChanges* paramChanges = data.inputParameterChanges;
+  IParamAutomation& automation = mPlug.mParamAutomation;
+
+  if (automation.IsEnabled())
+    automation.Clear();
   
   if (paramChanges)
   {
@@ -288,6 +292,22 @@ void IPlugVST3ProcessorBase::ProcessParameterChanges(ProcessData& data, IPlugQue
         int32 offsetSamples;
         double value;
         
+        if (automation.IsEnabled())
+        {
+          int idx = paramQueue->getParameterId();
+          
+          if (idx >= 0 && idx < mPlug.NParams())
+          {
+            const double previousValue = mPlug.GetParam(idx)->GetNormalized();
+            
+            for (int32 p = 0; p < numPoints; p++)
+            {
+              if (paramQueue->getPoint(p, offsetSamples, value) == kResultTrue)
+                automation.Add(idx, offsetSamples, value, previousValue);
+            }
+          }
+        }
+        
         if (paramQueue->getPoint(numPoints - 1,  offsetSamples, value) == kResultTrue)
         {
           int idx = paramQueue->getParameterId();
@@ -311,6 +331,9 @@ void IPlugVST3ProcessorBase::ProcessParameterChanges(ProcessData& data, IPlugQue
                 mPlug.mParams_mutex.Enter();
 #endif
                 mPlug.GetParam(idx)->SetNormalized(value);
+#ifdef PARAMS_SNAPSHOT
+                mPlug.InvalidateParamSnapshotValue(idx);
+#endif
               
                 // In VST3 non distributed the same parameter value is also set via IPlugVST3Controller::setParamNormalized(ParamID tag, ParamValue value)
                 mPlug.OnParamChange(idx, kHost, offsetSamples);
@@ -343,6 +366,9 @@ void IPlugVST3ProcessorBase::ProcessParameterChanges(ProcessData& data, IPlugQue
       }
     }
   }
+  
+  if (automation.IsEnabled())
+    automation.Finalize(true);
 }
 
 void IPlugVST3ProcessorBase::ProcessAudio(ProcessData& data, ProcessSetup& setup, const BusList& ins, const BusList& outs)
@@ -439,6 +465,5 @@ void IPlugVST3ProcessorBase::Process(ProcessData& data, ProcessSetup& setup, con
 
 bool IPlugVST3ProcessorBase::SendMidiMsg(const IMidiMsg& msg)
 {
-  mMidiOutputQueue.Add(msg);
-  return true;
+  return mMidiOutputQueue.Add(msg);
 }
@@ -66,6 +66,7 @@ void IPlugWAM::onProcess(WAM::AudioBus* pAudio, void* pData)
   AttachBuffers(ERoute::kInput, 0, NChannelsConnected(ERoute::kInput), pAudio->inputs, blockSize);
   AttachBuffers(ERoute::kOutput, 0, NChannelsConnected(ERoute::kOutput), pAudio->outputs, blockSize);
   
+  APPLY_PARAMS_SNAPSHOT
   ENTER_PARAMS_MUTEX
   ProcessBuffers((float) 0.0f, blockSize);
   LEAVE_PARAMS_MUTEX
@@ -73,18 +74,17 @@ void IPlugWAM::onProcess(WAM::AudioBus* pAudio, void* pData)
 
 void IPlugWAM::OnEditorIdleTick()
 {
-  while(mParamChangeFromProcessor.ElementsAvailable())
-  {
-    ParamTuple p;
-    mParamChangeFromProcessor.Pop(p);
-    SendParameterValueFromDelegate(p.idx, p.value, false);
-  }
+  mParamChangeFromProcessor.Drain([this](int paramIdx, double value) {
+    SendParameterValueFromDelegate(paramIdx, value, false);
+  });
+
+  IMidiMsg msgs[QUEUE_BATCH_SIZE];
+  int nMsgs;
 
-  while (mMidiMsgsFromProcessor.ElementsAvailable())
+  while ((nMsgs = mMidiMsgsFromProcessor.PopBatch(msgs, QUEUE_BATCH_SIZE)) > 0)
   {
-    IMidiMsg msg;
-    mMidiMsgsFromProcessor.Pop(msg);
-    SendMidiMsgFromDelegate(msg);
+    for (auto i = 0; i < nMsgs; i++)
+      SendMidiMsgFromDelegate(msgs[i]);
   }
 
   OnIdle();
@@ -84,6 +84,7 @@ void IPlugWasmDSP::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
   // thread from the main thread, but parameter messages arrive via postMessage
   // which is serialized, so the mutex primarily guards against concurrent
   // parameter changes from within ProcessBuffers itself (e.g., meta-parameters).
+  APPLY_PARAMS_SNAPSHOT
   ENTER_PARAMS_MUTEX
   ProcessBuffers(0.0f, nFrames);
   LEAVE_PARAMS_MUTEX
@@ -92,19 +93,18 @@ void IPlugWasmDSP::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
 void IPlugWasmDSP::OnIdleTick()
 {
   // Flush queued parameter changes from DSP to UI
-  while (mParamChangeFromProcessor.ElementsAvailable())
-  {
-    ParamTuple p;
-    mParamChangeFromProcessor.Pop(p);
-    SendParameterValueFromDelegate(p.idx, p.value, false);
-  }
+  mParamChangeFromProcessor.Drain([this](int paramIdx, double value) {
+    SendParameterValueFromDelegate(paramIdx, value, false);
+  });
 
   // Flush queued MIDI messages from DSP to UI
-  while (mMidiMsgsFromProcessor.ElementsAvailable())
+  IMidiMsg msgs[QUEUE_BATCH_SIZE];
+  int nMsgs;
+
+  while ((nMsgs = mMidiMsgsFromProcessor.PopBatch(msgs, QUEUE_BATCH_SIZE)) > 0)
   {
-    IMidiMsg msg;
-    mMidiMsgsFromProcessor.Pop(msg);
-    SendMidiMsgFromDelegate(msg);
+    for (auto i = 0; i < nMsgs; i++)
+      SendMidiMsgFromDelegate(msgs[i]);
   }
 
   OnIdle();
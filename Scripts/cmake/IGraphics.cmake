@@ -43,7 +43,7 @@ if(NOT TARGET iPlug2::IGraphics)
       ${IGRAPHICS_DIR}/Platforms/IGraphicsCoreText.mm
     )
   elseif(UNIX AND NOT APPLE)
-    message("Error - Linux not yet supported")
+    # There is no windowed platform for Linux yet, only the headless one (see iPlug2::IGraphics::Lice)
   endif()
 
   target_sources(iPlug2::IGraphics INTERFACE ${IGRAPHICS_SRC})
@@ -79,8 +79,6 @@ if(NOT TARGET iPlug2::IGraphics)
       "-framework Accelerate"
       "-framework QuartzCore"
     )
-  elseif(UNIX AND NOT APPLE)
-    message("Error - Linux not yet supported")
   endif()
 
   target_link_libraries(iPlug2::IGraphics INTERFACE iPlug2::IPlug)
@@ -389,6 +387,50 @@ if(NOT TARGET iPlug2::IGraphics::Skia::CPU)
   )
 endif()
 
+# LICE drawing backend (CPU only) with the headless platform, which renders offscreen
+# for screenshots, visual tests and draw benchmarks
+if(NOT TARGET iPlug2::IGraphics::Lice)
+  add_library(iPlug2::IGraphics::Lice INTERFACE IMPORTED)
+
+  set(LICE_SRC
+    ${IGRAPHICS_DIR}/Drawing/IGraphicsLice.cpp
+    ${IGRAPHICS_DIR}/Platforms/IGraphicsHeadless.cpp
+    ${WDL_DIR}/lice/lice.cpp
+    ${WDL_DIR}/lice/lice_png.cpp
+    ${WDL_DIR}/lice/lice_jpg.cpp
+  )
+
+  foreach(file png pngerror pngget pngmem pngpread pngread pngrio pngrtran pngrutil pngset pngtrans)
+    list(APPEND LICE_SRC ${WDL_DIR}/libpng/${file}.c)
+  endforeach()
+
+  foreach(file adler32 compress crc32 deflate infback inffast inflate inftrees trees uncompr zutil)
+    list(APPEND LICE_SRC ${WDL_DIR}/zlib/${file}.c)
+  endforeach()
+
+  file(GLOB JPEGLIB_SRC ${WDL_DIR}/jpeglib/j*.c)
+  list(APPEND LICE_SRC ${JPEGLIB_SRC})
+
+  target_sources(iPlug2::IGraphics::Lice INTERFACE ${LICE_SRC})
+
+  # stb_truetype.h is shared with NanoVG
+  target_include_directories(iPlug2::IGraphics::Lice INTERFACE
+    ${IGRAPHICS_DEPS_DIR}/NanoVG/src
+  )
+
+  target_compile_definitions(iPlug2::IGraphics::Lice INTERFACE
+    IGRAPHICS_LICE
+    IGRAPHICS_HEADLESS
+  )
+
+  if(NOT WIN32)
+    # LICE_SysBitmap needs SWELL on macOS and Linux, and is not used
+    target_compile_definitions(iPlug2::IGraphics::Lice INTERFACE _LICE_NO_SYSBITMAPS_)
+  endif()
+
+  target_link_libraries(iPlug2::IGraphics::Lice INTERFACE iPlug2::IGraphics)
+endif()
+
 # =============================================================================
 # IGraphics Extras - Optional modules
 # =============================================================================
@@ -454,15 +496,16 @@ endif()
 # These can be overridden by setting IGRAPHICS_BACKEND and/or IGRAPHICS_RENDERER
 # BEFORE including iPlug2.cmake or calling find_package(iPlug2)
 
-# Backend selection (NANOVG or SKIA)
+# Backend selection (NANOVG, SKIA or LICE)
 if(NOT DEFINED IGRAPHICS_BACKEND)
   set(IGRAPHICS_BACKEND "NANOVG" CACHE STRING "IGraphics drawing backend")
-  set_property(CACHE IGRAPHICS_BACKEND PROPERTY STRINGS "NANOVG" "SKIA")
+  set_property(CACHE IGRAPHICS_BACKEND PROPERTY STRINGS "NANOVG" "SKIA" "LICE")
 endif()
 
 # Renderer selection with platform-aware defaults
 # NANOVG supports: GL2, GL3, METAL (Metal is macOS/iOS only)
 # SKIA supports: GL3, METAL, CPU
+# LICE is always CPU and headless, the renderer is ignored
 if(NOT DEFINED IGRAPHICS_RENDERER)
   if(WIN32)
     set(DEFAULT_RENDERER "GL2")
@@ -477,7 +520,9 @@ endif()
 
 # Construct IGRAPHICS_LIB target based on selections
 if(NOT DEFINED IGRAPHICS_LIB)
-  if(IGRAPHICS_BACKEND STREQUAL "SKIA")
+  if(IGRAPHICS_BACKEND STREQUAL "LICE")
+    set(IGRAPHICS_LIB iPlug2::IGraphics::Lice)
+  elseif(IGRAPHICS_BACKEND STREQUAL "SKIA")
     if(IGRAPHICS_RENDERER STREQUAL "CPU")
       set(IGRAPHICS_LIB iPlug2::IGraphics::Skia::CPU)
     elseif(IGRAPHICS_RENDERER STREQUAL "GL3")
@@ -16,6 +16,9 @@ endif()
 # Option to disable deprecation warnings (useful for CI)
 option(IPLUG2_DISABLE_DEPRECATION_WARNINGS "Disable deprecation warnings" ON)
 
+# Option to process in single precision, skipping sample format conversion for hosts that supply float buffers
+option(IPLUG2_SAMPLE_TYPE_FLOAT "Use float as the plug-in sample type (SAMPLE_TYPE_FLOAT)" OFF)
+
 if(NOT TARGET iPlug2::IPlug)
   add_library(iPlug2::IPlug INTERFACE IMPORTED)
 
@@ -31,6 +34,9 @@ if(NOT TARGET iPlug2::IPlug)
     ${IPLUG_DIR}/IPlugEditorDelegate.h
     ${IPLUG_DIR}/IPlugLogger.h
     ${IPLUG_DIR}/IPlugMidi.h
+    ${IPLUG_DIR}/IPlugParamAutomation.h
+    ${IPLUG_DIR}/IPlugParamChangeQueue.h
+    ${IPLUG_DIR}/IPlugParamSnapshot.h
     ${IPLUG_DIR}/IPlugParameter.h
     ${IPLUG_DIR}/IPlugParameter.cpp
     ${IPLUG_DIR}/IPlugPaths.h
@@ -41,6 +47,7 @@ if(NOT TARGET iPlug2::IPlug)
     ${IPLUG_DIR}/IPlugProcessor.h
     ${IPLUG_DIR}/IPlugProcessor.cpp
     ${IPLUG_DIR}/IPlugQueue.h
+    ${IPLUG_DIR}/IPlugSampleConversion.h
     ${IPLUG_DIR}/IPlugStructs.h
     ${IPLUG_DIR}/IPlugTimer.h
     ${IPLUG_DIR}/IPlugTimer.cpp
@@ -70,6 +77,10 @@ if(NOT TARGET iPlug2::IPlug)
     $<$<CONFIG:Debug>:DEBUG>
     $<$<CONFIG:Debug>:_DEBUG>
   )
+
+  if(IPLUG2_SAMPLE_TYPE_FLOAT)
+    target_compile_definitions(iPlug2::IPlug INTERFACE SAMPLE_TYPE_FLOAT)
+  endif()
   
   if(MSVC)
     target_compile_definitions(iPlug2::IPlug INTERFACE
@@ -113,7 +124,9 @@ if(NOT TARGET iPlug2::IPlug)
       "-framework Foundation"
     )
   elseif(UNIX AND NOT APPLE)
-    message("Error - Linux not yet supported")
+    # Only headless targets build on Linux so far, WDL_Mutex needs pthreads
+    find_package(Threads REQUIRED)
+    target_link_libraries(iPlug2::IPlug INTERFACE Threads::Threads)
   endif()
 
   # Generate PkgInfo file for macOS bundles (used by VST2, CLAP, etc.)
@@ -0,0 +1,173 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Checks IDataDecimator against a direct search of each pixel column, including data with NaNs, which must not read out of bounds.
+// Build it with -fsanitize=address to catch that, and with and without IPLUG_SIMDE to check both min/max searches.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "IGraphicsDataDecimator.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+static int sFailures = 0;
+
+#define CHECK(cond, ...) \
+  if (!(cond)) { fprintf(stderr, "FAILED %s:%i: ", __FILE__, __LINE__); fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); sFailures++; }
+
+/** Checks that every kept point is one of the input points, in order, and that each column keeps its smallest and largest values, ignoring NaNs */
+static void CheckDecimation(const char* name, const std::vector<float>& y, int nColumns)
+{
+  IDataDecimator decimator;
+  const int nPoints = static_cast<int>(y.size());
+  const int nKept = decimator.Process(y.data(), nullptr, nPoints, nColumns);
+
+  CHECK(nKept > 0 && nKept <= IDataDecimator::kPointsPerColumn * nColumns + 2, "%s: %i points kept", name, nKept);
+
+  if (nKept <= 0)
+    return;
+
+  const float* pX = decimator.GetX();
+  const float* pY = decimator.GetY();
+  std::vector<int> indices;
+  int prevIdx = -1;
+
+  auto column = [&](int idx) { return std::min(static_cast<int>(static_cast<int64_t>(idx) * nColumns / (nPoints - 1)), nColumns - 1); };
+
+  for (int k = 0; k < nKept; k++)
+  {
+    const int idx = static_cast<int>(std::lround(pX[k] * (nPoints - 1)));
+
+    CHECK(idx > prevIdx && idx < nPoints, "%s: point %i is at index %i after %i", name, k, idx, prevIdx);
+
+    if (idx <= prevIdx || idx >= nPoints)
+      return;
+
+    CHECK(std::isnan(y[idx]) ? std::isnan(pY[k]) : pY[k] == y[idx], "%s: point %i does not match the input", name, k);
+    indices.push_back(idx);
+    prevIdx = idx;
+  }
+
+  CHECK(pX[0] == 0.f && pX[nKept - 1] == 1.f, "%s: the first and last points are not kept", name);
+
+  // The extremes of each column, found directly
+  for (int c = 0; c < nColumns; c++)
+  {
+    float min = std::numeric_limits<float>::infinity(), max = -min;
+    float keptMin = min, keptMax = max;
+
+    for (int i = 0; i < nPoints; i++)
+    {
+      if (column(i) == c && !std::isnan(y[i]))
+      {
+        min = std::min(min, y[i]);
+        max = std::max(max, y[i]);
+      }
+    }
+
+    for (int idx : indices)
+    {
+      if (column(idx) == c && !std::isnan(y[idx]))
+      {
+        keptMin = std::min(keptMin, y[idx]);
+        keptMax = std::max(keptMax, y[idx]);
+      }
+    }
+
+    CHECK(min == keptMin && max == keptMax, "%s: column %i keeps %g to %g instead of %g to %g", name, c, keptMin, keptMax, min, max);
+  }
+}
+
+int main()
+{
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> random(0.f, 1.f);
+
+  // All NaN, which used to read normYPoints[-1]
+  CheckDecimation("all NaN", std::vector<float>(1000, nan), 100);
+
+  // NaNs at the start of columns, where the SIMD search starts, and scattered through them
+  for (int every : {2, 7, 10, 33})
+  {
+    std::vector<float> y(10000);
+
+    for (size_t i = 0; i < y.size(); i++)
+      y[i] = (i % every == 0) ? nan : random(generator);
+
+    char name[32];
+    snprintf(name, sizeof(name), "NaN every %i", every);
+    CheckDecimation(name, y, 100);
+  }
+
+  // Runs of NaN longer than a column
+  {
+    std::vector<float> y(5000);
+
+    for (size_t i = 0; i < y.size(); i++)
+      y[i] = ((i / 300) % 2) ? nan : random(generator);
+
+    CheckDecimation("NaN runs", y, 64);
+  }
+
+  // No NaNs
+  {
+    std::vector<float> y(4096);
+
+    for (float& v : y)
+      v = random(generator);
+
+    CheckDecimation("random", y, 200);
+  }
+
+  // NaN X positions stay in the column of the point before, so there are no more columns than nColumns
+  {
+    IDataDecimator decimator;
+    std::vector<float> x(1000), y(1000);
+
+    for (size_t i = 0; i < x.size(); i++)
+    {
+      x[i] = (i % 50 == 0) ? nan : static_cast<float>(i) / (x.size() - 1);
+      y[i] = random(generator);
+    }
+
+    const int nKept = decimator.Process(y.data(), x.data(), static_cast<int>(x.size()), 100);
+    CHECK(nKept > 0 && nKept <= IDataDecimator::kPointsPerColumn * 100, "NaN X: %i points kept", nKept);
+  }
+
+  // Many points at a column boundary, where X * nColumns can round below the column that X starts
+  {
+    IDataDecimator decimator;
+    const int nColumns = 300;
+    std::vector<float> x(3000), y(3000);
+
+    for (size_t i = 0; i < x.size(); i++)
+    {
+      x[i] = static_cast<float>((i / 10) + 1) / nColumns;
+      y[i] = random(generator);
+    }
+
+    const int nKept = decimator.Process(y.data(), x.data(), static_cast<int>(x.size()), nColumns);
+    CHECK(nKept > 0 && nKept <= IDataDecimator::kPointsPerColumn * nColumns, "column boundaries: %i points kept", nKept);
+  }
+
+  if (sFailures)
+    fprintf(stderr, "%i checks failed\n", sFailures);
+  else
+    printf("All checks passed\n");
+
+  return sFailures ? 1 : 0;
+}
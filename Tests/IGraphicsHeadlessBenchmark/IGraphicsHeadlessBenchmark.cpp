@@ -0,0 +1,336 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Draws a UI with a mix of vector, SVG, bitmap and text controls in IGraphicsHeadless, and prints the frame times and per control draw times.
+// Then opens the editors of several instances, one after another and at once on separate threads, and times how long each takes to open.
+// Usage: IGraphicsHeadlessBenchmark [nFrames] [screenshot.png] [nInstances]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "IGraphics_include_in_plug_hdr.h"
+#include "IGraphics_include_in_plug_src.h"
+#include "IGraphicsEditorDelegate.h"
+#include "IControls.h"
+#include "IPlugTimer.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+#ifndef RESOURCES_DIR
+  #define RESOURCES_DIR "resources"
+#endif
+
+static constexpr int kWidth = 1024;
+static constexpr int kHeight = 768;
+static constexpr int kNumParams = 16;
+
+/** The editor half of a plug-in, with nobody to inform of parameter changes */
+class BenchmarkDelegate final : public IGEditorDelegate
+{
+public:
+  BenchmarkDelegate()
+  : IGEditorDelegate(kNumParams)
+  {
+    for (int i = 0; i < kNumParams; i++)
+      GetParam(i)->InitDouble("Param", 0.5, 0., 1., 0.01);
+
+    mMakeGraphicsFunc = [&]() {
+      return MakeGraphics(*this, kWidth, kHeight, 60);
+    };
+
+    mLayoutFunc = [&](IGraphics* pGraphics) {
+      Layout(pGraphics);
+    };
+  }
+
+  void BeginInformHostOfParamChangeFromUI(int paramIdx) override {}
+  void EndInformHostOfParamChangeFromUI(int paramIdx) override {}
+
+private:
+  static void Layout(IGraphics* pGraphics)
+  {
+    pGraphics->LoadFont("Roboto-Regular", RESOURCES_DIR "/fonts/Roboto-Regular.ttf");
+    pGraphics->AttachPanelBackground(COLOR_GRAY);
+
+    const ISVG svg = pGraphics->LoadSVG(RESOURCES_DIR "/img/23.svg");
+    const IBitmap bitmap = pGraphics->LoadBitmap(RESOURCES_DIR "/img/smiley.png");
+    const IRECT bounds = pGraphics->GetBounds().GetPadded(-10.f);
+    const IVStyle style = DEFAULT_STYLE.WithShowValue(true).WithDrawShadows(true);
+    int paramIdx = 0;
+
+    // Rows of knobs and sliders, which are mostly arcs, rounded rects and short text
+    for (int i = 0; i < 8; i++)
+      pGraphics->AttachControl(new IVKnobControl(bounds.GetGridCell(0, i, 4, 8).GetPadded(-5.f), paramIdx++, "Knob", style));
+
+    for (int i = 0; i < 8; i++)
+      pGraphics->AttachControl(new IVSliderControl(bounds.GetGridCell(1, i, 4, 8).GetPadded(-5.f), paramIdx++, "Slider", style));
+
+    // Plots with more points than pixel columns, so DrawData decimates them
+    const IRECT plots = bounds.GetGridCell(2, 0, 4, 1);
+
+    pGraphics->AttachControl(new IVPlotControl(plots.GetGridCell(0, 0, 1, 2).GetPadded(-5.f), {
+      {COLOR_RED, [](double x) { return std::sin(x * 200. * PI); }},
+      {COLOR_BLUE, [](double x) { return std::cos(x * 13. * PI) * x; }}
+    }, 8192, "Plot", style));
+
+    pGraphics->AttachControl(new IVPlotControl(plots.GetGridCell(0, 1, 1, 2).GetPadded(-5.f), {
+      {COLOR_GREEN, [](double x) { return std::tanh(std::sin(x * 40. * PI) * 4.) * 0.8; }}
+    }, 1024, "Plot", style));
+
+    // SVGs, bitmaps, buttons and text
+    const IRECT row = bounds.GetGridCell(3, 0, 4, 1);
+    const IRECT textArea = row.GetGridCell(0, 4, 1, 6).Union(row.GetGridCell(0, 5, 1, 6)).GetPadded(-5.f);
+    const char* lines[] = { "The quick brown fox jumps over the lazy dog", "Pack my box with five dozen liquor jugs", "0123456789 -12.5 dB 440.0 Hz" };
+
+    pGraphics->AttachControl(new ISVGControl(row.GetGridCell(0, 0, 1, 6).GetPadded(-5.f), svg));
+    pGraphics->AttachControl(new IBitmapControl(row.GetGridCell(0, 1, 1, 6).GetCentredInside(bitmap), bitmap));
+    pGraphics->AttachControl(new IVTabSwitchControl(row.GetGridCell(0, 2, 1, 6).GetPadded(-5.f), kNoParameter, {"One", "Two", "Three"}, "Tabs", style));
+    pGraphics->AttachControl(new IVButtonControl(row.GetGridCell(0, 3, 1, 6).GetPadded(-5.f), SplashClickActionFunc, "Button", style));
+
+    for (int i = 0; i < 3; i++)
+      pGraphics->AttachControl(new ITextControl(textArea.GetGridCell(i, 0, 3, 1), lines[i], IText(16.f + i * 4.f, EAlign::Near)));
+  }
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double MillisecondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/** @return A checksum of the pixels that an editor drew, after drawing the whole UI */
+static uint32_t RenderChecksum(BenchmarkDelegate& delegate)
+{
+  IGraphicsHeadless* pGraphics = static_cast<IGraphicsHeadless*>(delegate.GetUI());
+  pGraphics->SetAllControlsDirty();
+  pGraphics->RenderFrame();
+
+  LICE_IBitmap* pBitmap = pGraphics->GetDrawBitmap();
+  uint32_t checksum = 2166136261u;
+
+  for (int y = 0; y < pBitmap->getHeight(); y++)
+  {
+    const LICE_pixel* pRow = pBitmap->getBits() + y * pBitmap->getRowSpan();
+
+    for (int x = 0; x < pBitmap->getWidth(); x++)
+      checksum = (checksum ^ pRow[x]) * 16777619u;
+  }
+
+  return checksum;
+}
+
+/** Opens an editor, which creates its IGraphics, loads its resources and lays out its controls, and then draws its first frame
+ * @return The time it took to open, not including the frame, in ms, or a negative value if it failed */
+static double OpenEditor(BenchmarkDelegate& delegate)
+{
+  const Clock::time_point start = Clock::now();
+  delegate.OpenWindow(nullptr);
+  const double ms = MillisecondsSince(start);
+
+  IGraphicsHeadless* pGraphics = static_cast<IGraphicsHeadless*>(delegate.GetUI());
+
+  if (!pGraphics)
+    return -1.;
+
+  pGraphics->RenderFrame();
+  return ms;
+}
+
+/** Opens the editors of several instances, which share the bitmaps and SVGs they load, and checks that each draws the same UI. The shared
+ * resources are freed when the last editor that loaded them closes, so the editors that are opened after the others have closed load them again
+ * @return The number of failures */
+static int BenchmarkEditorOpen(int nInstances)
+{
+  int failures = 0;
+  uint32_t expectedChecksum = 0;
+
+  auto check = [&](BenchmarkDelegate& delegate, const char* when) {
+    if (RenderChecksum(delegate) != expectedChecksum && !failures++)
+      fprintf(stderr, "An editor draws a different UI %s\n", when);
+  };
+
+  printf("\nOpening %i editors\n", nInstances);
+
+  // One after another, all staying open. The first loads the resources and the others find them in the cache
+  {
+    std::vector<std::unique_ptr<BenchmarkDelegate>> delegates;
+    double firstMs = 0.;
+    double othersMs = 0.;
+
+    for (int i = 0; i < nInstances; i++)
+    {
+      delegates.push_back(std::make_unique<BenchmarkDelegate>());
+      const double ms = OpenEditor(*delegates.back());
+
+      if (ms < 0.)
+      {
+        fprintf(stderr, "Could not create the UI\n");
+        return failures + 1;
+      }
+
+      (i ? othersMs : firstMs) += ms;
+
+      if (!i)
+        expectedChecksum = RenderChecksum(*delegates.back());
+    }
+
+    printf("%-24s first %8.2f ms, then %8.2f ms each\n", "one after another", firstMs, nInstances > 1 ? othersMs / (nInstances - 1) : 0.);
+
+    // Closing the first editor must not free resources that the others still draw
+    delegates.front()->CloseWindow();
+
+    for (int i = 1; i < nInstances; i++)
+      check(*delegates[i], "after another editor closed");
+
+    for (auto& pDelegate : delegates)
+      pDelegate->CloseWindow();
+  }
+
+  // Reopened after all were closed, when the resources have been freed
+  {
+    BenchmarkDelegate delegate;
+    const double ms = OpenEditor(delegate);
+    printf("%-24s %8.2f ms\n", "reopened", ms);
+    check(delegate, "when it is reopened");
+    delegate.CloseWindow();
+  }
+
+  // At once, each on its own thread, which stay open until all have opened
+  {
+    std::vector<std::thread> threads;
+    std::vector<double> times(nInstances, 0.);
+    std::atomic<int> nOpen{0};
+    std::atomic<int> nDifferent{0};
+    const Clock::time_point start = Clock::now();
+
+    for (int i = 0; i < nInstances; i++)
+    {
+      threads.emplace_back([&, i]() {
+        BenchmarkDelegate delegate;
+        times[i] = OpenEditor(delegate);
+        nOpen++;
+
+        while (nOpen.load() < nInstances)
+          std::this_thread::yield();
+
+        if (times[i] < 0. || RenderChecksum(delegate) != expectedChecksum)
+          nDifferent++;
+
+        delegate.CloseWindow();
+      });
+    }
+
+    for (auto& thread : threads)
+      thread.join();
+
+    const double totalMs = MillisecondsSince(start);
+    printf("%-24s slowest %8.2f ms, %8.2f ms until all had opened and drawn\n", "at once", *std::max_element(times.begin(), times.end()), totalMs);
+
+    if (nDifferent.load())
+    {
+      fprintf(stderr, "%i editors opened at once did not draw the same UI\n", nDifferent.load());
+      failures += nDifferent.load();
+    }
+  }
+
+  return failures;
+}
+
+int main(int argc, char* argv[])
+{
+  const int nFrames = argc > 1 ? std::max(1, atoi(argv[1])) : 100;
+  const char* pngPath = argc > 2 ? argv[2] : nullptr;
+  const int nInstances = argc > 3 ? std::max(1, atoi(argv[3])) : 8;
+
+  BenchmarkDelegate delegate;
+  delegate.OpenWindow(nullptr);
+
+  IGraphicsHeadless* pGraphics = static_cast<IGraphicsHeadless*>(delegate.GetUI());
+
+  if (!pGraphics)
+  {
+    fprintf(stderr, "Could not create the UI\n");
+    return 1;
+  }
+
+  int result = 0;
+
+  // Draw once first, so that fonts, SVGs and layers are not counted
+  pGraphics->SetAllControlsDirty();
+  pGraphics->RenderFrame();
+
+  const std::pair<IGraphicsHeadless::EBenchmarkRegions, const char*> regions[] = {
+    {IGraphicsHeadless::EBenchmarkRegions::FullFrame, "Full frame"},
+    {IGraphicsHeadless::EBenchmarkRegions::EachControl, "Each control"},
+    {IGraphicsHeadless::EBenchmarkRegions::RandomRects, "Random rects"}
+  };
+
+  for (const auto& region : regions)
+  {
+    printf("\n%s (%s, %ix%i)\n", region.second, pGraphics->GetDrawingAPIStr(), pGraphics->WindowWidth(), pGraphics->WindowHeight());
+
+    const IGraphicsHeadless::BenchmarkResults results = pGraphics->Benchmark(nFrames, region.first);
+    results.Print(stdout);
+
+    if (results.controls.empty())
+    {
+      fprintf(stderr, "No controls were drawn\n");
+      result = 1;
+    }
+  }
+
+#if defined OS_LINUX
+  // Without an OS run loop, timers are fired by RenderFrame(), on the thread that runs the UI
+  int nTicks = 0;
+  bool tickedOnMainThread = true;
+  const std::thread::id mainThreadID = std::this_thread::get_id();
+  std::unique_ptr<Timer> pTimer(Timer::Create([&](Timer& timer) {
+    nTicks++;
+    tickedOnMainThread &= std::this_thread::get_id() == mainThreadID;
+  }, 1));
+
+  for (int i = 0; i < 10; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    pGraphics->RenderFrame();
+  }
+
+  pTimer = nullptr;
+
+  if (!nTicks || !tickedOnMainThread)
+  {
+    fprintf(stderr, "The timer ticked %i times, %s\n", nTicks, tickedOnMainThread ? "on the main thread" : "not always on the main thread");
+    result = 1;
+  }
+#endif
+
+  if (pngPath && !pGraphics->RenderToPNG(pngPath))
+  {
+    fprintf(stderr, "Could not write %s\n", pngPath);
+    result = 1;
+  }
+
+  delegate.CloseWindow();
+
+  if (BenchmarkEditorOpen(nInstances))
+    result = 1;
+
+  return result;
+}
@@ -3,6 +3,8 @@
 
 #include "IControls.h"
 
+#include <chrono>
+
 IGraphicsStressTest::IGraphicsStressTest(const InstanceInfo& info)
 : iplug::Plugin(info, MakeConfig(kNumParams, 1))
 {
@@ -22,6 +24,72 @@ void IGraphicsStressTest::OnParentWindowResize(int width, int height)
     GetUI()->Resize(width, height, 1.f, false);
 }
 
+void IGraphicsStressTest::ToggleIdleBenchmark(IGraphics* pGraphics)
+{
+  if (mIdleBenchmarkFirstIdx > -1)
+  {
+    pGraphics->RemoveControls(mIdleBenchmarkFirstIdx);
+    pGraphics->EnableIncrementalDirtyTracking(false);
+    pGraphics->EnableMouseHitGrid(false);
+    mIdleBenchmarkFirstIdx = -1;
+    return;
+  }
+
+  static constexpr int kNumRows = 100;
+  static constexpr int kNumColumns = 100;
+  static constexpr int kNumFrames = 1000;
+
+  const IRECT area = pGraphics->GetControl(1)->GetRECT();
+  mIdleBenchmarkFirstIdx = pGraphics->NControls();
+
+  for (int row = 0; row < kNumRows; row++)
+  {
+    for (int col = 0; col < kNumColumns; col++)
+    {
+      pGraphics->AttachControl(new IPanelControl(area.GetGridCell(row, col, kNumRows, kNumColumns), IColor::GetRandomColor()));
+    }
+  }
+
+  // Time the display refresh work when nothing has changed, which is what an idle editor costs at each frame
+  auto timeIdleFrames = [pGraphics]() {
+    IRECTList rects;
+    pGraphics->IsDirty(rects);
+    pGraphics->SetAllControlsClean();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < kNumFrames; i++)
+    {
+      IRECTList idleRects;
+      pGraphics->IsDirty(idleRects);
+      pGraphics->SetAllControlsClean();
+    }
+
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / kNumFrames;
+  };
+
+  pGraphics->EnableIncrementalDirtyTracking(false);
+  const double fullScanTime = timeIdleFrames();
+
+  pGraphics->EnableIncrementalDirtyTracking(true);
+  pGraphics->EnableMouseHitGrid(true);
+  const double incrementalTime = timeIdleFrames();
+
+  pGraphics->SetAllControlsDirty();
+
+  // Time a parameter update from the delegate, as sent by OnTimer() for each changed parameter. Only linked controls should be visited
+  const auto paramStart = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < kNumFrames; i++)
+    SendParameterValueFromDelegate(kParamDummy, static_cast<double>(i % 2), true);
+
+  const double paramUpdateTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - paramStart).count() / kNumFrames;
+
+  DBGMSG("Idle frame with %i controls: full scan %.2f us, incremental %.2f us\n", pGraphics->NControls(), fullScanTime, incrementalTime);
+  DBGMSG("Parameter update with %i controls: %.2f us\n", pGraphics->NControls(), paramUpdateTime);
+  pGraphics->GetControlWithTag(kCtrlTagTestNum)->As<ITextControl>()->SetStrFmt(128, "Idle: %.1f us scan, %.1f us incr.", fullScanTime, incrementalTime);
+}
+
 void IGraphicsStressTest::LayoutUI(IGraphics* pGraphics)
 {
   IRECT bounds = pGraphics->GetBounds();
@@ -62,12 +130,13 @@ void IGraphicsStressTest::LayoutUI(IGraphics* pGraphics)
     GetUI()->SetAllControlsDirty();
   };
   
-  pGraphics->SetKeyHandlerFunc([DoFunc](const IKeyPress& key, bool isUp)
+  pGraphics->SetKeyHandlerFunc([DoFunc, this](const IKeyPress& key, bool isUp)
   {
     if(!isUp) {
       switch (key.VK) {
         case kVK_UP: DoFunc(EFunc::More); return true;
         case kVK_DOWN: DoFunc(EFunc::Less); return true;
+        case kVK_B: ToggleIdleBenchmark(GetUI()); return true;
         case kVK_TAB: key.S ? DoFunc(EFunc::Prev) : DoFunc(EFunc::Next); return true;
         default: return false;
       }
@@ -30,8 +30,10 @@ public:
 #if IPLUG_EDITOR
   void LayoutUI(IGraphics* pGraphics) override;
   void OnParentWindowResize(int width, int height) override;
+  void ToggleIdleBenchmark(IGraphics* pGraphics);
 public:
   int mNumberOfThings = 16;
   int mKindOfThing = 0;
+  int mIdleBenchmarkFirstIdx = -1;
 #endif
 };
@@ -0,0 +1,139 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Checks PARAMS_SNAPSHOT: after a recall, GetParamSnapshotValue() returns the recalled values until the host or the UI sets a parameter,
+// and then that parameter's new value. The default OnParamResetDSP() must only pass recalled values on to the DSP, even if a later recall
+// has already started to overwrite the IParams. Built with PARAMS_SNAPSHOT and NO_IGRAPHICS, a block is a call to ApplyParamSnapshot().
+
+#include <cstdio>
+
+#include "IPlugAPIBase.h"
+
+using namespace iplug;
+
+static int sFailures = 0;
+
+#define CHECK(cond, ...) \
+  if (!(cond)) { fprintf(stderr, "FAILED %s:%i: ", __FILE__, __LINE__); fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); sFailures++; }
+
+enum EParams
+{
+  kGain = 0,
+  kFreq,
+  kNumParams
+};
+
+/** A plug-in without an API, which records the values its DSP was given */
+class TestPlug final : public IPlugAPIBase
+{
+public:
+  TestPlug(bool overrideChangeDSP)
+  : IPlugAPIBase(Config(kNumParams, 0, "1-1", "Test", "Test", "Test", 0x00010000, 'Tst1', 'Acme', 0, false, false, false, false, 0, false, 100, 100, 100, 100, 100, 100, false, "com.acme.test", ""), kAPIVST3)
+  , mOverrideChangeDSP(overrideChangeDSP)
+  {
+    GetParam(kGain)->InitDouble("Gain", 0., 0., 100., 0.01);
+    GetParam(kFreq)->InitDouble("Freq", 0., 0., 100., 0.01);
+  }
+
+  /** The start of a block */
+  void ProcessBlock() { ApplyParamSnapshot(); }
+
+  /** Recalls a preset as the host would on a non-realtime thread */
+  void Recall(double gain, double freq)
+  {
+    IByteChunk chunk;
+    chunk.Put(&gain);
+    chunk.Put(&freq);
+    UnserializeParams(chunk, 0);
+  }
+
+  /** Sets a parameter as the API classes do for host automation */
+  void Automate(int paramIdx, double value)
+  {
+    GetParam(paramIdx)->Set(value);
+    InvalidateParamSnapshotValue(paramIdx);
+    OnParamChange(paramIdx, kHost);
+  }
+
+  using IPlugAPIBase::OnParamChange;
+
+  void OnParamChange(int paramIdx) override { mDSP[paramIdx] = GetParam(paramIdx)->Value(); }
+
+  void OnParamChangeDSP(int paramIdx, double value, EParamSource source) override
+  {
+    if (mOverrideChangeDSP)
+      mDSP[paramIdx] = value;
+    else
+      IPlugAPIBase::OnParamChangeDSP(paramIdx, value, source);
+  }
+
+  double mDSP[kNumParams] = {};
+
+private:
+  const bool mOverrideChangeDSP;
+};
+
+int main()
+{
+  for (bool overrideChangeDSP : {false, true})
+  {
+    const char* name = overrideChangeDSP ? "OnParamChangeDSP() override" : "default OnParamChangeDSP()";
+    TestPlug plug(overrideChangeDSP);
+
+    // Recall, then host automation and a UI edit
+    plug.Recall(10., 20.);
+    plug.ProcessBlock();
+    CHECK(plug.mDSP[kGain] == 10. && plug.mDSP[kFreq] == 20., "%s: recall gave %g %g", name, plug.mDSP[kGain], plug.mDSP[kFreq]);
+    CHECK(plug.GetParamSnapshotValue(kGain) == 10. && plug.GetParamSnapshotValue(kFreq) == 20., "%s: the snapshot does not have the recalled values", name);
+
+    plug.Automate(kGain, 30.);
+    plug.SetParameterValue(kFreq, plug.GetParam(kFreq)->ToNormalized(40.));
+    plug.ProcessBlock();
+    CHECK(plug.GetParamSnapshotValue(kGain) == 30., "%s: automation after a recall reads %g", name, plug.GetParamSnapshotValue(kGain));
+    CHECK(plug.GetParamSnapshotValue(kFreq) == 40., "%s: a UI edit after a recall reads %g", name, plug.GetParamSnapshotValue(kFreq));
+    CHECK(plug.mDSP[kGain] == 30. && plug.mDSP[kFreq] == 40., "%s: the DSP has %g %g after automation", name, plug.mDSP[kGain], plug.mDSP[kFreq]);
+
+    // A later recall makes the snapshot current again
+    plug.Recall(50., 60.);
+    plug.ProcessBlock();
+    CHECK(plug.GetParamSnapshotValue(kGain) == 50. && plug.GetParamSnapshotValue(kFreq) == 60., "%s: the second recall reads %g %g", name,
+          plug.GetParamSnapshotValue(kGain), plug.GetParamSnapshotValue(kFreq));
+
+    // Automation between a recall and the block that applies it wins over the recalled value
+    plug.Recall(1., 2.);
+    plug.Automate(kGain, 3.);
+    plug.ProcessBlock();
+    CHECK(plug.GetParamSnapshotValue(kGain) == 3. && plug.GetParamSnapshotValue(kFreq) == 2., "%s: automation before the block reads %g %g", name,
+          plug.GetParamSnapshotValue(kGain), plug.GetParamSnapshotValue(kFreq));
+    CHECK(plug.mDSP[kGain] == 3. && plug.mDSP[kFreq] == 2., "%s: the DSP has %g %g after automation before the block", name, plug.mDSP[kGain], plug.mDSP[kFreq]);
+
+    // A recall that has set some IParams but not published its snapshot yet, when the previous one is applied. The DSP only gets recalled values
+    plug.mDSP[kGain] = plug.mDSP[kFreq] = -1.;
+    plug.Recall(7., 8.);
+    plug.GetParam(kGain)->Set(9.);
+    plug.ProcessBlock();
+    CHECK(plug.GetParamSnapshotValue(kGain) == 7. && plug.GetParamSnapshotValue(kFreq) == 8., "%s: a recall in progress reads %g %g", name,
+          plug.GetParamSnapshotValue(kGain), plug.GetParamSnapshotValue(kFreq));
+    CHECK(plug.mDSP[kGain] == (overrideChangeDSP ? 7. : -1.) && plug.mDSP[kFreq] == 8., "%s: a recall in progress gave the DSP %g %g", name,
+          plug.mDSP[kGain], plug.mDSP[kFreq]);
+
+    // Then that recall completes
+    plug.Recall(9., 10.);
+    plug.ProcessBlock();
+    CHECK(plug.mDSP[kGain] == 9. && plug.mDSP[kFreq] == 10., "%s: the completed recall gave the DSP %g %g", name, plug.mDSP[kGain], plug.mDSP[kFreq]);
+  }
+
+  if (sFailures)
+    fprintf(stderr, "%i checks failed\n", sFailures);
+  else
+    printf("All checks passed\n");
+
+  return sFailures ? 1 : 0;
+}
@@ -0,0 +1,154 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Passes items from a producer thread to a consumer thread through IPlugQueue, one at a time with Push() and Pop() and in batches with
+// PushBatch() and PopBatch(), and prints the best time per item of each. The consumer checks that every item arrives once and in order.
+// Usage: IPlugQueueBenchmark [nItems] [nRuns]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "IPlugQueue.h"
+
+using namespace iplug;
+
+static constexpr int kQueueSize = 1024;
+
+/** An item of a given size, the first bytes of which are its sequence number */
+template <int Size>
+struct Item
+{
+  int64_t mSeq = 0;
+  char mPayload[Size - sizeof(int64_t)] = {};
+};
+
+/** Moves nItems items through a queue
+ * @param batchSize The number of items per PushBatch() and PopBatch(), or 0 to use Push() and Pop()
+ * @return The time it took in seconds, or a negative value if an item was lost, repeated or out of order */
+template <int Size>
+static double Transfer(IPlugQueue<Item<Size>>& queue, int64_t nItems, int batchSize)
+{
+  bool ok = true;
+
+  std::thread consumer([&]() {
+    std::vector<Item<Size>> items(std::max(batchSize, 1));
+    int64_t expected = 0;
+
+    while (expected < nItems)
+    {
+      int n = 0;
+
+      if (batchSize)
+        n = queue.PopBatch(items.data(), batchSize);
+      else
+        n = queue.Pop(items[0]) ? 1 : 0;
+
+      if (!n)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+
+      for (int i = 0; i < n; i++)
+        ok &= items[i].mSeq == expected++ && items[i].mPayload[0] == static_cast<char>(items[i].mSeq);
+    }
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<Item<Size>> items(std::max(batchSize, 1));
+  int64_t next = 0;
+
+  while (next < nItems)
+  {
+    const int nWanted = static_cast<int>(std::min<int64_t>(std::max(batchSize, 1), nItems - next));
+
+    for (int i = 0; i < nWanted; i++)
+    {
+      items[i].mSeq = next + i;
+      items[i].mPayload[0] = static_cast<char>(next + i);
+    }
+
+    int n = 0;
+
+    if (batchSize)
+      n = queue.PushBatch(items.data(), nWanted);
+    else
+      n = queue.Push(items[0]) ? 1 : 0;
+
+    if (!n)
+      std::this_thread::yield();
+
+    next += n;
+  }
+
+  consumer.join();
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return ok && queue.WasEmpty() ? seconds : -1.;
+}
+
+template <int Size>
+static int RunBenchmark(int64_t nItems, int nRuns)
+{
+  IPlugQueue<Item<Size>> queue(kQueueSize);
+  int failures = 0;
+  double singleNs = 0.;
+
+  for (int batchSize : {0, 8, 64, 256})
+  {
+    double best = 0.;
+
+    for (int r = 0; r < nRuns; r++)
+    {
+      const double seconds = Transfer(queue, nItems, batchSize);
+
+      if (seconds < 0.)
+        failures++;
+      else if (!r || seconds < best)
+        best = seconds;
+    }
+
+    const double ns = best * 1e9 / nItems;
+
+    if (!batchSize)
+    {
+      singleNs = ns;
+      printf("%4i bytes  Push/Pop             %8.2f ns per item\n", Size, ns);
+    }
+    else
+    {
+      printf("%4i bytes  batches of %-4i      %8.2f ns per item  %5.2fx\n", Size, batchSize, ns, singleNs / ns);
+    }
+  }
+
+  if (failures)
+    fprintf(stderr, "%i bytes: %i runs lost, repeated or reordered items\n", Size, failures);
+
+  return failures;
+}
+
+int main(int argc, char* argv[])
+{
+  const int64_t nItems = argc > 1 ? std::max(1, atoi(argv[1])) : 10000000;
+  const int nRuns = argc > 2 ? std::max(1, atoi(argv[2])) : 3;
+
+  printf("%lli items through a queue of %i, best of %i runs\n", static_cast<long long>(nItems), kQueueSize, nRuns);
+
+  int failures = 0;
+  failures += RunBenchmark<16>(nItems, nRuns);
+  failures += RunBenchmark<64>(nItems, nRuns);
+
+  return failures ? 1 : 0;
+}
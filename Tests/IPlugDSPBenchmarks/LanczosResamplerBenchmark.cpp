@@ -0,0 +1,194 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Resamples blocks of a sine from 48 kHz to 44.1 kHz with LanczosResampler, for float and double and 1, 2 and 8 channels, and prints the time per
+// output frame. Also checks that every channel gets the same output, that float matches double and that the sine keeps its level.
+// Build it with and without IPLUG_SIMDE (and with AVX) to compare the scalar and vector paths.
+// Usage: LanczosResamplerBenchmark [nBlocks] [nRuns]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "wdltypes.h" // WDL_FIXALIGN, which plug-ins get from their other includes
+#include "LanczosResampler.h"
+
+using namespace iplug;
+
+static constexpr double kInputRate = 48000.;
+static constexpr double kOutputRate = 44100.;
+static constexpr double kFreq = 1000.;
+static constexpr int kBlockSize = 512;
+
+struct Result
+{
+  double nsPerFrame;
+  std::vector<double> output; // Channel 0
+};
+
+/** Pushes nBlocks of kBlockSize input frames and pops all the output after each one, best time of nRuns */
+template <typename T, int NCHANS>
+static Result Run(int nBlocks, int nRuns, int& failures)
+{
+  using Resampler = LanczosResampler<T, NCHANS>;
+
+  const int maxOut = kBlockSize * 2;
+  std::vector<T> inBuffer(NCHANS * kBlockSize), outBuffer(NCHANS * maxOut);
+  T* inputs[NCHANS];
+  T* outputs[NCHANS];
+
+  for (int c = 0; c < NCHANS; c++)
+  {
+    inputs[c] = inBuffer.data() + c * kBlockSize;
+    outputs[c] = outBuffer.data() + c * maxOut;
+  }
+
+  Result result;
+  double best = 0.;
+
+  for (int r = 0; r < nRuns; r++)
+  {
+    // The state is about 32 KB per channel, too much for the stack with 8 channels
+    auto pResampler = std::make_unique<Resampler>(static_cast<float>(kInputRate), static_cast<float>(kOutputRate));
+    std::vector<double> output;
+    double elapsed = 0.;
+    size_t nOut = 0;
+
+    for (int b = 0; b < nBlocks; b++)
+    {
+      for (int s = 0; s < kBlockSize; s++)
+      {
+        const T x = static_cast<T>(0.5 * std::sin(2. * PI * kFreq * (b * kBlockSize + s) / kInputRate));
+
+        for (int c = 0; c < NCHANS; c++)
+          inputs[c][s] = x;
+      }
+
+      const auto start = std::chrono::steady_clock::now();
+      pResampler->PushBlock(inputs, kBlockSize, NCHANS);
+      const size_t n = pResampler->PopBlock(outputs, maxOut, NCHANS);
+      pResampler->RenormalizePhases();
+      elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      for (size_t s = 0; s < n; s++)
+      {
+        for (int c = 1; c < NCHANS; c++)
+        {
+          if (outputs[c][s] != outputs[0][s])
+          {
+            if (!failures++)
+              fprintf(stderr, "Channel %i differs from channel 0 with %i channels\n", c, NCHANS);
+            break;
+          }
+        }
+
+        output.push_back(outputs[0][s]);
+      }
+
+      nOut += n;
+    }
+
+    const double nsPerFrame = elapsed * 1e9 / std::max<size_t>(nOut, 1);
+
+    if (r == 0 || nsPerFrame < best)
+      best = nsPerFrame;
+
+    result.output = std::move(output);
+  }
+
+  result.nsPerFrame = best;
+  return result;
+}
+
+/** @return The RMS level of a signal in dB, after the filter has settled */
+static double LevelDB(const std::vector<double>& x)
+{
+  const size_t start = std::min<size_t>(x.size(), 256);
+  double sum = 0.;
+
+  for (size_t s = start; s < x.size(); s++)
+    sum += x[s] * x[s];
+
+  return 10. * std::log10(sum / std::max<size_t>(x.size() - start, 1) + 1e-30);
+}
+
+int main(int argc, char* argv[])
+{
+  const int nBlocks = argc > 1 ? std::max(1, atoi(argv[1])) : 1000;
+  const int nRuns = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+  int failures = 0;
+
+#if !defined IPLUG_SIMDE
+  const char* path = "scalar";
+#elif defined __AVX__
+  const char* path = "AVX";
+#else
+  const char* path = "SSE2";
+#endif
+
+  auto start = std::chrono::steady_clock::now();
+  LanczosResampler<float>::InitTables();
+  LanczosResampler<double>::InitTables();
+  const double tablesMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%i blocks of %i frames, %g Hz -> %g Hz, best of %i, %s\n", nBlocks, kBlockSize, kInputRate, kOutputRate, nRuns, path);
+  printf("Building the float and double tables took %.1f ms\n\n", tablesMs);
+  printf("%8s %10s %14s\n", "type", "channels", "ns per frame");
+
+  const Result f1 = Run<float, 1>(nBlocks, nRuns, failures);
+  const Result f2 = Run<float, 2>(nBlocks, nRuns, failures);
+  const Result f8 = Run<float, 8>(nBlocks, nRuns, failures);
+  const Result d1 = Run<double, 1>(nBlocks, nRuns, failures);
+  const Result d2 = Run<double, 2>(nBlocks, nRuns, failures);
+  const Result d8 = Run<double, 8>(nBlocks, nRuns, failures);
+
+  const std::pair<const char*, const Result*> results[] = { {"float", &f1}, {"float", &f2}, {"float", &f8}, {"double", &d1}, {"double", &d2}, {"double", &d8} };
+  const int channels[] = { 1, 2, 8, 1, 2, 8 };
+
+  for (int i = 0; i < 6; i++)
+    printf("%8s %10i %14.1f\n", results[i].first, channels[i], results[i].second->nsPerFrame);
+
+  // The channel count only changes the buffer size, so the same input must give the same output
+  if (f2.output != f1.output || f8.output != f1.output || d2.output != d1.output || d8.output != d1.output)
+  {
+    fprintf(stderr, "The output depends on the channel count\n");
+    failures++;
+  }
+
+  double maxDiff = 0.;
+
+  for (size_t s = 0; s < std::min(f1.output.size(), d1.output.size()); s++)
+    maxDiff = std::max(maxDiff, std::fabs(f1.output[s] - d1.output[s]));
+
+  const double level = LevelDB(d1.output);
+  const double expected = 20. * std::log10(0.5 / std::sqrt(2.));
+
+  printf("\nLargest difference between float and double: %g\n", maxDiff);
+  printf("Level of a %g Hz sine: %.3f dB, expected %.3f dB\n", kFreq, level, expected);
+
+  if (f1.output.size() != d1.output.size() || maxDiff > 1e-5)
+  {
+    fprintf(stderr, "float and double differ\n");
+    failures++;
+  }
+
+  if (std::fabs(level - expected) > 0.01)
+  {
+    fprintf(stderr, "The sine has the wrong level\n");
+    failures++;
+  }
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,313 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Sends OSC messages over the loopback interface to an OSCReceiver with a receive thread, and measures the latency from sendto() to the handler
+// and the number of messages per second. Every message is addressed to one of the handlers registered with AddOSCHandler(), so it goes through the
+// recvmmsg() path on Linux and OSCDispatcher. Also times OSCDispatcher::Dispatch() on its own, with exact addresses and with wildcard patterns.
+// Usage: OSCLoopbackBenchmark [nMessages] [port]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "IPlugOSC.h"
+
+using namespace iplug;
+
+static constexpr int kNVoices = 16;
+static constexpr int kNParams = 8;
+static constexpr int kWindow = 32; // The most messages in flight when measuring throughput, fewer than fit in the receive queue
+static const char* kParamNames[kNParams] = { "gain", "pan", "cutoff", "reso", "attack", "decay", "sustain", "release" };
+
+using Clock = std::chrono::steady_clock;
+
+static double SecondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void GetAddress(int idx, char* address, int len)
+{
+  snprintf(address, len, "/synth/%i/%s", (idx / kNParams) % kNVoices + 1, kParamNames[idx % kNParams]);
+}
+
+/** What the handlers received, by the sequence number in the first argument of each message. Written by the thread that dispatches, and read
+ * by the sending thread once mNReceived says the message has arrived */
+struct Recorder
+{
+  std::vector<Clock::time_point> mSendTimes;
+  std::vector<Clock::time_point> mReceiveTimes;
+  std::vector<int> mCounts;
+  std::atomic<int> mNReceived{0};
+  std::atomic<int> mNWrong{0};
+
+  void Reset(int nMessages)
+  {
+    mSendTimes.assign(nMessages, Clock::time_point());
+    mReceiveTimes.assign(nMessages, Clock::time_point());
+    mCounts.assign(nMessages, 0);
+    mNReceived.store(0);
+    mNWrong.store(0);
+  }
+
+  void OnMessage(int handlerIdx, OscMessageRead& msg)
+  {
+    const Clock::time_point now = Clock::now();
+    const int* pSeq = msg.PopIntArg(false);
+
+    if (!pSeq || *pSeq < 0 || *pSeq >= static_cast<int>(mCounts.size()) || *pSeq % (kNVoices * kNParams) != handlerIdx)
+    {
+      mNWrong.fetch_add(1);
+      return;
+    }
+
+    mReceiveTimes[*pSeq] = now;
+    mCounts[*pSeq]++;
+    mNReceived.fetch_add(1, std::memory_order_release);
+  }
+};
+
+/** A UDP socket that sends each message in its own datagram */
+class LoopbackSender
+{
+public:
+  LoopbackSender(int port)
+  {
+    JNL::open_socketlib();
+    mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&mAddress, 0, sizeof(mAddress));
+    mAddress.sin_family = AF_INET;
+    mAddress.sin_addr.s_addr = inet_addr("127.0.0.1");
+    mAddress.sin_port = htons(port);
+  }
+
+  ~LoopbackSender()
+  {
+    if (mSocket != INVALID_SOCKET)
+      closesocket(mSocket);
+  }
+
+  bool IsValid() const { return mSocket != INVALID_SOCKET; }
+
+  void Send(Recorder& recorder, int seq)
+  {
+    char address[64];
+    GetAddress(seq, address, sizeof(address));
+
+    OscMessageWrite msg;
+    msg.PushWord(address);
+    msg.PushIntArg(seq);
+
+    int len = 0;
+    const char* pData = msg.GetBuffer(&len);
+
+    recorder.mSendTimes[seq] = Clock::now();
+    sendto(mSocket, pData, len, 0, (struct sockaddr*) &mAddress, sizeof(mAddress));
+  }
+
+private:
+  SOCKET mSocket = INVALID_SOCKET;
+  struct sockaddr_in mAddress;
+};
+
+/** Waits until the receiver has dispatched at least n messages
+ * @return \c false if it timed out */
+static bool WaitForReceived(const Recorder& recorder, int n)
+{
+  const Clock::time_point start = Clock::now();
+
+  while (recorder.mNReceived.load(std::memory_order_acquire) < n)
+  {
+    if (SecondsSince(start) > 1.)
+      return false;
+
+    std::this_thread::yield();
+  }
+
+  return true;
+}
+
+/** Checks that each message was dispatched exactly once to the right handler
+ * @return The number of failures */
+static int CheckReceived(const char* name, const Recorder& recorder, int nDropped)
+{
+  int nMissing = 0;
+  int nRepeated = 0;
+
+  for (int count : recorder.mCounts)
+  {
+    nMissing += count == 0;
+    nRepeated += count > 1;
+  }
+
+  const int failures = nMissing + nRepeated + recorder.mNWrong.load() + nDropped;
+
+  if (failures)
+    fprintf(stderr, "%s: %i messages missing, %i dispatched more than once, %i to the wrong handler, %i dropped\n", name, nMissing, nRepeated,
+            recorder.mNWrong.load(), nDropped);
+
+  return failures;
+}
+
+static int RunLoopback(const char* name, EOSCDelivery delivery, int nMessages, int port)
+{
+  Recorder recorder;
+  OSCReceiver receiver(port);
+
+  for (int i = 0; i < kNVoices * kNParams; i++)
+  {
+    char address[64];
+    GetAddress(i, address, sizeof(address));
+    receiver.AddOSCHandler(address, [&recorder, i](OscMessageRead& msg) { recorder.OnMessage(i, msg); });
+  }
+
+  receiver.SetReceiveThread(true, delivery);
+
+  // With kManual, a thread stands in for the audio thread and dispatches the queued messages
+  std::atomic<bool> polling{delivery == EOSCDelivery::kManual};
+  std::thread pollThread([&]() {
+    while (polling.load(std::memory_order_relaxed))
+    {
+      if (!receiver.ProcessOSCMessages())
+        std::this_thread::yield();
+    }
+  });
+
+  LoopbackSender sender(port);
+  int failures = 0;
+
+  // Latency, one message at a time
+  recorder.Reset(nMessages);
+
+  for (int i = 0; i < nMessages && !failures; i++)
+  {
+    sender.Send(recorder, i);
+
+    if (!WaitForReceived(recorder, i + 1))
+      failures++;
+  }
+
+  std::vector<double> latencies(nMessages);
+
+  for (int i = 0; i < nMessages; i++)
+    latencies[i] = std::chrono::duration<double, std::micro>(recorder.mReceiveTimes[i] - recorder.mSendTimes[i]).count();
+
+  std::sort(latencies.begin(), latencies.end());
+  double meanLatency = 0.;
+
+  for (double latency : latencies)
+    meanLatency += latency / nMessages;
+
+  failures += CheckReceived(name, recorder, receiver.GetNDroppedOSCMessages());
+
+  // Throughput, with up to kWindow messages in flight. Skipped after a failure, when a late message could still be dispatched
+  double seconds = 0.;
+
+  if (!failures)
+  {
+    recorder.Reset(nMessages);
+    const Clock::time_point start = Clock::now();
+
+    for (int i = 0; i < nMessages && !failures; i++)
+    {
+      if (i >= kWindow && !WaitForReceived(recorder, i - kWindow + 1))
+        failures++;
+
+      sender.Send(recorder, i);
+    }
+
+    if (!failures && !WaitForReceived(recorder, nMessages))
+      failures++;
+
+    seconds = SecondsSince(start);
+    failures += CheckReceived(name, recorder, receiver.GetNDroppedOSCMessages());
+  }
+
+  polling = false;
+  pollThread.join();
+  receiver.StopReceiving();
+
+  if (!sender.IsValid())
+    fprintf(stderr, "%s: could not create a socket\n", name);
+  else if (failures)
+    fprintf(stderr, "%s: messages to port %i were lost, is it in use?\n", name, port);
+  else
+    printf("%-16s %8i messages   latency mean %7.1f us, 99%% %7.1f us, max %7.1f us   %9.0f msgs/s\n", name, nMessages, meanLatency,
+           latencies[std::min(nMessages - 1, nMessages * 99 / 100)], latencies.back(), nMessages / seconds);
+
+  return failures;
+}
+
+static int RunDispatch(const char* name, const char* pattern, int nExpected, int nMessages)
+{
+  OSCDispatcher dispatcher;
+  int nCalled = 0;
+
+  for (int i = 0; i < kNVoices * kNParams; i++)
+  {
+    char address[64];
+    GetAddress(i, address, sizeof(address));
+    dispatcher.AddHandler(address, [&nCalled](OscMessageRead& msg) { nCalled++; });
+  }
+
+  OscMessageWrite msg;
+  msg.PushWord(pattern);
+  msg.PushIntArg(0);
+
+  int len = 0;
+  const char* pData = msg.GetBuffer(&len);
+  bool ok = true;
+
+  const Clock::time_point start = Clock::now();
+
+  for (int i = 0; i < nMessages; i++)
+    ok &= dispatcher.Dispatch(pData, len) == nExpected;
+
+  const double seconds = SecondsSince(start);
+  ok &= nCalled == nExpected * nMessages;
+
+  printf("%-16s %-28s %3i handlers   %8.1f ns per message\n", name, pattern, nExpected, seconds * 1e9 / nMessages);
+
+  if (!ok)
+    fprintf(stderr, "%s: %s did not call %i handlers\n", name, pattern, nExpected);
+
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+  const int nMessages = argc > 1 ? std::max(1, atoi(argv[1])) : 100000;
+  const int port = argc > 2 ? atoi(argv[2]) : 9123;
+
+  int failures = 0;
+
+#if defined __linux__
+  printf("Loopback to port %i, received with recvmmsg()\n", port);
+#else
+  printf("Loopback to port %i, received with recvfrom()\n", port);
+#endif
+
+  failures += RunLoopback("receive thread", EOSCDelivery::kReceiveThread, nMessages, port);
+  failures += RunLoopback("manual", EOSCDelivery::kManual, nMessages, port);
+
+  printf("\nOSCDispatcher::Dispatch() with %i handlers\n", kNVoices * kNParams);
+  failures += RunDispatch("exact", "/synth/12/cutoff", 1, nMessages * 10);
+  failures += RunDispatch("no match", "/synth/12/feedback", 0, nMessages * 10);
+  failures += RunDispatch("?", "/synth/?/gain", 9, nMessages);
+  failures += RunDispatch("*", "/synth/*/cutoff", kNVoices, nMessages);
+  failures += RunDispatch("{} and []", "/synth/{1,2,3}/[a-d]*", 9, nMessages);
+
+  return failures ? 1 : 0;
+}
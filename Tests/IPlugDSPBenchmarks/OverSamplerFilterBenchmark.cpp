@@ -0,0 +1,306 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Measures the quality and the cost of OverSampler's IIR filters and of its linear-phase FIR filters at several stop band attenuations, in double.
+// For each it prints the latency, the pass band ripple, the rejection of the up-sampling image and of tones at the higher rate that would alias into
+// the pass band, and the time per stereo block at 2x and 16x. Also checks that the FIR filters return an exactly delayed copy of a pass band sine.
+// Build it with OVERSAMPLER_FIR_FFT to convolve the long kernels with an FFT.
+// Usage: OverSamplerFilterBenchmark [nBlocks] [nFreqs]
+
+#include <algorithm>
+#include <cassert> // The HIIR headers use assert() without including it
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Oversampler.h"
+
+using namespace iplug;
+
+static constexpr int kBlockSize = 512;
+static constexpr int kMeasureLength = 4096; // Tones are a whole number of cycles in this many samples at the original rate
+static constexpr int kSettleLength = 4096; // Longer than the latency of any filter here
+
+struct Config
+{
+  const char* name;
+  EOverSamplingFilter filter;
+  double stopbandDB;
+  double passbandEdge;
+};
+
+struct Measurement
+{
+  int latency[2]; // 2x, 16x
+  double rippleDB;
+  double imageDB;
+  double aliasDB[2];
+  double usPerBlock[2];
+};
+
+/** @return The level in dB of the component of x at bin cycles per n samples, which must be a whole number of cycles */
+static double ToneLevelDB(const double* x, int n, int64_t bin)
+{
+  std::complex<double> sum = 0.;
+
+  for (int i = 0; i < n; i++)
+    sum += x[i] * std::polar(1., -2. * PI * static_cast<double>((bin * i) % n) / n);
+
+  return 20. * std::log10(2. * std::abs(sum) / n + 1e-30);
+}
+
+/** A sine with a whole number of cycles per period, computed from the phase modulo the period so that it stays exact */
+static double Tone(int64_t bin, int64_t i, int64_t period)
+{
+  return std::sin(2. * PI * static_cast<double>((bin * i) % period) / period);
+}
+
+static std::unique_ptr<OverSampler<double>> MakeOverSampler(const Config& config, EFactor factor, int nChans)
+{
+  auto pOverSampler = std::make_unique<OverSampler<double>>(factor, true, nChans, nChans, config.filter);
+
+  if (config.filter == EOverSamplingFilter::kLinearPhaseFIR)
+    pOverSampler->SetFilter(config.filter, config.stopbandDB, config.passbandEdge);
+
+  pOverSampler->Reset(kBlockSize);
+  return pOverSampler;
+}
+
+/** Runs kSettleLength + kMeasureLength samples through an OverSampler. The input is a sine at inBin, and the function adds a sine at upBin, in cycles
+ * per kMeasureLength * rate samples at the higher rate. Keeps the last kMeasureLength samples of the output and kMeasureLength * rate of the up-sampled input */
+static void RunTones(const Config& config, EFactor factor, int rate, int64_t inBin, int64_t upBin, std::vector<double>& output, std::vector<double>& upsampled)
+{
+  auto pOverSampler = MakeOverSampler(config, factor, 1);
+  const int length = kSettleLength + kMeasureLength;
+  std::vector<double> input(length);
+  int64_t upPos = 0;
+
+  output.assign(length, 0.);
+  upsampled.assign(static_cast<size_t>(length) * rate, 0.);
+
+  for (int i = 0; i < length; i++)
+    input[i] = inBin ? Tone(inBin, i, kMeasureLength) : 0.;
+
+  auto func = [&](double** in, double** out, int nFrames) {
+    for (int i = 0; i < nFrames; i++, upPos++)
+    {
+      upsampled[upPos] = in[0][i];
+      out[0][i] = in[0][i] + (upBin ? Tone(upBin, upPos, static_cast<int64_t>(kMeasureLength) * rate) : 0.);
+    }
+  };
+
+  for (int b = 0; b < length; b += kBlockSize)
+  {
+    double* pIn = input.data() + b;
+    double* pOut = output.data() + b;
+    pOverSampler->ProcessBlock(&pIn, &pOut, kBlockSize, 1, 1, func);
+  }
+
+  output.erase(output.begin(), output.begin() + kSettleLength);
+  upsampled.erase(upsampled.begin(), upsampled.begin() + static_cast<size_t>(kSettleLength) * rate);
+}
+
+/** @return The worst level at the output of tones at the higher rate that would alias into the pass band, at nFreqs frequencies */
+static double MeasureAlias(const Config& config, EFactor factor, int rate, int nFreqs)
+{
+  std::vector<double> output, upsampled;
+  const int64_t first = static_cast<int64_t>(std::ceil((1. - config.passbandEdge) * kMeasureLength));
+  const int64_t last = static_cast<int64_t>(kMeasureLength) * rate / 2 - 1;
+  double worst = -1000.;
+
+  for (int f = 0; f < nFreqs; f++)
+  {
+    // Includes the frequencies in between the images of the pass band, which alias into the transition band, but must still be rejected by the later stages
+    const int64_t upBin = first + (last - first) * f / std::max(nFreqs - 1, 1);
+    int64_t outBin = upBin % kMeasureLength;
+
+    if (outBin > kMeasureLength / 2)
+      outBin = kMeasureLength - outBin;
+
+    if (outBin > config.passbandEdge * kMeasureLength)
+      continue;
+
+    RunTones(config, factor, rate, 0, upBin, output, upsampled);
+    worst = std::max(worst, ToneLevelDB(output.data(), kMeasureLength, outBin));
+  }
+
+  return worst;
+}
+
+/** @return The time per block of stereo noise with a pass-through function in us, best of 3 */
+static double MeasureCPU(const Config& config, EFactor factor, int nBlocks)
+{
+  auto pOverSampler = MakeOverSampler(config, factor, 2);
+  std::vector<double> inBuffer(2 * kBlockSize), outBuffer(2 * kBlockSize);
+  double* inputs[2] = { inBuffer.data(), inBuffer.data() + kBlockSize };
+  double* outputs[2] = { outBuffer.data(), outBuffer.data() + kBlockSize };
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> noise(-1., 1.);
+  double best = 0.;
+
+  auto passThrough = [](double** in, double** out, int nFrames) {
+    for (int c = 0; c < 2; c++)
+      std::copy(in[c], in[c] + nFrames, out[c]);
+  };
+
+  for (int r = 0; r < 3; r++)
+  {
+    double elapsed = 0.;
+
+    for (int b = 0; b < nBlocks; b++)
+    {
+      for (double& x : inBuffer)
+        x = noise(generator);
+
+      const auto start = std::chrono::steady_clock::now();
+      pOverSampler->ProcessBlock(inputs, outputs, kBlockSize, 2, 2, passThrough);
+      elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const double usPerBlock = elapsed * 1e6 / nBlocks;
+    best = r == 0 ? usPerBlock : std::min(best, usPerBlock);
+  }
+
+  return best;
+}
+
+/** @return The largest difference between a pass band sine at 0.43 fs and the output, delayed by the latency, at every factor */
+static double MeasureDelayedCopyError(const Config& config)
+{
+  const int64_t bin = static_cast<int64_t>(0.43 * kMeasureLength);
+  double worst = 0.;
+
+  for (EFactor factor : {k2x, k4x, k8x, k16x})
+  {
+    auto pOverSampler = MakeOverSampler(config, factor, 1);
+    const int latency = pOverSampler->GetLatency();
+    const int length = kSettleLength + kMeasureLength;
+    std::vector<double> input(length), output(length);
+
+    for (int i = 0; i < length; i++)
+      input[i] = Tone(bin, i, kMeasureLength);
+
+    auto passThrough = [](double** in, double** out, int nFrames) {
+      std::copy(in[0], in[0] + nFrames, out[0]);
+    };
+
+    for (int b = 0; b < length; b += kBlockSize)
+    {
+      double* pIn = input.data() + b;
+      double* pOut = output.data() + b;
+      pOverSampler->ProcessBlock(&pIn, &pOut, kBlockSize, 1, 1, passThrough);
+    }
+
+    for (int i = kSettleLength; i < length; i++)
+      worst = std::max(worst, std::fabs(output[i] - input[i - latency]));
+  }
+
+  return worst;
+}
+
+static Measurement Measure(const Config& config, int nBlocks, int nFreqs)
+{
+  Measurement m;
+  std::vector<double> output, upsampled;
+
+  m.latency[0] = MakeOverSampler(config, k2x, 1)->GetLatency();
+  m.latency[1] = MakeOverSampler(config, k16x, 1)->GetLatency();
+
+  // Pass band ripple through the up-sampler and the down-sampler, and the up-sampler's image of each tone at 1 - f
+  m.rippleDB = 0.;
+  m.imageDB = -1000.;
+
+  for (int f = 0; f < nFreqs; f++)
+  {
+    const int64_t bin = 1 + static_cast<int64_t>(config.passbandEdge * kMeasureLength - 1) * f / std::max(nFreqs - 1, 1);
+
+    RunTones(config, k2x, 2, bin, 0, output, upsampled);
+    m.rippleDB = std::max(m.rippleDB, std::fabs(ToneLevelDB(output.data(), kMeasureLength, bin)));
+    m.imageDB = std::max(m.imageDB, ToneLevelDB(upsampled.data(), kMeasureLength * 2, kMeasureLength - bin));
+  }
+
+  m.aliasDB[0] = MeasureAlias(config, k2x, 2, nFreqs);
+  m.aliasDB[1] = MeasureAlias(config, k16x, 16, nFreqs);
+  m.usPerBlock[0] = MeasureCPU(config, k2x, nBlocks);
+  m.usPerBlock[1] = MeasureCPU(config, k16x, nBlocks);
+
+  return m;
+}
+
+int main(int argc, char* argv[])
+{
+  const int nBlocks = argc > 1 ? std::max(1, atoi(argv[1])) : 1000;
+  const int nFreqs = argc > 2 ? std::max(2, atoi(argv[2])) : 64;
+  int failures = 0;
+
+  const Config configs[] = {
+    {"IIR (HIIR)", EOverSamplingFilter::kIIR, 0., 0.45},
+    {"FIR 100 dB / 0.45", EOverSamplingFilter::kLinearPhaseFIR, 100., 0.45},
+    {"FIR 120 dB / 0.45", EOverSamplingFilter::kLinearPhaseFIR, 120., 0.45},
+    {"FIR 140 dB / 0.48", EOverSamplingFilter::kLinearPhaseFIR, 140., 0.48},
+    {"FIR 150 dB / 0.49", EOverSamplingFilter::kLinearPhaseFIR, 150., 0.49}
+  };
+
+#ifdef OVERSAMPLER_FIR_FFT
+  const char* convolution = "FFT for kernels of 128 taps or more";
+#else
+  const char* convolution = "direct";
+#endif
+
+  printf("Double precision, FIR convolution: %s\n", convolution);
+  printf("Latency in samples at the original rate. Ripple is the largest gain error up to the pass band edge, image and alias are the worst levels\n");
+  printf("of the up-sampler's image and of tones at the higher rate that fold into the pass band, in dB relative to a full scale sine.\n");
+  printf("Times are per block of %i stereo frames with a pass-through function, %i frequencies per sweep, %i blocks\n\n", kBlockSize, nFreqs, nBlocks);
+  printf("%-18s %7s %7s %10s %9s %10s %10s %10s %10s\n", "", "lat 2x", "lat 16x", "ripple dB", "image dB", "alias 2x", "alias 16x", "us 2x", "us 16x");
+
+  for (const Config& config : configs)
+  {
+    const Measurement m = Measure(config, nBlocks, nFreqs);
+
+    printf("%-18s %7i %7i %10.2g %9.1f %10.1f %10.1f %10.1f %10.1f\n", config.name, m.latency[0], m.latency[1], m.rippleDB, m.imageDB,
+           m.aliasDB[0], m.aliasDB[1], m.usPerBlock[0], m.usPerBlock[1]);
+
+    if (config.filter != EOverSamplingFilter::kLinearPhaseFIR)
+      continue;
+
+    // DesignHalfBandFIR() uses Kaiser's estimate of the length, which is optimistic for the short filters of the later stages, so they can fall up to
+    // about 7 dB short of the nominal attenuation. The pass band ripple of a half-band filter is its stop band ripple, and at 16x the sine goes through 8
+    const double ripple = 8. * std::pow(10., (7. - config.stopbandDB) / 20.);
+    const double copyError = MeasureDelayedCopyError(config);
+
+    if (copyError > ripple)
+    {
+      fprintf(stderr, "%s: a sine at 0.43 fs is not a delayed copy of the input, the error is %g\n", config.name, copyError);
+      failures++;
+    }
+
+    const double limit = 7. - config.stopbandDB;
+
+    if (m.imageDB > limit || m.aliasDB[0] > limit || m.aliasDB[1] > limit)
+    {
+      fprintf(stderr, "%s: the stop band attenuation is less than %g dB\n", config.name, -limit);
+      failures++;
+    }
+
+    if (m.rippleDB > 0.001)
+    {
+      fprintf(stderr, "%s: the pass band ripple is %g dB\n", config.name, m.rippleDB);
+      failures++;
+    }
+  }
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Oversamples blocks of noise through OverSampler's IIR filters with a pass-through function, for stereo and 7.1 in float and double, and prints
+// the time per block with each channel in its own single channel OverSampler (the scalar filters) and with all channels in one OverSampler, which
+// runs four channels at once in SIMD lanes. Also checks that both give the same output.
+// Build it with and without IPLUG_SIMDE (and with AVX) to compare the vector paths with plain arrays.
+// Usage: OverSamplerLanesBenchmark [nBlocks] [nRuns]
+
+#include <algorithm>
+#include <cassert> // The HIIR headers use assert() without including it
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Oversampler.h"
+
+using namespace iplug;
+
+static constexpr int kBlockSize = 512;
+
+template <typename T>
+struct Result
+{
+  double usPerBlock;
+  std::vector<T> output;
+};
+
+/** Oversamples nBlocks of noise with nChans channels, best time of nRuns. With inLanes, one OverSampler has all the channels, otherwise each has one */
+template <typename T>
+static Result<T> Run(EFactor factor, int nChans, bool inLanes, int nBlocks, int nRuns)
+{
+  std::vector<T> inBuffer(nChans * kBlockSize), outBuffer(nChans * kBlockSize);
+  std::vector<T*> inputs(nChans), outputs(nChans);
+
+  for (int c = 0; c < nChans; c++)
+  {
+    inputs[c] = inBuffer.data() + c * kBlockSize;
+    outputs[c] = outBuffer.data() + c * kBlockSize;
+  }
+
+  auto passThrough = [nChans](T** in, T** out, int nFrames) {
+    for (int c = 0; c < nChans; c++)
+      std::copy(in[c], in[c] + nFrames, out[c]);
+  };
+
+  auto passThroughMono = [](T** in, T** out, int nFrames) {
+    std::copy(in[0], in[0] + nFrames, out[0]);
+  };
+
+  Result<T> result;
+
+  for (int r = 0; r < nRuns; r++)
+  {
+    std::vector<std::unique_ptr<OverSampler<T>>> overSamplers;
+
+    for (int i = 0; i < (inLanes ? 1 : nChans); i++)
+    {
+      const int n = inLanes ? nChans : 1;
+      overSamplers.push_back(std::make_unique<OverSampler<T>>(factor, true, n, n));
+      overSamplers.back()->Reset(kBlockSize);
+    }
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> noise(-1., 1.);
+    std::vector<T> output;
+    double elapsed = 0.;
+
+    for (int b = 0; b < nBlocks; b++)
+    {
+      for (T& x : inBuffer)
+        x = static_cast<T>(noise(generator));
+
+      const auto start = std::chrono::steady_clock::now();
+
+      if (inLanes)
+        overSamplers[0]->ProcessBlock(inputs.data(), outputs.data(), kBlockSize, nChans, nChans, passThrough);
+      else
+      {
+        for (int c = 0; c < nChans; c++)
+          overSamplers[c]->ProcessBlock(&inputs[c], &outputs[c], kBlockSize, 1, 1, passThroughMono);
+      }
+
+      elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      if (r == 0)
+        output.insert(output.end(), outBuffer.begin(), outBuffer.end());
+    }
+
+    const double usPerBlock = elapsed * 1e6 / nBlocks;
+
+    if (r == 0)
+    {
+      result.usPerBlock = usPerBlock;
+      result.output = std::move(output);
+    }
+    else
+      result.usPerBlock = std::min(result.usPerBlock, usPerBlock);
+  }
+
+  return result;
+}
+
+template <typename T>
+static int RunAll(const char* type, int nBlocks, int nRuns)
+{
+  const std::pair<EFactor, int> factors[] = { {k2x, 2}, {k4x, 4}, {k8x, 8}, {k16x, 16} };
+  int failures = 0;
+
+  for (int nChans : {2, 8})
+  {
+    for (const auto& factor : factors)
+    {
+      const Result<T> scalar = Run<T>(factor.first, nChans, false, nBlocks, nRuns);
+      const Result<T> lanes = Run<T>(factor.first, nChans, true, nBlocks, nRuns);
+
+      printf("%8s %10s %8ix %14.1f %14.1f %10.2f\n", type, nChans == 2 ? "stereo" : "7.1", factor.second,
+             scalar.usPerBlock, lanes.usPerBlock, scalar.usPerBlock / lanes.usPerBlock);
+
+      if (lanes.output != scalar.output)
+      {
+        fprintf(stderr, "%s %i channels at %ix: the lanes differ from the scalar filters\n", type, nChans, factor.second);
+        failures++;
+      }
+    }
+  }
+
+  return failures;
+}
+
+int main(int argc, char* argv[])
+{
+  const int nBlocks = argc > 1 ? std::max(1, atoi(argv[1])) : 1000;
+  const int nRuns = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+
+#if !defined IPLUG_SIMDE
+  const char* path = "plain arrays";
+#elif defined __AVX__
+  const char* path = "SSE2 + AVX";
+#else
+  const char* path = "SSE2";
+#endif
+
+  printf("%i blocks of %i frames with a pass-through function, best of %i, %s\n", nBlocks, kBlockSize, nRuns, path);
+  printf("Times are in us per block, scalar is one OverSampler per channel\n\n");
+  printf("%8s %10s %9s %14s %14s %10s\n", "type", "channels", "factor", "scalar", "lanes", "speedup");
+
+  const int failures = RunAll<float>("float", nBlocks, nRuns) + RunAll<double>("double", nBlocks, nRuns);
+
+  return failures ? 1 : 0;
+}
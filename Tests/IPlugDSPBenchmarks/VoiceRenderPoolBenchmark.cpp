@@ -0,0 +1,154 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Renders blocks of busy synth voices with VoiceAllocator, for a range of voice and render thread counts, and prints the mean and worst block times
+// as a fraction of the block period, and the speedup over rendering on the calling thread only. Also checks that every thread count gives the same output.
+// Usage: VoiceRenderPoolBenchmark [nBlocks] [maxThreads]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "VoiceAllocator.h"
+
+using namespace iplug;
+
+static constexpr double kSampleRate = 48000.;
+static constexpr int kBlockSize = 128;
+static constexpr int kNumChannels = 2;
+
+/** A voice that is always busy, with a few detuned saws through a saturating one-pole filter, roughly the cost of a simple virtual analog voice */
+class BenchmarkVoice final : public SynthVoice
+{
+public:
+  static constexpr int kNumOscs = 8;
+
+  explicit BenchmarkVoice(int voiceIdx)
+  {
+    const double freq = 55. * std::pow(2., (voiceIdx % 48) / 12.);
+
+    for (int o = 0; o < kNumOscs; o++)
+      mIncrements[o] = freq * (1. + 0.003 * (o - kNumOscs / 2)) / kSampleRate;
+  }
+
+  bool GetBusy() const override { return true; }
+
+  void ProcessSamplesAccumulating(sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIdx, int nFrames) override
+  {
+    for (int s = startIdx; s < startIdx + nFrames; s++)
+    {
+      double sum = 0.;
+
+      for (int o = 0; o < kNumOscs; o++)
+      {
+        mPhases[o] += mIncrements[o];
+        mPhases[o] -= std::floor(mPhases[o]);
+        sum += 2. * mPhases[o] - 1.;
+      }
+
+      mState += 0.2 * (std::tanh(sum * 0.25) - mState);
+
+      for (int c = 0; c < nOutputs; c++)
+        outputs[c][s] += mState * 0.05;
+    }
+  }
+
+private:
+  double mPhases[kNumOscs] = {};
+  double mIncrements[kNumOscs];
+  double mState = 0.;
+};
+
+struct Result
+{
+  double meanLoad;
+  double maxLoad;
+  std::vector<double> output;
+};
+
+static Result Render(int nVoices, int nThreads, int nBlocks)
+{
+  VoiceAllocator allocator;
+  std::vector<std::unique_ptr<BenchmarkVoice>> voices;
+
+  for (int v = 0; v < nVoices; v++)
+  {
+    voices.push_back(std::make_unique<BenchmarkVoice>(v));
+    allocator.AddVoice(voices.back().get(), 0);
+  }
+
+  allocator.SetSampleRateAndBlockSize(kSampleRate, kBlockSize);
+  allocator.SetNumRenderThreads(nThreads, kNumChannels);
+
+  std::vector<sample> buffer(kNumChannels * kBlockSize);
+  sample* outputs[kNumChannels] = { buffer.data(), buffer.data() + kBlockSize };
+  const double blockPeriod = kBlockSize / kSampleRate;
+  double total = 0., worst = 0.;
+  Result result;
+
+  for (int b = 0; b < nBlocks; b++)
+  {
+    std::fill(buffer.begin(), buffer.end(), 0.);
+
+    const auto start = std::chrono::steady_clock::now();
+    allocator.ProcessVoices(nullptr, outputs, 0, kNumChannels, 0, kBlockSize);
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    total += elapsed;
+    worst = std::max(worst, elapsed);
+    result.output.insert(result.output.end(), buffer.begin(), buffer.begin() + kBlockSize);
+  }
+
+  result.meanLoad = total / nBlocks / blockPeriod;
+  result.maxLoad = worst / blockPeriod;
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  const int nBlocks = argc > 1 ? std::max(1, atoi(argv[1])) : 2000;
+  const int nCores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  const int maxThreads = argc > 2 ? std::max(1, atoi(argv[2])) : std::min(nCores, 8);
+  int result = 0;
+
+  printf("%i blocks of %i samples at %g Hz, %i cores\n", nBlocks, kBlockSize, kSampleRate, nCores);
+  printf("Load is the block time as a percentage of the block period, speedup is relative to 1 thread\n\n");
+  printf("%8s %8s %12s %12s %10s\n", "voices", "threads", "mean load", "worst load", "speedup");
+
+  for (int nVoices : {8, 32, 64, 128})
+  {
+    const Result serial = Render(nVoices, 1, nBlocks);
+    printf("%8i %8i %11.1f%% %11.1f%% %10.2f\n", nVoices, 1, serial.meanLoad * 100., serial.maxLoad * 100., 1.);
+
+    for (int nThreads = 2; nThreads <= maxThreads; nThreads++)
+    {
+      const Result parallel = Render(nVoices, nThreads, nBlocks);
+      printf("%8i %8i %11.1f%% %11.1f%% %10.2f\n", nVoices, nThreads, parallel.meanLoad * 100., parallel.maxLoad * 100., serial.meanLoad / parallel.meanLoad);
+
+      // buses are summed in a fixed order, but voices are grouped differently for each thread count
+      for (size_t s = 0; s < serial.output.size(); s++)
+      {
+        if (std::fabs(parallel.output[s] - serial.output[s]) > 1e-9)
+        {
+          fprintf(stderr, "%i voices on %i threads differ from 1 thread at sample %i\n", nVoices, nThreads, static_cast<int>(s));
+          result = 1;
+          break;
+        }
+      }
+    }
+  }
+
+  return result;
+}
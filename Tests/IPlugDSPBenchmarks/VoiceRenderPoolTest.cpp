@@ -0,0 +1,122 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+// Stress test of VoiceRenderPool: runs many short blocks with job counts that change from one Run() to the next, and checks that every job
+// index of every Run() is executed exactly once, with that Run()'s function and context, and never after Run() has returned.
+// Runs once with workers that sleep between blocks and once with workers that spin, which is where they race with the next Run().
+// Usage: VoiceRenderPoolTest [nRuns] [nWorkers]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include "VoiceRenderPool.h"
+
+using namespace iplug;
+
+static constexpr int kMaxTestJobs = 64;
+static constexpr int kNContexts = 3;
+
+/** The state of one Run(). These take turns, so that a job executed with the context of another Run() is counted in the wrong one */
+struct Context
+{
+  bool usesOtherFunc = false; // The last context is run with OtherJob() rather than Job()
+  std::atomic<bool> active{false};
+  std::atomic<int> nFailures{0};
+  std::atomic<int> counts[kMaxTestJobs];
+
+  Context()
+  {
+    for (auto& count : counts)
+      count.store(0);
+  }
+
+  void Count(bool otherFunc, int jobIdx)
+  {
+    if (otherFunc != usesOtherFunc || !active.load(std::memory_order_acquire) || jobIdx < 0 || jobIdx >= kMaxTestJobs)
+      nFailures.fetch_add(1);
+    else
+      counts[jobIdx].fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+static void Job(void* pContext, int jobIdx)
+{
+  static_cast<Context*>(pContext)->Count(false, jobIdx);
+}
+
+/** A second job function, so that a job executed with the function of another Run() is detected */
+static void OtherJob(void* pContext, int jobIdx)
+{
+  static_cast<Context*>(pContext)->Count(true, jobIdx);
+}
+
+static int RunTest(const char* name, int nRuns, int nWorkers, int idleSpinUs)
+{
+  VoiceRenderPool pool;
+  pool.Start(nWorkers, idleSpinUs);
+
+  Context contexts[kNContexts];
+  contexts[kNContexts - 1].usesOtherFunc = true;
+
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int> nJobsDist(0, kMaxTestJobs);
+  int failures = 0;
+
+  for (int r = 0; r < nRuns; r++)
+  {
+    Context& context = contexts[r % kNContexts];
+    // Alternate small and large job counts, so that a worker that saw the job index of a small run and then the job count of a large one
+    // would claim a job that does not exist
+    const int nJobs = (r % 2) ? nJobsDist(generator) : std::min(nJobsDist(generator), 2);
+
+    context.active.store(true, std::memory_order_release);
+    pool.Run(nJobs, context.usesOtherFunc ? OtherJob : Job, &context);
+    context.active.store(false, std::memory_order_release);
+
+    bool ok = context.nFailures.exchange(0) == 0;
+
+    for (int i = 0; i < kMaxTestJobs; i++)
+      ok &= context.counts[i].exchange(0, std::memory_order_relaxed) == (i < nJobs ? 1 : 0);
+
+    if (!ok && !failures++)
+      fprintf(stderr, "%s: run %i with %i jobs did not execute each job exactly once with its own function and context\n", name, r, nJobs);
+  }
+
+  // Jobs that are executed after their Run() returned
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  pool.Stop();
+
+  for (auto& context : contexts)
+  {
+    failures += context.nFailures.load();
+
+    for (int i = 0; i < kMaxTestJobs; i++)
+      failures += context.counts[i].load();
+  }
+
+  printf("%-10s %8i runs on %i workers: %s\n", name, nRuns, nWorkers, failures ? "FAILED" : "ok");
+  return failures;
+}
+
+int main(int argc, char* argv[])
+{
+  const int nRuns = argc > 1 ? std::max(1, atoi(argv[1])) : 200000;
+  const int nWorkers = argc > 2 ? std::max(1, atoi(argv[2])) : std::max(3, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+
+  // Workers that always sleep after a block and have to be woken, and workers that spin through the whole test
+  const int failures = RunTest("sleeping", nRuns, nWorkers, 0) + RunTest("spinning", nRuns, nWorkers, 1000000);
+
+  return failures ? 1 : 0;
+}
@@ -28,10 +28,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
+#include <atomic>
 #include "convoengine.h"
 
 #include "denormal.h"
 
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+#endif
+
 //#define TIMING
 #include "timing.c"
 
@@ -710,17 +720,144 @@ void WDL_ConvolutionEngine::Advance(int len)
 **  low latency version
 */
 
+// auto-reset event
+class WDL_ConvoEngine_Signal
+{
+public:
+#ifdef _WIN32
+  WDL_ConvoEngine_Signal() { m_ev=CreateEvent(NULL,FALSE,FALSE,NULL); }
+  ~WDL_ConvoEngine_Signal() { CloseHandle(m_ev); }
+
+  void Set() { SetEvent(m_ev); }
+  void Wait(int ms) { WaitForSingleObject(m_ev,ms); }
+
+private:
+  HANDLE m_ev;
+#else
+  WDL_ConvoEngine_Signal()
+  {
+    m_set=false;
+    pthread_mutex_init(&m_mutex,NULL);
+    pthread_cond_init(&m_cond,NULL);
+  }
+  ~WDL_ConvoEngine_Signal()
+  {
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+  }
+
+  void Set()
+  {
+    pthread_mutex_lock(&m_mutex);
+    m_set=true;
+    pthread_cond_signal(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+  }
+  void Wait(int ms)
+  {
+    struct timeval tv;
+    gettimeofday(&tv,NULL);
+    long long ns = (tv.tv_usec + ms*1000LL) * 1000LL;
+    struct timespec ts;
+    ts.tv_sec = tv.tv_sec + (time_t)(ns/1000000000LL);
+    ts.tv_nsec = (long)(ns%1000000000LL);
+
+    pthread_mutex_lock(&m_mutex);
+    while (!m_set)
+    {
+      if (pthread_cond_timedwait(&m_cond,&m_mutex,&ts) == ETIMEDOUT) break;
+    }
+    m_set=false;
+    pthread_mutex_unlock(&m_mutex);
+  }
+
+private:
+  pthread_mutex_t m_mutex;
+  pthread_cond_t m_cond;
+  bool m_set;
+#endif
+};
+
+// Add() and Avail() hand a partition's input to the threads a block (fftsize/2 samples) at a time, through slots allocated by TailPrime().
+// A slot goes FREE -> QUEUED (input copied in by the audio thread) -> DONE (output written over it by whoever ran it) -> FREE (output
+// collected by the audio thread), so neither side locks or allocates. Three slots let one block run while the next is queued and the
+// previous one waits to be collected.
+struct WDL_ConvolutionEngine_Div::TailJob
+{
+  enum { NSLOTS=3 };
+  enum { SLOT_FREE=0, SLOT_QUEUED, SLOT_DONE };
+
+  struct Slot
+  {
+    Slot() : state(SLOT_FREE) { len=0; }
+
+    std::atomic<int> state;
+    int len; // output samples per channel, when DONE
+    WDL_TypedBuf<WDL_FFT_REAL> buf;
+    WDL_TypedBuf<WDL_FFT_REAL *> ptrs; // a block per channel in buf
+  };
+
+  TailJob() : busy(false), queued(0), lead(0) { nch=0; submit_pos=collect_pos=run_pos=0; }
+  ~TailJob() { in.Empty(true); out.Empty(true); }
+
+  int BlockSize() { return eng.GetFFTSize()/2; }
+  int InAvail() { return in.GetSize() ? (int) (in.Get(0)->Available()/sizeof(WDL_FFT_REAL)) : 0; }
+  int OutAvail() { return out.GetSize() ? (int) (out.Get(0)->Available()/sizeof(WDL_FFT_REAL)) : 0; }
+
+  Slot slots[NSLOTS];
+  int nch;
+
+  // owned by whoever set busy, which the threads only do under m_tail_mutex
+  std::atomic<bool> busy;
+  WDL_ConvolutionEngine eng;
+  int run_pos;
+
+  std::atomic<int> queued; // slots waiting to run
+  std::atomic<int> lead; // output samples computed ahead of the audio thread, TailPickJob() runs the smallest first
+
+  // owned by the audio thread
+  WDL_PtrList<WDL_Queue> in, out;
+  int submit_pos, collect_pos;
+};
+
+struct WDL_ConvolutionEngine_Div::TailThreads
+{
+  TailThreads(WDL_ConvolutionEngine_Div *div, int nthreads);
+  ~TailThreads();
+
+  void Run();
+
+  WDL_ConvolutionEngine_Div *m_div;
+  WDL_ConvoEngine_Signal m_work, m_done;
+  int m_kill; // owned by m_div->m_tail_mutex
+
+#ifdef _WIN32
+  WDL_TypedBuf<HANDLE> m_threads;
+  static unsigned WINAPI ThreadProc(void *p) { ((TailThreads *)p)->Run(); return 0; }
+#else
+  WDL_TypedBuf<pthread_t> m_threads;
+  static void *ThreadProc(void *p) { ((TailThreads *)p)->Run(); return NULL; }
+#endif
+};
+
 WDL_ConvolutionEngine_Div::WDL_ConvolutionEngine_Div()
 {
   timingInit();
   for (int x = 0; x < 2; x ++) m_sout.Add(new WDL_Queue);
   m_need_feedsilence=true;
+  m_tail_threads=NULL;
+  m_tail_nthreads=m_tail_fftsize=m_tail_nch=m_tail_misses=m_tail_waits=0;
 }
 
 int WDL_ConvolutionEngine_Div::SetImpulse(WDL_ImpulseBuffer *impulse, int maxfft_size, int known_blocksize, int max_imp_size, int impulse_offset, int latency_allowed)
 {
   m_need_feedsilence=true;
 
+  m_tail_mutex.Enter();
+  TailWaitIdle();
+  m_tail.Empty(true);
+  m_tail_misses=m_tail_waits=0;
+
   m_engines.Empty(true);
   if (maxfft_size<0)maxfft_size=-maxfft_size;
   maxfft_size*=2;
@@ -745,25 +882,49 @@ int WDL_ConvolutionEngine_Div::SetImpulse(WDL_ImpulseBuffer *impulse, int maxfft
     fftsize=impulsechunksize=x;
   }
 
+  int tail_fftsize=0;
+  if (m_tail_nthreads>0)
+  {
+    tail_fftsize = m_tail_fftsize>0 ? m_tail_fftsize : known_blocksize*8;
+    if (tail_fftsize<4096) tail_fftsize=4096;
+  }
+
   int offs=0;
   int samplesleft=impulse->impulses[0].GetSize()-impulse_offset;
   if (max_imp_size>0 && samplesleft>max_imp_size) samplesleft=max_imp_size;
 
   do
   {
-    WDL_ConvolutionEngine *eng=new WDL_ConvolutionEngine;
+    TailJob *job=NULL;
+    WDL_ConvolutionEngine *eng;
 
     bool wantBrute = !latency_allowed && !offs;
-    if (impulsechunksize*(wantBrute ? 2 : 3) >= samplesleft) impulsechunksize=samplesleft; // early-out, no point going to a larger FFT (since if we did this, we wouldnt have enough samples for a complete next pass)
-    if (fftsize>=maxfft_size) { impulsechunksize=samplesleft; fftsize=maxfft_size; } // if FFTs are as large as possible, finish up
+    if (tail_fftsize>0 && offs>=tail_fftsize)
+    {
+      // the input for a block of fftsize/2 samples is complete fftsize/2 samples before its output is due at offs,
+      // which leaves the threads that long to compute it
+      job=new TailJob;
+      eng=&job->eng;
+      fftsize=16;
+      while (fftsize*2 <= offs && fftsize*2 <= maxfft_size) fftsize*=2;
+      impulsechunksize=offs;
+      if (impulsechunksize*2 >= samplesleft || fftsize>=maxfft_size) impulsechunksize=samplesleft;
+    }
+    else
+    {
+      eng=new WDL_ConvolutionEngine;
+      if (impulsechunksize*(wantBrute ? 2 : 3) >= samplesleft) impulsechunksize=samplesleft; // early-out, no point going to a larger FFT (since if we did this, we wouldnt have enough samples for a complete next pass)
+      if (fftsize>=maxfft_size) { impulsechunksize=samplesleft; fftsize=maxfft_size; } // if FFTs are as large as possible, finish up
+    }
 
     eng->SetImpulse(impulse,fftsize,offs+impulse_offset,impulsechunksize, wantBrute);
     eng->m_zl_delaypos = offs;
     eng->m_zl_dumpage=0;
-    m_engines.Add(eng);
+    if (job) m_tail.Add(job);
+    else m_engines.Add(eng);
 
 #ifdef WDLCONVO_ZL_ACCOUNTING
-    wdl_log("ce%d: offs=%d, len=%d, fftsize=%d\n",m_engines.GetSize(),offs,impulsechunksize,fftsize);
+    wdl_log("ce%d: offs=%d, len=%d, fftsize=%d%s\n",m_engines.GetSize()+m_tail.GetSize(),offs,impulsechunksize,fftsize,job?" (thread)":"");
 #endif
 
     samplesleft -= impulsechunksize;
@@ -779,7 +940,21 @@ int WDL_ConvolutionEngine_Div::SetImpulse(WDL_ImpulseBuffer *impulse, int maxfft
 #endif
   }
   while (samplesleft > 0);
-  
+
+  const bool wantThreads = m_tail.GetSize() && m_tail_nthreads>0 && !m_tail_threads;
+  m_tail_mutex.Leave();
+
+  if (wantThreads)
+  {
+    m_tail_threads = new TailThreads(this,m_tail_nthreads);
+    if (!m_tail_threads->m_threads.GetSize())
+    {
+      // no threads, Avail() computes the tail
+      delete m_tail_threads;
+      m_tail_threads=NULL;
+    }
+  }
+
   return GetLatency();
 }
 
@@ -802,12 +977,19 @@ void WDL_ConvolutionEngine_Div::Reset()
     m_sout.Get(x)->Clear();
   }
 
+  m_tail_mutex.Enter();
+  TailWaitIdle();
+  TailPrime(m_tail_nch);
+  m_tail_mutex.Leave();
+
   m_need_feedsilence=true;
 }
 
 WDL_ConvolutionEngine_Div::~WDL_ConvolutionEngine_Div()
 {
   timingPrint();
+  delete m_tail_threads;
+  m_tail.Empty(true);
   m_engines.Empty(true);
   m_sout.Empty(true);
 }
@@ -839,6 +1021,32 @@ void WDL_ConvolutionEngine_Div::Add(WDL_FFT_REAL **bufs, int len, int nch)
     if (ns) eng->AddSilenceToOutput(eng->m_zl_delaypos); // add silence to output (to delay output to its correct time)
 
   }
+
+  if (m_tail.GetSize())
+  {
+    if (ns || nch != m_tail_nch)
+    {
+      // after SetImpulse() or Reset(), or when the channel count changes
+      m_tail_mutex.Enter();
+      TailWaitIdle();
+      TailPrime(nch);
+      m_tail_mutex.Leave();
+    }
+
+    bool wake=false;
+    for (x = 0; x < m_tail.GetSize(); x ++)
+    {
+      TailJob *job=m_tail.Get(x);
+      for (int c = 0; c < nch; c ++)
+      {
+        void *p=job->in.Get(c)->Add(bufs ? bufs[c] : NULL,len*sizeof(WDL_FFT_REAL));
+        if (!bufs && p) memset(p,0,len*sizeof(WDL_FFT_REAL));
+      }
+      if (TailSync(job)) wake=true;
+    }
+
+    if (wake && m_tail_threads) m_tail_threads->m_work.Set();
+  }
 }
 WDL_FFT_REAL **WDL_ConvolutionEngine_Div::Get() 
 {
@@ -902,6 +1110,43 @@ int WDL_ConvolutionEngine_Div::Avail(int wantSamples)
     maxcnt=-1;
   }
 #endif
+
+  if (m_tail.GetSize())
+  {
+    bool wake=false;
+    for (x = 0; x < m_tail.GetSize() && wantSamples>0; x ++)
+    {
+      TailJob *job=m_tail.Get(x);
+      for (;;)
+      {
+        if (TailSync(job)) wake=true;
+        const int a=job->OutAvail();
+        if (a >= wantSamples) break;
+        if (job->queued.load() <= 0)
+        {
+          wantSamples=a;
+          break;
+        }
+
+        if (!job->busy.exchange(true,std::memory_order_acquire))
+        {
+          // missed its deadline, compute it here
+          m_tail_misses++;
+          TailRunJob(job);
+        }
+        else
+        {
+          // a thread is running this partition's next block. This is bounded by the time of one block (at most a few FFTs
+          // of tail_fftsize or larger), and only happens when the threads are this close to the deadline, see GetTailWaits()
+          m_tail_waits++;
+          if (m_tail_threads) m_tail_threads->m_done.Wait(1);
+        }
+      }
+    }
+
+    if (wake && m_tail_threads) m_tail_threads->m_work.Set();
+  }
+
   if (wantSamples>0)
   {
     const int add_sz = wantSamples*sizeof(WDL_FFT_REAL);
@@ -935,6 +1180,30 @@ int WDL_ConvolutionEngine_Div::Avail(int wantSamples)
       }
       eng->Advance(wantSamples);
     }
+
+    for (x = 0; x < m_tail.GetSize(); x ++)
+    {
+      TailJob *job=m_tail.Get(x);
+      const int n = wdl_min(job->out.GetSize(),m_sout.GetSize());
+      for (int i = 0; i < n; i ++)
+      {
+        WDL_Queue *q = m_sout.Get(i), *jq = job->out.Get(i);
+        const int qsz = q->Available();
+        if (WDL_NORMALLY(qsz >= add_sz && jq->Available() >= add_sz))
+        {
+          WDL_FFT_REAL *o=(WDL_FFT_REAL *)((char *)q->Get() + qsz - add_sz);
+          const WDL_FFT_REAL *in=(const WDL_FFT_REAL *)jq->Get();
+          int j=wantSamples;
+          while (j-->0) *o++ += *in++;
+        }
+      }
+      for (int i = 0; i < job->out.GetSize(); i ++)
+      {
+        job->out.Get(i)->Advance(add_sz);
+        job->out.Get(i)->Compact();
+      }
+      job->lead.fetch_sub(wantSamples);
+    }
   }
   timingLeave(1);
 
@@ -944,17 +1213,436 @@ int WDL_ConvolutionEngine_Div::Avail(int wantSamples)
 }
 
 
+/****************************************************************
+**  low latency version, tail partitions on background threads
+*/
+
+WDL_ConvolutionEngine_Div::TailThreads::TailThreads(WDL_ConvolutionEngine_Div *div, int nthreads)
+{
+  m_div=div;
+  m_kill=0;
+  for (int x = 0; x < nthreads; x ++)
+  {
+#ifdef _WIN32
+    unsigned id;
+    HANDLE t=(HANDLE)_beginthreadex(NULL,0,ThreadProc,(void *)this,0,&id);
+    if (t)
+    {
+      SetThreadPriority(t,THREAD_PRIORITY_HIGHEST);
+      m_threads.Add(t);
+    }
+#else
+    // raised priority, falling back to the default where that needs privileges (e.g. linux without an rtprio limit)
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+  #ifdef __APPLE__
+    pthread_attr_set_qos_class_np(&attr,QOS_CLASS_USER_INTERACTIVE,0);
+  #else
+    struct sched_param param;
+    memset(&param,0,sizeof(param));
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO) + (sched_get_priority_max(SCHED_FIFO)-sched_get_priority_min(SCHED_FIFO))/3;
+    pthread_attr_setinheritsched(&attr,PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr,SCHED_FIFO);
+    pthread_attr_setschedparam(&attr,&param);
+  #endif
+    pthread_t t;
+    if (pthread_create(&t,&attr,ThreadProc,(void *)this) == 0 ||
+        pthread_create(&t,NULL,ThreadProc,(void *)this) == 0) m_threads.Add(t);
+    pthread_attr_destroy(&attr);
+#endif
+  }
+}
+
+WDL_ConvolutionEngine_Div::TailThreads::~TailThreads()
+{
+  m_div->m_tail_mutex.Enter();
+  m_kill=1;
+  m_div->m_tail_mutex.Leave();
+
+  for (int x = 0; x < m_threads.GetSize(); x ++)
+  {
+    m_work.Set();
+#ifdef _WIN32
+    WaitForSingleObject(m_threads.Get()[x],INFINITE);
+    CloseHandle(m_threads.Get()[x]);
+#else
+    void *p;
+    pthread_join(m_threads.Get()[x],&p);
+#endif
+  }
+}
+
+void WDL_ConvolutionEngine_Div::TailThreads::Run()
+{
+  for (;;)
+  {
+    m_div->m_tail_mutex.Enter();
+    if (m_kill)
+    {
+      m_div->m_tail_mutex.Leave();
+      break;
+    }
+
+    TailJob *job=m_div->TailPickJob();
+    if (job && job->busy.exchange(true,std::memory_order_acquire)) job=NULL; // Avail() is computing it
+    else if (job && m_div->TailPickJob()) m_work.Set(); // more is ready, wake another thread
+    m_div->m_tail_mutex.Leave();
+
+    if (job)
+    {
+      m_div->TailRunJob(job);
+      m_done.Set();
+    }
+    else m_work.Wait(50);
+  }
+}
+
+void WDL_ConvolutionEngine_Div::SetTailThreads(int nthreads, int tail_fftsize)
+{
+  if (nthreads<0) nthreads=0;
+  if (nthreads != m_tail_nthreads)
+  {
+    delete m_tail_threads;
+    m_tail_threads=NULL;
+  }
+  m_tail_nthreads=nthreads;
+  m_tail_fftsize=tail_fftsize;
+}
+
+WDL_ConvolutionEngine_Div::TailJob *WDL_ConvolutionEngine_Div::TailPickJob()
+{
+  // earliest deadline first: the job with the least output left to play before it runs dry
+  TailJob *best=NULL;
+  int bestdl=0;
+  for (int x = 0; x < m_tail.GetSize(); x ++)
+  {
+    TailJob *job=m_tail.Get(x);
+    if (job->busy.load() || job->queued.load() <= 0) continue;
+
+    const int dl=job->lead.load();
+    if (!best || dl < bestdl) { best=job; bestdl=dl; }
+  }
+  return best;
+}
+
+void WDL_ConvolutionEngine_Div::TailRunJob(TailJob *job)
+{
+  TailJob::Slot *slot=job->slots+job->run_pos;
+  if (slot->state.load(std::memory_order_acquire) == TailJob::SLOT_QUEUED)
+  {
+    const int bs=job->BlockSize(), nch=job->nch;
+    WDL_FFT_REAL **ptrs=slot->ptrs.Get();
+    job->eng.Add(ptrs,bs,nch);
+
+    // a block in makes a block out, written over the input it came from
+    int avail=job->eng.Avail(bs);
+    WDL_FFT_REAL **p=job->eng.Get();
+    if (!p) avail=0;
+    else if (WDL_NOT_NORMALLY(avail > bs)) avail=bs;
+
+    for (int c = 0; c < nch && avail>0; c ++) memcpy(ptrs[c],p[c],avail*sizeof(WDL_FFT_REAL));
+    job->eng.Advance(avail);
+
+    slot->len=avail;
+    job->run_pos=(job->run_pos+1) % TailJob::NSLOTS;
+    job->lead.fetch_add(avail);
+    job->queued.fetch_sub(1);
+    slot->state.store(TailJob::SLOT_DONE,std::memory_order_release);
+  }
+  job->busy.store(false,std::memory_order_release);
+}
+
+bool WDL_ConvolutionEngine_Div::TailSync(TailJob *job)
+{
+  const int nch=job->nch, bs=job->BlockSize();
+  int x;
+  for (;;)
+  {
+    TailJob::Slot *slot=job->slots+job->collect_pos;
+    if (slot->state.load(std::memory_order_acquire) != TailJob::SLOT_DONE) break;
+
+    for (x = 0; x < nch; x ++) job->out.Get(x)->Add(slot->ptrs.Get()[x],slot->len*sizeof(WDL_FFT_REAL));
+    slot->state.store(TailJob::SLOT_FREE,std::memory_order_relaxed);
+    job->collect_pos=(job->collect_pos+1) % TailJob::NSLOTS;
+  }
+
+  bool submitted=false;
+  while (job->InAvail() >= bs)
+  {
+    TailJob::Slot *slot=job->slots+job->submit_pos;
+    if (slot->state.load(std::memory_order_relaxed) != TailJob::SLOT_FREE) break; // all in flight, the rest waits here
+
+    for (x = 0; x < nch; x ++)
+    {
+      WDL_Queue *q=job->in.Get(x);
+      memcpy(slot->ptrs.Get()[x],q->Get(),bs*sizeof(WDL_FFT_REAL));
+      q->Advance(bs*sizeof(WDL_FFT_REAL));
+    }
+    slot->state.store(TailJob::SLOT_QUEUED,std::memory_order_release);
+    job->queued.fetch_add(1);
+    job->submit_pos=(job->submit_pos+1) % TailJob::NSLOTS;
+    submitted=true;
+  }
+  if (submitted) for (x = 0; x < nch; x ++) job->in.Get(x)->Compact();
+  return submitted;
+}
+
+void WDL_ConvolutionEngine_Div::TailWaitIdle()
+{
+  for (;;)
+  {
+    bool busy=false;
+    for (int x = 0; x < m_tail.GetSize() && !busy; x ++) busy=m_tail.Get(x)->busy.load();
+    if (!busy) return;
+
+    m_tail_mutex.Leave();
+    if (m_tail_threads) m_tail_threads->m_done.Wait(1);
+    m_tail_mutex.Enter();
+  }
+}
+
+void WDL_ConvolutionEngine_Div::TailPrime(int nch)
+{
+  m_tail_nch=nch;
+  for (int x = 0; x < m_tail.GetSize(); x ++)
+  {
+    TailJob *job=m_tail.Get(x);
+    job->nch=nch;
+    job->eng.Reset();
+
+    const int bs=job->BlockSize();
+    for (int s = 0; s < TailJob::NSLOTS; s ++)
+    {
+      TailJob::Slot *slot=job->slots+s;
+      WDL_FFT_REAL *buf=slot->buf.ResizeOK(nch*bs,false);
+      WDL_FFT_REAL **ptrs=slot->ptrs.ResizeOK(nch,false);
+      if (WDL_NORMALLY(buf && ptrs)) for (int c = 0; c < nch; c ++) ptrs[c]=buf+c*bs;
+      slot->state.store(TailJob::SLOT_FREE);
+      slot->len=0;
+    }
+    job->submit_pos=job->collect_pos=job->run_pos=0;
+    job->queued.store(0);
+    job->lead.store(job->eng.m_zl_delaypos);
+
+    while (job->in.GetSize() < nch) job->in.Add(new WDL_Queue);
+    while (job->in.GetSize() > nch) job->in.Delete(job->in.GetSize()-1,true);
+    while (job->out.GetSize() < nch) job->out.Add(new WDL_Queue);
+    while (job->out.GetSize() > nch) job->out.Delete(job->out.GetSize()-1,true);
+
+    const int delay_sz=job->eng.m_zl_delaypos*sizeof(WDL_FFT_REAL);
+    for (int c = 0; c < nch; c ++)
+    {
+      job->in.Get(c)->Clear();
+      job->out.Get(c)->Clear();
+      memset(job->out.Get(c)->Add(NULL,delay_sz),0,delay_sz); // delays the output to its correct time
+    }
+  }
+}
+
+
 #ifdef WDL_TEST_CONVO
 
+// build with -DWDL_TEST_CONVO=1 to test WDL_ConvolutionEngine, or =2 to test WDL_ConvolutionEngine_Div and to benchmark its tail threads:
+//   c++ -O2 -DWDL_TEST_CONVO=2 convoengine.cpp fft.c -lpthread
+
 #include <stdio.h>
 
+#if WDL_TEST_CONVO==2
+
+#ifndef _WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// CPU time of the calling thread, so that the audio thread is not charged for the tail threads when they share a core.
+// Windows has no fine grained equivalent, so it is wall time there
+static double convo_test_thread_time()
+{
+#ifdef _WIN32
+  LARGE_INTEGER c,f;
+  QueryPerformanceCounter(&c);
+  QueryPerformanceFrequency(&f);
+  return (double)c.QuadPart/(double)f.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+  return ts.tv_sec + ts.tv_nsec*1.0e-9;
+#endif
+}
+
+static double convo_test_wall_time()
+{
+#ifdef _WIN32
+  LARGE_INTEGER c,f;
+  QueryPerformanceCounter(&c);
+  QueryPerformanceFrequency(&f);
+  return (double)c.QuadPart/(double)f.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec*1.0e-9;
+#endif
+}
+
+static void convo_test_sleep_until(double t)
+{
+  const double now=convo_test_wall_time();
+  if (t <= now) return;
+#ifdef _WIN32
+  Sleep((DWORD)((t-now)*1000.0));
+#else
+  usleep((useconds_t)((t-now)*1000000.0));
+#endif
+}
+
+static int convo_test_cmp_double(const void *a, const void *b)
+{
+  const double da=*(const double *)a, db=*(const double *)b;
+  return da<db ? -1 : da>db ? 1 : 0;
+}
+
+static void convo_test_print_times(const char *name, WDL_TypedBuf<double> *times)
+{
+  const int n=times->GetSize();
+  double *t=times->Get(), sum=0.0;
+  for (int x = 0; x < n; x ++) sum+=t[x];
+  qsort(t,n,sizeof(double),convo_test_cmp_double);
+  printf("%-10s mean %8.1f us  p99.9 %8.1f us  max %8.1f us\n",name,sum/n*1.0e6,t[wdl_min(n-1,(int)(n*0.999))]*1.0e6,t[n-1]*1.0e6);
+}
+
+// Runs blocks of noise through a noise impulse, with the tail computed in Avail() and then on nthreads threads,
+// and prints the time each block takes in the calling (audio) thread. The threaded run is paced in real time
+// so the threads get the time they would in a host. Fails if the outputs differ by more than float rounding
+static int convo_bench(double irlen_s, int blocksize, int nthreads, int nch, double runlen_s)
+{
+  const double srate=48000.0;
+  const int implen=(int)(irlen_s*srate), nblocks=(int)(runlen_s*srate/blocksize);
+  int x, c, b;
+
+  if (implen < 1 || blocksize < 1 || nthreads < 0 || nch < 1 || nch > 8 || nblocks < 1)
+  {
+    printf("invalid parameters\n");
+    return -1;
+  }
+
+  // decaying noise, scaled to unit energy so the output has about the level of the input
+  WDL_ImpulseBuffer imp;
+  imp.samplerate=srate;
+  imp.SetNumChannels(nch,false);
+  imp.SetLength(implen);
+  srand(1);
+  for (c = 0; c < nch; c ++)
+  {
+    WDL_FFT_REAL *p=imp.impulses[c].Get();
+    double energy=0.0;
+    for (x = 0; x < implen; x ++)
+    {
+      p[x]=(WDL_FFT_REAL)((rand()/(double)RAND_MAX*2.0-1.0)*exp(-6.9*x/implen));
+      energy+=p[x]*p[x];
+    }
+    const double scale=1.0/sqrt(energy);
+    for (x = 0; x < implen; x ++) p[x]=(WDL_FFT_REAL)(p[x]*scale);
+  }
+
+  WDL_TypedBuf<WDL_FFT_REAL> input, output;
+  input.Resize(nch*blocksize);
+  output.Resize(nch*nblocks*blocksize);
+
+  printf("%.1f s impulse, %d ch, %d sample blocks at %.0f Hz, %.1f s\n",irlen_s,nch,blocksize,srate,runlen_s);
+
+  double maxdiff=0.0;
+  for (int pass = 0; pass < 2; pass ++)
+  {
+    const int threads=pass ? nthreads : 0;
+    WDL_ConvolutionEngine_Div engine;
+    engine.SetTailThreads(threads);
+    engine.SetImpulse(&imp,0,blocksize);
+
+    WDL_TypedBuf<double> times;
+    times.Resize(nblocks);
+    srand(2);
+
+    const double start=convo_test_wall_time();
+    for (b = 0; b < nblocks; b ++)
+    {
+      WDL_FFT_REAL *inptrs[8];
+      for (c = 0; c < nch; c ++)
+      {
+        inptrs[c]=input.Get()+c*blocksize;
+        for (x = 0; x < blocksize; x ++) inptrs[c][x]=(WDL_FFT_REAL)(rand()/(double)RAND_MAX*2.0-1.0);
+      }
+
+      if (threads) convo_test_sleep_until(start+b*blocksize/srate);
+
+      const double t0=convo_test_thread_time();
+      engine.Add(inptrs,blocksize,nch);
+      const int avail=wdl_min(engine.Avail(blocksize),blocksize);
+      WDL_FFT_REAL **outptrs=engine.Get();
+      for (c = 0; c < nch; c ++)
+      {
+        WDL_FFT_REAL *o=output.Get()+(c*nblocks+b)*blocksize;
+        if (!pass)
+        {
+          memset(o,0,blocksize*sizeof(WDL_FFT_REAL));
+          memcpy(o+blocksize-avail,outptrs[c],avail*sizeof(WDL_FFT_REAL));
+        }
+        else
+        {
+          for (x = 0; x < blocksize; x ++)
+          {
+            const double v = x >= blocksize-avail ? outptrs[c][x-(blocksize-avail)] : 0.0;
+            maxdiff=wdl_max(maxdiff,fabs(v-o[x]));
+          }
+        }
+      }
+      engine.Advance(avail);
+      times.Get()[b]=convo_test_thread_time()-t0;
+    }
+
+    if (pass)
+    {
+      char name[32];
+      snprintf(name,sizeof(name),"%d thread%s",threads,threads==1 ? "" : "s");
+      convo_test_print_times(name,&times);
+      printf("%-10s %d partitions missed their deadline, Avail() waited %d times\n","",engine.GetTailMisses(),engine.GetTailWaits());
+    }
+    else convo_test_print_times("in Avail()",&times);
+  }
+
+  printf("max difference %g\n",maxdiff);
+  return maxdiff > 1.0e-4 ? 1 : 0;
+}
+
+#endif
+
 int main(int argc, char **argv)
 {
+#if WDL_TEST_CONVO==2
+  if (argc>=2 && !strcmp(argv[1],"bench"))
+  {
+    if (argc<4 || argc>7)
+    {
+      printf("usage: convoengine bench irseconds blocksize [nthreads=1] [nch=2] [runseconds=10]\n");
+      return -1;
+    }
+    return convo_bench(atof(argv[2]),atoi(argv[3]),argc>4 ? atoi(argv[4]) : 1,argc>5 ? atoi(argv[5]) : 2,argc>6 ? atof(argv[6]) : 10.0);
+  }
+#endif
+
+#if WDL_TEST_CONVO==2
+  if (argc!=5 && argc!=6)
+  {
+    printf("usage: convoengine fftsize implen oneoffs pingoffs [tailthreads=0]\n");
+    printf("       convoengine bench irseconds blocksize [nthreads=1] [nch=2] [runseconds=10]\n");
+    return -1;
+  }
+#else
   if (argc!=5)
   {
     printf("usage: convoengine fftsize implen oneoffs pingoffs\n");
     return -1;
   }
+#endif
 
   int fftsize=atoi(argv[1]);
   int implen = atoi(argv[2]);
@@ -968,13 +1656,14 @@ int main(int argc, char **argv)
   }
 
   WDL_ImpulseBuffer imp;
-  imp.nch=1;
+  imp.SetNumChannels(1);
   memset(imp.impulses[0].Resize(implen),0,implen*sizeof(WDL_FFT_REAL));
   imp.impulses[0].Get()[oneoffs]=1.0;
 
 
 #if WDL_TEST_CONVO==2
   WDL_ConvolutionEngine_Div engine;
+  if (argc>5) engine.SetTailThreads(atoi(argv[5]));
 #else
   WDL_ConvolutionEngine engine;
 #endif
@@ -999,18 +1688,24 @@ int main(int argc, char **argv)
     printf("cant get output\n");
     return -1;
   }
-  int x;
+#if WDL_FFT_REALSIZE == 8
+  const double tolerance=0.000000001;
+#else
+  const double tolerance=0.00001; // float FFT rounding
+#endif
+  int x, errors=0;
   for (x = 0; x < avail; x ++)
   {
     WDL_FFT_REAL val=output[0][x];
     WDL_FFT_REAL expval = (x==pingoffs+oneoffs) ? 1.0:0.0;
-    if (fabs(val-expval)>0.000000001)
+    if (fabs(val-expval)>tolerance)
     {
-      printf("%d: %.4fdB - %f %f\n",x,log10(max(val,0.000000000001))*20.0 - log10(max(expval,0.000000000001))*20.0,val,expval);
+      printf("%d: %.4fdB - %f %f\n",x,log10(wdl_max(val,0.000000000001))*20.0 - log10(wdl_max(expval,0.000000000001))*20.0,val,expval);
+      errors++;
     }
   }
 
-  return 0;
+  return errors ? 1 : 0;
 }
 
 #endif
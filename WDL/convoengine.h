@@ -33,6 +33,7 @@
 #include "queue.h"
 #include "fastqueue.h"
 #include "fft.h"
+#include "mutex.h"
 
 //#define WDL_CONVO_WANT_FULLPRECISION_IMPULSE_STORAGE // define this for slowerness with -138dB error difference in resulting output (+-1 LSB at 24 bit)
 
@@ -165,7 +166,28 @@ public:
   WDL_FFT_REAL **Get(); // returns length valid
   void Advance(int len);
 
+  // Moves the large partitions at the end of the impulse to nthreads background threads, which compute them ahead of time
+  // instead of in Avail(). Those partitions are laid out so their input is complete at least one FFT block before their output
+  // is due, which leaves the threads that long to run them, earliest deadline first. If a partition is late anyway, Avail()
+  // computes it itself, so the output is identical to the synchronous version and the latency is unchanged.
+  // tail_fftsize is the smallest FFT size to move, 0 picks one from known_blocksize. nthreads=0 (the default) disables.
+  // Takes effect at the next SetImpulse()
+  // The threads run at a raised priority where the OS allows it, below that of a typical audio thread. Add() and Avail() pass them
+  // input blocks and take back results through buffers allocated at the first Add() after SetImpulse() or Reset(), without locking.
+  void SetTailThreads(int nthreads, int tail_fftsize=0);
+  int GetTailMisses() const { return m_tail_misses; } // number of tail partitions Avail() had to compute since SetImpulse()
+  int GetTailWaits() const { return m_tail_waits; } // number of times Avail() waited for a thread to finish a partition since SetImpulse()
+
 private:
+  struct TailJob;
+  struct TailThreads;
+
+  TailJob *TailPickJob(); // m_tail_mutex must be held
+  void TailRunJob(TailJob *job); // job->busy must be set, runs its next queued block and clears busy
+  bool TailSync(TailJob *job); // audio thread, collects finished blocks and queues complete input blocks, returns true if it queued any
+  void TailWaitIdle(); // m_tail_mutex must be held
+  void TailPrime(int nch); // m_tail_mutex must be held and no job busy
+
   WDL_PtrList<WDL_ConvolutionEngine> m_engines;
 
   WDL_PtrList<WDL_Queue> m_sout;
@@ -173,6 +195,11 @@ private:
 
   bool m_need_feedsilence;
 
+  WDL_PtrList<TailJob> m_tail; // changed under m_tail_mutex, while no job is busy
+  WDL_Mutex m_tail_mutex;
+  TailThreads *m_tail_threads;
+  int m_tail_nthreads, m_tail_fftsize, m_tail_nch, m_tail_misses, m_tail_waits;
+
 } WDL_FIXALIGN;
 
 
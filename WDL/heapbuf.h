@@ -36,6 +36,8 @@
 #ifndef WDL_HEAPBUF_IMPL_ONLY
 
 #include "wdltypes.h"
+#include <stdlib.h>
+#include <string.h>
 
 class WDL_HeapBuf
 {